@@ -2,13 +2,13 @@
 
 #include <FastLED.h>
 #include "globalDefines.h"
-#include "LED_Pattern_Interface.h"
+#include "Keyframe_Pattern.h"
 #include <unordered_map>
 #include <vector>
 // #include <utilities>
 
 // Called when an input with an LED is pressed. LED turns on and fades away over the course of the animation length
-class Button_Flash : public LED_Pattern_Interface
+class Button_Flash : public Keyframe_Pattern
 {
 public:
     Button_Flash(std::unordered_map<uint8_t, uint8_t> inputIDLedIdx)
@@ -19,69 +19,59 @@ public:
         }
 
         animationTicks = 15;
+
+        setProgram(LED_Program_Evaluator::ButtonFlash());
+
+        // Flashes sit on top of the button layer without blanking the buttons around them
+        setBlendMode(LED_BLEND_MAX);
+        setZOrder(1);
     }
 
     void configurePattern(JsonDocument &config)
     {
         if (config.containsKey("inputID"))
         {
-            inputID = config["inputID"];
+            setInputID(config["inputID"]);
         }
+    }
 
+    // Points the flash at the LED of an input and restarts it
+    void setInputID(uint8_t inputID)
+    {
         clearPattern();
+
+        auto pin = inputIdLedPins.find(inputID);
+        setTarget(pin != inputIdLedPins.end() && pin->second < numLeds ? pin->second : -1);
     }
 
-    bool iterateFrame()
+    void clearPattern()
     {
-        if (startTime == 0) 
+        if (leds == nullptr)
         {
-            startTime = xTaskGetTickCount();
+            return;
         }
 
-        if (inputIdLedPins.find(inputID) != inputIdLedPins.end())
+        for (auto kvp : inputIdLedPins)
         {
-            // Determine brightness this frame
-            float brightness = 1.0 - (float)(xTaskGetTickCount() - startTime) / (float)animationMS;
-            if (inputIdLedPins[inputID] < numLeds) 
+            if (kvp.second < numLeds)
             {
-                leds[inputIdLedPins[inputID]] = CRGB(themeColor.r * brightness, themeColor.g * brightness, themeColor.b * brightness);
+                leds[kvp.second] = CRGB(0, 0, 0);
             }
         }
-        else 
-        {
-            resetPattern();
-            return true;
-        }
 
-        currTick++;
-
-        if ((xTaskGetTickCount() - startTime) >= animationMS)
-        {
-            if (inputIdLedPins[inputID] < numLeds) 
-            {
-                leds[inputIdLedPins[inputID]] = CRGB(0, 0, 0);
-            }
-
-            resetPattern();
-            return true;
-        } 
-        else
-        {
-            return false;
-        }
+        resetPattern();
     }
 
-    void clearPattern()
+    void GetLayerRange(int &begin, int &end)
     {
+        begin = (int)numLeds;
+        end = -1;
+
         for (auto kvp : inputIdLedPins)
         {
-            if (kvp.second < numLeds)
-            {
-                leds[kvp.second] = CRGB(0, 0, 0);
-            }
+            begin = min(begin, (int)kvp.second);
+            end = max(end, (int)kvp.second);
         }
-
-        resetPattern();
     }
 
     void SetRegisteredPatternID(int patternID) { registeredPatternID = patternID; }
@@ -89,7 +79,6 @@ public:
 
 protected:
     std::unordered_map<uint8_t, uint8_t> inputIdLedPins;
-    uint8_t inputID;
 
     static int registeredPatternID;
-};
\ No newline at end of file
+};
@@ -60,6 +60,18 @@ public:
         }
     }
 
+    void GetLayerRange(int &begin, int &end)
+    {
+        begin = (int)numLeds;
+        end = -1;
+
+        for (auto kvp : inputIdLedPins)
+        {
+            begin = min(begin, (int)kvp.second);
+            end = max(end, (int)kvp.second);
+        }
+    }
+
     void SetRegisteredPatternID(int patternID) { registeredPatternID = patternID; }
     static int RegisteredPatternID() { return registeredPatternID; }
 
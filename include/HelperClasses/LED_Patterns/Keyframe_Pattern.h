@@ -0,0 +1,63 @@
+#pragma once
+
+#include "LED_Pattern_Interface.h"
+#include "LED_Program.h"
+#include <string>
+
+/*
+    Plays an LED_Program. Programs are compiled from JSON of the form:
+
+    {
+        "lengthMS": 1000,
+        "tracks": [
+            {
+                "beginIdx": 0, "endIdx": 15,    // or "target": true
+                "color": [255, 0, 0],           // omit to use the theme color
+                "keyframes": [
+                    { "t": 0.0, "level": 0 },
+                    { "t": 0.5, "level": 255, "ease": "inOut" },
+                    { "t": 1.0, "level": 0 }
+                ]
+            }
+        ]
+    }
+
+    Easing names are "linear", "in", "out", "inOut" and "step".
+    The loop length is the pattern's animation length if set, otherwise lengthMS, which must be an unsigned
+    32 bit integer.
+*/
+class Keyframe_Pattern : public LED_Pattern_Interface
+{
+public:
+    Keyframe_Pattern();
+
+    // Compiles a program from JSON. Leaves the current program untouched and returns false if it is invalid.
+    static bool CompileProgram(JsonVariantConst source, LED_Program &program);
+
+    bool loadProgram(JsonVariantConst source);
+
+    // Loads a program stored as MessagePack on SPIFFS
+    bool loadProgramFile(const std::string &filename);
+
+    void setProgram(const LED_Program &program);
+    const LED_Program &Program() { return program; }
+
+    // Sets the LED lit by target tracks. -1 clears it.
+    void setTarget(int ledIdx);
+
+    // Accepts "program", "file" and "target"
+    void configurePattern(JsonDocument &config);
+
+    bool iterateFrame();
+    void clearPattern();
+    void GetLayerRange(int &begin, int &end);
+
+    void SetRegisteredPatternID(int patternID) {}
+
+protected:
+    LED_Program program;
+    int targetIdx;
+
+    // Resolves a track's LED range. Returns false if the track has nothing to draw.
+    bool trackRange(const LED_Track &track, int &begin, int &end);
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "FastLED.h"
+
+// Estimated draw of a WS2812B channel at full brightness and of an LED that is off
+#define LED_CHANNEL_MA 20
+#define LED_IDLE_MA 1
+
+// Default current budget for the LED string
+#define LED_DEFAULT_BUDGET_MA 600
+
+// The full budget is available down to this battery percentage.
+// Below it the budget is derated linearly to LED_EMPTY_BATTERY_BUDGET_PERCENT of the budget at 0%.
+#define LED_FULL_BUDGET_BATTERY_PERCENT 50
+#define LED_EMPTY_BATTERY_BUDGET_PERCENT 25
+
+/*
+    Last step before FastLED. Turns a composited frame into the values sent to the LEDs:
+
+    1. Gamma corrects each channel into 8.8 fixed point
+    2. Scales the whole frame down if its estimated current is over budget
+    3. Temporally dithers back to 8 bits, carrying each channel's remainder into the next frame
+
+    The budget is checked against the dithered output, so a frame never exceeds it.
+*/
+class LED_Output_Stage
+{
+public:
+    // Allocates the dither state for numLeds LEDs
+    static void init(size_t numLeds);
+
+    static void render(const CRGB *frame, CRGB *output, size_t numLeds);
+
+    // Current budget for the whole string, before battery derating
+    static void setBudgetMA(uint16_t budgetMA);
+    static uint16_t BudgetMA() { return _BudgetMA; }
+
+    // Derates the budget for the given battery percentage
+    static void setBatteryPercentage(long percentage);
+
+    // Budget in effect after battery derating
+    static uint16_t EffectiveBudgetMA() { return _EffectiveBudgetMA; }
+
+    static void setGammaEnabled(bool enabled) { _GammaEnabled = enabled; }
+    static bool GammaEnabled() { return _GammaEnabled; }
+
+    static void setDitherEnabled(bool enabled) { _DitherEnabled = enabled; }
+    static bool DitherEnabled() { return _DitherEnabled; }
+
+    // Estimated current of an 8 bit frame as sent to the LEDs
+    static uint32_t EstimateMA(const CRGB *leds, size_t numLeds);
+
+    // Estimated current of the last rendered frame
+    static uint32_t LastEstimateMA() { return _LastEstimateMA; }
+
+    // Number of frames scaled down to fit the budget
+    static uint32_t LimitedFrames() { return _LimitedFrames; }
+
+protected:
+    static void updateEffectiveBudget();
+
+    static uint16_t _BudgetMA;
+    static long _BatteryPercentage;
+    static uint16_t _EffectiveBudgetMA;
+
+    static bool _GammaEnabled;
+    static bool _DitherEnabled;
+
+    // Fractional part of each channel left over from the last frame
+    static uint8_t *_DitherError;
+    static size_t _NumLeds;
+
+    static uint32_t _LastEstimateMA;
+    static uint32_t _LimitedFrames;
+};
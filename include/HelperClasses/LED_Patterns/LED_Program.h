@@ -0,0 +1,156 @@
+#pragma once
+
+#include "FastLED.h"
+
+#define MAX_LED_PROGRAM_TRACKS 4
+#define MAX_LED_PROGRAM_KEYFRAMES 16
+
+// Curve used to reach a keyframe from the one before it
+enum LED_Easing : uint8_t
+{
+    LED_EASE_LINEAR,
+    LED_EASE_IN,
+    LED_EASE_OUT,
+    LED_EASE_IN_OUT,
+    LED_EASE_STEP,
+};
+
+struct LED_Keyframe
+{
+    // Position in the loop as a fraction of 65535
+    uint16_t position;
+    uint8_t level;
+    LED_Easing easing;
+};
+
+// A range of LEDs driven by a run of keyframes
+struct LED_Track
+{
+    // -1 leaves the track unassigned
+    int16_t beginIdx;
+    int16_t endIdx;
+
+    // Target tracks light the single LED passed to Keyframe_Pattern::setTarget
+    bool target;
+    bool useThemeColor;
+    CRGB color;
+
+    uint8_t firstKeyframe;
+    uint8_t numKeyframes;
+};
+
+// Compiled animation. Evaluated every frame without touching JSON.
+struct LED_Program
+{
+    // 32 bits, so slow loops of more than a minute keep their length
+    uint32_t lengthMS;
+    uint8_t numTracks;
+    uint8_t numKeyframes;
+
+    LED_Track tracks[MAX_LED_PROGRAM_TRACKS];
+    LED_Keyframe keyframes[MAX_LED_PROGRAM_KEYFRAMES];
+};
+
+/*
+    Per frame evaluation of an LED_Program, and the built in programs.
+    Only needs FastLED's math, so tools/keyframe_test.cpp can run it on the host.
+*/
+class LED_Program_Evaluator
+{
+public:
+    // Position in the loop as a fraction of 65535
+    static uint16_t Position(uint32_t elapsedMS, uint32_t lengthMS)
+    {
+        return elapsedMS >= lengthMS ? UINT16_MAX : (uint64_t)elapsedMS * UINT16_MAX / lengthMS;
+    }
+
+    // Level of a track at a position, as an nscale8 scale
+    static uint8_t Level(const LED_Program &program, const LED_Track &track, uint16_t position)
+    {
+        const LED_Keyframe *keyframes = &program.keyframes[track.firstKeyframe];
+
+        if (track.numKeyframes == 0)
+        {
+            return 0;
+        }
+
+        if (position <= keyframes[0].position)
+        {
+            return keyframes[0].level;
+        }
+
+        for (uint8_t i = 1; i < track.numKeyframes; i++)
+        {
+            const LED_Keyframe &from = keyframes[i - 1];
+            const LED_Keyframe &to = keyframes[i];
+
+            if (position < to.position)
+            {
+                uint8_t fraction = ((uint32_t)(position - from.position) << 8) / (to.position - from.position);
+                return lerp8by8(from.level, to.level, Ease(fraction, to.easing));
+            }
+        }
+
+        return keyframes[track.numKeyframes - 1].level;
+    }
+
+    static uint8_t Ease(uint8_t fraction, LED_Easing easing)
+    {
+        switch (easing)
+        {
+        case LED_EASE_IN:
+            return scale8(fraction, fraction);
+        case LED_EASE_OUT:
+            return 255 - scale8(255 - fraction, 255 - fraction);
+        case LED_EASE_IN_OUT:
+            return ease8InOutQuad(fraction);
+        case LED_EASE_STEP:
+            return 0;
+        case LED_EASE_LINEAR:
+        default:
+            return fraction;
+        }
+    }
+
+    // Whole ring fades in over the first half of the loop and out over the second. Used by Ring_Pulse.
+    static LED_Program RingPulse()
+    {
+        LED_Program pulse = {};
+
+        pulse.lengthMS = 1000;
+        pulse.numTracks = 1;
+        pulse.numKeyframes = 3;
+
+        pulse.tracks[0].beginIdx = -1;
+        pulse.tracks[0].endIdx = -1;
+        pulse.tracks[0].useThemeColor = true;
+        pulse.tracks[0].firstKeyframe = 0;
+        pulse.tracks[0].numKeyframes = 3;
+
+        pulse.keyframes[0] = {0, 0, LED_EASE_LINEAR};
+        pulse.keyframes[1] = {UINT16_MAX / 2, 255, LED_EASE_LINEAR};
+        pulse.keyframes[2] = {UINT16_MAX, 0, LED_EASE_LINEAR};
+
+        return pulse;
+    }
+
+    // Target LED starts fully lit and fades out over the loop. Used by Button_Flash.
+    static LED_Program ButtonFlash()
+    {
+        LED_Program flash = {};
+
+        flash.lengthMS = 300;
+        flash.numTracks = 1;
+        flash.numKeyframes = 2;
+
+        flash.tracks[0].target = true;
+        flash.tracks[0].useThemeColor = true;
+        flash.tracks[0].firstKeyframe = 0;
+        flash.tracks[0].numKeyframes = 2;
+
+        flash.keyframes[0] = {0, 255, LED_EASE_LINEAR};
+        flash.keyframes[1] = {UINT16_MAX, 0, LED_EASE_LINEAR};
+
+        return flash;
+    }
+};
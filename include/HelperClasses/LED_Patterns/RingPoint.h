@@ -1,6 +1,7 @@
 #pragma once
 
 #include "LED_Pattern_Interface.h"
+#include "Ring_Kernels.h"
 
 // A pattern used to point a direction with the LED ring.
 // The angle is degrees from the beginning index of the ring is supplied for the direction.
@@ -20,8 +21,8 @@ public:
         beginIdx = -1;
         endIdx = -1;
 
-        fadeDegrees = 0;
-        directionDegrees = 0;
+        fadeWidth = 0;
+        directionAngle = 0;
 
         setAnimationLengthTicks(1);
     }
@@ -55,12 +56,12 @@ public:
 
         if (config.containsKey("fadeDegrees"))
         {
-            fadeDegrees = config["fadeDegrees"];
+            fadeWidth = Ring_Kernels::degreesToWidth(config["fadeDegrees"].as<float>());
         }
 
         if (config.containsKey("directionDegrees"))
         {
-            directionDegrees = config["directionDegrees"];
+            directionAngle = Ring_Kernels::degreesToAngle(config["directionDegrees"].as<float>());
         }
     }
 
@@ -77,12 +78,6 @@ public:
             return true;
         }
 
-        // Clear ring
-        for (int i = beginIdx; i <= endIdx; i++)
-        {
-            leds[i] = CRGB(0, 0, 0);
-        }
-
         CRGB outColor;
 
         if (rOverride == 0 && gOverride == 0 && bOverride == 0)
@@ -94,12 +89,7 @@ public:
             outColor = CRGB(rOverride, gOverride, bOverride);
         }
 
-        for (int i = beginIdx; i <= endIdx; i++)
-        {
-            float brightness = GetLEDPointBrightness(i);
-
-            leds[i] = CRGB(outColor.r * brightness, outColor.g * brightness, outColor.b * brightness);
-        }
+        Ring_Kernels::renderPoint(leds, beginIdx, endIdx, endIdx - beginIdx, directionAngle, fadeWidth, outColor, RING_FALLOFF_LINEAR);
 
         return true;
     }
@@ -115,8 +105,12 @@ public:
         {
             leds[i] = CRGB(0, 0, 0);
         }
+    }
 
-        FastLED.show();
+    void GetLayerRange(int &begin, int &end)
+    {
+        begin = beginIdx;
+        end = endIdx;
     }
 
     void SetRegisteredPatternID(int patternID) { _RegisteredPatternID = patternID; }
@@ -132,35 +126,7 @@ protected:
     int beginIdx;
     int endIdx;
 
-    float fadeDegrees;
-    float directionDegrees;
-    
-    float GetLEDPointBrightness(int ledIdx)
-    {
-        if (beginIdx == -1 || endIdx == -1)
-        {
-            return 0;
-        }
-
-        // Calculate the angle of the LED from the beginning index
-        float angle = (float)(ledIdx - beginIdx) * 360.0 / (float)(endIdx - beginIdx);
-
-        // Calculate the angle difference between the LED and the direction
-        float angleDiff = abs(angle - directionDegrees);
-
-        // If the angle difference is greater than 180, use the smaller angle
-        if (angleDiff > 180)
-        {
-            angleDiff = 360 - angleDiff;
-        }
-
-        // If the angle difference is greater than the fade degrees, return 0
-        if (angleDiff > fadeDegrees)
-        {
-            return 0;
-        }
-
-        // Calculate the brightness based on the angle difference
-        return 1.0 - (angleDiff / fadeDegrees);
-    }
+    // Width and direction of the point as fractions of a turn
+    uint32_t fadeWidth;
+    uint32_t directionAngle;
 };
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "FastLED.h"
+
+// Shape of the brightness curve around a lit point on the ring
+enum Ring_Falloff : uint8_t
+{
+    RING_FALLOFF_LINEAR,
+    RING_FALLOFF_QUADRATIC,
+    NUM_RING_FALLOFFS,
+};
+
+// Fixed point kernels shared by the ring patterns and LED_Manager.
+// Angles are 32 bit fractions of a full turn, so wraparound is plain integer overflow.
+// 16 bits are too coarse for narrow points: at a 1 degree fade one step of angle moves an LED by more than one LSB.
+class Ring_Kernels
+{
+public:
+    static uint32_t degreesToAngle(float degrees)
+    {
+        return (uint32_t)(int64_t)(degrees * (4294967296.0f / 360.0f));
+    }
+
+    // Converts a width in degrees to an angle. Widths of a full turn or more saturate.
+    static uint32_t degreesToWidth(float degrees)
+    {
+        if (degrees <= 0.0f)
+        {
+            return 0;
+        }
+
+        if (degrees >= 360.0f)
+        {
+            return UINT32_MAX;
+        }
+
+        return (uint32_t)(degrees * (4294967296.0f / 360.0f));
+    }
+
+    // Lights LEDs beginIdx to endIdx as a point on a ring where ledSpan LEDs make a full turn.
+    // The LED at beginIdx sits at angle 0.
+    static void renderPoint(CRGB *leds, int beginIdx, int endIdx, int ledSpan, uint32_t pointAngle, uint32_t fadeWidth, const CRGB &color, Ring_Falloff falloff);
+
+protected:
+    // Brightness of an LED as an nscale8 scale at ledAngle for a point at pointAngle.
+    // fadeReciprocal is 2^48 / fadeWidth, so the distance is scaled by a multiply rather than a division per LED.
+    static uint8_t pointBrightness(uint32_t ledAngle, uint32_t pointAngle, uint32_t fadeWidth, uint64_t fadeReciprocal, const uint16_t *table)
+    {
+        uint32_t diff = ledAngle - pointAngle;
+
+        // Use the shorter way around the ring
+        if (diff > 0x80000000)
+        {
+            diff = -diff;
+        }
+
+        if (diff >= fadeWidth)
+        {
+            return 0;
+        }
+
+        // Distance as a 8.8 fixed point index into the falloff table, interpolated between entries.
+        // diff < fadeWidth keeps the product under 2^48.
+        uint32_t position = (uint32_t)((diff * fadeReciprocal) >> 32);
+        uint8_t idx = position >> 8;
+        uint8_t frac = position & 0xFF;
+        uint32_t level = table[idx] - (((uint32_t)(table[idx] - table[idx + 1]) * frac) >> 8);
+
+        // nscale8 multiplies by (scale + 1) / 256, so round to the scale that lands closest to level
+        level = (level + 128) >> 8;
+        return level == 0 ? 0 : level - 1;
+    }
+
+    static const uint16_t *falloffTable(Ring_Falloff falloff);
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "LED_Pattern_Interface.h"
+#include "Ring_Kernels.h"
 
 // Uses the LED ring to display scrolling progress
 class ScrollWheel : public LED_Pattern_Interface
@@ -56,12 +57,17 @@ public:
             // Serial.println(currItem);
         #endif
 
-        for (int i = beginIdx; i <= endIdx; i++)
+        if (numItems <= 0 || endIdx <= beginIdx)
         {
-            float ledBrightness = _CalculateLEDPointBrightness(i);
-            leds[i] = CRGB(themeColor.r * ledBrightness, themeColor.g * ledBrightness, themeColor.b * ledBrightness);
+            return true;
         }
 
+        // Point at the current item. It spans half an item but never less than one LED.
+        uint32_t targetAngle = (uint64_t)currItem * 0x100000000ULL / numItems;
+        uint64_t fadeWidth = max(0x80000000ULL / numItems, 0x100000000ULL / (endIdx - beginIdx));
+
+        Ring_Kernels::renderPoint(leds, beginIdx, endIdx, endIdx - beginIdx, targetAngle, min(fadeWidth, (uint64_t)UINT32_MAX), themeColor, RING_FALLOFF_QUADRATIC);
+
         return true;
     }
 
@@ -76,8 +82,12 @@ public:
         {
             leds[i] = CRGB(0, 0, 0);
         }
+    }
 
-        FastLED.show();
+    void GetLayerRange(int &begin, int &end)
+    {
+        begin = beginIdx;
+        end = endIdx;
     }
 
     void SetRegisteredPatternID(int patternID) { _RegisteredPatternID = patternID; }
@@ -95,73 +105,4 @@ protected:
 
     // Current scrolling item
     int currItem;
-
-    // Calculate the brightness of the LED at the given index
-    float _CalculateLEDPointBrightness(int ledIdx)
-    {
-        if (beginIdx == -1 || endIdx == -1 || numItems == -1 || currItem == -1)
-        {
-            return 0;
-        }
-
-        #if DEBUG == 1
-            // Serial.print("ledIdx: ");
-            // Serial.print(ledIdx);
-        #endif
-
-        #if DEBUG == 1
-            // Serial.print(" currItem: ");
-            // Serial.print(currItem);
-            // Serial.print(" numItems: ");
-            // Serial.print(numItems);
-        #endif
-
-        // Target angle of the LED in degrees
-        float targetAngle = ((float)currItem / numItems) * 360.0;
-        #if DEBUG == 1
-            // Serial.print(" targetAngle: ");
-            // Serial.print(targetAngle);
-        #endif
-
-        float fadeDegrees = max((360.0f / (float)numItems) / 2.0f, (360.0f / (endIdx - beginIdx)));
-
-        // Calculate the angle of the LED from the beginning index
-        float angle = (float)(ledIdx - beginIdx) * 360.0 / (float)(endIdx - beginIdx);
-
-        #if DEBUG == 1
-            // Serial.print(" LEDangle: ");
-            // Serial.print(angle);
-        #endif
-
-        // Calculate the angle difference between the LED and the target angle
-        float angleDiff = abs(angle - targetAngle);
-
-        // If the angle difference is greater than 180, use the smaller angle
-        if (angleDiff > 180)
-        {
-            angleDiff = 360 - angleDiff;
-        }
-
-        #if DEBUG == 1
-            // Serial.print(" angleDiff: ");
-            // Serial.print(angleDiff);
-        #endif
-
-        // If the angle difference is greater than the fade degrees, return 0
-        if (angleDiff > fadeDegrees)
-        {
-            return 0;
-        }
-
-        // Calculate the brightness based on the angle difference with exponential decay
-        float returnVal = (-1.0 * pow(angleDiff / fadeDegrees, 2.0)) + 1.0;
-        #if DEBUG == 1
-            // Serial.print(" returnVal: ");
-            // Serial.print(returnVal);
-            // Serial.print(" fadeDegrees: ");
-            // Serial.println(fadeDegrees);
-        #endif
-
-        return returnVal;
-    }
 };
\ No newline at end of file
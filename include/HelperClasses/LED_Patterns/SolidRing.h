@@ -89,6 +89,12 @@ public:
         }
     }
 
+    void GetLayerRange(int &begin, int &end)
+    {
+        begin = beginIdx;
+        end = endIdx;
+    }
+
     void SetRegisteredPatternID(int patternID) { _RegisteredPatternID = patternID; }
     static int RegisteredPatternID() { return _RegisteredPatternID; }
 
@@ -8,7 +8,7 @@
 class Compass_Content : public OLED_Content
 {
 public:
-    Compass_Content(Adafruit_SSD1306 *disp);
+    Compass_Content(Display_Panel *disp);
     ~Compass_Content();
 
     void printContent();
@@ -12,7 +12,7 @@ enum Confirm_State
 class Confirm_Content : public OLED_Content
 {
 public:
-    Confirm_Content(Adafruit_SSD1306 *disp);
+    Confirm_Content(Display_Panel *disp);
 
     ~Confirm_Content();
 
@@ -10,7 +10,7 @@
 class <TYPE>_Content : public OLED_Content
 {
 public:
-    <TYPE>_Content(Adafruit_SSD1306 *disp);
+    <TYPE>_Content(Display_Panel *disp);
 
     ~<TYPE>_Content();
 
@@ -5,7 +5,7 @@
 class Edit_Bool_Content : public OLED_Content
 {
 public:
-    Edit_Bool_Content(Adafruit_SSD1306 *disp)
+    Edit_Bool_Content(Display_Panel *disp)
     {
         display = disp;
         type = ContentType::EDIT_BOOL;
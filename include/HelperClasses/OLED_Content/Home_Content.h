@@ -17,7 +17,7 @@ public:
 
     uint8_t contentMode;
 
-    Home_Content(Adafruit_SSD1306 *display);
+    Home_Content(Display_Panel *display);
     ~Home_Content();
 
     void printContent();
@@ -8,7 +8,7 @@
 class LoRa_Test_Content : public OLED_Content
 {
 public:
-    LoRa_Test_Content(Adafruit_SSD1306 *disp);
+    LoRa_Test_Content(Display_Panel *disp);
     ~LoRa_Test_Content();
 
     void printContent();
@@ -7,6 +7,7 @@
 #include "globalDefines.h"
 #include "System_Utils.h"
 #include "Display_Utils.h"
+#include "Display_Panel.h"
 
 // TODO: Get rid of this
 enum class ContentType
@@ -70,7 +71,7 @@ public:
     //TODO: axe this
     ContentType type = ContentType::NONE;
     
-    static Adafruit_SSD1306 *display;
+    static Display_Panel *display;
     static QueueHandle_t displayCommandQueue;
 
     // map inputID to callback struct
@@ -117,7 +118,7 @@ class OLED_Content_List : public OLED_Content
 public:
 
     OLED_Content_List();
-    OLED_Content_List(Adafruit_SSD1306 *display);
+    OLED_Content_List(Display_Panel *display);
     ~OLED_Content_List();
 
     void addNode(Content_Node *node);
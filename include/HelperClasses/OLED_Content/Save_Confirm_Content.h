@@ -7,7 +7,7 @@
 class Save_Confirm_Content : public OLED_Content
 {
 public:
-    Save_Confirm_Content(Adafruit_SSD1306 *disp);
+    Save_Confirm_Content(Display_Panel *disp);
 
     ~Save_Confirm_Content();
 
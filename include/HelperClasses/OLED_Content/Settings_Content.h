@@ -45,6 +45,7 @@ public:
     void popVariant(bool printAfter = false);
     void pushVariant(bool printAfter = false);
     void refresh();
+    void resetToRoot(JsonDocument &settings);
     size_t getVariantDepth();
     void printVariantValue(ArduinoJson::JsonVariant variant);
     JsonVariantType getVariantType();
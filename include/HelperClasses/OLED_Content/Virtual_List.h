@@ -0,0 +1,156 @@
+#pragma once
+
+#include <functional>
+#include <stddef.h>
+
+// List model that pulls rows from a data source on demand instead of copying the backing collection.
+// Only the rows inside the viewport plus one prefetched row are held in memory, so the cost of
+// scrolling does not depend on the length of the list.
+template <typename T, size_t VIEWPORT_ROWS = 1>
+class Virtual_List
+{
+public:
+    using CountFunction = std::function<size_t()>;
+    using FetchFunction = std::function<bool(size_t index, T &row)>;
+
+    Virtual_List() {}
+
+    Virtual_List(CountFunction count, FetchFunction fetch)
+    {
+        setDataSource(count, fetch);
+    }
+
+    void setDataSource(CountFunction count, FetchFunction fetch)
+    {
+        countFunction = count;
+        fetchFunction = fetch;
+        reset();
+    }
+
+    // Moves the selection back to the first row and drops all cached rows
+    void reset()
+    {
+        selectedIdx = 0;
+        viewportStart = 0;
+        invalidate();
+    }
+
+    // Drops all cached rows. Call when the backing collection changes.
+    void invalidate()
+    {
+        for (size_t i = 0; i < CACHE_SIZE; i++)
+        {
+            cache[i].valid = false;
+        }
+    }
+
+    size_t size() const
+    {
+        return countFunction ? countFunction() : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t selectedIndex() const { return selectedIdx; }
+    size_t firstVisibleIndex() const { return viewportStart; }
+    static constexpr size_t viewportRows() { return VIEWPORT_ROWS; }
+
+    // Returns the row at a position inside the viewport, or nullptr if it is past the end of the list
+    const T *visibleRow(size_t viewportRow)
+    {
+        return row(viewportStart + viewportRow);
+    }
+
+    const T *selected()
+    {
+        return row(selectedIdx);
+    }
+
+    // Returns the row at index, fetching it from the data source if it is not cached
+    const T *row(size_t index)
+    {
+        if (index >= size())
+        {
+            return nullptr;
+        }
+
+        Cached_Row &slot = cache[index % CACHE_SIZE];
+
+        if (!slot.valid || slot.index != index)
+        {
+            slot.valid = fetchFunction(index, slot.value);
+            slot.index = index;
+        }
+
+        return slot.valid ? &slot.value : nullptr;
+    }
+
+    void scrollUp(bool wrap = true)
+    {
+        size_t numRows = size();
+
+        if (numRows < 2 || (selectedIdx == 0 && !wrap))
+        {
+            return;
+        }
+
+        selectedIdx = selectedIdx == 0 ? numRows - 1 : selectedIdx - 1;
+        updateViewport(numRows);
+
+        if (selectedIdx > 0)
+        {
+            row(selectedIdx - 1);
+        }
+    }
+
+    void scrollDown(bool wrap = true)
+    {
+        size_t numRows = size();
+
+        if (numRows < 2 || (selectedIdx == numRows - 1 && !wrap))
+        {
+            return;
+        }
+
+        selectedIdx = selectedIdx == numRows - 1 ? 0 : selectedIdx + 1;
+        updateViewport(numRows);
+
+        row(selectedIdx + 1);
+    }
+
+private:
+    // Visible rows plus the row prefetched in the direction of the last scroll.
+    // Rows are stored by index modulo the cache size so neighbouring rows never evict each other.
+    static constexpr size_t CACHE_SIZE = VIEWPORT_ROWS + 1;
+
+    struct Cached_Row
+    {
+        size_t index = 0;
+        bool valid = false;
+        T value;
+    };
+
+    void updateViewport(size_t numRows)
+    {
+        if (selectedIdx < viewportStart)
+        {
+            viewportStart = selectedIdx;
+        }
+        else if (selectedIdx >= viewportStart + VIEWPORT_ROWS)
+        {
+            viewportStart = selectedIdx - VIEWPORT_ROWS + 1;
+        }
+
+        if (viewportStart + VIEWPORT_ROWS > numRows)
+        {
+            viewportStart = numRows > VIEWPORT_ROWS ? numRows - VIEWPORT_ROWS : 0;
+        }
+    }
+
+    CountFunction countFunction;
+    FetchFunction fetchFunction;
+
+    Cached_Row cache[CACHE_SIZE];
+    size_t selectedIdx = 0;
+    size_t viewportStart = 0;
+};
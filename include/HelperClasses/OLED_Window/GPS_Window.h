@@ -15,7 +15,7 @@ public:
     GPS_Window(OLED_Window *parent) : OLED_Window(parent)
     {
         state.assignInput(BUTTON_3, ACTION_BACK, "Back");
-        Display_Utils::enableRefreshTimer(GPS_WINDOW_REFRESH_RATE_MS);
+        Display_Utils::enableRefreshTimer(GPS_WINDOW_REFRESH_RATE_MS, REFRESH_DEPENDENCY_GPS);
         currentState = &state;
     }
 
@@ -31,18 +31,17 @@ public:
 
     void Resume()
     {
-        Display_Utils::enableRefreshTimer(GPS_WINDOW_REFRESH_RATE_MS);
+        Display_Utils::enableRefreshTimer(GPS_WINDOW_REFRESH_RATE_MS, REFRESH_DEPENDENCY_GPS);
     }
 
     void drawWindow()
     {
         OLED_Window::drawWindow();
 
-        if (NavigationUtils::IsGPSConnected())
-        {
-            NavigationUtils::UpdateGPS();
-            auto location = NavigationUtils::GetLocation();
+        auto location = NavigationUtils::GetLocation();
 
+        if (location.isValid())
+        {
             Display_Utils::getDisplay()->setCursor(Display_Utils::alignTextLeft(), Display_Utils::selectTextLine(1));
             Display_Utils::getDisplay()->print("Lat: ");
             Display_Utils::getDisplay()->print(location.lat(), 8);
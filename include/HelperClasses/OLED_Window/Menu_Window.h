@@ -101,6 +101,12 @@ public:
         menuState->addMenuItem(text, callbackID);
     }
 
+    void reuseWindow(OLED_Window *parent)
+    {
+        menuState->resetSelection();
+        OLED_Window::reuseWindow(parent);
+    }
+
     Menu_State *menuState;
 
 protected:
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "OLED_Window.h"
+#include "Nearby_State.h"
+#include "Tracking_State.h"
+
+class NearbyWindow : public OLED_Window
+{
+public:
+    NearbyWindow(OLED_Window *parent) : OLED_Window(parent)
+    {
+        nearbyState = new Nearby_State();
+        stateList.push_back(nearbyState);
+
+        trackingState = new Tracking_State();
+        stateList.push_back(trackingState);
+
+        setInitialState(nearbyState);
+
+        nearbyState->setAdjacentState(BUTTON_2, trackingState);
+
+        trackingState->assignInput(BUTTON_3, ACTION_RETURN_FROM_FUNCTIONAL_WINDOW_STATE, "Back");
+    }
+
+    ~NearbyWindow() {}
+
+protected:
+    Nearby_State *nearbyState;
+    Tracking_State *trackingState;
+};
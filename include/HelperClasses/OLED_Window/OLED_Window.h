@@ -19,7 +19,7 @@ public:
     OLED_Window();
     OLED_Window(OLED_Window *parent);
 
-    static Adafruit_SSD1306 *display;
+    static Display_Panel *display;
     OLED_Content *content = nullptr;
     Window_State *currentState = nullptr;
     std::stack<Window_State *> stateStack;
@@ -220,6 +220,7 @@ public:
 
     void setInitialState(Window_State *initialState)
     {
+        this->initialState = initialState;
         currentState = initialState;
         State_Transfer_Data transferData;
         transferData.inputID = 0;
@@ -231,6 +232,37 @@ public:
 
     virtual uint32_t GetCallbackIDFromSelect(uint8_t inputID) { return ACTION_NONE; }
 
+    // Pooled windows are kept alive by Display_Manager instead of being deleted.
+    // releaseWindow() does the teardown the destructor would, without freeing states or content.
+    virtual void releaseWindow()
+    {
+        if (currentState != nullptr)
+        {
+            currentState->exitState();
+        }
+
+        while (!stateStack.empty())
+        {
+            stateStack.pop();
+        }
+
+        isPaused = false;
+
+        LED_Manager::clearRing();
+    }
+
+    // Re-attaches a released window under a new parent and re-enters its initial state.
+    // Child classes should reset any per-visit data before calling this.
+    virtual void reuseWindow(OLED_Window *parent)
+    {
+        parentWindow = parent;
+
+        if (initialState != nullptr)
+        {
+            setInitialState(initialState);
+        }
+    }
+
     // void execBtnCallback(uint8_t buttonNumber, void *arg);
 
     virtual ~OLED_Window();
@@ -293,6 +325,9 @@ protected:
 
     size_t returnAction = 0;
 
+    // State entered by setInitialState(), used to reset pooled windows
+    Window_State *initialState = nullptr;
+
     char btn1Text[BUTTON_TEXT_MAX + 1];
     char btn2Text[BUTTON_TEXT_MAX + 1];
     char btn3Text[BUTTON_TEXT_MAX + 1];
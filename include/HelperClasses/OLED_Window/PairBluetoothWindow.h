@@ -54,8 +54,7 @@ public:
             prompt.horizontalAlignment = ALIGN_CENTER_HORIZONTAL;
             prompt.verticalAlignment = ALIGN_CENTER_VERTICAL;
 
-            std::string msg = "PIN: " + std::to_string(Bluetooth_Utils::bluetoothPin());
-            Display_Utils::printFormattedText(msg.c_str(), prompt);
+            Display_Utils::printfFormattedText(prompt, "PIN: %d", Bluetooth_Utils::bluetoothPin());
         } else if (Bluetooth_Utils::bluetoothConnected() && Bluetooth_Utils::bluetoothPaired()) {
             TextFormat prompt;
             prompt.horizontalAlignment = ALIGN_CENTER_HORIZONTAL;
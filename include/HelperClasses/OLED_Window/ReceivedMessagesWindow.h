@@ -25,6 +25,7 @@ public:
         trackingState = new Tracking_State();
         selectMessageState = new Select_Message_State();
         selectLocationState = new Select_Location_State();
+        selectLocationState->setCurrentLocationName(CURR_LOCATION);
         selectionState = new SelectKeyValueState();
         saveLocationState = new SaveLocationState();
         
@@ -42,12 +43,7 @@ public:
         receivedMessagesState->assignInput(ENC_UP, ACTION_DEFER_CALLBACK_TO_WINDOW);
         receivedMessagesState->assignInput(ENC_DOWN, ACTION_DEFER_CALLBACK_TO_WINDOW);
 
-        if (LoraUtils::GetNumMessages() > 0) 
-        {
-            receivedMessagesState->assignInput(BUTTON_1, ACTION_CALL_FUNCTIONAL_WINDOW_STATE, "Save");
-            receivedMessagesState->assignInput(BUTTON_2, ACTION_CALL_FUNCTIONAL_WINDOW_STATE, "Reply");
-            receivedMessagesState->assignInput(BUTTON_4, ACTION_CALL_FUNCTIONAL_WINDOW_STATE, "Track");
-        }
+        assignMessageInputs();
 
         receivedMessagesState->setAdjacentState(BUTTON_1, selectionState);
         receivedMessagesState->setAdjacentState(BUTTON_2, selectLocationState);
@@ -61,6 +57,13 @@ public:
 
     ~ReceivedMessagesWindow() {}
 
+    void reuseWindow(OLED_Window *parent)
+    {
+        clearMessageInfo();
+        assignMessageInputs();
+        OLED_Window::reuseWindow(parent);
+    }
+
     void transferState(State_Transfer_Data &transferData)
     {
         Window_State *oldState = transferData.oldState;
@@ -102,28 +105,20 @@ public:
 
              // Transfer to Select Message State
             delete transferData.serializedData;
-            transferData.serializedData = new DynamicJsonDocument(1024);
-
-            JsonArray msgArray = (*transferData.serializedData).createNestedArray("Messages");
-
-            if (!useCurrLocation)
-            {
-                msgArray.add(locName);
-            }
+            transferData.serializedData = nullptr;
 
-            LoraUtils::SerializeSavedMessageList(*transferData.serializedData);
+            selectMessageState->setLocationMessage(useCurrLocation ? std::string() : locName);
 
             newState = selectMessageState;
         }
         else if (oldState == selectMessageState && transferData.serializedData != nullptr)
         {
+            GPS_Fix fix = NavigationUtils::GetFix();
+
             if (useCurrLocation)
             {
-                NavigationUtils::UpdateGPS();
-                auto loc = NavigationUtils::GetLocation();
-
-                latitude = loc.lat();
-                longitude = loc.lng();
+                latitude = fix.lat();
+                longitude = fix.lng();
             }
 
             DynamicJsonDocument *doc = (DynamicJsonDocument *)transferData.serializedData;
@@ -135,8 +130,8 @@ public:
                 auto color = LED_Utils::ThemeColor();
 
                 MessagePing *newMsg = new MessagePing(
-                    NavigationUtils::GetTime().value(),
-                    NavigationUtils::GetDate().value(),
+                    fix.time,
+                    fix.date,
                     recipientID,
                     LoraUtils::UserID(),
                     LoraUtils::UserName().c_str(),
@@ -273,18 +268,6 @@ public:
             {
                 return;
             }
-            
-            NavigationUtils::UpdateGPS();
-
-            transferData.serializedData = new DynamicJsonDocument(1024);
-            (*transferData.serializedData).createNestedArray("Locations");
-            auto currLocObj = (*transferData.serializedData)["Locations"].createNestedObject();
-            currLocObj["Name"] = CURR_LOCATION;
-            currLocObj["Lat"] = NavigationUtils::GetLocation().lat();
-            currLocObj["Lng"] = NavigationUtils::GetLocation().lng();
-            
-            NavigationUtils::SerializeSavedLocations(*transferData.serializedData);
-            
         }
 
 
@@ -312,6 +295,23 @@ protected:
     double longitude;
     std::string locName;
 
+    // Message actions are only available when there is a message to act on
+    void assignMessageInputs()
+    {
+        if (LoraUtils::GetNumMessages() > 0) 
+        {
+            receivedMessagesState->assignInput(BUTTON_1, ACTION_CALL_FUNCTIONAL_WINDOW_STATE, "Save");
+            receivedMessagesState->assignInput(BUTTON_2, ACTION_CALL_FUNCTIONAL_WINDOW_STATE, "Reply");
+            receivedMessagesState->assignInput(BUTTON_4, ACTION_CALL_FUNCTIONAL_WINDOW_STATE, "Track");
+        }
+        else
+        {
+            receivedMessagesState->buttonCallbacks.erase(BUTTON_1);
+            receivedMessagesState->buttonCallbacks.erase(BUTTON_2);
+            receivedMessagesState->buttonCallbacks.erase(BUTTON_4);
+        }
+    }
+
     void clearMessageInfo()
     {
         recipientID = 0;
@@ -19,6 +19,8 @@ public:
 
     void transferState(State_Transfer_Data &transferData);
 
+    void reuseWindow(OLED_Window *parent);
+
     // void execBtnCallback(uint8_t inputID);
     // void drawWindow();
 
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <new>
+#include <stdint.h>
+
+// Only pointers to windows are handled here, so the pool also builds in tools/window_pool_test.cpp
+class OLED_Window;
+
+// Statically allocated storage for a single window instance.
+// The window is placement constructed on first use and then reused every time it is opened,
+// so frequently visited windows never touch the heap after the first visit.
+template <typename T>
+class Window_Pool_Slot
+{
+public:
+    // Returns true once the window has been constructed in the slot
+    bool isConstructed() const { return instance != nullptr; }
+
+    // Returns true if the window is currently attached to the window stack
+    bool isInUse() const { return inUse; }
+
+    bool owns(const OLED_Window *window) const
+    {
+        return window != nullptr && window == instance;
+    }
+
+    // Returns the pooled window attached to parent.
+    // Returns nullptr if the pooled window is already attached. Callers should fall back to the heap.
+    T *acquire(OLED_Window *parent)
+    {
+        if (inUse)
+        {
+            return nullptr;
+        }
+
+        if (instance == nullptr)
+        {
+            instance = new (storage) T(parent);
+        }
+        else
+        {
+            instance->reuseWindow(parent);
+        }
+
+        inUse = true;
+        return instance;
+    }
+
+    // Releases the window back to the slot. Returns false if the window is not owned by this slot.
+    bool release(OLED_Window *window)
+    {
+        if (!owns(window) || !inUse)
+        {
+            return false;
+        }
+
+        instance->releaseWindow();
+        inUse = false;
+        return true;
+    }
+
+protected:
+    alignas(T) uint8_t storage[sizeof(T)];
+    T *instance = nullptr;
+    bool inUse = false;
+};
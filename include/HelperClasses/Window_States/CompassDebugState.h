@@ -34,7 +34,8 @@ public:
 
         LED_Utils::enablePattern(_RingPointID);
 
-        Display_Utils::enableRefreshTimer(COMPASS_WINDOW_REFRESH_RATE_MS);
+        // Redrawn when the filtered heading moves a degree, the raw values are only shown alongside it
+        Display_Utils::enableRefreshTimer(COMPASS_WINDOW_REFRESH_RATE_MS, REFRESH_DEPENDENCY_COMPASS);
     }
 
     void exitState(State_Transfer_Data &transferData)
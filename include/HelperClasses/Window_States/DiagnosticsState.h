@@ -10,13 +10,11 @@ public:
     void displayState()
     {
         TextFormat format;
-        std::string text;
         format.horizontalAlignment = TextAlignmentHorizontal::ALIGN_LEFT;
         format.verticalAlignment = TextAlignmentVertical::TEXT_LINE;
         format.line = 1;
 
-        text = "Heap Free: ";
-        std::string heapFreeUnits = "b";
+        const char *heapFreeUnits = "b";
         // Presumably in bytes
         auto freeHeap = ESP.getFreeHeap();
         if (freeHeap > 1024)
@@ -30,21 +28,15 @@ public:
             }
         }
 
-        text += std::to_string(freeHeap);
-        text += heapFreeUnits;
-        Display_Utils::printFormattedText(text.c_str(), format);
+        Display_Utils::printfFormattedText(format, "Heap Free: %u%s", (unsigned int)freeHeap, heapFreeUnits);
 
         format.line = 2;
-        text = "Heap Frag: ";
-        text += std::to_string((float)ESP.getMaxAllocHeap() / (float)ESP.getFreeHeap());
-        text += "%";
-        Display_Utils::printFormattedText(text.c_str(), format);
+        // Share of free heap outside the largest block. The old ratio printed largest/free, which read backwards.
+        Display_Utils::printfFormattedText(format, "Heap Frag: %u%%", (unsigned int)Heap_Utils::FragmentationPercent());
 
         // Stack water level
         format.line = 3;
-        text = "Stack Left: ";
-        text += std::to_string(uxTaskGetStackHighWaterMark(NULL));
-        Display_Utils::printFormattedText(text.c_str(), format);
+        Display_Utils::printfFormattedText(format, "Stack Left: %u", (unsigned int)uxTaskGetStackHighWaterMark(NULL));
 
         Display_Utils::UpdateDisplay().Invoke();
         
@@ -149,11 +149,10 @@ public:
         // Serial.println(text);
         // Serial.println("Setting cursor");
         #endif
-        display->setCursor(Display_Utils::centerTextHorizontal(text), Display_Utils::centerTextVertical());
         #if DEBUG == 1
         // Serial.println("Printing text");
         #endif
-        display->print(text);
+        Display_Utils::printText(text, Display_Utils::centerTextHorizontal(text), Display_Utils::centerTextVertical());
 
         #if DEBUG == 1
         // Serial.println("Rendered menu item");
@@ -180,6 +179,12 @@ public:
         currentMenuItem = menuItems.begin();
     }
 
+    // Moves the selection back to the first menu item
+    void resetSelection()
+    {
+        currentMenuItem = menuItems.begin();
+    }
+
     CallbackData *getMenuItemCallback()
     {
         if (currentMenuItem == menuItems.end())
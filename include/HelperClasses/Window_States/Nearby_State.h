@@ -0,0 +1,178 @@
+#pragma once
+
+#include "Window_State.h"
+#include "NavigationUtils.h"
+#include "ScrollWheel.h"
+#include "LED_Utils.h"
+
+// Items shown in the nearby list
+#define NEARBY_LIST_LENGTH 10
+
+// Lists the saved locations and pinging users nearest the current fix
+// Inputs:
+//   ENC_UP: Select next item
+//   ENC_DOWN: Select previous item
+//   BUTTON_3: Return
+//   BUTTON_2: Track
+class Nearby_State : public Window_State
+{
+public:
+    Nearby_State()
+    {
+        assignInput(ENC_UP, ACTION_DEFER_CALLBACK_TO_WINDOW);
+        assignInput(ENC_DOWN, ACTION_DEFER_CALLBACK_TO_WINDOW);
+
+        assignInput(BUTTON_3, ACTION_BACK, "Back");
+        assignInput(BUTTON_2, ACTION_CALL_FUNCTIONAL_WINDOW_STATE, "Track");
+    }
+
+    ~Nearby_State()
+    {
+
+    }
+
+    void enterState(State_Transfer_Data &transferData)
+    {
+        Window_State::enterState(transferData);
+
+        _ScrollWheelPatternID = ScrollWheel::RegisteredPatternID();
+        LED_Utils::enablePattern(_ScrollWheelPatternID);
+
+        // Distances change as we move, and the list changes as pings arrive
+        Display_Utils::enableRefreshTimer(1000, REFRESH_DEPENDENCY_GPS | REFRESH_DEPENDENCY_MESSAGES);
+
+        _SelectedIdx = 0;
+        refreshItems();
+    }
+
+    void exitState(State_Transfer_Data &transferData)
+    {
+        Window_State::exitState(transferData);
+
+        Display_Utils::disableRefreshTimer();
+        LED_Utils::disablePattern(_ScrollWheelPatternID);
+
+        // Output coordinates and name of the selected item
+        if (transferData.inputID == BUTTON_2 && _SelectedIdx < _Items.size())
+        {
+            const Nearby_Item &item = _Items[_SelectedIdx];
+            DynamicJsonDocument *doc = new DynamicJsonDocument(256);
+
+            (*doc)["lat"] = item.latitude;
+            (*doc)["lon"] = item.longitude;
+
+            (*doc)["color_R"] = LED_Utils::ThemeColor().r;
+            (*doc)["color_G"] = LED_Utils::ThemeColor().g;
+            (*doc)["color_B"] = LED_Utils::ThemeColor().b;
+
+            auto displayArr = (*doc).createNestedArray("displayTxt");
+
+            displayArr.add(item.name);
+
+            transferData.serializedData = doc;
+        }
+    }
+
+    void processInput(uint8_t inputID)
+    {
+        if (_Items.empty())
+        {
+            return;
+        }
+
+        if (inputID == ENC_DOWN)
+        {
+            _SelectedIdx = (_SelectedIdx + 1) % _Items.size();
+        }
+
+        if (inputID == ENC_UP)
+        {
+            _SelectedIdx = _SelectedIdx == 0 ? _Items.size() - 1 : _SelectedIdx - 1;
+        }
+
+        _SelectedKind = _Items[_SelectedIdx].kind;
+        _SelectedID = _Items[_SelectedIdx].id;
+    }
+
+    void displayState()
+    {
+        refreshItems();
+
+        Window_State::displayState();
+
+        if (_Items.empty())
+        {
+            Display_Utils::printCenteredText(NavigationUtils::IsGPSConnected() ? "Nothing Nearby" : "No GPS Signal", true);
+            return;
+        }
+
+        const Nearby_Item &item = _Items[_SelectedIdx];
+
+        TextFormat format;
+        format.horizontalAlignment = ALIGN_CENTER_HORIZONTAL;
+        format.verticalAlignment = TEXT_LINE;
+
+        format.line = 2;
+        Display_Utils::printFormattedText(item.name.c_str(), format);
+
+        format.line = 3;
+        if (item.vector.distanceM > 2000)
+        {
+            Display_Utils::printfFormattedText(format, "%.1f km %s", item.vector.distanceM / 1000, compassPoint(item.vector.bearingDeg));
+        }
+        else
+        {
+            Display_Utils::printfFormattedText(format, "%d m %s", (int)item.vector.distanceM, compassPoint(item.vector.bearingDeg));
+        }
+
+        if (_ScrollWheelPatternID > -1)
+        {
+            StaticJsonDocument<128> doc;
+            doc["numItems"] = _Items.size();
+            doc["currItem"] = _SelectedIdx;
+
+            LED_Utils::configurePattern(_ScrollWheelPatternID, doc);
+            LED_Utils::iteratePattern(_ScrollWheelPatternID);
+        }
+    }
+
+protected:
+    // Reorders the list as the fix moves, keeping the same item selected
+    void refreshItems()
+    {
+        _Items = NavigationUtils::GetNearby(NEARBY_LIST_LENGTH);
+        _SelectedIdx = 0;
+
+        for (size_t i = 0; i < _Items.size(); i++)
+        {
+            if (_Items[i].kind == _SelectedKind && _Items[i].id == _SelectedID)
+            {
+                _SelectedIdx = i;
+                break;
+            }
+        }
+
+        if (_Items.empty())
+        {
+            buttonCallbacks.erase(BUTTON_2);
+        }
+        else
+        {
+            assignInput(BUTTON_2, ACTION_CALL_FUNCTIONAL_WINDOW_STATE, "Track");
+            _SelectedKind = _Items[_SelectedIdx].kind;
+            _SelectedID = _Items[_SelectedIdx].id;
+        }
+    }
+
+    static const char *compassPoint(float bearingDeg)
+    {
+        static const char *points[] = {"N", "NE", "E", "SE", "S", "SW", "W", "NW"};
+        return points[(int)((bearingDeg + 22.5f) / 45.0f) % 8];
+    }
+
+    std::vector<Nearby_Item> _Items;
+    size_t _SelectedIdx = 0;
+    uint8_t _SelectedKind = SPATIAL_SAVED_LOCATION;
+    uint32_t _SelectedID = UINT32_MAX;
+    int _ScrollWheelPatternID = -1;
+};
@@ -67,11 +67,7 @@ public:
         
         if (updateMessage)
         {
-            MessageBase *msg = LoraUtils::GetCurrentMessage();
-            if (msg != nullptr)
-            {
-                messageDisplay->SetDisplayMessage(msg);
-            }
+            refreshDisplayMessage();
         }
     }
 
@@ -86,12 +82,7 @@ public:
         }
 
         LoraUtils::ResetMessageIterator();
-
-        MessageBase *msg = LoraUtils::GetCurrentMessage();
-        if (msg != nullptr)
-        {
-            messageDisplay->SetDisplayMessage(msg);
-        }
+        refreshDisplayMessage();
 
         #if DEBUG == 1
         Serial.println("ReceivedMessageState::enterState() - Done");
@@ -165,19 +156,19 @@ public:
         }
         else
         {
-            MessageBase *msg = LoraUtils::GetCurrentMessage();
-            if (msg != nullptr)
+            // Only copy the message out of the store again if the store changed since it was fetched
+            if (_DisplayedStoreVersion != LoraUtils::MessageStoreVersion() || messageDisplay->DisplayMessage() == nullptr)
             {
-                messageDisplay->SetDisplayMessage(msg);
+                refreshDisplayMessage();
             }
-            #if DEBUG == 1
-            else
+
+            if (messageDisplay->DisplayMessage() == nullptr)
             {
+                #if DEBUG == 1
                 Serial.println("ReceivedMessageState::displayState() - Message is null");
+                #endif
             }
-            #endif
-
-            if (messageDisplay->DisplayMessage()->GetInstanceMessageType() == MessagePing::MessageType())
+            else if (messageDisplay->DisplayMessage()->GetInstanceMessageType() == MessagePing::MessageType())
             {
                 MessagePing *ping = (MessagePing *)messageDisplay->DisplayMessage();
 
@@ -202,6 +193,18 @@ public:
     }
 
 protected:
+    void refreshDisplayMessage()
+    {
+        _DisplayedStoreVersion = LoraUtils::MessageStoreVersion();
+
+        MessageBase *msg = LoraUtils::GetCurrentMessage();
+        if (msg != nullptr)
+        {
+            messageDisplay->SetDisplayMessage(msg);
+        }
+    }
+
     LoraMessageDisplay *messageDisplay;
+    uint32_t _DisplayedStoreVersion = 0;
     int _SolidRingPatternID;
 };
\ No newline at end of file
@@ -91,7 +91,15 @@ public:
 
             if (message != nullptr)
             {
-                Display_Utils::enableRefreshTimer(MESSAGE_REPEAT_INTERVAL_MS);
+                // The clock always changes within an interval, so the message still repeats every MESSAGE_REPEAT_INTERVAL_MS
+                uint32_t dependencies = REFRESH_DEPENDENCY_CLOCK;
+
+                if (message->GetInstanceMessageType() == MessagePing::MessageType() && ((MessagePing *)message)->IsLive)
+                {
+                    dependencies |= REFRESH_DEPENDENCY_GPS;
+                }
+
+                Display_Utils::enableRefreshTimer(MESSAGE_REPEAT_INTERVAL_MS, dependencies);
             }
         }
     }
@@ -131,12 +139,12 @@ public:
                     #if DEBUG == 1
                     Serial.println("Repeat_Message_State::displayState: Updating GPS");
                     #endif
-                    NavigationUtils::UpdateGPS();
+                    GPS_Fix fix = NavigationUtils::GetFix();
 
-                    ping->lat = NavigationUtils::GetLocation().lat();
-                    ping->lng = NavigationUtils::GetLocation().lng();
-                    ping->time = NavigationUtils::GetTime().value();
-                    ping->date = NavigationUtils::GetDate().value();
+                    ping->lat = fix.lat();
+                    ping->lng = fix.lng();
+                    ping->time = fix.time;
+                    ping->date = fix.date;
                 }
             }
 
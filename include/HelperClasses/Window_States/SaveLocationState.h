@@ -25,8 +25,9 @@ public:
 
         if (transferData.serializedData == nullptr)
         {
-            lat = NavigationUtils::GetLocation().lat();
-            lon = NavigationUtils::GetLocation().lng();
+            GPS_Fix fix = NavigationUtils::GetFix();
+            lat = fix.lat();
+            lon = fix.lng();
 
             transferData.serializedData = new DynamicJsonDocument(64);
 
@@ -4,6 +4,7 @@
 #include "ScrollWheel.h"
 #include "LED_Utils.h"
 #include "NavigationUtils.h"
+#include "Virtual_List.h"
 
 namespace
 {
@@ -22,6 +23,10 @@ public:
         assignInput(ENC_DOWN, ACTION_DEFER_CALLBACK_TO_WINDOW);
 
         _ScrollWheelPatternID = ScrollWheel::RegisteredPatternID();
+
+        locations.setDataSource(
+            [this]() { return NavigationUtils::GetSavedLocationsSize() + (currentLocationName.empty() ? 0 : 1); },
+            [this](size_t index, SavedLocation &location) { return fetchLocation(index, location); });
     }
 
     ~Select_Location_State()
@@ -35,26 +40,8 @@ public:
         _ScrollWheelPatternID = ScrollWheel::RegisteredPatternID();
         LED_Utils::enablePattern(_ScrollWheelPatternID);
 
-        locations.clear();
-
-        if (transferData.serializedData != nullptr)
-        {
-            DynamicJsonDocument *doc = transferData.serializedData;
-            if (doc->containsKey("Locations") && (*doc)["Locations"].is<JsonArray>())
-            {
-                for (auto loc : (*doc)["Locations"].as<JsonArray>())
-                {
-                    SavedLocation location;
-                    location.Name = loc["Name"].as<std::string>();
-                    location.Latitude = loc["Lat"].as<double>();
-                    location.Longitude = loc["Lng"].as<double>();
-
-                    locations.push_back(location);
-                }
-
-                locationIt = locations.begin();
-            }
-        }
+        // Locations are read from NavigationUtils as they scroll into view
+        locations.reset();
     }
 
     void exitState(State_Transfer_Data &transferData)
@@ -64,14 +51,15 @@ public:
 
         LED_Utils::disablePattern(_ScrollWheelPatternID);
 
-        if (locationIt != locations.end() && transferData.inputID == BUTTON_4)
+        const SavedLocation *location = locations.selected();
+
+        if (location != nullptr && transferData.inputID == BUTTON_4)
         {
             doc = new DynamicJsonDocument(128);
-            auto location = *locationIt;
 
-            (*doc)["Name"] = location.Name;
-            (*doc)["Lat"] = location.Latitude;
-            (*doc)["Lng"] = location.Longitude;
+            (*doc)["Name"] = location->Name;
+            (*doc)["Lat"] = location->Latitude;
+            (*doc)["Lng"] = location->Longitude;
 
             transferData.serializedData = doc;
         }
@@ -84,33 +72,11 @@ public:
         switch (inputID)
         {
         case ENC_UP:
-        {
-            if (locations.size() > 1)
-            {
-                if (locationIt == locations.begin())
-                {
-                    locationIt = locations.end() - 1;
-                }
-                else
-                {
-                    locationIt--;
-                }
-            }
-        }
-        break;
+            locations.scrollUp();
+            break;
         case ENC_DOWN:
-        {
-            if (locations.size() > 1)
-            {
-                locationIt++;
-
-                if (locationIt == locations.end())
-                {
-                    locationIt = locations.begin();
-                }
-            }
-        }
-        break;
+            locations.scrollDown();
+            break;
         default:
             break;
         }
@@ -120,20 +86,20 @@ public:
     {
         Display_Utils::clearContentArea();
 
-        if (locations.size() > 0)
+        const SavedLocation *location = locations.selected();
+
+        if (location != nullptr)
         {
             if (_ScrollWheelPatternID > -1)
             {
                 StaticJsonDocument<128> doc;
 
                 doc["numItems"] = locations.size();
-                doc["currItem"] = std::distance(locations.begin(), locationIt);
+                doc["currItem"] = locations.selectedIndex();
                 LED_Utils::configurePattern(_ScrollWheelPatternID, doc);
                 LED_Utils::iteratePattern(_ScrollWheelPatternID);
             }
 
-            SavedLocation location = *locationIt;
-            
             TextFormat prompt;
             prompt.horizontalAlignment = ALIGN_CENTER_HORIZONTAL;
             prompt.verticalAlignment = TEXT_LINE;
@@ -146,7 +112,7 @@ public:
             locationText.verticalAlignment = TEXT_LINE;
             locationText.line = 3;
 
-            Display_Utils::printFormattedText(location.Name.c_str(), locationText);
+            Display_Utils::printFormattedText(location->Name.c_str(), locationText);
         }
         else
         {
@@ -160,9 +126,42 @@ public:
         display->display();
     }
 
+    // Adds a first row holding the live GPS position under the given name. Pass nullptr to remove it.
+    void setCurrentLocationName(const char *name)
+    {
+        currentLocationName = name == nullptr ? "" : name;
+        locations.invalidate();
+    }
+
 private:
-    std::vector<SavedLocation> locations;
-    std::vector<SavedLocation>::iterator locationIt;
+    bool fetchLocation(size_t index, SavedLocation &location)
+    {
+        if (!currentLocationName.empty())
+        {
+            if (index == 0)
+            {
+                GPS_Fix fix = NavigationUtils::GetFix();
+
+                location.Name = currentLocationName;
+                location.Latitude = fix.lat();
+                location.Longitude = fix.lng();
+                return true;
+            }
+
+            index--;
+        }
+
+        if (index >= NavigationUtils::GetSavedLocationsSize())
+        {
+            return false;
+        }
+
+        location = *(NavigationUtils::GetSavedLocationsBegin() + index);
+        return true;
+    }
+
+    Virtual_List<SavedLocation> locations;
+    std::string currentLocationName;
 
     int _ScrollWheelPatternID;
 };
\ No newline at end of file
@@ -4,7 +4,8 @@
 #include "Saved_Messages_Content.h"
 #include "ScrollWheel.h"
 #include "LED_Utils.h"
-#include <vector>
+#include "LoraUtils.h"
+#include "Virtual_List.h"
 #include <string>
 
 namespace
@@ -27,6 +28,10 @@ public:
     {
         assignInput(BUTTON_3, ACTION_RETURN_FROM_FUNCTIONAL_WINDOW_STATE, "Back");
         assignInput(BUTTON_4, ACTION_RETURN_FROM_FUNCTIONAL_WINDOW_STATE, "Send");
+
+        _Messages.setDataSource(
+            [this]() { return LoraUtils::GetSavedMessageListSize() + (_LocationMessage.empty() ? 0 : 1); },
+            [this](size_t index, std::string &msg) { return fetchMessage(index, msg); });
     }
 
     ~Select_Message_State()
@@ -41,21 +46,8 @@ public:
         _ScrollWheelPatternID = ScrollWheel::RegisteredPatternID();
         LED_Utils::enablePattern(_ScrollWheelPatternID);
 
-        _Messages.clear();
-
-        if (transferData.serializedData != nullptr)
-        {
-            DynamicJsonDocument *doc = transferData.serializedData;
-            if (doc->containsKey("Messages") && (*doc)["Messages"].is<JsonArray>())
-            {
-                for (auto msg : (*doc)["Messages"].as<JsonArray>())
-                {
-                    _Messages.push_back(msg.as<std::string>());
-                }
-
-                _MessageIt = _Messages.begin();
-            }
-        }
+        // Saved messages are read from LoraUtils as they scroll into view
+        _Messages.reset();
     }
 
     void exitState(State_Transfer_Data &transferData)
@@ -64,10 +56,12 @@ public:
 
         LED_Utils::disablePattern(_ScrollWheelPatternID);
 
-        if (_MessageIt != _Messages.end() && transferData.inputID == BUTTON_4)
+        const std::string *msg = _Messages.selected();
+
+        if (msg != nullptr && transferData.inputID == BUTTON_4)
         {
             DynamicJsonDocument *doc = new DynamicJsonDocument(200);
-            (*doc)["Message"] = *_MessageIt;
+            (*doc)["Message"] = *msg;
             transferData.serializedData = doc;
         }
     }
@@ -77,33 +71,11 @@ public:
         switch (inputID)
         {
         case ENC_UP:
-        {
-            if (_Messages.size() > 0)
-            {
-                if (_MessageIt == _Messages.begin())
-                {
-                    _MessageIt = _Messages.end() - 1;
-                }
-                else
-                {
-                    _MessageIt--;
-                }
-            }
-        }
-        break;
+            _Messages.scrollUp();
+            break;
         case ENC_DOWN:
-        {
-            if (_Messages.size() > 0)
-            {
-                _MessageIt++;
-
-                if (_MessageIt == _Messages.end())
-                {
-                    _MessageIt = _Messages.begin();
-                }
-            }
-        }
-        break;
+            _Messages.scrollDown();
+            break;
         default:
             break;
         }
@@ -111,15 +83,16 @@ public:
 
     void displayState()
     {
-        if (_Messages.size() > 0)
-        {
+        const std::string *msg = _Messages.selected();
 
+        if (msg != nullptr)
+        {
             if (_ScrollWheelPatternID > -1)
             {
                 StaticJsonDocument<128> doc;
 
                 doc["numItems"] = _Messages.size();
-                doc["currItem"] = std::distance(_Messages.begin(), _MessageIt);
+                doc["currItem"] = _Messages.selectedIndex();
                 LED_Utils::configurePattern(_ScrollWheelPatternID, doc);
                 LED_Utils::iteratePattern(_ScrollWheelPatternID);
             }
@@ -131,12 +104,12 @@ public:
 
             Display_Utils::printFormattedText(MSG_SELECT, prompt);
 
-            TextFormat msg;
-            msg.horizontalAlignment = ALIGN_CENTER_HORIZONTAL;
-            msg.verticalAlignment = TEXT_LINE;
-            msg.line = 3;
+            TextFormat msgText;
+            msgText.horizontalAlignment = ALIGN_CENTER_HORIZONTAL;
+            msgText.verticalAlignment = TEXT_LINE;
+            msgText.line = 3;
 
-            Display_Utils::printFormattedText(_MessageIt->c_str(), msg);
+            Display_Utils::printFormattedText(msg->c_str(), msgText);
         }
         else
         {
@@ -150,10 +123,38 @@ public:
         display->display();
     }
 
+    // Offers the name of the selected location as the first message. Pass an empty string to remove it.
+    void setLocationMessage(const std::string &locationName)
+    {
+        _LocationMessage = locationName;
+        _Messages.invalidate();
+    }
+
 private:
-    
-    std::vector<std::string> _Messages;
-    std::vector<std::string>::iterator _MessageIt;
+    bool fetchMessage(size_t index, std::string &msg)
+    {
+        if (!_LocationMessage.empty())
+        {
+            if (index == 0)
+            {
+                msg = _LocationMessage;
+                return true;
+            }
+
+            index--;
+        }
+
+        if (index >= LoraUtils::GetSavedMessageListSize())
+        {
+            return false;
+        }
+
+        msg = *(LoraUtils::SavedMessageListBegin() + index);
+        return true;
+    }
+
+    Virtual_List<std::string> _Messages;
+    std::string _LocationMessage;
     uint64_t userID;
 
     int _ScrollWheelPatternID;
@@ -139,6 +139,12 @@ public:
         }
     }
 
+    // Returns the settings list to the top level. Used when the window is reopened.
+    void resetToRoot()
+    {
+        settingsContent->resetToRoot(FilesystemModule::Utilities::SettingsFile());
+    }
+
     JsonVariant getCurrentVariant()
     {
         return settingsContent->getCurrentVariant();
@@ -30,7 +30,7 @@ public:
     {
         Window_State::enterState(transferData);
 
-        Display_Utils::enableRefreshTimer(100);
+        Display_Utils::enableRefreshTimer(100, REFRESH_DEPENDENCY_COMPASS | REFRESH_DEPENDENCY_GPS);
 
         _RingPointID = RingPoint::RegisteredPatternID();
         LED_Utils::enablePattern(_RingPointID);
@@ -87,10 +87,16 @@ public:
 
         Window_State::displayState();
 
-        double distance = NavigationUtils::GetDistanceTo(lat, lng);
+        Geo_Vector vector = {0, 0};
+        bool hasFix = NavigationUtils::GetVectorTo(lat, lng, vector);
+        double distance = vector.distanceM;
 
         char distanceStr[10];
-        if (distance > 2000)
+        if (!hasFix)
+        {
+            sprintf(distanceStr, "-- m");
+        }
+        else if (distance > 2000)
         {
             sprintf(distanceStr, "%.1f km", distance / 1000);
         }
@@ -129,8 +135,8 @@ public:
             distance = ledFxMin;
         }
 
-        double heading = NavigationUtils::GetHeadingTo(lat, lng);
-        int azimuth = NavigationUtils::GetAzimuth();
+        double heading = vector.bearingDeg;
+        float azimuth = NavigationUtils::GetHeading().headingDeg;
 
         float fadeDegrees = -0.075f * distance + 61.5;
         float directionDegrees = heading - azimuth;
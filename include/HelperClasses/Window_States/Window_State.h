@@ -21,7 +21,7 @@ struct State_Transfer_Data
 class Window_State
 {
 public:
-    inline static Adafruit_SSD1306 *display = nullptr;
+    inline static Display_Panel *display = nullptr;
 
     OLED_Content *renderContent = nullptr;
 
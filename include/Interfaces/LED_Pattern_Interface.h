@@ -4,6 +4,15 @@
 #include "FastLED.h"
 #include "ArduinoJson.h"
 
+// How a pattern's layer is combined with the layers beneath it
+enum LED_Blend_Mode : uint8_t
+{
+    LED_BLEND_REPLACE,
+    LED_BLEND_ADD,
+    LED_BLEND_MAX,
+    LED_BLEND_ALPHA,
+};
+
 class LED_Pattern_Interface
 {
 public:
@@ -12,8 +21,20 @@ public:
         animationTicks = 0;
         animationMS = 0;
         startTime = 0;
+        animationStarted = false;
+
+        frameTimeMS = 0;
+        frameDeltaMS = 0;
+        hasFrameTime = false;
+
+        blendMode = LED_BLEND_REPLACE;
+        blendAlpha = 255;
+        zOrder = 0;
     }
 
+    // Patterns are deleted through this interface once unregistered
+    virtual ~LED_Pattern_Interface() {}
+
     // Used to pass custom parameters to the pattern
     // This function will typically follow the pattern of:
     // if (config.containsKey("key")) { key = config["key"]; }
@@ -23,23 +44,56 @@ public:
     void resetPattern() {
         currTick = 0;
         startTime = 0;
+        animationStarted = false;
     }
 
     void setAnimationLengthMS(size_t ms) {
-        animationTicks = ms / msPerTick;
+        // Round up so short animations still get at least the frames they asked for
+        animationTicks = msPerTick > 0 ? (ms + msPerTick - 1) / msPerTick : 0;
         animationMS = ms;
     }
 
+    // Called by LED_Utils before each iterateFrame with the time the frame is scheduled for
+    void setFrameTime(size_t frameMS) {
+        frameDeltaMS = hasFrameTime ? frameMS - frameTimeMS : 0;
+        frameTimeMS = frameMS;
+        hasFrameTime = true;
+    }
+
     void setAnimationLengthTicks(size_t ticks) {
         animationTicks = ticks;
         animationMS = ticks * msPerTick;
     }
 
-    static void setLeds(CRGB *leds, size_t numLeds) {
-        LED_Pattern_Interface::leds = leds;
+    static void setNumLeds(size_t numLeds) {
         LED_Pattern_Interface::numLeds = numLeds;
     }
 
+    // Sets the layer the pattern renders into. The layer is indexed like the LED strip.
+    void setLayer(CRGB *layer) {
+        leds = layer;
+    }
+
+    CRGB *Layer() { return leds; }
+
+    // Range of LEDs the pattern draws to. Only this range of the layer is composited.
+    virtual void GetLayerRange(int &begin, int &end) {
+        begin = 0;
+        end = (int)numLeds - 1;
+    }
+
+    void setBlendMode(LED_Blend_Mode mode, uint8_t alpha = 255) {
+        blendMode = mode;
+        blendAlpha = alpha;
+    }
+
+    LED_Blend_Mode BlendMode() { return blendMode; }
+    uint8_t BlendAlpha() { return blendAlpha; }
+
+    // Layers with a higher z-order are composited on top
+    void setZOrder(int8_t z) { zOrder = z; }
+    int8_t ZOrder() { return zOrder; }
+
     static void setTickRate(size_t ms) {
         msPerTick = ms;
     }
@@ -63,7 +117,8 @@ public:
     static CRGB &ThemeColor() { return themeColor; }
 
 protected:
-    static CRGB *leds;
+    // Layer owned by this pattern. Allocated when the pattern is registered.
+    CRGB *leds = nullptr;
     static size_t numLeds;
     static size_t msPerTick;
     static CRGB &themeColor;
@@ -75,7 +130,27 @@ protected:
     // Current progress of animation
     size_t currTick;
     
-    // Timestamp an animation was started
+    // Frame clock time the animation loop was started
     size_t startTime;
+    bool animationStarted;
+
+    // Scheduled time of the current frame and time since this pattern's previous frame
+    size_t frameTimeMS;
+    size_t frameDeltaMS;
+    bool hasFrameTime;
+
+    // Time since the animation loop started on the frame clock. The first call starts the loop.
+    size_t elapsedMS() {
+        if (!animationStarted) {
+            startTime = frameTimeMS;
+            animationStarted = true;
+        }
+
+        return frameTimeMS - startTime;
+    }
+
+    LED_Blend_Mode blendMode;
+    uint8_t blendAlpha;
+    int8_t zOrder;
 
 };
\ No newline at end of file
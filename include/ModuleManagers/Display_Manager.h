@@ -6,6 +6,7 @@
 #include <map>
 #include <unordered_map>
 #include <vector>
+#include <memory>
 #include "Button_Flash.h"
 #include "LED_Utils.h"
 #include "EventDeclarations.h"
@@ -20,6 +21,7 @@
 #include "SOS_Window.h"
 #include "EditStatusMessagesWindow.h"
 #include "EditSavedLocationsWindow.h"
+#include "NearbyWindow.h"
 #include "Menu_Window.h"
 #include "OTA_Update_Window.h"
 #include "LoraUtils.h"
@@ -29,17 +31,23 @@
 #include "DiagnosticsWindow.h"
 #include "WiFiRpcWindow.h"
 #include "PairBluetoothWindow.h"
+#include "Window_Pool.h"
 
 #include "Lock_State.h"
 
 #include "Select_Content_List_State.h"
 
 #include "globalDefines.h"
+#include "esp_timer.h"
+#include "mbedtls/base64.h"
 // #include "esp_event_base.h"
 
 #define DEBOUNCE_DELAY 100
 #define DISPLAY_COMMAND_QUEUE_LENGTH 1
 
+// Longest script InjectInputsRpc will queue
+#define INPUT_SCRIPT_MAX_INPUTS 64
+
 using callbackPointer = void (*)(uint8_t);
 using inputCallbackPointer = void (*)();
 
@@ -47,7 +55,7 @@ class Display_Manager
 {
 public:
 
-    static Adafruit_SSD1306 display;
+    static Display_Panel display;
 
     static OLED_Window *currentWindow;
     static OLED_Window *rootWindow;
@@ -102,12 +110,26 @@ public:
     static void lockDevice(uint8_t inputID);
     static void openOTAWindow(uint8_t inputID);
     static void openSavedLocationsWindow(uint8_t inputID);
+    static void openNearbyWindow(uint8_t inputID);
     static void openDiagnosticsWindow(uint8_t inputID);
     static void openWiFiRpcWindow(uint8_t inputID);
 
     static void initializeBle(uint8_t inputID);
     // static void callFunctionWindowState(uint8_t inputID);
 
+    // Draws the current window and records frame statistics
+    static void drawCurrentWindow();
+    static const DisplayFrameStats &FrameStats() { return frameStats; }
+    static void ResetFrameStats() { frameStats = DisplayFrameStats(); }
+
+    // UI harness RPCs
+    // Returns draw time and flush statistics for frames drawn by the display task
+    static void GetFrameStatsRpc(JsonDocument &doc);
+    // Returns the current framebuffer as a base64 encoded binary PBM (P4) image
+    static void GetFrameSnapshotRpc(JsonDocument &doc);
+    // Queues the inputIDs in "inputs" and returns at once. A timer sends them to the display task "intervalMS" apart.
+    static void InjectInputsRpc(JsonDocument &doc);
+
     // Input callbacks
     static void processMessageReceived();
     static void openSOS();
@@ -126,12 +148,37 @@ private:
         }
     }
 
+    // Frequently opened windows are constructed once in static storage and reused
+    static Window_Pool_Slot<Menu_Window> menuWindowSlot;
+    static Window_Pool_Slot<Settings_Window> settingsWindowSlot;
+    static Window_Pool_Slot<ReceivedMessagesWindow> receivedMessagesWindowSlot;
+
+    // Returns a pooled window to its slot, or deletes it if it was heap allocated
+    static void releaseWindow(OLED_Window *window);
+
+    static void populateMainMenu(Menu_Window *menuWindow);
+
+    // Registers the data sources used by the adaptive refresh timer
+    static void registerRefreshSources();
+
+    static DisplayFrameStats frameStats;
+
     static TickType_t lastButtonPressTick;
     // static std::vector<uint8_t> getInputsFromNotification(uint32_t notification);
 
     static int lockStateTimerID;
     static Lock_State *lockState;
 
+    // Input script played back by the input script timer
+    static uint8_t inputScript[INPUT_SCRIPT_MAX_INPUTS];
+    static size_t inputScriptLength;
+    static size_t inputScriptNext;
+    static portMUX_TYPE inputScriptLock;
+    static StaticTimer_t inputScriptTimerBuffer;
+    static int inputScriptTimerID;
+
+    static void inputScriptTimerCallback(TimerHandle_t xTimer);
+
     static QueueHandle_t displayCommandQueue;
     static StaticQueue_t displayCommandQueueBuffer;
     static uint8_t displayCommandQueueStorage[DISPLAY_COMMAND_QUEUE_LENGTH * sizeof(DisplayCommandQueueItem)];
@@ -3,6 +3,7 @@
 #include <FastLED.h>
 #include "globalDefines.h"
 #include "Button_Flash.h"
+#include "Ring_Kernels.h"
 #include "Settings_Manager.h"
 #include "LED_Utils.h"
 #include "Display_Utils.h"
@@ -59,6 +60,7 @@ private:
     static StaticTimer_t patternTimerBuffer;
 
     static int buttonFlashPatternID;
+    static Button_Flash *buttonFlash;
 
     static uint8_t r, g, b;
 
@@ -13,6 +13,9 @@ namespace
     const char *USER_LIST_FILENAME PROGMEM = "/SavedUsers.msgpk";
     const char *MESSAGE_LIST_FILENAME PROGMEM = "/SavedMessages.msgpk";
 
+    // Room for one user or saved message while loading
+    const size_t LIST_ELEMENT_CAPACITY = JSON_OBJECT_SIZE(2) + 64;
+
     const size_t MESSAGE_RECEIVE_TIMEOUT_MS = 100;
     const size_t RECEIVE_THREAD_SLEEP_MS = 100;
 
@@ -74,6 +77,12 @@ public:
 
         LoraUtils::Init();
 
+        if (UserListCollectionID() < 0)
+        {
+            UserListCollectionID() = Persistence_Utils::registerCollection(USER_LIST_FILENAME, LoraUtils::SerializeUserInfoList, LoraUtils::UserInfoListMutex());
+            MessageListCollectionID() = Persistence_Utils::registerCollection(MESSAGE_LIST_FILENAME, LoraUtils::SerializeSavedMessageList, LoraUtils::SavedMessageListMutex());
+        }
+
         LoraUtils::UserInfoListUpdated() += SaveUserInfoList;
         this->LoadUserInfoList(); 
 
@@ -82,9 +91,8 @@ public:
 
         if (LoraUtils::GetSavedMessageListSize() == 0)
         {
-            LoraUtils::AddSavedMessage("Meet here");
-            LoraUtils::AddSavedMessage("Point of interest");
-            LoraUtils::AddSavedMessage("I have a quest");
+            LoraUtils::LoadDefaultMessages();
+            LoraUtils::SavedMessageListUpdated().Invoke();
         }
 
         _sendQueue = System_Utils::getQueue(LoraUtils::MessageSendQueueID());
@@ -99,17 +107,17 @@ public:
 
     void RadioTask()
     {
+        HEAP_TASK_TAG(HEAP_TAG_LORA);
+
         while (true)
         {
             StaticJsonDocument<MSG_BASE_SIZE> jsondoc;
 
             if (_Driver->ReceiveMessage(jsondoc, MESSAGE_RECEIVE_TIMEOUT_MS))
             {
-                #if DEBUG == 1
-                Serial.print("Message received: ");
-                serializeJson(jsondoc, Serial);
-                Serial.println();
-                #endif
+                TRACE_SCOPE(TRACE_RADIO_RECEIVE, 0);
+
+                LOG_DEBUG("Radio: message received, type %u", MessageBase::GetMessageTypeFromJson(jsondoc));
                 // Process received message
                 if (MessageBase::GetMessageTypeFromJson(jsondoc) != 0)
                 {
@@ -119,19 +127,19 @@ public:
                     {
                         if (!msg->IsValid())
                         {
-#if DEBUG == 1
-                            Serial.println("Invalid message");
-#endif
+                            LOG_DEBUG("Radio: invalid message");
                             delete msg;   
                             msg = nullptr;
                         }
                         else
                         {
                             // Fill in time received if not set
-                            if (msg->time == 0 && msg->date == 0 && NavigationUtils::IsGPSConnected())
+                            GPS_Fix fix = NavigationUtils::GetFix();
+
+                            if (msg->time == 0 && msg->date == 0 && fix.isValid())
                             {
-                                msg->time = NavigationUtils::GetTime().value();
-                                msg->date = NavigationUtils::GetDate().value();
+                                msg->time = fix.time;
+                                msg->date = fix.date;
                             }
 
                             auto fwd = ShouldMessageBeForwarded(msg);
@@ -165,6 +173,7 @@ public:
                                     auto msgExists = LoraUtils::MessageExists(msg->sender, msg->msgID);
                                     LoraUtils::SetReceivedMessage(msg->sender, msg);
 
+                                    TRACE_SCOPE(TRACE_MESSAGE_RECEIVED, msg->sender);
                                     LoraUtils::MessageReceived().Invoke(msg->sender, !msgExists);
                                 }
 
@@ -180,11 +189,13 @@ public:
             {
                 if (MessageBase::GetMessageTypeFromJson(_SendBuffer) != 0)
                 {
-                    if (!_Driver->SendMessage(_SendBuffer))
+                    TRACE_BEGIN(TRACE_RADIO_SEND, 0);
+                    bool sent = _Driver->SendMessage(_SendBuffer);
+                    TRACE_END(TRACE_RADIO_SEND, 0);
+
+                    if (!sent)
                     {
-                        #if DEBUG == 1
-                        Serial.println("Failed to send message");
-                        #endif
+                        LOG_WARN("Radio: failed to send message");
                     }
                     _SendBuffer.clear();
                     _SendBufferIdle = true;
@@ -318,28 +329,16 @@ public:
 
     // }
 
-    // Event code to save user list to flash
+    // Event code to save user list to flash. The write happens on the persistence task.
     static void SaveUserInfoList()
     {
-        DynamicJsonDocument doc(1024);
-        LoraUtils::SerializeUserInfoList(doc);
-
-        auto returncode = FilesystemModule::Utilities::WriteFile(USER_LIST_FILENAME, doc);
-
-        if (returncode != FilesystemModule::FilesystemReturnCode::FILESYSTEM_OK)
-        {
-            #if DEBUG == 1
-            Serial.print("Failed to save user list. Error code: ");
-            Serial.println((int)returncode);
-            #endif
-        }
+        Persistence_Utils::markDirty(UserListCollectionID());
     }
 
     // Load user list from flash
     void LoadUserInfoList()
     {
-        DynamicJsonDocument doc(1024);
-        auto returncode = FilesystemModule::Utilities::ReadFile(USER_LIST_FILENAME, doc);
+        auto returncode = FilesystemModule::Utilities::ReadArrayFile(USER_LIST_FILENAME, "users", LIST_ELEMENT_CAPACITY, LoraUtils::DeserializeUserInfo);
 
         if (returncode != FilesystemModule::FilesystemReturnCode::FILESYSTEM_OK)
         {
@@ -348,34 +347,30 @@ public:
             Serial.println((int)returncode);
             #endif
         }
-        else
-        {
-            LoraUtils::DeserializeUserInfoList(doc);
-        }
     }
 
-    // Event code to save message list to flash
+    // Event code to save message list to flash. The write happens on the persistence task.
     static void SaveMessageList()
     {
-        DynamicJsonDocument doc(1024);
-        LoraUtils::SerializeSavedMessageList(doc);
+        Persistence_Utils::markDirty(MessageListCollectionID());
+    }
 
-        auto returncode = FilesystemModule::Utilities::WriteFile(MESSAGE_LIST_FILENAME, doc);
+    static int &UserListCollectionID()
+    {
+        static int collectionID = -1;
+        return collectionID;
+    }
 
-        if (returncode != FilesystemModule::FilesystemReturnCode::FILESYSTEM_OK)
-        {
-            #if DEBUG == 1
-            Serial.print("Failed to save message list. Error code: ");
-            Serial.println((int)returncode);
-            #endif
-        }
+    static int &MessageListCollectionID()
+    {
+        static int collectionID = -1;
+        return collectionID;
     }
 
     // Load message list from flash
     void LoadMessageList()
     {
-        DynamicJsonDocument doc(1024);
-        auto returncode = FilesystemModule::Utilities::ReadFile(MESSAGE_LIST_FILENAME, doc);
+        auto returncode = FilesystemModule::Utilities::ReadArrayFile(MESSAGE_LIST_FILENAME, "Messages", LIST_ELEMENT_CAPACITY, LoraUtils::DeserializeSavedMessage);
 
         if (returncode != FilesystemModule::FilesystemReturnCode::FILESYSTEM_OK)
         {
@@ -384,10 +379,6 @@ public:
             Serial.println((int)returncode);
             #endif
         }
-        else
-        {
-            LoraUtils::DeserializeSavedMessageList(doc);
-        }
     }
 
     void SetTaskHandles(TaskHandle_t sendHandle, TaskHandle_t receiveHandle)
@@ -7,6 +7,9 @@
 namespace
 {
     const char *LOCATION_FILE PROGMEM = "/SavedLocations.msgpk";
+
+    // Room for one saved location while loading, name included
+    const size_t LOCATION_ELEMENT_CAPACITY = JSON_OBJECT_SIZE(3) + 64;
 }
 
 // Manager class to iniitialize NavigationUtils
@@ -21,7 +24,20 @@ public:
         Serial.println("NavigationManager::InitializeUtils");
         #endif
         NavigationUtils::Init(compass, gpsInputStream);
+        LoadStoredState();
+    }
+
+    // Preferred for UART GPS modules. The GPS task wakes on received data instead of polling.
+    void InitializeUtils(CompassInterface *compass, HardwareSerial &gpsSerial)
+    {
+        NavigationUtils::Init(compass, gpsSerial);
+        LoadStoredState();
+    }
 
+    // Loads saved locations and compass calibration from flash
+    void LoadStoredState()
+    {
+        RegisterLocationCollection();
         NavigationUtils::SavedLocationsUpdated() += SaveLocationsToFlash;
         this->LoadLocationsFromFlash();
 
@@ -43,6 +59,7 @@ public:
     {
         NavigationUtils::Init(compass);
 
+        RegisterLocationCollection();
         NavigationUtils::SavedLocationsUpdated() += SaveLocationsToFlash;
         this->LoadLocationsFromFlash();
     }
@@ -53,32 +70,30 @@ public:
 
     }
 
+    // Event code to save locations to flash. Bursts of changes are coalesced into one write by Persistence_Utils.
     static void SaveLocationsToFlash()
     {
-        DynamicJsonDocument doc(16000);
+        Persistence_Utils::markDirty(LocationCollectionID());
+    }
 
-        NavigationUtils::SerializeSavedLocations(doc);
-        auto returncode = FilesystemModule::Utilities::WriteFile(LOCATION_FILE, doc);
+    static int &LocationCollectionID()
+    {
+        static int collectionID = -1;
+        return collectionID;
+    }
 
-        if (returncode != FilesystemModule::FilesystemReturnCode::FILESYSTEM_OK)
-        {
-            #if DEBUG == 1
-            Serial.print("Failed to save locations to flash. Error code: ");
-            Serial.println((int)returncode);
-            #endif
-        }
-        else
+    static void RegisterLocationCollection()
+    {
+        if (LocationCollectionID() < 0)
         {
-            #if DEBUG == 1
-            Serial.println("Saved locations to flash.");
-            #endif
+            LocationCollectionID() = Persistence_Utils::registerCollection(LOCATION_FILE, NavigationUtils::SerializeSavedLocations, NavigationUtils::SavedLocationsMutex());
         }
     }
 
     void LoadLocationsFromFlash()
     {
-        DynamicJsonDocument doc(16000);
-        auto returncode = FilesystemModule::Utilities::ReadFile(LOCATION_FILE, doc);
+        // Streamed one location at a time, so the list can grow past what fits in a single document
+        auto returncode = FilesystemModule::Utilities::ReadArrayFile(LOCATION_FILE, "Locations", LOCATION_ELEMENT_CAPACITY, NavigationUtils::DeserializeSavedLocation);
 
         if (returncode != FilesystemModule::FilesystemReturnCode::FILESYSTEM_OK)
         {
@@ -87,9 +102,5 @@ public:
             Serial.println((int)returncode);
             #endif
         }
-        else
-        {
-            NavigationUtils::DeserializeSavedLocations(doc);
-        }
     }
 };
\ No newline at end of file
@@ -64,16 +64,12 @@ namespace RpcModule
                             continue;
                         }
 
-                        #if DEBUG == 1
-                        Serial.print("MsgPack found on channel ");
-                        Serial.print(channelID);
-                        Serial.println(": ");
-                        serializeJson(rpcPayload, Serial);
-                        Serial.println();
-                        #endif
+                        LOG_DEBUG("Rpc: payload on channel %d", channelID);
 
                         if (rpcPayload.containsKey(Utilities::RPC_FUNCTION_NAME_FIELD())) 
                         {
+                            TRACE_SCOPE(TRACE_RPC_CALL, channelID);
+
                             auto result = Utilities::CallRpc(rpcPayload[Utilities::RPC_FUNCTION_NAME_FIELD()].as<std::string>(), rpcPayload);
 
                             if (result != RpcReturnCode::RPC_SUCCESS)
@@ -239,6 +235,8 @@ namespace RpcModule
             Serial.println("Rpc loop started");
             #endif
 
+            HEAP_TASK_TAG(HEAP_TAG_RPC);
+
             Manager *manager = (Manager *)pvParameters;
             manager->RegisterSerialRpc();
             manager->ProcessRpcChannels();
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <Arduino.h>
+#include "ArduinoJson.h"
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+#include <atomic>
+#include <functional>
+
+/*
+    Read-only asset partition. Static data such as default messages, sample locations and factory settings
+    is packed on the host by tools/pack_assets.py and flashed to its own partition. The partition is memory
+    mapped, so assets are read straight from flash without copying them to the heap.
+
+    The partition table needs an entry like:
+        assets, data, 0x40, , 64K
+
+    Layout, all little endian:
+        Asset_Header
+        Asset_Index_Entry[numEntries]   sorted by nameHash
+        name table                      null terminated names
+        payloads                        each aligned to 8 bytes
+*/
+
+#define ASSET_PARTITION_LABEL "assets"
+#define ASSET_PARTITION_SUBTYPE 0x40
+
+// "ASST"
+#define ASSET_MAGIC 0x54535341
+#define ASSET_VERSION 1
+
+#define ASSET_LOCATION_NAME_LENGTH 24
+
+// Assets read by the firmware. tools/assets.json has an example of each.
+#define ASSET_DEFAULT_MESSAGES "messages/default"
+#define ASSET_SAMPLE_LOCATIONS "locations/sample"
+#define ASSET_SETTINGS_DEFAULTS "settings/defaults"
+
+enum Asset_Type : uint16_t
+{
+    ASSET_TYPE_BLOB,
+
+    // count null terminated strings back to back
+    ASSET_TYPE_STRINGS,
+
+    // count Asset_Location records
+    ASSET_TYPE_LOCATIONS,
+
+    // A single MessagePack value
+    ASSET_TYPE_MSGPACK,
+};
+
+struct Asset_Header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t numEntries;
+
+    // Bytes used in the partition, header included
+    uint32_t totalSize;
+
+    // CRC32 of everything after the header
+    uint32_t crc;
+};
+
+struct Asset_Index_Entry
+{
+    // FNV-1a of the name
+    uint32_t nameHash;
+    uint32_t nameOffset;
+    Asset_Type type;
+    uint16_t count;
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct Asset_Location
+{
+    double latitude;
+    double longitude;
+    char name[ASSET_LOCATION_NAME_LENGTH];
+};
+
+// Points into mapped flash. Valid until the partition is unmapped, which never happens at runtime.
+struct Asset_View
+{
+    const uint8_t *data;
+    uint32_t length;
+    Asset_Type type;
+    uint16_t count;
+};
+
+class Asset_Utils
+{
+public:
+    // Maps and validates the partition. Safe to call more than once. Returns false if there is no valid partition.
+    static bool init();
+
+    static bool isMounted() { return _Header != nullptr; }
+
+    // Finds an asset by name. Maps the partition on first use.
+    static bool find(const char *name, Asset_View &view);
+
+    // Calls onString for each string of an ASSET_TYPE_STRINGS asset. Returns false if the asset does not exist.
+    static bool forEachString(const char *name, std::function<void(const char *value)> onString);
+
+    // Returns the records of an ASSET_TYPE_LOCATIONS asset, or nullptr if it does not exist
+    static const Asset_Location *locations(const char *name, uint16_t &count);
+
+    // Deserializes an ASSET_TYPE_MSGPACK asset into doc
+    static bool readDocument(const char *name, JsonDocument &doc);
+
+    static uint32_t Hash(const char *name);
+
+    // Lists the assets in the partition
+    static void GetAssetsRpc(JsonDocument &doc);
+
+protected:
+    // Validates a mapped image. Kept apart from the mapping so the format checks do not depend on the partition API.
+    static bool mount(const uint8_t *base, size_t size);
+
+    static bool mapPartition();
+
+    static const uint8_t *_Base;
+    static const Asset_Header *_Header;
+    static const Asset_Index_Entry *_Index;
+    static spi_flash_mmap_handle_t _MapHandle;
+
+    enum Init_State : uint8_t
+    {
+        ASSET_INIT_NONE,
+        ASSET_INIT_RUNNING,
+        ASSET_INIT_DONE,
+    };
+
+    static std::atomic<uint8_t> _InitState;
+};
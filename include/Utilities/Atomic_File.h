@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// First byte of files written by WriteFileAtomic. 0xC1 is never used by MessagePack, so it cannot start a plain file.
+#define PERSISTED_FILE_MAGIC 0xC1
+#define PERSISTED_FILE_VERSION 1
+
+// Suffix of the file written before it replaces the original
+#define PERSISTED_FILE_TEMP_SUFFIX ".tmp"
+
+namespace FilesystemModule
+{
+    enum FilesystemReturnCode
+    {
+        FILESYSTEM_OK = 0,
+        READ_BUFFER_OVERFLOW = 1,
+        FILE_NOT_FOUND = 2,
+        WRITE_FAILED = 3,
+        READ_ERROR = 4,
+        CHECKSUM_MISMATCH = 5
+    };
+
+    // Prefixes the MessagePack payload of files written by WriteFileAtomic
+    struct Persisted_File_Header
+    {
+        uint8_t magic;
+        uint8_t version;
+        uint16_t reserved;
+        uint32_t length;
+        uint32_t crc;
+    };
+
+    /*
+        The crash safe write behind WriteFileAtomic. The payload goes to <file>.tmp behind a header holding its
+        length and checksum, and the original is only removed once the temporary file reads back complete. Recover()
+        finishes or discards a write interrupted by a reset. A power loss at any point leaves either the old or
+        the new file readable.
+
+        Filesystem provides openRead, openWrite, exists, remove and rename with the SPIFFS semantics, and a static
+        crc32(crc, data, length) that can be chained. Its File has the Arduino File interface.
+        Kept free of Arduino so tools/power_loss_test.cpp can cut the power at every byte of a write on the host.
+    */
+    template <typename Filesystem>
+    class Atomic_File
+    {
+    public:
+        typedef typename Filesystem::File File;
+
+        // writePayload(file, crc) streams the payload into file, sets crc to the checksum of the bytes it wrote and
+        // returns their count. length and crc describe the payload it is expected to write.
+        template <typename Write_Payload>
+        static FilesystemReturnCode Write(Filesystem &fs, const std::string &filename, uint32_t length, uint32_t crc,
+                                          Write_Payload writePayload, size_t *bytesWritten = nullptr)
+        {
+            std::string tempFilename = filename + PERSISTED_FILE_TEMP_SUFFIX;
+
+            Persisted_File_Header header = {};
+            header.magic = PERSISTED_FILE_MAGIC;
+            header.version = PERSISTED_FILE_VERSION;
+            header.length = length;
+            header.crc = crc;
+
+            File file = fs.openWrite(tempFilename.c_str());
+            if (!file)
+            {
+                return FilesystemReturnCode::WRITE_FAILED;
+            }
+
+            size_t written = file.write((const uint8_t *)&header, sizeof(header));
+            uint32_t payloadCrc = 0;
+
+            written += writePayload(file, payloadCrc);
+            file.close();
+
+            if (written != sizeof(header) + length)
+            {
+                fs.remove(tempFilename.c_str());
+                return FilesystemReturnCode::WRITE_FAILED;
+            }
+
+            // The contents changed between producing the checksum and writing the payload
+            if (payloadCrc != crc)
+            {
+                fs.remove(tempFilename.c_str());
+                return FilesystemReturnCode::CHECKSUM_MISMATCH;
+            }
+
+            // Read the temporary file back before the original is touched. A full filesystem can accept bytes
+            // that never reach flash.
+            file = fs.openRead(tempFilename.c_str());
+            bool verified = file && file.peek() == PERSISTED_FILE_MAGIC && CheckHeader(file) == FilesystemReturnCode::FILESYSTEM_OK;
+
+            if (file)
+            {
+                file.close();
+            }
+
+            if (!verified)
+            {
+                fs.remove(tempFilename.c_str());
+                return FilesystemReturnCode::WRITE_FAILED;
+            }
+
+            // SPIFFS cannot rename over an existing file. A reset between these two steps is finished by Recover.
+            if (fs.exists(filename.c_str()))
+            {
+                fs.remove(filename.c_str());
+            }
+
+            if (!fs.rename(tempFilename.c_str(), filename.c_str()))
+            {
+                return FilesystemReturnCode::WRITE_FAILED;
+            }
+
+            if (bytesWritten != nullptr)
+            {
+                *bytesWritten = written;
+            }
+
+            return FilesystemReturnCode::FILESYSTEM_OK;
+        }
+
+        // Finishes or discards a write interrupted by a reset. Returns true if the temporary file replaced filename.
+        static bool Recover(Filesystem &fs, const std::string &filename)
+        {
+            std::string tempFilename = filename + PERSISTED_FILE_TEMP_SUFFIX;
+
+            if (!fs.exists(tempFilename.c_str()))
+            {
+                return false;
+            }
+
+            File file = fs.openRead(tempFilename.c_str());
+            bool complete = false;
+
+            if (file)
+            {
+                complete = file.peek() == PERSISTED_FILE_MAGIC && CheckHeader(file) == FilesystemReturnCode::FILESYSTEM_OK;
+                file.close();
+            }
+
+            // A complete temporary file is newer than the original. An incomplete one was interrupted before the original was touched.
+            if (!complete)
+            {
+                fs.remove(tempFilename.c_str());
+                return false;
+            }
+
+            if (fs.exists(filename.c_str()))
+            {
+                fs.remove(filename.c_str());
+            }
+
+            return fs.rename(tempFilename.c_str(), filename.c_str());
+        }
+
+        // Verifies the header and checksum of a file opened for reading and leaves it positioned at the payload.
+        // Plain files without a header are left at offset 0.
+        static FilesystemReturnCode CheckHeader(File &file)
+        {
+            if (file.peek() != PERSISTED_FILE_MAGIC)
+            {
+                return FilesystemReturnCode::FILESYSTEM_OK;
+            }
+
+            Persisted_File_Header header;
+
+            if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || header.version != PERSISTED_FILE_VERSION)
+            {
+                return FilesystemReturnCode::READ_ERROR;
+            }
+
+            if (file.size() != sizeof(header) + header.length)
+            {
+                return FilesystemReturnCode::CHECKSUM_MISMATCH;
+            }
+
+            uint8_t buffer[64];
+            uint32_t crc = 0;
+            size_t remaining = header.length;
+
+            while (remaining > 0)
+            {
+                size_t chunk = file.read(buffer, std::min(remaining, sizeof(buffer)));
+
+                if (chunk == 0)
+                {
+                    return FilesystemReturnCode::READ_ERROR;
+                }
+
+                crc = Filesystem::crc32(crc, buffer, chunk);
+                remaining -= chunk;
+            }
+
+            if (crc != header.crc)
+            {
+                return FilesystemReturnCode::CHECKSUM_MISMATCH;
+            }
+
+            file.seek(sizeof(header));
+            return FilesystemReturnCode::FILESYSTEM_OK;
+        }
+    };
+}
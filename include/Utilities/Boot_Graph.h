@@ -0,0 +1,162 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+
+#define BOOT_MAX_MODULES 16
+
+// Runs on either core
+#define BOOT_ANY_CORE -1
+
+// Returned by Boot_Graph::claim
+#define BOOT_NONE_READY -1
+#define BOOT_ALL_FINISHED -2
+
+// Returns false if the module failed to initialize. Modules that depend on it are skipped.
+typedef std::function<bool()> Boot_Init_Function;
+
+enum Boot_Module_State : uint8_t
+{
+    BOOT_MODULE_PENDING,
+    BOOT_MODULE_RUNNING,
+    BOOT_MODULE_DONE,
+    BOOT_MODULE_FAILED,
+    BOOT_MODULE_SKIPPED,
+};
+
+struct Boot_Module
+{
+    const char *name;
+    Boot_Init_Function init;
+
+    // Bit n is set if the module waits for module n
+    uint32_t dependencies;
+    int8_t core;
+
+    volatile Boot_Module_State state;
+    int8_t ranOnCore;
+
+    // Relative to the start of run()
+    uint32_t startUS;
+    uint32_t durationUS;
+};
+
+/*
+    The module graph Boot_Utils works through: which module a runner may claim next and which are skipped
+    because a dependency failed. Keeps no lock and does not log, so tools/boot_sim.cpp runs it on the host
+    with its own runner threads. Locking and waking runners are left to Boot_Utils.
+*/
+class Boot_Graph
+{
+public:
+    // Returns the module ID, or -1 if the table is full or a dependency is not registered
+    int add(const char *name, Boot_Init_Function init, uint32_t dependencies, int8_t core)
+    {
+        if (numModules >= BOOT_MAX_MODULES || !init || (dependencies >> numModules) != 0)
+        {
+            return -1;
+        }
+
+        Boot_Module &module = modules[numModules];
+        module = {};
+        module.name = name;
+        module.init = init;
+        module.dependencies = dependencies;
+        module.core = core;
+        module.state = BOOT_MODULE_PENDING;
+        module.ranOnCore = -1;
+
+        return numModules++;
+    }
+
+    // Returns the next module a runner on core can run and marks it running, BOOT_NONE_READY if none is
+    // ready yet, or BOOT_ALL_FINISHED once every module has finished. A runner on BOOT_ANY_CORE takes modules
+    // pinned to either core. Modules found to depend on a failed or skipped module are marked skipped and
+    // added to skipped, if given.
+    int claim(int8_t core, uint32_t *skipped = nullptr)
+    {
+        uint32_t done = 0;
+        uint32_t finished = 0;
+        bool remaining = false;
+        int claimed = BOOT_NONE_READY;
+
+        // Dependencies always have lower IDs, so one pass in ID order sees every dependency's final state
+        for (uint8_t i = 0; i < numModules; i++)
+        {
+            Boot_Module &module = modules[i];
+            uint32_t bit = 1UL << i;
+
+            if (module.state == BOOT_MODULE_DONE)
+            {
+                done |= bit;
+                finished |= bit;
+                continue;
+            }
+
+            if (module.state == BOOT_MODULE_FAILED || module.state == BOOT_MODULE_SKIPPED)
+            {
+                finished |= bit;
+                continue;
+            }
+
+            if (module.state == BOOT_MODULE_PENDING && (module.dependencies & finished) == module.dependencies)
+            {
+                if ((module.dependencies & done) != module.dependencies)
+                {
+                    module.state = BOOT_MODULE_SKIPPED;
+                    finished |= bit;
+
+                    if (skipped != nullptr)
+                    {
+                        *skipped |= bit;
+                    }
+
+                    continue;
+                }
+
+                if (claimed == BOOT_NONE_READY && (core == BOOT_ANY_CORE || module.core == BOOT_ANY_CORE || module.core == core))
+                {
+                    module.state = BOOT_MODULE_RUNNING;
+                    claimed = i;
+                }
+            }
+
+            remaining = true;
+        }
+
+        return remaining ? claimed : BOOT_ALL_FINISHED;
+    }
+
+    void finish(int moduleID, bool success) { modules[moduleID].state = success ? BOOT_MODULE_DONE : BOOT_MODULE_FAILED; }
+
+    // True if some pending module may run on a core other than core
+    bool needsOtherCore(int8_t core) const
+    {
+        for (uint8_t i = 0; i < numModules; i++)
+        {
+            if (modules[i].state == BOOT_MODULE_PENDING && modules[i].core != core)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // True if every module initialized
+    bool succeeded() const
+    {
+        for (uint8_t i = 0; i < numModules; i++)
+        {
+            if (modules[i].state != BOOT_MODULE_DONE)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    Boot_Module modules[BOOT_MAX_MODULES];
+    uint8_t numModules = 0;
+};
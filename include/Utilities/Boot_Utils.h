@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include "ArduinoJson.h"
+#include "Boot_Graph.h"
+#include <initializer_list>
+
+// Stack of the worker that runs modules on the core setup() is not running on
+#define BOOT_WORKER_STACK_SIZE 6144
+
+/*
+    Initializes modules concurrently on both cores in dependency order.
+
+    Modules are registered before run() with the IDs of the modules they depend on. Dependencies
+    must already be registered, so the graph cannot have cycles. run() works through the graph on the
+    calling task and on a worker pinned to the other core, and returns once every module has finished.
+
+        int fs = Boot_Utils::registerModule("Filesystem", [] { FilesystemModule::Manager::Init(); return true; });
+        int lora = Boot_Utils::registerModule("LoRa", [&] { return loraManager.Init(); }, {fs});
+        int nav = Boot_Utils::registerModule("Navigation", [&] { navManager.InitializeUtils(&compass, Serial2); return true; }, {fs});
+        Boot_Utils::registerModule("Display", [] { Display_Manager::init(); return true; }, {lora, nav}, 1);
+        Boot_Utils::run();
+
+    Modules that touch the same peripheral without a lock of their own must depend on each other.
+*/
+class Boot_Utils
+{
+public:
+    // Returns the module ID, or -1 if the table is full or a dependency is not registered.
+    // core pins the module to one core, BOOT_ANY_CORE lets either worker take it.
+    static int registerModule(const char *name, Boot_Init_Function init, std::initializer_list<int> dependencies = {}, int8_t core = BOOT_ANY_CORE);
+
+    // Returns true if every module initialized
+    static bool run();
+
+    static Boot_Module_State ModuleState(int moduleID);
+
+    // Per module timings from the last run, plus the wall time and the time the same work would take run one after another
+    static void GetBootTimingsRpc(JsonDocument &doc);
+
+protected:
+    static void workerTask(void *pvParameters);
+
+    // Runs ready modules for core until nothing is left to run
+    static void runModules(int8_t core);
+
+    // Returns the next module core can run, BOOT_NONE_READY if none is ready yet, or BOOT_ALL_FINISHED once
+    // every module has finished
+    static int claimModule(int8_t core);
+    static void finishModule(int moduleID, bool success);
+
+    // Wakes the other runner, if there is one
+    static void wakeRunners();
+
+    static Boot_Graph _Graph;
+
+    static int64_t _RunStartUS;
+    static uint32_t _RunDurationUS;
+
+    static SemaphoreHandle_t _Mutex;
+    static StaticSemaphore_t _MutexBuffer;
+
+    // Both runners wait here for modules to finish
+    static TaskHandle_t _Runners[2];
+    static SemaphoreHandle_t _WorkerDone;
+    static StaticSemaphore_t _WorkerDoneBuffer;
+};
@@ -3,6 +3,7 @@
 #include <queue>
 #include <memory>
 #include <Arduino.h>
+#include <esp_now.h>
 #include "System_Utils.h"
 // #include "WiFiManager.h"
 // #include "AlooWifiManager.h"
@@ -171,9 +172,15 @@ namespace ConnectivityModule
 
         static void ProcessSettings(JsonDocument &doc)
         {
-            if (doc.containsKey("WiFi Provisioning"))
+            OnProvisioningSettingChanged();
+        }
+
+        // Settings_Registry listener for SETTING_WIFI_PROVISIONING
+        static void OnProvisioningSettingChanged()
+        {
+            if (Settings_Registry::has(SETTING_WIFI_PROVISIONING))
             {
-                auto mode = doc["WiFi Provisioning"]["cfgVal"].as<int>();
+                auto mode = Settings_Registry::getInt(SETTING_WIFI_PROVISIONING);
                 if (mode >= WIFI_PROV_MODE_NONE && mode <= WIFI_PROV_MODE_TEMP_AP)
                 {
                     ProvisioningMode() = static_cast<WiFiProvisioningMode>(mode);
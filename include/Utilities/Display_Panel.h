@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Adafruit_SSD1306.h>
+
+// The SSD1306 the UI draws on. Counts every framebuffer sent to the panel, so frame statistics report what
+// actually went over I2C instead of assuming one flush per frame.
+// display() hides the non-virtual Adafruit_SSD1306::display(), so it is only counted when called through a
+// Display_Panel. The UI holds the panel as one everywhere for that reason.
+class Display_Panel : public Adafruit_SSD1306
+{
+public:
+    using Adafruit_SSD1306::Adafruit_SSD1306;
+
+    // Sends the whole framebuffer to the panel
+    void display()
+    {
+        Adafruit_SSD1306::display();
+
+        // Adafruit_SSD1306::display() always sends every page
+        _Flushes++;
+        _BytesFlushed += WIDTH * ((HEIGHT + 7) / 8);
+    }
+
+    uint32_t Flushes() const { return _Flushes; }
+    uint64_t BytesFlushed() const { return _BytesFlushed; }
+
+private:
+    uint32_t _Flushes = 0;
+    uint64_t _BytesFlushed = 0;
+};
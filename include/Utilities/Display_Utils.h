@@ -1,9 +1,11 @@
 #pragma once
 
+#include <Arduino.h>
 #include "Adafruit_GFX.h"
-#include "System_Utils.h"
+#include "Adafruit_SSD1306.h"
 #include "EventHandler.h"
 #include <string>
+#include <stdarg.h>
 
 enum TextAlignmentHorizontal
 {
@@ -92,12 +94,59 @@ struct DisplayCommandQueueItem
     } commandData;
 };
 
+// Data sources a refreshing screen can depend on.
+// When a screen declares dependencies, the refresh timer only redraws once one of them changes.
+enum RefreshDependency : uint32_t
+{
+    REFRESH_DEPENDENCY_NONE = 0,
+    REFRESH_DEPENDENCY_COMPASS = 1 << 0,
+    REFRESH_DEPENDENCY_GPS = 1 << 1,
+    REFRESH_DEPENDENCY_MESSAGES = 1 << 2,
+    REFRESH_DEPENDENCY_CLOCK = 1 << 3,
+};
+
+#define NUM_REFRESH_DEPENDENCIES 4
+
+// Longest the display task will sleep between dependency checks when nothing is changing
+#define REFRESH_IDLE_MAX_MS 1000
+
+// Returns a value that changes whenever the underlying data changes
+using RefreshSourceFunction = uint32_t (*)();
+
+// Per-frame statistics recorded by the display task
+struct DisplayFrameStats
+{
+    uint32_t frameCount = 0;
+    uint32_t lastDrawTimeUS = 0;
+    uint32_t maxDrawTimeUS = 0;
+    uint64_t totalDrawTimeUS = 0;
+    uint32_t flushes = 0;
+    uint64_t bytesFlushed = 0;
+
+    // Adds a frame that took drawTimeUS and sent the given flushes and bytes to the panel
+    void record(uint32_t drawTimeUS, uint32_t frameFlushes, uint32_t frameBytes)
+    {
+        frameCount++;
+        lastDrawTimeUS = drawTimeUS;
+        totalDrawTimeUS += drawTimeUS;
+        if (drawTimeUS > maxDrawTimeUS)
+        {
+            maxDrawTimeUS = drawTimeUS;
+        }
+
+        flushes += frameFlushes;
+        bytesFlushed += frameBytes;
+    }
+};
+
 class Display_Utils
 {
 public:
 
     // Setters
     static void setDisplay(Adafruit_GFX *display);
+    // Enables direct text blitting into a SSD1306 style paged framebuffer
+    static void setFrameBuffer(uint8_t *buffer);
     static void setDisplayDimensions(size_t width, size_t height);
     static void setRefreshTimerID(int timerID);
     static void setDisplayCommandQueue(QueueHandle_t queue);
@@ -156,6 +205,14 @@ public:
     // Prints a formatted string to the display
     static void printFormattedText(const char *text, TextFormat &format);
 
+    // printf style printFormattedText. The string is formatted into a stack buffer
+    static void printfFormattedText(TextFormat &format, const char *fmt, ...);
+
+    // Prints text at the given cursor position and leaves the cursor after the text.
+    // Single line text that fits on screen is copied straight from the font into the framebuffer,
+    // anything else falls back to Adafruit_GFX::print.
+    static void printText(const char *text, int16_t x, int16_t y);
+
     // Returns the X cursor position for aligning text to the left
     // distanceFrom is the spacing from the left edge of the display in characters
     static uint16_t alignTextLeft(int distanceFrom = 0);
@@ -166,6 +223,13 @@ public:
     // Returns the X cursor position for aligning text to the right using the length of the string
     static uint16_t alignTextRight(const char *text, int distanceFrom = 0);
 
+    // Returns the length of the binary PBM (P4) image writePbm() produces for a width x height frame
+    static size_t pbmLength(size_t width, size_t height);
+
+    // Writes a SSD1306 style paged framebuffer as a binary PBM (P4) image. out must hold pbmLength() bytes.
+    // Returns the number of bytes written.
+    static size_t writePbm(const uint8_t *framebuffer, size_t width, size_t height, uint8_t *out);
+
     // Returns the number of characters in an integer
     static size_t getIntLength(int64_t num);
 
@@ -175,21 +239,46 @@ public:
     // Enables the refresh timer
     static void enableRefreshTimer(size_t timerPeriodMS = 0);
 
+    // Enables the refresh timer for a screen that depends on the given RefreshDependency flags.
+    // timerPeriodMS is the fastest the screen will be redrawn. Redraws are skipped while none of
+    // the dependencies change, and the check interval backs off up to REFRESH_IDLE_MAX_MS.
+    static void enableRefreshTimer(size_t timerPeriodMS, uint32_t dependencies);
+
     // Disables the refresh timer
     static void disableRefreshTimer();
 
     static uint32_t RefreshTimerInterval() { return refreshTimerInterval; }
 
+    // Registers the function used to detect changes for a single dependency flag
+    static void RegisterRefreshSource(RefreshDependency dependency, RefreshSourceFunction source);
+
+    // Refresh source value for a location. Moves below ~1m give the same value, and any invalid location gives 0.
+    static uint32_t LocationRefreshValue(bool valid, double lat, double lng);
+
+    // Returns the time the display task should wait for a command before the next refresh check
+    static uint32_t NextRefreshWaitMS();
+
+    // Called by the display task when the refresh wait elapses. Returns true if the screen should be redrawn.
+    static bool ShouldRefresh();
+
+    // Refresh instrumentation
+    static uint32_t RefreshesDrawn() { return refreshesDrawn; }
+    static uint32_t RefreshesSkipped() { return refreshesSkipped; }
+
     // Command Queue Functions
 
     // Sends an input command to the display command queue
     static void sendInputCommand(uint8_t inputID);
 
+    // Sends an input command without waiting for room in the queue. Returns false if the queue is full.
+    static bool trySendInputCommand(uint8_t inputID);
+
     // Sends a callback command to the display command queue
     static void sendCallbackCommand(uint32_t resourceID);
 
 protected:
     static Adafruit_GFX *display;
+    static uint8_t *frameBuffer;
 
     static size_t displayWidth;
     static size_t displayHeight;
@@ -205,6 +294,15 @@ protected:
     static int refreshTimerID;
     static uint32_t refreshTimerInterval;
 
+    // Adaptive refresh
+    static uint32_t refreshDependencies;
+    static uint32_t refreshWaitMS;
+    static bool forceRefresh;
+    static RefreshSourceFunction refreshSources[NUM_REFRESH_DEPENDENCIES];
+    static uint32_t refreshSourceValues[NUM_REFRESH_DEPENDENCIES];
+    static uint32_t refreshesDrawn;
+    static uint32_t refreshesSkipped;
+
     static QueueHandle_t displayCommandQueue;
 
     // Event handlers
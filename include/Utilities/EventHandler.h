@@ -1,8 +1,94 @@
 #pragma once
 
+#include <Arduino.h>
 #include <vector>
 #include <algorithm>
 
+/*
+    Callback storage shared by the event handlers. Callbacks are added from modules booting on either core while
+    other tasks invoke, so the list is only read or changed under a spinlock. It never allocates inside the lock:
+    a longer list is reserved outside and swapped in. Invoke reads one callback at a time and calls it outside
+    the lock, so callbacks may add or remove handlers. A removal racing an Invoke can skip one callback.
+*/
+template <typename Callback>
+class Callback_List
+{
+public:
+    void add(Callback callback)
+    {
+        std::vector<Callback> grown;
+
+        while (true)
+        {
+            portENTER_CRITICAL(&_lock);
+
+            if (std::find(_callbacks.begin(), _callbacks.end(), callback) != _callbacks.end())
+            {
+                portEXIT_CRITICAL(&_lock);
+                return;
+            }
+
+            if (_callbacks.size() < _callbacks.capacity())
+            {
+                _callbacks.push_back(callback);
+                portEXIT_CRITICAL(&_lock);
+                return;
+            }
+
+            if (_callbacks.size() < grown.capacity())
+            {
+                grown.assign(_callbacks.begin(), _callbacks.end());
+                grown.push_back(callback);
+                _callbacks.swap(grown);
+                portEXIT_CRITICAL(&_lock);
+
+                // grown now holds the old list and frees it here, outside the lock
+                return;
+            }
+
+            size_t needed = _callbacks.size() + 4;
+            portEXIT_CRITICAL(&_lock);
+
+            grown.reserve(needed);
+        }
+    }
+
+    void remove(Callback callback)
+    {
+        portENTER_CRITICAL(&_lock);
+
+        auto it = std::find(_callbacks.begin(), _callbacks.end(), callback);
+        if (it != _callbacks.end())
+        {
+            _callbacks.erase(it);
+        }
+
+        portEXIT_CRITICAL(&_lock);
+    }
+
+    template <typename... Args>
+    void invoke(Args &&...args)
+    {
+        for (size_t i = 0;; i++)
+        {
+            portENTER_CRITICAL(&_lock);
+            Callback callback = i < _callbacks.size() ? _callbacks[i] : nullptr;
+            portEXIT_CRITICAL(&_lock);
+
+            if (callback == nullptr)
+            {
+                return;
+            }
+
+            callback(args...);
+        }
+    }
+
+protected:
+    std::vector<Callback> _callbacks;
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+};
+
 // Generic event handler for callbacks with no arguments
 class EventHandler
 {
@@ -18,7 +104,7 @@ public:
     void Invoke();
 
 protected:
-    std::vector<void (*)()> _callbacks;
+    Callback_List<void (*)()> _callbacks;
 };
 
 // Templated event handler for custom callback arguments
@@ -26,38 +112,25 @@ template <typename... Args>
 class EventHandlerT
 {
 public:
-    EventHandlerT()
-    {
-        _callbacks.clear();
-    }
+    EventHandlerT() {}
 
     // += operator to add a callback
     void operator+=(void (*callback)(Args...))
     {
-        if (std::find(_callbacks.begin(), _callbacks.end(), callback) == _callbacks.end())
-        {
-            _callbacks.push_back(callback);
-        }
+        _callbacks.add(callback);
     }   
 
     // -= operator to remove callback
     void operator-=(void (*callback)(Args...))
     {
-        auto it = std::find(_callbacks.begin(), _callbacks.end(), callback);
-        if (it != _callbacks.end()) 
-        {
-            _callbacks.erase(it);
-        }
+        _callbacks.remove(callback);
     }
     
     void Invoke(Args... args)
     {
-        for (auto &callback : _callbacks) 
-        {
-            callback(args...);
-        }
+        _callbacks.invoke(args...);
     }
 
 protected:
-    std::vector<void (*)(Args...)> _callbacks;
-};
\ No newline at end of file
+    Callback_List<void (*)(Args...)> _callbacks;
+};
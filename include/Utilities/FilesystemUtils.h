@@ -2,6 +2,10 @@
 
 #include "ArduinoJson.h"
 #include "System_Utils.h"
+#include "Log_Utils.h"
+#include "Settings_Registry.h"
+#include "MsgPack_Stream.h"
+#include "Atomic_File.h"
 #include <StreamUtils.h>
 #include <SPIFFS.h>
 #include <string>
@@ -9,15 +13,6 @@
 namespace FilesystemModule
 {
 
-    enum FilesystemReturnCode
-    {
-        FILESYSTEM_OK = 0,
-        READ_BUFFER_OVERFLOW = 1,
-        FILE_NOT_FOUND = 2,
-        WRITE_FAILED = 3,
-        READ_ERROR = 4
-    };
-
     // Static class with helper functions for interacting with the SPIFFS filesystem
     // Data is stored in MessagePack format
     class Utilities
@@ -32,22 +27,23 @@ namespace FilesystemModule
                 vTaskDelay(pdMS_TO_TICKS(1000));
                 ESP.restart();
             }
+
+            // Created at mount, before any task writes
+            WriteMutex();
+            RecoverFiles();
         }
 
+        // Held by every write, rename and removal so two tasks never touch the same temporary file
+        static SemaphoreHandle_t WriteMutex();
+
         // Reads a file from the SPIFFS filesystem into a JsonDocument
         static FilesystemReturnCode ReadFile(std::string filename, JsonDocument &doc)
         {   
-            #if DEBUG == 1
-            Serial.print("Reading file: ");
-            Serial.println(filename.c_str());
-            #endif
+            LOG_DEBUG("Reading file: %s", filename);
 
             if (!SPIFFS.exists(filename.c_str()))
             {
-                #if DEBUG == 1
-                Serial.print("File not found: ");
-                Serial.println(filename.c_str());
-                #endif
+                LOG_DEBUG("File not found: %s", filename);
                 return FilesystemReturnCode::FILE_NOT_FOUND;
             }
         
@@ -55,42 +51,36 @@ namespace FilesystemModule
         
             if (!file)
             {
-                #if DEBUG == 1
-                Serial.print("Failed to open file: ");
-                Serial.println(filename.c_str());
-                #endif
+                LOG_WARN("Failed to open file: %s", filename);
                 return FilesystemReturnCode::READ_ERROR;
             }
         
+            // Skips the header of files written by WriteFileAtomic. Plain files start at offset 0.
+            auto headerCode = CheckFileHeader(file);
+
+            if (headerCode != FilesystemReturnCode::FILESYSTEM_OK)
+            {
+                LOG_WARN("Corrupt file: %s", filename);
+                file.close();
+                return headerCode;
+            }
+
             deserializeMsgPack(doc, file); 
             file.close();
         
             if (doc.overflowed())
             {
-                #if DEBUG == 1
-                Serial.print("Buffer overflow while reading file: ");
-                Serial.println(filename.c_str());
-                #endif
+                LOG_WARN("Buffer overflow while reading file: %s", filename);
                 return FilesystemReturnCode::READ_BUFFER_OVERFLOW;
             }
         
             if (doc.isNull())
             {
-                #if DEBUG == 1
-                Serial.print("Failed to deserialize file: ");
-                Serial.println(filename.c_str());
-                #endif
+                LOG_WARN("Failed to deserialize file: %s", filename);
                 return FilesystemReturnCode::READ_ERROR;
             }
-            else
-            {
-                #if DEBUG == 1
-                Serial.print("File read successfully: ");
-                Serial.println(filename.c_str());
-                serializeJson(doc, Serial);
-                Serial.println();
-                #endif
-            }
+
+            LOG_VERBOSE("File read successfully: %s (%u bytes as JSON)", filename, measureJson(doc));
             return FilesystemReturnCode::FILESYSTEM_OK;
         }
 
@@ -104,14 +94,19 @@ namespace FilesystemModule
             // Serial.println();
             #endif
 
+            xSemaphoreTake(WriteMutex(), portMAX_DELAY);
+
             File file = SPIFFS.open(filename.c_str(), FILE_WRITE);
             if (!file)
             {
+                xSemaphoreGive(WriteMutex());
                 return FilesystemReturnCode::WRITE_FAILED;
             }
         
             auto bytesWritten = serializeMsgPack(doc, file);
             file.close();
+
+            xSemaphoreGive(WriteMutex());
         
             if (bytesWritten == 0)
             {
@@ -121,6 +116,24 @@ namespace FilesystemModule
             return FilesystemReturnCode::FILESYSTEM_OK;
         }
 
+        // Writes to a temporary file with a checksummed header, then replaces filename with it.
+        // A power loss at any point leaves either the old or the new file readable by ReadFile.
+        static FilesystemReturnCode WriteFileAtomic(const std::string &filename, JsonDocument &doc, size_t *bytesWritten = nullptr);
+
+        // Like WriteFileAtomic, but the payload is streamed by produce instead of held in a JsonDocument.
+        // produce is called twice, once to checksum the payload and once to write it. It must write the same bytes both times.
+        static FilesystemReturnCode WriteFileStreamed(const std::string &filename, MsgPack_Producer produce, size_t *bytesWritten = nullptr);
+
+        // Streams the elements of the array stored under key in a file shaped like {key: [...]}.
+        // Only one element is held in memory at a time, in a document of elementCapacity bytes.
+        static FilesystemReturnCode ReadArrayFile(const std::string &filename, const char *key, size_t elementCapacity, MsgPack_Element_Callback onElement);
+
+        // Removes a file, waiting for any write in progress
+        static void RemoveFile(const std::string &filename);
+
+        // Verifies the header and checksum of a file opened for reading and leaves it positioned at the payload
+        static FilesystemReturnCode CheckFileHeader(File &file);
+
         // Loads the settings file from the given path
         // static FilesystemReturnCode LoadSettingsFile(std::string filename)
         // {
@@ -138,7 +151,8 @@ namespace FilesystemModule
         // Settings file getter
         static JsonDocument &SettingsFile() { return _SettingsFile; }
 
-        static FilesystemReturnCode LoadSettingsFile(JsonDocument &doc) { return ReadFile(SettingsFileName(), doc); }
+        // Reads the settings file and applies the settings delta over it
+        static FilesystemReturnCode LoadSettingsFile(JsonDocument &doc);
 
         static std::string &SettingsFileName()
         {
@@ -152,31 +166,22 @@ namespace FilesystemModule
         // Settings file setter
         static FilesystemReturnCode WriteSettingsFile(std::string filename, JsonDocument &doc) 
         {
-            auto returncode = WriteFile(SettingsFileName(), doc);
-            if (returncode == FilesystemReturnCode::FILESYSTEM_OK && &doc != &_SettingsFile)
+            auto returncode = WriteFileAtomic(SettingsFileName(), doc);
+            if (returncode == FilesystemReturnCode::FILESYSTEM_OK)
             {
-                _SettingsFile.set(doc);
+                if (&doc != &_SettingsFile)
+                {
+                    _SettingsFile.set(doc);
+                }
+
+                Settings_Registry::clearDelta();
+                Settings_Registry::syncFromDocument(_SettingsFile);
             }
             return returncode;
         }
 
-        static FilesystemReturnCode WriteSettingsFileToFlash()
-        {
-            if (SettingsFileName().length() == 0 || SettingsFile().isNull())
-            {
-                Serial.println("Settings file not loaded.");
-                return FilesystemReturnCode::WRITE_FAILED;
-            }
-
-            
-            auto returnCode = WriteFile(SettingsFileName(), SettingsFile());
-            if (returnCode == FilesystemReturnCode::FILESYSTEM_OK)
-            {
-                _SettingsUpdated.Invoke(SettingsFile());
-            }
-
-            return returnCode;
-        }
+        // Rewrites the whole settings file. Settings in the registry are better saved with Settings_Registry::persist().
+        static FilesystemReturnCode WriteSettingsFileToFlash();
 
         static void RpcGetSettingsFile(JsonDocument &doc)
         {
@@ -202,10 +207,22 @@ namespace FilesystemModule
 
             // serializeJson(doc, Serial);
 
-            SettingsFile()[key]["cfgVal"] = value;
+            bool success;
+            Setting_Key settingKey = Settings_Registry::Find(key.c_str());
+
+            if (settingKey != NUM_SETTINGS)
+            {
+                Settings_Registry::setFromString(settingKey, value.c_str());
+                success = Settings_Registry::persist();
+            }
+            else
+            {
+                SettingsFile()[key]["cfgVal"] = value;
+                success = WriteSettingsFileToFlash() == FilesystemReturnCode::FILESYSTEM_OK;
+            }
 
             doc.clear();
-            doc["Success"] = WriteSettingsFileToFlash() == FilesystemReturnCode::FILESYSTEM_OK;
+            doc["Success"] = success;
         }
 
         static void RpcUpdateSettings(JsonDocument &doc) 
@@ -215,15 +232,35 @@ namespace FilesystemModule
             if (doc.containsKey("Settings") && doc["Settings"].is<JsonArray>())
             {
                 auto settingsArray = doc["Settings"].as<JsonArray>();
+                bool unregisteredKeys = false;
+
                 for (auto setting : settingsArray)
                 {
                     auto key = setting["SettingKey"].as<std::string>();
                     auto value = setting["SettingValue"].as<std::string>();
 
-                    SettingsFile()[key]["cfgVal"] = value;
+                    Setting_Key settingKey = Settings_Registry::Find(key.c_str());
+
+                    if (settingKey != NUM_SETTINGS)
+                    {
+                        Settings_Registry::setFromString(settingKey, value.c_str());
+                    }
+                    else
+                    {
+                        SettingsFile()[key]["cfgVal"] = value;
+                        unregisteredKeys = true;
+                    }
                 }
 
-                success = WriteSettingsFileToFlash() == FilesystemReturnCode::FILESYSTEM_OK;
+                // Keys outside the registry are only saved by a full write, which also covers the registered ones
+                if (unregisteredKeys)
+                {
+                    success = WriteSettingsFileToFlash() == FilesystemReturnCode::FILESYSTEM_OK;
+                }
+                else
+                {
+                    success = Settings_Registry::persist();
+                }
             }
             else
             {
@@ -238,11 +275,17 @@ namespace FilesystemModule
         static EventHandlerT<ArduinoJson::JsonDocument &> &SettingsUpdated() { return _SettingsUpdated; }
 
     protected:
+        // Finishes or discards every WriteFileAtomic interrupted by a reset. Only run at mount, before anything writes.
+        static void RecoverFiles();
+
         // Settings File
         static DynamicJsonDocument _SettingsFile;
         static std::string _SettingsFilename;
 
         // Event handler for settings file updates
         static EventHandlerT<ArduinoJson::JsonDocument &> _SettingsUpdated;
+
+        static SemaphoreHandle_t _WriteMutex;
+        static StaticSemaphore_t _WriteMutexBuffer;
     };
 };
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+
+// GPS state published by the GPS task after every complete NMEA sentence.
+// lat(), lng() and isValid() match TinyGPSLocation so a fix can stand in for one.
+struct GPS_Fix
+{
+    double latitude;
+    double longitude;
+
+    // hhmmsscc and ddmmyy, as TinyGPSTime::value() and TinyGPSDate::value()
+    uint32_t time;
+    uint32_t date;
+
+    float hdop;
+    float speedKmph;
+    float courseDeg;
+    uint8_t satellites;
+
+    bool locationValid;
+    bool timeValid;
+    bool dateValid;
+    bool courseValid;
+
+    // millis() when the location was last updated
+    uint32_t locationMS;
+
+    uint32_t passedChecksums;
+    uint32_t failedChecksums;
+
+    double lat() const { return latitude; }
+    double lng() const { return longitude; }
+    bool isValid() const { return locationValid; }
+    uint32_t age() const { return locationValid ? millis() - locationMS : UINT32_MAX; }
+
+    // Takes the parser's state after a complete sentence. A template over TinyGPSPlus, so tools that have no
+    // TinyGPS++ can still use GPS_Fix.
+    template <typename Parser>
+    static GPS_Fix FromParser(Parser &gps)
+    {
+        GPS_Fix fix = {};
+
+        fix.locationValid = gps.location.isValid();
+
+        if (fix.locationValid)
+        {
+            fix.latitude = gps.location.lat();
+            fix.longitude = gps.location.lng();
+            fix.locationMS = millis() - gps.location.age();
+        }
+
+        fix.timeValid = gps.time.isValid();
+        fix.time = gps.time.value();
+        fix.dateValid = gps.date.isValid();
+        fix.date = gps.date.value();
+
+        fix.hdop = gps.hdop.hdop();
+        fix.speedKmph = gps.speed.kmph();
+        fix.courseValid = gps.course.isValid();
+        fix.courseDeg = gps.course.deg();
+        fix.satellites = gps.satellites.value();
+
+        fix.passedChecksums = gps.passedChecksum();
+        fix.failedChecksums = gps.failedChecksum();
+
+        return fix;
+    }
+};
+
+// Time of a GPS_Fix with the accessors of TinyGPSTime
+struct GPS_Time
+{
+    uint32_t time;
+    bool valid;
+
+    uint32_t value() const { return time; }
+    bool isValid() const { return valid; }
+    uint8_t hour() const { return time / 1000000; }
+    uint8_t minute() const { return (time / 10000) % 100; }
+    uint8_t second() const { return (time / 100) % 100; }
+    uint8_t centisecond() const { return time % 100; }
+};
+
+// Date of a GPS_Fix with the accessors of TinyGPSDate
+struct GPS_Date
+{
+    uint32_t date;
+    bool valid;
+
+    uint32_t value() const { return date; }
+    bool isValid() const { return valid; }
+    uint16_t year() const { return 2000 + date % 100; }
+    uint8_t month() const { return (date / 100) % 100; }
+    uint8_t day() const { return date / 10000; }
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Same sphere as TinyGPSPlus::distanceBetween, so projected and great circle results agree
+#define GEO_EARTH_RADIUS_M 6371009.0
+
+// Beyond this distance from the projection origin, Geo_Projection falls back to the great circle formulas
+#define GEO_PROJECTION_RANGE_M 50000.0f
+
+// NavigationUtils moves the projection origin to the current fix once the fix is this far from it
+#define GEO_PROJECTION_REFRESH_M 2000.0f
+
+#define GEO_E7 10000000.0
+
+// Meters along a meridian per 1e-7 degree
+#define GEO_METERS_PER_E7 ((float)(GEO_EARTH_RADIUS_M * M_PI / 180.0 / GEO_E7))
+
+// Position in 1e-7 degrees, about 1 cm. Differences between points are exact integers.
+struct Geo_Point_E7
+{
+    int32_t latE7;
+    int32_t lngE7;
+};
+
+struct Geo_Vector
+{
+    float distanceM;
+
+    // Degrees clockwise from north, 0 to 360
+    float bearingDeg;
+};
+
+// Great circle reference formulas, in double precision
+class Geo_Math
+{
+public:
+    static Geo_Point_E7 toE7(double lat, double lng)
+    {
+        return {(int32_t)lround(lat * GEO_E7), (int32_t)lround(lng * GEO_E7)};
+    }
+
+    static double toDegrees(int32_t e7) { return e7 / GEO_E7; }
+
+    // As TinyGPSPlus::distanceBetween
+    static double distanceBetween(double lat1, double lng1, double lat2, double lng2)
+    {
+        double delta = toRadians(lng1 - lng2);
+        double sdlong = sin(delta);
+        double cdlong = cos(delta);
+
+        lat1 = toRadians(lat1);
+        lat2 = toRadians(lat2);
+
+        double slat1 = sin(lat1);
+        double clat1 = cos(lat1);
+        double slat2 = sin(lat2);
+        double clat2 = cos(lat2);
+
+        delta = (clat1 * slat2) - (slat1 * clat2 * cdlong);
+        delta = delta * delta;
+        delta += (clat2 * sdlong) * (clat2 * sdlong);
+        delta = sqrt(delta);
+
+        double denom = (slat1 * slat2) + (clat1 * clat2 * cdlong);
+        return atan2(delta, denom) * GEO_EARTH_RADIUS_M;
+    }
+
+    // As TinyGPSPlus::courseTo
+    static double courseTo(double lat1, double lng1, double lat2, double lng2)
+    {
+        double dlon = toRadians(lng2 - lng1);
+
+        lat1 = toRadians(lat1);
+        lat2 = toRadians(lat2);
+
+        double a1 = sin(dlon) * cos(lat2);
+        double a2 = cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(dlon);
+        a2 = atan2(a1, a2);
+
+        if (a2 < 0.0)
+        {
+            a2 += 2 * M_PI;
+        }
+
+        return a2 * 180.0 / M_PI;
+    }
+
+    static Geo_Vector greatCircle(Geo_Point_E7 from, Geo_Point_E7 to)
+    {
+        double lat1 = toDegrees(from.latE7);
+        double lng1 = toDegrees(from.lngE7);
+        double lat2 = toDegrees(to.latE7);
+        double lng2 = toDegrees(to.lngE7);
+
+        return {(float)distanceBetween(lat1, lng1, lat2, lng2), (float)courseTo(lat1, lng1, lat2, lng2)};
+    }
+
+private:
+    static double toRadians(double deg) { return deg * M_PI / 180.0; }
+};
+
+/*
+    Local tangent plane around an origin, giving meters east and north of it.
+
+    Only the origin's trig is computed in double precision. Latitude and longitude differences are taken in integers,
+    then scaled in single precision with the longitude scale at the midpoint latitude. Within GEO_PROJECTION_RANGE_M
+    this is within 0.01% of the great circle distance and 0.01 degrees of its course, and needs no double precision
+    trig per target. Points outside the range are handed to the Geo_Math great circle formulas.
+
+    Kept free of Arduino so tools/geo_bench.cpp can check it on the host.
+*/
+class Geo_Projection
+{
+public:
+    Geo_Projection() {}
+    Geo_Projection(Geo_Point_E7 origin) { setOrigin(origin); }
+
+    void setOrigin(Geo_Point_E7 origin)
+    {
+        double latRad = Geo_Math::toDegrees(origin.latE7) * M_PI / 180.0;
+
+        originPoint = origin;
+        cosLat = (float)cos(latRad);
+        sinLat = (float)sin(latRad);
+        hasOrigin = true;
+    }
+
+    bool valid() const { return hasOrigin; }
+    Geo_Point_E7 origin() const { return originPoint; }
+
+    // Meters east and north of the origin
+    void project(Geo_Point_E7 point, float &east, float &north) const
+    {
+        int32_t dLat = point.latE7 - originPoint.latE7;
+        int64_t dLng = wrapE7(point.lngE7 - (int64_t)originPoint.lngE7);
+
+        north = dLat * GEO_METERS_PER_E7;
+
+        // cos(lat0 + d / 2) ~ cos(lat0) - sin(lat0) d / 2
+        float midCos = cosLat - sinLat * (north * (float)(0.5 / GEO_EARTH_RADIUS_M));
+        east = (float)dLng * GEO_METERS_PER_E7 * midCos;
+    }
+
+    bool inRange(float east, float north) const
+    {
+        return fabsf(east) < GEO_PROJECTION_RANGE_M && fabsf(north) < GEO_PROJECTION_RANGE_M;
+    }
+
+    // Meters from the origin, or infinity when the point is out of range
+    float distanceFromOrigin(Geo_Point_E7 point) const
+    {
+        float east;
+        float north;
+        project(point, east, north);
+
+        return inRange(east, north) ? sqrtf(east * east + north * north) : INFINITY;
+    }
+
+    Geo_Vector vectorTo(Geo_Point_E7 from, Geo_Point_E7 to) const
+    {
+        Geo_Vector vector;
+        vectorsTo(from, &to, 1, &vector);
+        return vector;
+    }
+
+    // Distance and bearing from one point to each of numTargets targets
+    void vectorsTo(Geo_Point_E7 from, const Geo_Point_E7 *targets, size_t numTargets, Geo_Vector *vectors) const
+    {
+        float fromEast = 0;
+        float fromNorth = 0;
+        bool fromInRange = hasOrigin;
+
+        if (fromInRange)
+        {
+            project(from, fromEast, fromNorth);
+            fromInRange = inRange(fromEast, fromNorth);
+        }
+
+        // Trig at the from point, stepped from the origin's
+        float fromOffset = fromNorth * (float)(1.0 / GEO_EARTH_RADIUS_M);
+        float fromCos = cosLat - sinLat * fromOffset;
+        float fromSin = sinLat + cosLat * fromOffset;
+
+        for (size_t i = 0; i < numTargets; i++)
+        {
+            if (fromInRange)
+            {
+                int32_t dLat = targets[i].latE7 - from.latE7;
+                float north = dLat * GEO_METERS_PER_E7;
+
+                float halfLat = north * (float)(0.5 / GEO_EARTH_RADIUS_M);
+                float midCos = fromCos - fromSin * halfLat;
+                float midSin = fromSin + fromCos * halfLat;
+
+                float dLng = wrapE7(targets[i].lngE7 - (int64_t)from.lngE7) * (float)(M_PI / 180.0 / GEO_E7);
+                float east = dLng * (float)GEO_EARTH_RADIUS_M * midCos;
+
+                if (inRange(east, north))
+                {
+                    // The initial great circle course turns poleward of the straight line by half the meridian convergence
+                    float bearing = (atan2f(east, north) - 0.5f * dLng * midSin) * (float)(180.0 / M_PI);
+
+                    vectors[i].distanceM = sqrtf(east * east + north * north);
+                    vectors[i].bearingDeg = bearing < 0 ? bearing + 360.0f : bearing;
+                    continue;
+                }
+            }
+
+            vectors[i] = Geo_Math::greatCircle(from, targets[i]);
+        }
+    }
+
+private:
+    // Shortest way around the antimeridian
+    static int64_t wrapE7(int64_t dLng)
+    {
+        if (dLng > 1800000000LL)
+        {
+            return dLng - 3600000000LL;
+        }
+
+        if (dLng < -1800000000LL)
+        {
+            return dLng + 3600000000LL;
+        }
+
+        return dLng;
+    }
+
+    Geo_Point_E7 originPoint = {0, 0};
+    float cosLat = 1;
+    float sinLat = 0;
+    bool hasOrigin = false;
+};
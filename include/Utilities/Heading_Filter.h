@@ -0,0 +1,124 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// Tuning for Heading_Filter
+struct Heading_Filter_Config
+{
+    // Time for the output to cover ~63% of a step in the magnetometer heading
+    float magTimeConstantS = 0.35f;
+
+    // GPS course is ignored below minimum speed and given its full weight from full speed
+    float gpsMinSpeedKmph = 3.0f;
+    float gpsFullSpeedKmph = 10.0f;
+    float gpsMaxWeight = 0.6f;
+
+    // Magnetometer jitter, in degrees RMS, that halves the confidence
+    float jitterHalfConfidenceDeg = 12.0f;
+
+    // Time constant of the jitter estimate
+    float jitterTimeConstantS = 2.0f;
+};
+
+/*
+    Complementary filter over compass headings in degrees clockwise from north.
+
+    Each magnetometer sample pulls the estimate toward it through a first order low pass, taken on the
+    circle so 359 and 1 average to 0. When moving, the target is first pulled toward the GPS course in
+    proportion to speed, which corrects slow magnetometer errors while walking or riding.
+
+    Confidence falls with magnetometer jitter and rises when the GPS course agrees with the estimate.
+    Kept free of Arduino and FreeRTOS so tools/heading_replay.cpp can run it on recorded traces.
+*/
+class Heading_Filter
+{
+public:
+    Heading_Filter() {}
+    Heading_Filter(const Heading_Filter_Config &config) : config(config) {}
+
+    void reset()
+    {
+        initialized = false;
+        headingDeg = 0;
+        jitterVariance = 0;
+        currentGpsWeight = 0;
+        currentConfidence = 0;
+    }
+
+    // Folds in one magnetometer sample taken dtS seconds after the last. Pass courseValid false when
+    // there is no recent GPS course.
+    void update(float magHeadingDeg, float dtS, float courseDeg, float speedKmph, bool courseValid)
+    {
+        magHeadingDeg = wrap360(magHeadingDeg);
+
+        if (!initialized)
+        {
+            headingDeg = magHeadingDeg;
+            jitterVariance = 0;
+            initialized = true;
+        }
+
+        currentGpsWeight = 0;
+
+        if (courseValid && speedKmph > config.gpsMinSpeedKmph)
+        {
+            float speedRange = config.gpsFullSpeedKmph - config.gpsMinSpeedKmph;
+            float speedFraction = speedRange > 0 ? (speedKmph - config.gpsMinSpeedKmph) / speedRange : 1.0f;
+            currentGpsWeight = config.gpsMaxWeight * (speedFraction < 1.0f ? speedFraction : 1.0f);
+        }
+
+        float targetDeg = wrap360(magHeadingDeg + currentGpsWeight * wrap180(courseDeg - magHeadingDeg));
+        float innovation = wrap180(targetDeg - headingDeg);
+
+        float alpha = dtS / (config.magTimeConstantS + dtS);
+        headingDeg = wrap360(headingDeg + alpha * innovation);
+
+        // Jitter is measured against the filtered heading, so steady turns count less than noise
+        float jitterAlpha = dtS / (config.jitterTimeConstantS + dtS);
+        jitterVariance += jitterAlpha * (innovation * innovation - jitterVariance);
+
+        float halfVariance = config.jitterHalfConfidenceDeg * config.jitterHalfConfidenceDeg;
+        float confidence = halfVariance / (halfVariance + jitterVariance);
+
+        if (currentGpsWeight > 0)
+        {
+            // Agreement within ~20 degrees raises confidence, disagreement lowers it
+            float agreement = cosf(wrap180(courseDeg - headingDeg) * (float)M_PI / 180.0f);
+            float gpsFactor = 0.5f + 0.5f * agreement;
+            confidence = confidence * (1.0f - currentGpsWeight) + gpsFactor * currentGpsWeight;
+        }
+
+        currentConfidence = (uint8_t)(confidence * 100.0f + 0.5f);
+    }
+
+    bool valid() const { return initialized; }
+    float heading() const { return headingDeg; }
+
+    // 0 to 100
+    uint8_t confidence() const { return currentConfidence; }
+
+    // Share of the last update taken from the GPS course
+    float gpsWeight() const { return currentGpsWeight; }
+
+    static float wrap360(float deg)
+    {
+        deg = fmodf(deg, 360.0f);
+        return deg < 0 ? deg + 360.0f : deg;
+    }
+
+    static float wrap180(float deg)
+    {
+        deg = wrap360(deg);
+        return deg > 180.0f ? deg - 360.0f : deg;
+    }
+
+private:
+    Heading_Filter_Config config;
+
+    bool initialized = false;
+    float headingDeg = 0;
+    float jitterVariance = 0;
+    float currentGpsWeight = 0;
+    uint8_t currentConfidence = 0;
+};
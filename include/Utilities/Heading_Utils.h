@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Arduino.h>
+#include "ArduinoJson.h"
+#include "CompassInterface.h"
+#include "Heading_Filter.h"
+#include <atomic>
+
+#define HEADING_SAMPLE_PERIOD_MS 50
+
+// The compass is read over I2C, which can block, so sampling runs on its own task rather than the timer daemon
+#define HEADING_TASK_STACK_SIZE 3072
+#define HEADING_TASK_PRIORITY 1
+
+// GPS course older than this is left out of the filter
+#define HEADING_GPS_MAX_AGE_MS 2000
+
+struct Heading_Estimate
+{
+    // Degrees clockwise from north
+    float headingDeg;
+
+    // 0 to 100
+    uint8_t confidence;
+
+    // Share of the heading taken from the GPS course, 0 when stationary
+    float gpsWeight;
+
+    // millis() of the sample
+    uint32_t updatedMS;
+
+    bool valid;
+};
+
+/*
+    Samples the compass on a task every HEADING_SAMPLE_PERIOD_MS and runs it through a Heading_Filter with
+    the GPS course, so the LED ring and displays read one smoothed heading instead of polling the compass.
+
+    Sampling pauses while the compass is calibrated. GetHeadingRpc reports the estimate and what an update costs.
+*/
+class Heading_Utils
+{
+public:
+    static void init(CompassInterface *compass);
+
+    static Heading_Estimate GetHeading();
+
+    // Heading rounded to whole degrees, or -1 before the first sample. Stands in for a compass azimuth.
+    static int GetAzimuth();
+
+    static void pause();
+    static void resume();
+
+    static void GetHeadingRpc(JsonDocument &doc);
+
+private:
+    static void sampleTask(void *pvParameters);
+    static void sample();
+
+    static CompassInterface *_Compass;
+
+    // Only touched by the sample task
+    static Heading_Filter _Filter;
+
+    static Heading_Estimate _Estimate;
+    static portMUX_TYPE _EstimateLock;
+
+    static uint32_t _LastSampleMS;
+    static std::atomic<bool> _Paused;
+
+    // Set by resume. The sample task resets the filter before its next sample.
+    static std::atomic<bool> _ResetRequested;
+
+    static uint32_t _Updates;
+    static uint32_t _LastUpdateUS;
+    static uint32_t _MaxUpdateUS;
+    static uint64_t _TotalUpdateUS;
+
+    static int _SampleTaskID;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <Arduino.h>
+#include "ArduinoJson.h"
+#include "esp_heap_caps.h"
+
+// Set to 1 to route operator new and delete through the tag accounting. With 0 only heap snapshots are taken
+// and every HEAP_ macro compiles to nothing.
+#ifndef HEAP_TRACKING_ENABLED
+#define HEAP_TRACKING_ENABLED 0
+#endif
+
+// Allocation sizes are counted in power of two classes from 16 bytes up. The last class holds everything larger.
+#define HEAP_SIZE_CLASSES 12
+#define HEAP_SMALLEST_CLASS_BYTES 16
+
+// Tasks that can carry a tag at once
+#define HEAP_MAX_TAGGED_TASKS 16
+
+#define HEAP_SNAPSHOT_PERIOD_MS 30000
+#define HEAP_SNAPSHOT_HISTORY 8
+
+enum Heap_Tag : uint8_t
+{
+    HEAP_TAG_UNTAGGED,
+    HEAP_TAG_SYSTEM,
+    HEAP_TAG_DISPLAY,
+    HEAP_TAG_LORA,
+    HEAP_TAG_NAVIGATION,
+    HEAP_TAG_LED,
+    HEAP_TAG_RPC,
+    HEAP_TAG_FILESYSTEM,
+    HEAP_TAG_NETWORK,
+    NUM_HEAP_TAGS,
+};
+
+struct Heap_Tag_Stats
+{
+    uint32_t liveCount;
+    uint32_t liveBytes;
+    uint32_t peakBytes;
+    uint32_t totalAllocations;
+    uint32_t failedAllocations;
+
+    // Live allocations per size class
+    uint16_t sizeClasses[HEAP_SIZE_CLASSES];
+};
+
+struct Heap_Region_Snapshot
+{
+    uint32_t freeBytes;
+    uint32_t largestFreeBlock;
+    uint32_t minimumFreeBytes;
+    uint32_t freeBlocks;
+    uint32_t allocatedBlocks;
+
+    // Free blocks per size class. Only filled on ESP-IDF 5.3 and later, which can walk the heap.
+    uint16_t freeSizeClasses[HEAP_SIZE_CLASSES];
+};
+
+struct Heap_Snapshot
+{
+    uint32_t timestampMS;
+    Heap_Region_Snapshot internal;
+    Heap_Region_Snapshot spiram;
+    uint32_t liveBytes[NUM_HEAP_TAGS];
+};
+
+/*
+    Heap accounting and fragmentation snapshots.
+
+    With HEAP_TRACKING_ENABLED, every operator new is charged to the tag of the calling task. Tasks take a
+    tag with setTaskTag(), and HEAP_TAG_SCOPE charges a block of code to another tag. Each allocation carries
+    a small header with its size and tag so delete can credit the right tag.
+    DynamicJsonDocument allocates through malloc and is only counted when built as Heap_Json_Document.
+
+    A timer records the free block layout of each heap region every HEAP_SNAPSHOT_PERIOD_MS.
+    GetHeapStatsRpc returns the tags and the snapshot history. tools/heap_analyze.py reads the responses.
+
+    The accounting is in Heap_Tracking.cpp, which tools/heap_tracking_test.cpp builds on the host.
+*/
+class Heap_Utils
+{
+public:
+    static void init();
+
+    static const char *TagName(uint8_t tag);
+
+    // Charges the calling task's allocations to tag. Returns the tag it replaces.
+    static Heap_Tag setTaskTag(Heap_Tag tag);
+    static Heap_Tag TaskTag();
+
+    // Drops a deleted task's tag, so a new task given the same handle starts untagged
+    static void forgetTask(TaskHandle_t task);
+
+    static void takeSnapshot();
+
+    // Percentage of free internal heap outside the largest free block. 0 means one contiguous block.
+    static uint8_t FragmentationPercent();
+
+    // Pass "clear": true to reset the peaks afterwards
+    static void GetHeapStatsRpc(JsonDocument &doc);
+
+    // Tagged allocation. Used by the operator new overrides and Heap_Json_Allocator.
+    static void *allocate(size_t size);
+    static void *reallocate(void *ptr, size_t size);
+    static void release(void *ptr);
+
+    static uint8_t SizeClass(size_t size);
+
+    // Copies every tag's stats under the lock, then sets each peak to the live bytes if clearPeaks.
+    // All zero without HEAP_TRACKING_ENABLED.
+    static void CopyTagStats(Heap_Tag_Stats *stats, bool clearPeaks);
+    static void CopyLiveBytes(uint32_t *liveBytes);
+
+private:
+    static void fillRegion(Heap_Region_Snapshot &region, uint32_t caps);
+    static void snapshotTimerCallback(TimerHandle_t timer);
+
+    static Heap_Snapshot _Snapshots[HEAP_SNAPSHOT_HISTORY];
+    static size_t _SnapshotHead;
+    static size_t _SnapshotCount;
+
+    static int _SnapshotTimerID;
+    static StaticTimer_t _SnapshotTimerBuffer;
+
+#if HEAP_TRACKING_ENABLED == 1
+    static Heap_Tag_Stats _Tags[NUM_HEAP_TAGS];
+
+    static TaskHandle_t _TaggedTasks[HEAP_MAX_TAGGED_TASKS];
+    static Heap_Tag _TaskTags[HEAP_MAX_TAGGED_TASKS];
+
+    static portMUX_TYPE _Lock;
+
+    // Call with _Lock held
+    static Heap_Tag findTaskTag(TaskHandle_t task);
+    static void charge(Heap_Tag tag, size_t size, uint8_t sizeClass);
+    static void credit(Heap_Tag tag, size_t size, uint8_t sizeClass);
+#endif
+};
+
+// Charges allocations to a tag until it goes out of scope
+class Heap_Tag_Scope
+{
+public:
+    Heap_Tag_Scope(Heap_Tag tag) : previous(Heap_Utils::setTaskTag(tag)) {}
+    ~Heap_Tag_Scope() { Heap_Utils::setTaskTag(previous); }
+
+private:
+    Heap_Tag previous;
+};
+
+// ArduinoJson allocator that charges documents to the current tag
+struct Heap_Json_Allocator
+{
+    void *allocate(size_t size) { return Heap_Utils::allocate(size); }
+    void deallocate(void *ptr) { Heap_Utils::release(ptr); }
+    void *reallocate(void *ptr, size_t size) { return Heap_Utils::reallocate(ptr, size); }
+};
+
+typedef BasicJsonDocument<Heap_Json_Allocator> Heap_Json_Document;
+
+#define HEAP_CONCAT_INNER(a, b) a##b
+#define HEAP_CONCAT(a, b) HEAP_CONCAT_INNER(a, b)
+
+#if HEAP_TRACKING_ENABLED == 1
+#define HEAP_TAG_SCOPE(tag) Heap_Tag_Scope HEAP_CONCAT(_heapTagScope, __LINE__)(tag)
+#define HEAP_TASK_TAG(tag) Heap_Utils::setTaskTag(tag)
+#else
+#define HEAP_TAG_SCOPE(tag) do {} while (0)
+#define HEAP_TASK_TAG(tag) do {} while (0)
+#endif
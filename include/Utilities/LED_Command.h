@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Pattern IDs index a fixed array. Free IDs are tracked in a 32 bit mask.
+#define MAX_LED_PATTERNS 32
+
+// Largest MessagePack config that can be carried by a configure command
+#define LED_COMMAND_CONFIG_SIZE 96
+
+class LED_Pattern_Interface;
+
+enum LED_Command_Type : uint8_t
+{
+    LED_COMMAND_REGISTER,
+    LED_COMMAND_RESET,
+    LED_COMMAND_SET_LENGTH_MS,
+    LED_COMMAND_SET_LENGTH_TICKS,
+    LED_COMMAND_CONFIGURE,
+    LED_COMMAND_LOOP,
+    LED_COMMAND_ENABLE,
+    LED_COMMAND_DISABLE,
+    LED_COMMAND_CLEAR,
+    LED_COMMAND_ITERATE,
+    LED_COMMAND_APPLY,
+};
+
+// Runs on the LED task with the pattern and the argument passed to LED_Utils::applyToPattern
+typedef void (*LED_Pattern_Function)(LED_Pattern_Interface *pattern, int32_t argument);
+
+// A change to a pattern, copied by value into the LED task's command queue
+struct LED_Command
+{
+    LED_Command_Type type;
+    int patternID;
+
+    LED_Pattern_Interface *pattern;
+    LED_Pattern_Function function;
+    int32_t value;
+
+    size_t configLength;
+    uint8_t config[LED_COMMAND_CONFIG_SIZE];
+
+    // Iterate is sent every frame, so a dropped one is replaced by the next.
+    // Every other command changes state that nothing would resend.
+    bool droppable() const { return type == LED_COMMAND_ITERATE; }
+};
+
+/*
+    Pattern ID bookkeeping shared by the calling tasks and the LED task, without locks.
+
+    IDs are claimed by callers and released by the LED task once the pattern is deleted. Unregistering
+    is a bit in a mask rather than a queued command, so it cannot be dropped by a full queue.
+    Kept free of Arduino so tools/led_command_stress.cpp can run it on the host.
+*/
+class LED_Pattern_Slots
+{
+public:
+    // Returns a free ID, or -1 if every ID is claimed
+    int claim()
+    {
+        uint32_t claimed = claimedIDs.load();
+
+        while (claimed != UINT32_MAX)
+        {
+            int freeID = __builtin_ctz(~claimed);
+
+            if (claimedIDs.compare_exchange_weak(claimed, claimed | (1UL << freeID)))
+            {
+                return freeID;
+            }
+        }
+
+        return -1;
+    }
+
+    // Frees an ID. Called by the LED task after deleting the pattern, or by a caller whose register never reached it.
+    void release(int patternID)
+    {
+        claimedIDs.fetch_and(~(1UL << patternID));
+    }
+
+    bool isClaimed(int patternID) const
+    {
+        return patternID >= 0 && patternID < MAX_LED_PATTERNS && (claimedIDs.load() & (1UL << patternID));
+    }
+
+    uint32_t claimed() const { return claimedIDs.load(); }
+
+    void requestUnregister(int patternID)
+    {
+        unregisterIDs.fetch_or(1UL << patternID);
+    }
+
+    // Takes every pending unregister. The LED task takes these before draining the queue, so the register
+    // command of every ID taken is already queued ahead of it.
+    uint32_t takeUnregisterRequests()
+    {
+        return unregisterIDs.exchange(0);
+    }
+
+private:
+    std::atomic<uint32_t> claimedIDs{0};
+    std::atomic<uint32_t> unregisterIDs{0};
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+
+/*
+    Fixed rate frame clock for the LED task. Frames are scheduled on a grid of the frame period and every
+    pattern in a frame sees the scheduled time, so wake up jitter never reaches the animations.
+
+    Only needs the FreeRTOS tick, so tools/led_frame_jitter.cpp runs it on the host.
+*/
+class LED_Frame_Clock
+{
+public:
+    // Starts the grid at the current tick. Time before this is not counted as missed frames.
+    void restart() { lastWakeTime = xTaskGetTickCount(); }
+
+    // Time the current frame was scheduled for
+    size_t FrameMS() const { return lastWakeTime * portTICK_PERIOD_MS; }
+
+    // Waits until the next frame on the grid. If the frame overran, drops the frames that are already late
+    // instead of rendering them back to back. Returns the number of frames dropped.
+    uint32_t waitForNextFrame(size_t periodMS)
+    {
+        TickType_t framePeriod = max(pdMS_TO_TICKS(periodMS), (TickType_t)1);
+        TickType_t elapsed = xTaskGetTickCount() - lastWakeTime;
+        TickType_t missedFrames = 0;
+
+        if (elapsed > framePeriod)
+        {
+            missedFrames = (elapsed - 1) / framePeriod;
+            lastWakeTime += missedFrames * framePeriod;
+            skippedFrames += missedFrames;
+        }
+
+        vTaskDelayUntil(&lastWakeTime, framePeriod);
+        return missedFrames;
+    }
+
+    // Number of frames dropped because the LED task fell behind
+    uint32_t SkippedFrames() const { return skippedFrames; }
+
+private:
+    TickType_t lastWakeTime = 0;
+    uint32_t skippedFrames = 0;
+};
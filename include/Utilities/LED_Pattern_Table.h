@@ -0,0 +1,336 @@
+#pragma once
+
+#include <Arduino.h>
+#include "FastLED.h"
+#include "LED_Pattern_Interface.h"
+#include "LED_Command.h"
+
+// Maximum number of pattern layers composited in a single frame
+#define MAX_LED_LAYERS 16
+
+// How long a caller waits for room in a full queue before giving up on a command that cannot be dropped
+#define LED_COMMAND_SEND_TIMEOUT_MS 100
+
+// LED_Pattern_Table::registerPattern failures
+#define LED_PATTERN_NO_SLOT -1
+#define LED_PATTERN_NOT_ACCEPTED -2
+
+// Struct to hold pattern objects and their status
+struct LED_Pattern_Status
+{
+    int animationID;
+    LED_Pattern_Interface *pattern;
+    int loopsRemaining;
+    bool enabled;
+
+    // True while the pattern's layer holds a frame that should be composited
+    bool visible;
+};
+
+// Applies a command other than register to a registered pattern. Runs on the LED task.
+typedef void (*LED_Command_Handler)(LED_Pattern_Status &status, LED_Command &command, size_t frameMS);
+
+/*
+    The registered patterns and the command queue that feeds them, as used by LED_Utils.
+
+    Callers claim an ID and queue commands. The LED task drains the queue at the start of a frame, deletes
+    unregistered patterns, iterates the patterns that are playing, then composites the visible layers. Until a
+    queue is set there is no LED task, so commands are applied on the calling task.
+
+    Only needs FreeRTOS queues and FastLED colours, so tools/led_command_stress.cpp and tools/led_composite_test.cpp
+    run this code on the host.
+*/
+class LED_Pattern_Table
+{
+public:
+    LED_Pattern_Table(LED_Command_Handler handler) : handler(handler) {}
+
+    void setQueue(QueueHandle_t queue) { commandQueue = queue; }
+    bool hasQueue() const { return commandQueue != nullptr; }
+
+    // The task that drains the queue. It never waits on a full queue, as nothing else would empty it.
+    void setLedTask(TaskHandle_t task) { ledTask = task; }
+
+    LED_Pattern_Status &status(int patternID) { return patterns[patternID]; }
+
+    bool isClaimed(int patternID) const { return slots.isClaimed(patternID); }
+
+    // Claims an ID, gives the pattern a black layer of numLeds and queues its register command.
+    // Returns the ID, LED_PATTERN_NO_SLOT or LED_PATTERN_NOT_ACCEPTED. On failure the caller still owns the pattern.
+    int registerPattern(LED_Pattern_Interface *pattern, size_t numLeds)
+    {
+        int patternID = slots.claim();
+
+        if (patternID == -1)
+        {
+            return LED_PATTERN_NO_SLOT;
+        }
+
+        CRGB *layer = new CRGB[numLeds];
+        fill_solid(layer, numLeds, CRGB::Black);
+        pattern->setLayer(layer);
+        pattern->SetRegisteredPatternID(patternID);
+
+        LED_Command command = {LED_COMMAND_REGISTER, patternID};
+        command.pattern = pattern;
+
+        // The LED task never saw the pattern, so undo the claim here and hand the pattern back
+        if (!sendCommand(command))
+        {
+            pattern->setLayer(nullptr);
+            pattern->SetRegisteredPatternID(-1);
+            delete[] layer;
+            slots.release(patternID);
+            return LED_PATTERN_NOT_ACCEPTED;
+        }
+
+        return patternID;
+    }
+
+    // Marks a claimed pattern for deletion at the start of the next frame. Never dropped and never blocks.
+    // Without a queue the pattern is deleted in place. Returns false if the ID was not claimed.
+    bool unregisterPattern(int patternID)
+    {
+        if (!slots.isClaimed(patternID))
+        {
+            return false;
+        }
+
+        if (commandQueue == nullptr)
+        {
+            deletePattern(patternID);
+            return true;
+        }
+
+        slots.requestUnregister(patternID);
+        return true;
+    }
+
+    // True if sendCommand would wait for room rather than drop the command
+    bool waitsForRoom(const LED_Command &command) const
+    {
+        return !command.droppable() && xTaskGetCurrentTaskHandle() != ledTask;
+    }
+
+    // Queues a command for the LED task. Returns false if the command was dropped.
+    bool sendCommand(LED_Command &command)
+    {
+        if (command.patternID < 0 || command.patternID >= MAX_LED_PATTERNS)
+        {
+            return false;
+        }
+
+        if (commandQueue == nullptr)
+        {
+            processCommand(command, xTaskGetTickCount() * portTICK_PERIOD_MS);
+            return true;
+        }
+
+        // Per frame commands never wait
+        TickType_t timeout = waitsForRoom(command) ? pdMS_TO_TICKS(LED_COMMAND_SEND_TIMEOUT_MS) : 0;
+
+        if (xQueueSend(commandQueue, &command, timeout) != pdTRUE)
+        {
+            droppedCommands.fetch_add(1);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Counts a command that was dropped before it reached the queue
+    void countDroppedCommand() { droppedCommands.fetch_add(1); }
+    uint32_t DroppedCommands() const { return droppedCommands.load(); }
+
+    // Applies every queued command, then deletes unregistered patterns. Returns the IDs deleted.
+    // Only called from the LED task.
+    uint32_t processCommands(size_t frameMS)
+    {
+        if (commandQueue == nullptr)
+        {
+            return 0;
+        }
+
+        // Taken before draining, so the register command of every pattern in the mask is applied first
+        uint32_t unregisterIDs = slots.takeUnregisterRequests();
+        uint32_t deletedIDs = unregisterIDs;
+
+        LED_Command command;
+
+        while (xQueueReceive(commandQueue, &command, 0) == pdTRUE)
+        {
+            processCommand(command, frameMS);
+        }
+
+        while (unregisterIDs != 0)
+        {
+            int patternID = __builtin_ctz(unregisterIDs);
+            unregisterIDs &= unregisterIDs - 1;
+
+            deletePattern(patternID);
+        }
+
+        return deletedIDs;
+    }
+
+    // Deletes a pattern and its layer and frees its ID. Only called from the LED task.
+    void deletePattern(int patternID)
+    {
+        LED_Pattern_Status &status = patterns[patternID];
+        LED_Pattern_Interface *pattern = status.pattern;
+
+        status = {-1, nullptr, 0, false, false};
+
+        if (pattern != nullptr)
+        {
+            delete[] pattern->Layer();
+            delete pattern;
+        }
+
+        slots.release(patternID);
+    }
+
+    // Iterates every enabled pattern with loops left, giving each the frame's scheduled time.
+    // Returns true while any pattern has more frames to play. Only called from the LED task.
+    bool iterate(size_t frameMS)
+    {
+        bool workToDo = false;
+
+        for (int id = 0; id < MAX_LED_PATTERNS; id++)
+        {
+            taskYIELD();
+
+            LED_Pattern_Status &status = patterns[id];
+
+            if (status.pattern == nullptr || status.loopsRemaining == 0 || !status.enabled)
+            {
+                continue;
+            }
+
+            status.visible = true;
+            status.pattern->setFrameTime(frameMS);
+
+            if (status.pattern->iterateFrame())
+            {
+                if (status.loopsRemaining > 0)
+                {
+                    status.loopsRemaining--;
+                }
+
+                // A finished animation leaves nothing on its layer
+                if (status.loopsRemaining == 0)
+                {
+                    status.visible = false;
+                }
+            }
+
+            if (status.loopsRemaining != 0)
+            {
+                workToDo = true;
+            }
+        }
+
+        return workToDo;
+    }
+
+    // Blends every enabled, visible layer onto frame in z-order, then pattern ID order.
+    // frame holds the layer beneath every pattern. Only called from the LED task.
+    void composite(CRGB *frame, size_t numLeds)
+    {
+        LED_Pattern_Status *layers[MAX_LED_LAYERS];
+        size_t numLayers = 0;
+
+        for (int id = 0; id < MAX_LED_PATTERNS; id++)
+        {
+            LED_Pattern_Status &status = patterns[id];
+
+            if (status.pattern == nullptr || !status.enabled || !status.visible || status.pattern->Layer() == nullptr || numLayers >= MAX_LED_LAYERS)
+            {
+                continue;
+            }
+
+            size_t i = numLayers++;
+            int8_t z = status.pattern->ZOrder();
+
+            // Slots are visited in ID order, so equal z-orders stay in ID order
+            while (i > 0 && layers[i - 1]->pattern->ZOrder() > z)
+            {
+                layers[i] = layers[i - 1];
+                i--;
+            }
+
+            layers[i] = &status;
+        }
+
+        for (size_t l = 0; l < numLayers; l++)
+        {
+            LED_Pattern_Interface *pattern = layers[l]->pattern;
+            CRGB *layer = pattern->Layer();
+
+            int begin, end;
+            pattern->GetLayerRange(begin, end);
+
+            begin = max(begin, 0);
+            end = min(end, (int)numLeds - 1);
+
+            switch (pattern->BlendMode())
+            {
+            case LED_BLEND_ADD:
+                for (int i = begin; i <= end; i++)
+                {
+                    frame[i] += layer[i];
+                }
+                break;
+            case LED_BLEND_MAX:
+                for (int i = begin; i <= end; i++)
+                {
+                    frame[i] |= layer[i];
+                }
+                break;
+            case LED_BLEND_ALPHA:
+                for (int i = begin; i <= end; i++)
+                {
+                    nblend(frame[i], layer[i], pattern->BlendAlpha());
+                }
+                break;
+            case LED_BLEND_REPLACE:
+            default:
+                if (end >= begin)
+                {
+                    memcpy(&frame[begin], &layer[begin], (end - begin + 1) * sizeof(CRGB));
+                }
+                break;
+            }
+        }
+    }
+
+private:
+    void processCommand(LED_Command &command, size_t frameMS)
+    {
+        LED_Pattern_Status &status = patterns[command.patternID];
+
+        if (command.type == LED_COMMAND_REGISTER)
+        {
+            status = {command.patternID, command.pattern, 0, false, false};
+            return;
+        }
+
+        if (status.pattern != nullptr)
+        {
+            handler(status, command, frameMS);
+        }
+    }
+
+    LED_Command_Handler handler;
+
+    QueueHandle_t commandQueue = nullptr;
+    TaskHandle_t ledTask = nullptr;
+
+    // Only read and written by the LED task, except before it starts
+    LED_Pattern_Status patterns[MAX_LED_PATTERNS] = {};
+
+    // Claimed by callers, released by the LED task
+    LED_Pattern_Slots slots;
+
+    std::atomic<uint32_t> droppedCommands{0};
+};
@@ -4,24 +4,38 @@
 #include "System_Utils.h"
 #include "FastLED.h"
 #include "LED_Pattern_Interface.h"
+#include "Keyframe_Pattern.h"
+#include "LED_Output_Stage.h"
+#include "LED_Command.h"
+#include "LED_Pattern_Table.h"
+#include "LED_Frame_Clock.h"
 #include <unordered_map>
+#include <atomic>
 
-// Struct to hold pattern objects and their status
-struct LED_Pattern_Status
-{
-    int animationID;
-    LED_Pattern_Interface *pattern;
-    int loopsRemaining;
-    bool enabled;
-};
+// Commands waiting for the LED task
+#define LED_COMMAND_QUEUE_LENGTH 16
+
+// How often the LED task refreshes the battery derated current budget
+#define LED_BATTERY_CHECK_MS 30000
 
+/*
+    Patterns are owned by the LED task. The public pattern functions only queue a command and return,
+    so callers on other tasks never see a pattern mid-frame.
+    Queued commands are applied at the start of the next frame in the order they were sent.
+    If the queue is full, per frame commands are dropped and the rest wait up to LED_COMMAND_SEND_TIMEOUT_MS.
+*/
 class LED_Utils
 {
 public:
-    // Registers a pattern and returns the pattern ID
+    // Creates the command queue. Call before the LED task is started.
+    // Until then commands are applied immediately on the calling task.
+    static void init();
+
+    // Registers a pattern and returns the pattern ID, or -1 if every slot is taken or the LED task is stalled.
+    // On failure the caller still owns the pattern.
     static int registerPattern(LED_Pattern_Interface *pattern);
 
-    // Unregisters a pattern and deletes it
+    // Unregisters a pattern and deletes it on the LED task. Never dropped and never blocks.
     static void unregisterPattern(int patternID);
 
     // Resets a pattern to its initial state
@@ -34,6 +48,7 @@ public:
     static void setAnimationLengthTicks(int patternID, size_t ticks);
 
     // Sends a configuration object to a pattern
+    // The layer keys "blendMode", "alpha" and "zOrder" are handled here for every pattern
     static void configurePattern(int patternID, JsonDocument &config);
 
     // Sets a pattern to loop n times, or indefinitely if numLoops is -1
@@ -49,13 +64,24 @@ public:
     // Clears the given pattern's LEDs and stops it from looping
     static void clearPattern(int patternID);
 
-    // Sets the LED array to be used by the patterns
+    // Calls function with the pattern on the LED task. Use for pattern specific setters
+    // that would otherwise race with the pattern being drawn.
+    static void applyToPattern(int patternID, LED_Pattern_Function function, int32_t argument);
+
+    // Sets the LED array that output frames are written to
     static void setLeds(CRGB *leds, size_t numLeds);
 
+    // Layer beneath every pattern. LEDs driven directly by LED_Manager are written here.
+    static CRGB *BaseLayer() { return _BaseLayer; }
+
+    // Wakes the LED task to composite and show a frame
+    static void requestFrame();
+
     // Sets the tick rate for the LED patterns
     static void setTickRate(size_t ms);
 
-    // Task to iterate patterns. Updates FastLED at the end
+    // Task to iterate patterns. Composites the layers and updates FastLED once per frame
+    // Frames run at a fixed rate set by setTickRate. Frames that fall behind are skipped.
     // Returns false if there is no more work to do and the timer can be stopped
     // Otherwise, returns true
     static void iteratePatterns(void *pvParameters);
@@ -74,14 +100,63 @@ public:
     static void setInputIdLedPins(std::unordered_map<uint8_t, uint8_t> inputIdLedPins);
     static std::unordered_map<uint8_t, uint8_t> &InputIdLedPins();
 
-    static void SetIteratePatternTaskHandle(TaskHandle_t handle) { _IteratePatternsTaskHandle = handle; }
+    static void SetIteratePatternTaskHandle(TaskHandle_t handle)
+    {
+        _IteratePatternsTaskHandle = handle;
+        _Patterns.setLedTask(handle);
+    }
+
+    // Number of frames dropped because the LED task fell behind its frame rate
+    static uint32_t SkippedFrames() { return _FrameClock.SkippedFrames(); }
+
+    // Number of commands dropped because the command queue was full
+    static uint32_t DroppedCommands() { return _Patterns.DroppedCommands(); }
+
+    // Compiles a keyframe program from "program" (JSON) or "file" (SPIFFS path) and plays it.
+    // Pass "patternID" from an earlier call to replace that program, and "loops" to start it (-1 loops forever).
+    static void LoadPatternProgramRpc(JsonDocument &doc);
+
+    // Sets "budgetMA", "gamma" and "dither" on the output stage if present.
+    // Returns the output stage's settings and the estimated current of the last frame.
+    static void SetLedPowerRpc(JsonDocument &doc);
     
 protected:
+    // Queues a command for the LED task and wakes it. Returns false if the command was dropped.
+    static bool sendCommand(LED_Command &command);
+
+    // Applies every queued command and deletes unregistered patterns. Only called from the LED task.
+    static void processCommands(size_t frameMS);
+
+    // Applies a command to a registered pattern. Handler for _Patterns.
+    static void processCommand(LED_Pattern_Status &status, LED_Command &command, size_t frameMS);
+
+    // Blends the base layer and every enabled pattern layer, then passes the frame through the output stage
+    static void compositeFrame();
+
+    static CRGB *_OutputLeds;
+
+    // Composited frame before gamma, current limiting and dithering
+    static CRGB *_FrameLeds;
+    static size_t _LastBatteryCheckMS;
+    static CRGB *_BaseLayer;
+    static size_t _NumLeds;
+
     static CRGB _ThemeColor;
     static std::unordered_map<uint8_t, uint8_t> inputIdLedPins;
 
-    static std::unordered_map<int, LED_Pattern_Status> registeredPatterns;
-    static int nextPatternID;
+    // Registered patterns and the command queue that feeds them
+    static LED_Pattern_Table _Patterns;
+
     static size_t _PatternTickRateMS;
     static TaskHandle_t _IteratePatternsTaskHandle;
+
+    // Schedules frames at _PatternTickRateMS and counts the ones skipped
+    static LED_Frame_Clock _FrameClock;
+
+    static int _CommandQueueID;
+    static StaticQueue_t _CommandQueueBuffer;
+    static uint8_t _CommandQueueStorage[LED_COMMAND_QUEUE_LENGTH * sizeof(LED_Command)];
+
+    // Bit n is set while pattern ID n holds a pattern created through LoadPatternProgramRpc
+    static std::atomic<uint32_t> _ProgramPatternIDs;
 };
\ No newline at end of file
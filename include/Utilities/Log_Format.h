@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#define LOG_MAX_ARGS 6
+
+// Space in a record for copies of string arguments. Longer strings are truncated.
+#define LOG_TEXT_BYTES 32
+
+// Longest formatted line
+#define LOG_LINE_BYTES 160
+
+enum Log_Arg_Type : uint8_t
+{
+    LOG_ARG_INTEGER,
+    LOG_ARG_FLOAT,
+    LOG_ARG_TEXT,
+};
+
+union Log_Arg
+{
+    int64_t integer;
+    double number;
+
+    // Offset of the copied string in Log_Record::text
+    uint8_t textOffset;
+};
+
+// A log call packed as binary. The format string is only read when the drain task formats the record.
+struct Log_Record
+{
+    uint32_t timestampMS;
+    const char *format;
+
+    uint8_t level;
+    uint8_t numArgs;
+    uint8_t textUsed;
+    Log_Arg_Type argTypes[LOG_MAX_ARGS];
+    Log_Arg args[LOG_MAX_ARGS];
+
+    char text[LOG_TEXT_BYTES];
+};
+
+/*
+    Packs log arguments into a Log_Record and formats records back into text.
+    Kept free of Arduino so tools/log_bench.cpp can measure both halves of a log call on the host.
+*/
+class Log_Format
+{
+public:
+    static void begin(Log_Record &record, uint32_t timestampMS, uint8_t level, const char *format)
+    {
+        record.timestampMS = timestampMS;
+        record.format = format;
+        record.level = level;
+        record.numArgs = 0;
+        record.textUsed = 0;
+    }
+
+    template <typename T>
+    static void packArg(Log_Record &record, T value)
+    {
+        if (record.numArgs < LOG_MAX_ARGS)
+        {
+            record.argTypes[record.numArgs] = LOG_ARG_INTEGER;
+            record.args[record.numArgs++].integer = (int64_t)value;
+        }
+    }
+
+    static void packArg(Log_Record &record, float value) { packArg(record, (double)value); }
+    static void packArg(Log_Record &record, double value);
+    static void packArg(Log_Record &record, const char *value);
+    static void packArg(Log_Record &record, char *value) { packArg(record, (const char *)value); }
+    static void packArg(Log_Record &record, const std::string &value) { packArg(record, value.c_str()); }
+
+    // Formats a record into buffer. Returns the length written.
+    static size_t formatRecord(const Log_Record &record, char *buffer, size_t bufferSize);
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "globalDefines.h"
+#include <Arduino.h>
+#include <atomic>
+#include <string>
+#include "Log_Format.h"
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_VERBOSE 5
+
+// Calls above this level compile to nothing. Override with -DLOG_LEVEL=n.
+#ifndef LOG_LEVEL
+#if DEBUG == 1
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_LEVEL LOG_LEVEL_WARN
+#endif
+#endif
+
+// Records waiting for the drain task. Records logged while the queue is full are dropped and counted.
+#define LOG_QUEUE_LENGTH 24
+
+/*
+    Deferred logging. A log call copies its arguments into a Log_Record and queues it without blocking.
+    Formatting and Serial output happen on a low priority drain task.
+
+    Format strings must be string literals. Literals already live in flash on the ESP32, and the drain
+    task reads them after the call returns. String arguments are copied, so temporaries are safe.
+*/
+class Log_Utils
+{
+public:
+    // Starts the drain task. Until then log calls are formatted and printed on the calling task.
+    static void init();
+
+    template <typename... Args>
+    static void write(uint8_t level, const char *format, Args... args)
+    {
+        Log_Record record;
+        Log_Format::begin(record, millis(), level, format);
+
+        int unused[] = {0, (packArg(record, args), 0)...};
+        (void)unused;
+
+        submit(record);
+    }
+
+    // Number of records dropped because the queue was full
+    static uint32_t DroppedRecords() { return _DroppedRecords.load(); }
+
+private:
+    template <typename T>
+    static void packArg(Log_Record &record, T value) { Log_Format::packArg(record, value); }
+
+    static void packArg(Log_Record &record, const String &value) { Log_Format::packArg(record, value.c_str()); }
+
+    static void submit(Log_Record &record);
+    static void printRecord(const Log_Record &record);
+    static void drainTask(void *pvParameters);
+
+    static int _QueueID;
+    static QueueHandle_t _Queue;
+    static StaticQueue_t _QueueBuffer;
+    static uint8_t _QueueStorage[LOG_QUEUE_LENGTH * sizeof(Log_Record)];
+
+    static std::atomic<uint32_t> _DroppedRecords;
+    static uint32_t _ReportedDrops;
+    static int _DrainTaskID;
+};
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Log_Utils::write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) Log_Utils::write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) Log_Utils::write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Log_Utils::write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_VERBOSE
+#define LOG_VERBOSE(...) Log_Utils::write(LOG_LEVEL_VERBOSE, __VA_ARGS__)
+#else
+#define LOG_VERBOSE(...) do {} while (0)
+#endif
@@ -66,6 +66,8 @@ public:
     static uint8_t DefaultSendAttempts() { return _DefaultSendAttempts; }
     static size_t GetNumMessages() { return _ReceivedMessages.size(); }
     static size_t GetNumUnreadMessages() { return _UnreadMessages.size(); }
+    // Incremented whenever the received or unread message maps change
+    static uint32_t MessageStoreVersion() { return _MessageStoreVersion; }
     static bool MyLastBroacastExists() { return _MyLastBroadcast != nullptr; }
 
     // Setters
@@ -229,6 +231,9 @@ public:
 
     static EventHandler &SavedMessageListUpdated() { return _SavedMessageListUpdated; }
 
+    // Held while the saved message list changes and while Persistence_Utils serializes it
+    static SemaphoreHandle_t SavedMessageListMutex() { return _SavedMessageListMutex; }
+
     static std::vector<std::string>::iterator SavedMessageListBegin() { return _SavedMessageList.begin(); }
     static std::vector<std::string>::iterator SavedMessageListEnd() { return _SavedMessageList.end(); }
     static void AddSavedMessage(std::string message, bool flash = true);
@@ -249,8 +254,15 @@ public:
     static void SerializeSavedMessageList(JsonDocument &doc);
     static void DeserializeSavedMessageList(JsonDocument &doc);
 
+    // Streamed forms used for flash, one message at a time. Serialized with SavedMessageListMutex held.
+    static void SerializeSavedMessageList(MsgPack_Writer &writer);
+    static void DeserializeSavedMessage(JsonVariantConst message);
+
     static EventHandler &UserInfoListUpdated() { return _UserInfoListUpdated; }
 
+    // Held while the user list changes and while Persistence_Utils serializes it
+    static SemaphoreHandle_t UserInfoListMutex() { return _UserInfoListMutex; }
+
     static std::vector<UserInfo>::iterator UserInfoListBegin() { return _UserInfoList.begin(); }
     static std::vector<UserInfo>::iterator UserInfoListEnd() { return _UserInfoList.end(); }
     static void AddUserInfo(UserInfo userInfo);
@@ -260,8 +272,15 @@ public:
     static void SerializeUserInfoList(JsonDocument &doc);
     static void DeserializeUserInfoList(JsonDocument &doc);
 
+    // Streamed forms used for flash, one user at a time. Serialized with UserInfoListMutex held.
+    static void SerializeUserInfoList(MsgPack_Writer &writer);
+    static void DeserializeUserInfo(JsonVariantConst userObj);
+
     static void FlashDefaultMessages();
 
+    // Appends the default messages without saving, from the asset partition if it has them
+    static void LoadDefaultMessages();
+
 protected:
     // Last message received from each user
     static std::map<uint32_t, MessageBase *> _ReceivedMessages;
@@ -269,6 +288,8 @@ protected:
     // Unread messages
     static std::map<uint32_t, MessageBase *> _UnreadMessages;
 
+    static uint32_t _MessageStoreVersion;
+
     // Last message broadcasted by this device
     static MessageBase *_MyLastBroadcast;
 
@@ -303,6 +324,15 @@ protected:
     // Default number of send attempts for a message
     static uint8_t _DefaultSendAttempts;
 
+    static SemaphoreHandle_t _SavedMessageListMutex;
+    static StaticSemaphore_t _SavedMessageListMutexBuffer;
+
+    static SemaphoreHandle_t _UserInfoListMutex;
+    static StaticSemaphore_t _UserInfoListMutexBuffer;
+
+    // Appends the default messages with _SavedMessageListMutex held
+    static void appendDefaultMessages();
+
     // Semaphore for accessing _MyLastBroadcast and _ReceivedMessages
     static SemaphoreHandle_t _MessageAccessMutex;
     static StaticSemaphore_t _MessageAccessMutexBuffer;
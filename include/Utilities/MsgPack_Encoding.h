@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Writes MessagePack headers, strings and raw bytes to a Print. MsgPack_Writer adds whole ArduinoJson values.
+// Map and array headers carry their size, so the caller must know the element count before writing the elements.
+// Only needs Print, so tools/msgpack_bench.cpp can measure it on the host.
+class MsgPack_Encoder
+{
+public:
+    explicit MsgPack_Encoder(Print &output) : output(output) {}
+
+    void beginMap(uint32_t size);
+    void beginArray(uint32_t size);
+    void writeString(const char *value);
+
+    // Writes bytes that are already MessagePack
+    void writeRaw(const uint8_t *data, size_t length);
+
+    size_t BytesWritten() const { return bytesWritten; }
+
+protected:
+    void writeHeader(uint8_t fixType, uint8_t fixMax, uint8_t type16, uint8_t type32, uint32_t size);
+    void writeByte(uint8_t value);
+    void writeBigEndian(uint32_t value, uint8_t bytes);
+
+    Print &output;
+    size_t bytesWritten = 0;
+};
+
+// Reads MessagePack headers and strings from a Stream. MsgPack_Reader adds whole ArduinoJson values.
+// Every call returns false once the stream is malformed or ends.
+class MsgPack_Decoder
+{
+public:
+    explicit MsgPack_Decoder(Stream &input) : input(input) {}
+
+    bool readMapHeader(uint32_t &size);
+    bool readArrayHeader(uint32_t &size);
+
+    // Reads a string into buffer. Strings longer than the buffer are truncated.
+    bool readString(char *buffer, size_t bufferSize);
+
+    bool ok() const { return valid; }
+
+protected:
+    bool readHeader(uint8_t fixType, uint8_t fixMask, uint8_t type16, uint8_t type32, uint32_t &size);
+    bool readBigEndian(uint32_t &value, uint8_t bytes);
+
+    Stream &input;
+    bool valid = true;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+#include "ArduinoJson.h"
+#include "MsgPack_Encoding.h"
+#include <functional>
+
+class MsgPack_Writer;
+
+// Writes a file's payload through a MsgPack_Writer
+typedef std::function<void(MsgPack_Writer &writer)> MsgPack_Producer;
+
+// Receives one array element at a time. The element is only valid during the call.
+typedef std::function<void(JsonVariantConst element)> MsgPack_Element_Callback;
+
+// Writes MessagePack containers one piece at a time so a collection never has to be built as a whole JsonDocument.
+class MsgPack_Writer : public MsgPack_Encoder
+{
+public:
+    explicit MsgPack_Writer(Print &output) : MsgPack_Encoder(output) {}
+
+    // Writes a complete value, usually an element built in a small StaticJsonDocument
+    void writeElement(JsonVariantConst element);
+};
+
+// Reads MessagePack containers one piece at a time
+class MsgPack_Reader : public MsgPack_Decoder
+{
+public:
+    explicit MsgPack_Reader(Stream &input) : MsgPack_Decoder(input) {}
+
+    // Deserializes the next complete value into doc
+    bool readElement(JsonDocument &doc);
+
+    // Skips the next complete value without storing it
+    bool skipValue();
+};
@@ -2,14 +2,26 @@
 
 #include "System_Utils.h"
 #include "CompassInterface.h"
+#include "Heading_Utils.h"
+#include "Spatial_Index.h"
+#include "GPS_Fix.h"
+#include "Seqlock.h"
 #include "TinyGPS++.h"
 #include <string>
+#include <atomic>
+#include <map>
 
 namespace
 {
     const char *COMPASS_CALIBRATION_FILENAME PROGMEM = "/CompassCalibration.msgpk";
 }
 
+#define GPS_TASK_STACK_SIZE 3072
+#define GPS_TASK_PRIORITY 2
+
+// The GPS task also wakes this often, for streams that cannot signal received data
+#define GPS_POLL_INTERVAL_MS 100
+
 struct SavedLocation
 {
     std::string Name;
@@ -17,6 +29,24 @@ struct SavedLocation
     double Longitude;
 };
 
+// Saved locations and pinging users nearest the current fix
+#define NEARBY_DEFAULT_COUNT 10
+#define NEARBY_MAX_COUNT 32
+
+struct Nearby_Item
+{
+    // SPATIAL_SAVED_LOCATION or SPATIAL_PING
+    uint8_t kind;
+
+    // Saved location index, or the user ID of the ping's sender
+    uint32_t id;
+
+    std::string name;
+    double latitude;
+    double longitude;
+    Geo_Vector vector;
+};
+
 // Static class to manage navigation functions including the compass and the GPS.
 class NavigationUtils
 {
@@ -24,27 +54,49 @@ public:
     static void Init(CompassInterface *compass);
     static void Init(CompassInterface *compass, Stream &gpsInputStream);
 
+    // Also wakes the GPS task as soon as the UART receives data
+    static void Init(CompassInterface *compass, HardwareSerial &gpsSerial);
+
     // GPS Functionality
+
+    // Parses pending GPS input on the calling task. Only needed when the GPS task is not running.
     static void UpdateGPS();
+
+    // Latest fix. Never blocks and never parses, safe to call from any task.
+    static GPS_Fix GetFix();
+
     static bool IsGPSConnected();
-    static TinyGPSLocation GetLocation();
-    static TinyGPSTime GetTime();
-    static TinyGPSDate GetDate();
+    static GPS_Fix GetLocation() { return GetFix(); }
+    static GPS_Time GetTime();
+    static GPS_Date GetDate();
     static uint64_t GetTimeDifference(uint32_t time1, uint32_t date1, uint32_t time2, uint32_t date2);
     static uint64_t GetTimeDifference(uint32_t time1, uint32_t date1);
 
     // Compass Functionality
+
+    // Raw compass reading. Prefer GetHeading, which is filtered and blended with the GPS course.
     static int GetAzimuth();
+    static Heading_Estimate GetHeading() { return Heading_Utils::GetHeading(); }
     static double GetDistanceTo(double lat, double lon);
     static double GetHeadingTo(double lat, double lon);
+
+    // Distance and heading from the current fix. Prefer over GetDistanceTo and GetHeadingTo when both are needed.
+    // Returns false without a fix.
+    static bool GetVectorTo(double lat, double lon, Geo_Vector &vector);
+
+    // Batch form for many targets, such as every received ping. Returns false without a fix.
+    static bool GetVectorsTo(const Geo_Point_E7 *targets, size_t numTargets, Geo_Vector *vectors);
+
+    // Projection centered near the current fix, moved once the fix is GEO_PROJECTION_REFRESH_M from its origin
+    static Geo_Projection GetProjection();
     static int GetX();
     static int GetY();
     static int GetZ();
     static void PrintRawValues() { _Compass->PrintRawValues(); }
 
-    static void BeginCalibration() { if (_Compass) _Compass->BeginCalibration(); }
+    static void BeginCalibration() { if (_Compass) { Heading_Utils::pause(); _Compass->BeginCalibration(); } }
     static void IterateCalibration() { if (_Compass) _Compass->IterateCalibration(); }
-    static void EndCalibration() { if (_Compass) _Compass->EndCalibration(); }
+    static void EndCalibration() { if (_Compass) { _Compass->EndCalibration(); Heading_Utils::resume(); } }
     static void GetCalibrationData(JsonDocument &doc) { if (_Compass) _Compass->GetCalibrationData(doc); }
     static void SetCalibrationData(JsonDocument &doc) { if (_Compass) _Compass->SetCalibrationData(doc); }
     static const char *GetCalibrationFilename() { return COMPASS_CALIBRATION_FILENAME; }
@@ -60,9 +112,16 @@ public:
     static std::vector<SavedLocation>::iterator GetSavedLocationsEnd() { return _SavedLocations.end(); }
     static size_t GetSavedLocationsSize() { return _SavedLocations.size(); }
 
+    // Held while the saved locations or the nearby index change, and by Persistence_Utils while it writes them
+    static SemaphoreHandle_t SavedLocationsMutex() { return nearbyMutex(); }
+
     static void SerializeSavedLocations(JsonDocument &doc);
     static void DeserializeSavedLocations(JsonDocument &doc);
 
+    // Streamed forms used for flash, one location at a time
+    static void SerializeSavedLocations(MsgPack_Writer &writer);
+    static void DeserializeSavedLocation(JsonVariantConst location);
+
     // RPC
     static void RpcAddSavedLocation(JsonDocument &doc);
     static void RpcAddSavedLocations(JsonDocument &doc);
@@ -74,14 +133,52 @@ public:
 
     static void FlashSampleLocations();
 
+    // Nearby
+
+    // Called by LoraUtils for each received ping, and with 0, 0 once a sender's ping is replaced by another message.
+    // A ping at 0, 0 was sent without a fix and drops the sender.
+    static void IndexPing(uint32_t userID, const char *name, double lat, double lon);
+
+    // Up to count saved locations and pings within radiusM of the current fix, nearest first.
+    // Empty without a fix.
+    static std::vector<Nearby_Item> GetNearby(size_t count, float radiusM = SPATIAL_MAX_RADIUS_M);
+
+    // Args "Count" and "Radius" in meters, both optional
+    static void RpcGetNearby(JsonDocument &doc);
+
 protected:
     static CompassInterface *_Compass;
+
+    // Only touched by the GPS task, or by UpdateGPS when there is none
     static TinyGPSPlus _GPS;
-    static Stream &_GpsInputStream;
+    static Stream *_GpsInputStream;
+
+    static void gpsTask(void *pvParameters);
+    static bool parseAvailable();
+    static void publishFix();
+
+    static TaskHandle_t _GpsTask;
+
+    // Written by the GPS task, read by GetFix from any task
+    static Seqlock<GPS_Fix> _Fix;
 
-    static TinyGPSLocation _LastCoordinate;
+    // Refreshed by publishFix
+    static Geo_Projection _Projection;
+    static portMUX_TYPE _ProjectionLock;
 
     static EventHandler _SavedLocationsUpdated;
 
     static std::vector<SavedLocation> _SavedLocations;
+
+    // Saved locations and pings by position, kept in step with _SavedLocations and IndexPing
+    static Spatial_Index _NearbyIndex;
+    static std::map<uint32_t, std::string> _PingNames;
+    static SemaphoreHandle_t _NearbyMutex;
+    static StaticSemaphore_t _NearbyMutexBuffer;
+
+    static SemaphoreHandle_t nearbyMutex();
+
+    // Call with nearbyMutex held
+    static void indexSavedLocation(size_t idx);
+    static void reindexSavedLocations();
 };
\ No newline at end of file
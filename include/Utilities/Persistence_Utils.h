@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>
+#include "ArduinoJson.h"
+#include "MsgPack_Stream.h"
+#include <atomic>
+
+#define PERSISTENCE_MAX_COLLECTIONS 8
+
+// A dirty collection is written once no change has been marked for this long
+#define PERSISTENCE_DEBOUNCE_MS 1500
+
+// Upper bound on how long a steady stream of changes can hold off a write
+#define PERSISTENCE_MAX_DELAY_MS 10000
+
+// Streams the collection's current contents. Called twice per write, see FilesystemModule::Utilities::WriteFileStreamed.
+typedef void (*Persistence_Serializer)(MsgPack_Writer &writer);
+
+struct Persisted_Collection
+{
+    const char *filename;
+    Persistence_Serializer serialize;
+
+    // Owner's mutex over the collection's contents
+    SemaphoreHandle_t lock;
+
+    uint32_t writes;
+    uint32_t bytesWritten;
+    uint32_t failures;
+
+    // Changes folded into an already pending write
+    uint32_t coalesced;
+};
+
+/*
+    Writes collections such as saved messages, users and locations to SPIFFS in the background.
+
+    Owners mark a collection dirty after every change. The persistence task waits for the changes to settle,
+    then writes each dirty collection once through FilesystemModule::Utilities::WriteFileAtomic.
+    Before init() runs, markDirty() writes synchronously.
+
+    The serializer runs on the persistence task while the owner's tasks keep changing the collection, so each
+    collection is registered with the mutex its owner holds while changing it. The write holds that mutex
+    throughout, which keeps both serializer passes on the same contents without copying the collection.
+    Owners must release it before calling markDirty().
+*/
+class Persistence_Utils
+{
+public:
+    static void init();
+
+    // Returns the collection ID, or -1 if the table is full. lock is held while the collection is serialized.
+    static int registerCollection(const char *filename, Persistence_Serializer serialize, SemaphoreHandle_t lock);
+
+    static void markDirty(int collectionID);
+    static bool isDirty(int collectionID);
+
+    // Writes every dirty collection from the calling task. Called on shutdown.
+    static void flush();
+
+    static void GetPersistenceStatsRpc(JsonDocument &doc);
+
+protected:
+    static void persistenceTask(void *pvParameters);
+    static bool writeCollection(int collectionID);
+
+    static Persisted_Collection _Collections[PERSISTENCE_MAX_COLLECTIONS];
+    static uint8_t _NumCollections;
+    static portMUX_TYPE _RegisterLock;
+
+    // Bit n is set while collection n has unwritten changes
+    static std::atomic<uint32_t> _DirtyMask;
+    static volatile TickType_t _FirstMarkTick;
+    static volatile TickType_t _LastMarkTick;
+
+    static int _TaskID;
+    static TaskHandle_t _Task;
+
+    // Held while writing so flush() and the task never write the same file at once
+    static SemaphoreHandle_t _WriteMutex;
+    static StaticSemaphore_t _WriteMutexBuffer;
+};
@@ -52,20 +52,13 @@ namespace RpcModule
         {
             if (_rpcMap.find(name) != _rpcMap.end())
             {
-                #if DEBUG == 1
-                Serial.print("Calling function ");
-                Serial.println(name.c_str());
-                #endif
+                LOG_DEBUG("Rpc: calling %s", name);
 
                 _rpcMap[name](doc);
                 return RpcReturnCode::RPC_SUCCESS;
             }
 
-            #if DEBUG == 1
-            Serial.print("Function ");
-            Serial.print(name.c_str());
-            Serial.println(" not registered");
-            #endif
+            LOG_WARN("Rpc: %s not registered", name);
             return RpcReturnCode::RPC_FUNCTION_NOT_REGISTERED;
         }
 
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Runtime profiler sampling period and the number of samples kept in its history
+#define RUNTIME_PROFILER_PERIOD_MS 5000
+#define RUNTIME_PROFILER_HISTORY 16
+
+// Registered tasks recorded per history sample. Tasks past this are still reported live.
+#define RUNTIME_PROFILER_MAX_TASKS 16
+
+// Tasks created by the core and SDK besides the registered ones: idle, timer, IPC, esp_timer, WiFi, lwIP, events and loop.
+// Sizes the profiler's task status buffer together with SYSTEM_MAX_TASKS.
+#define RUNTIME_PROFILER_SYSTEM_TASKS 16
+
+// Reported in place of a CPU share when FreeRTOS run time stats are disabled
+#define RUNTIME_CPU_UNAVAILABLE 0xFF
+
+/*
+    What System_Utils' runtime profiler collects: task CPU shares, queue peak depths, timer callback times and
+    the history of samples. Only needs the FreeRTOS types and esp_timer, so tools/profiler_test.cpp runs it on
+    the host. Locking is left to System_Utils.
+*/
+
+struct Task_Runtime_Sample
+{
+    int16_t taskID;
+
+    // Share of one core since the previous sample, or RUNTIME_CPU_UNAVAILABLE
+    uint8_t cpuPercent;
+
+    // Lowest free stack seen, in bytes
+    uint16_t stackFree;
+};
+
+struct Runtime_Sample
+{
+    uint32_t timeMS;
+
+    uint32_t freeInternal;
+    uint32_t largestInternal;
+    uint32_t freeSpiram;
+
+    uint8_t numTasks;
+    Task_Runtime_Sample tasks[RUNTIME_PROFILER_MAX_TASKS];
+
+    // Returns false if the sample already holds RUNTIME_PROFILER_MAX_TASKS tasks
+    bool addTask(int taskID, uint8_t cpuPercent, uint32_t stackFree)
+    {
+        if (numTasks >= RUNTIME_PROFILER_MAX_TASKS)
+        {
+            return false;
+        }
+
+        Task_Runtime_Sample &task = tasks[numTasks++];
+        task.taskID = taskID;
+        task.cpuPercent = cpuPercent;
+        task.stackFree = min(stackFree, (uint32_t)UINT16_MAX);
+        return true;
+    }
+};
+
+struct Task_Profile
+{
+    uint32_t lastRunTime = 0;
+    uint8_t cpuPercent = RUNTIME_CPU_UNAVAILABLE;
+
+    // Takes the task's run time counter, which ticks in microseconds of esp_timer. The first call only
+    // records the counter, as there is no previous sample to measure from.
+    void update(uint32_t runTime, uint32_t elapsedUS)
+    {
+        if (elapsedUS > 0)
+        {
+            cpuPercent = min((uint64_t)(runTime - lastRunTime) * 100 / elapsedUS, (uint64_t)100);
+        }
+
+        lastRunTime = runTime;
+    }
+};
+
+struct Queue_Profile
+{
+    // Deepest the queue has been when sampled or sent to through System_Utils
+    uint32_t peakDepth = 0;
+
+    void record(uint32_t depth) { peakDepth = max(peakDepth, depth); }
+
+    // Starts a new peak from the current depth
+    void reset(uint32_t depth) { peakDepth = depth; }
+};
+
+// Registered timers call through the profiler, which times each callback
+struct Timer_Profile
+{
+    TimerCallbackFunction_t callback = nullptr;
+    uint32_t calls = 0;
+    uint32_t lastUS = 0;
+    uint32_t maxUS = 0;
+    uint64_t totalUS = 0;
+
+    // Profiles outlive their timers. The timer daemon may still be running the callback when deleteTimer returns.
+    bool deleted = false;
+
+    // Runs the callback and records how long it took. Only called from the timer daemon task.
+    void run(TimerHandle_t timer)
+    {
+        if (callback == nullptr)
+        {
+            return;
+        }
+
+        int64_t startTime = esp_timer_get_time();
+        callback(timer);
+        record((uint32_t)(esp_timer_get_time() - startTime));
+    }
+
+    void record(uint32_t durationUS)
+    {
+        calls++;
+        lastUS = durationUS;
+        maxUS = max(maxUS, durationUS);
+        totalUS += durationUS;
+    }
+
+    uint32_t averageUS() const { return calls > 0 ? (uint32_t)(totalUS / calls) : 0; }
+
+    // Clears the call statistics. The last duration is kept.
+    void resetStats()
+    {
+        calls = 0;
+        maxUS = 0;
+        totalUS = 0;
+    }
+};
+
+// The last RUNTIME_PROFILER_HISTORY samples
+class Runtime_History
+{
+public:
+    void add(const Runtime_Sample &sample)
+    {
+        samples[head] = sample;
+        head = (head + 1) % RUNTIME_PROFILER_HISTORY;
+        numSamples = min(numSamples + 1, (size_t)RUNTIME_PROFILER_HISTORY);
+    }
+
+    size_t count() const { return numSamples; }
+
+    // Most recent sample. Only valid once a sample has been added.
+    const Runtime_Sample &latest() const
+    {
+        return samples[(head + RUNTIME_PROFILER_HISTORY - 1) % RUNTIME_PROFILER_HISTORY];
+    }
+
+    // Copies up to maxSamples of the most recent samples, oldest first. Returns the number copied.
+    size_t copy(Runtime_Sample *destination, size_t maxSamples) const
+    {
+        size_t copied = min(maxSamples, numSamples);
+        size_t first = (head + RUNTIME_PROFILER_HISTORY - copied) % RUNTIME_PROFILER_HISTORY;
+
+        for (size_t i = 0; i < copied; i++)
+        {
+            destination[i] = samples[(first + i) % RUNTIME_PROFILER_HISTORY];
+        }
+
+        return copied;
+    }
+
+private:
+    Runtime_Sample samples[RUNTIME_PROFILER_HISTORY];
+    size_t head = 0;
+    size_t numSamples = 0;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+/*
+    Single writer, many reader copy of a plain struct. The count is odd while the writer is copying in, and
+    readers retry if it changed under them. Writes happen in a critical section, so a reader never waits on a
+    preempted writer.
+
+    Only needs atomics and a portMUX, so tools/gps_fix_test.cpp runs it on the host.
+*/
+template <typename T>
+class Seqlock
+{
+public:
+    // Only called from one task at a time
+    void write(const T &value)
+    {
+        portENTER_CRITICAL(&writeLock);
+        uint32_t current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        memcpy((void *)&data, &value, sizeof(T));
+
+        sequence.store(current + 2, std::memory_order_release);
+        portEXIT_CRITICAL(&writeLock);
+    }
+
+    // Never blocks. Safe to call from any task.
+    T read() const
+    {
+        T value;
+        uint32_t before;
+        uint32_t after;
+
+        do
+        {
+            before = sequence.load(std::memory_order_acquire);
+            memcpy(&value, (const void *)&data, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        return value;
+    }
+
+    // Number of writes so far
+    uint32_t Writes() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+    T data = {};
+    std::atomic<uint32_t> sequence{0};
+    portMUX_TYPE writeLock = portMUX_INITIALIZER_UNLOCKED;
+};
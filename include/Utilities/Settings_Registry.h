@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ArduinoJson.h"
+#include "EventHandler.h"
+#include "Settings_Store.h"
+#include <Arduino.h>
+#include <string>
+
+// Settings changed since the last full write are kept in this file and applied over the settings file on load
+#define SETTINGS_DELTA_FILENAME "/SettingsDelta.msgpk"
+
+/*
+    Typed view of the settings file. Values are read by key from a fixed array without touching JSON.
+
+    The settings file stays the source of truth for the settings UI. Setting a value writes it through to
+    the settings file in memory, notifies only that key's listeners and marks it dirty. persist() writes
+    the changed keys to a small delta file instead of rewriting the whole settings file.
+*/
+class Settings_Registry
+{
+public:
+    static const Setting_Descriptor &Descriptor(Setting_Key key) { return Settings_Store::Descriptor(key); }
+
+    // Returns NUM_SETTINGS if name is not a registered key
+    static Setting_Key Find(const char *name) { return Settings_Store::Find(name); }
+
+    static bool has(Setting_Key key);
+    static bool getBool(Setting_Key key, bool defaultValue = false);
+    static int32_t getInt(Setting_Key key, int32_t defaultValue = 0);
+    static float getFloat(Setting_Key key, float defaultValue = 0.0f);
+    static std::string getString(Setting_Key key, const char *defaultValue = "");
+
+    static void setBool(Setting_Key key, bool value);
+    static void setInt(Setting_Key key, int32_t value);
+    static void setFloat(Setting_Key key, float value);
+    static void setString(Setting_Key key, const char *value);
+
+    // Parses value as the key's type. Used for settings received as text over RPC.
+    static void setFromString(Setting_Key key, const char *value);
+
+    // Invoked after the key's value changes
+    static EventHandler &Changed(Setting_Key key);
+
+    // Reads every key from a settings document. Keys whose value changed notify their listeners.
+    static void syncFromDocument(JsonDocument &settings);
+
+    // Applies the delta file over a freshly loaded settings document
+    static void applyDelta(JsonDocument &settings);
+
+    // Writes dirty keys to the delta file. Returns false if the write failed.
+    static bool persist();
+
+    // Call after the whole settings file is written. The delta is no longer needed.
+    static void clearDelta();
+
+    // Bytes written by the last persist()
+    static size_t LastPersistBytes() { return _LastPersistBytes; }
+
+private:
+    static bool readValue(Setting_Key key, JsonVariantConst variant, Setting_Value &value);
+    static void writeValue(Setting_Key key, JsonVariant variant);
+
+    // Stores value, writes it through to the settings file and notifies if it changed
+    static void store(Setting_Key key, const Setting_Value &value);
+
+    static SemaphoreHandle_t mutex();
+
+    static Settings_Store _Store;
+    static EventHandler _Changed[NUM_SETTINGS];
+
+    static size_t _LastPersistBytes;
+
+    static SemaphoreHandle_t _Mutex;
+    static StaticSemaphore_t _MutexBuffer;
+};
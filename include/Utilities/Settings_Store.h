@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Longest string setting value, including the terminator
+#define SETTING_STRING_LENGTH 32
+
+// Room for the delta with every key at its longest value
+#define SETTINGS_DELTA_MAX_BYTES 384
+
+enum Setting_Type : uint8_t
+{
+    SETTING_TYPE_BOOL,
+    SETTING_TYPE_INT,
+    SETTING_TYPE_FLOAT,
+    SETTING_TYPE_STRING,
+};
+
+// Settings with typed, indexed storage. Add new keys here and to the descriptor table in Settings_Store.cpp.
+enum Setting_Key : uint8_t
+{
+    SETTING_DEVICE_NAME,
+    SETTING_USER_ID,
+    SETTING_WIFI_PROVISIONING,
+    SETTING_SILENT_MODE,
+    SETTING_24H_TIME,
+    NUM_SETTINGS,
+};
+
+struct Setting_Descriptor
+{
+    // Key in the settings file
+    const char *name;
+    Setting_Type type;
+};
+
+struct Setting_Value
+{
+    // False until the key is found in the settings file or set
+    bool present;
+
+    union
+    {
+        bool boolean;
+        int32_t integer;
+        float number;
+    };
+
+    char text[SETTING_STRING_LENGTH];
+};
+
+/*
+    Typed values of the registered settings, indexed by key, with the keys changed since the last full write
+    of the settings file and their MessagePack encoding for the delta file.
+
+    Not thread safe, Settings_Registry locks around it.
+    Kept free of Arduino so tools/settings_bench.cpp can measure it on the host.
+*/
+class Settings_Store
+{
+public:
+    static const Setting_Descriptor &Descriptor(Setting_Key key);
+
+    // Returns NUM_SETTINGS if name is not a registered key
+    static Setting_Key Find(const char *name);
+
+    // Parses text as the key's type
+    static Setting_Value Parse(Setting_Key key, const char *text);
+
+    static bool Equal(Setting_Key key, const Setting_Value &a, const Setting_Value &b);
+
+    bool has(Setting_Key key) const { return key < NUM_SETTINGS && values[key].present; }
+    const Setting_Value &value(Setting_Key key) const { return values[key]; }
+
+    // Stores a changed value and marks the key dirty. Returns false if the value is unchanged.
+    bool set(Setting_Key key, const Setting_Value &value);
+
+    // Stores a value read from the settings file, which is already on flash
+    bool load(Setting_Key key, const Setting_Value &value);
+
+    // Stores a value read from the delta file. It stays in the delta but is not dirty.
+    void loadDelta(Setting_Key key, const Setting_Value &value);
+
+    // Bit n is set while key n differs from the delta file
+    uint32_t dirtyKeys() const { return dirty; }
+
+    // Bit n is set while key n differs from the settings file on flash
+    uint32_t deltaKeys() const { return delta; }
+
+    // Call once the delta holding keys is written
+    void markPersisted(uint32_t keys) { dirty &= ~keys; }
+
+    // Call once the whole settings file is written
+    void clearDelta()
+    {
+        dirty = 0;
+        delta = 0;
+    }
+
+    // Encodes the delta keys as a MessagePack map of name to value.
+    // Returns the encoded length, or 0 if it does not fit in bufferSize.
+    size_t encodeDelta(uint8_t *buffer, size_t bufferSize) const;
+
+private:
+    Setting_Value values[NUM_SETTINGS] = {};
+    uint32_t dirty = 0;
+    uint32_t delta = 0;
+};
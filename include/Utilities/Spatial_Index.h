@@ -0,0 +1,288 @@
+#pragma once
+
+#include "Geo_Math.h"
+#include <algorithm>
+#include <vector>
+
+// Bits per axis in the cell key. 16 gives cells of about 300 m of latitude.
+#define SPATIAL_KEY_BITS 16
+
+// Cells scanned per query at most. Queries use the finest level whose cells cover the search box in this many.
+#define SPATIAL_MAX_QUERY_CELLS 9
+
+// Starting radius for nearest queries, multiplied by 4 until enough points are found
+#define SPATIAL_NEAREST_START_M 1000.0f
+
+// Half the circumference, past which every point is in range
+#define SPATIAL_MAX_RADIUS_M ((float)(M_PI * GEO_EARTH_RADIUS_M))
+
+enum Spatial_Kind : uint8_t
+{
+    SPATIAL_SAVED_LOCATION,
+    SPATIAL_PING,
+};
+
+struct Spatial_Entry
+{
+    uint32_t key;
+    Geo_Point_E7 point;
+
+    // Index into the saved locations, or the user ID of a ping's sender
+    uint32_t id;
+    uint8_t kind;
+};
+
+struct Spatial_Match
+{
+    uint8_t kind;
+    uint32_t id;
+    Geo_Point_E7 point;
+    Geo_Vector vector;
+};
+
+/*
+    Points sorted by a cell key that interleaves the bits of their latitude and longitude, so every cell at every
+    level is one contiguous run of the array. Queries cover the search box with a few cells, binary search each
+    run and measure only the points in it.
+
+    Inserts and removals keep the order, at the cost of moving the entries after them.
+    Kept free of Arduino so tools/spatial_bench.cpp can check it on the host.
+*/
+class Spatial_Index
+{
+public:
+    size_t size() const { return entries.size(); }
+    void clear() { entries.clear(); }
+    void reserve(size_t count) { entries.reserve(count); }
+
+    void insert(uint8_t kind, uint32_t id, Geo_Point_E7 point)
+    {
+        Spatial_Entry entry = {Key(point), point, id, kind};
+        entries.insert(std::upper_bound(entries.begin(), entries.end(), entry.key, keyBefore), entry);
+    }
+
+    bool remove(uint8_t kind, uint32_t id)
+    {
+        auto it = find(kind, id);
+
+        if (it == entries.end())
+        {
+            return false;
+        }
+
+        entries.erase(it);
+        return true;
+    }
+
+    // Inserts, or moves the point if it is already indexed
+    void update(uint8_t kind, uint32_t id, Geo_Point_E7 point)
+    {
+        remove(kind, id);
+        insert(kind, id, point);
+    }
+
+    // For ids that are positions in a list. Removes id and moves every later id of the kind down by one.
+    void removeAndShift(uint8_t kind, uint32_t id)
+    {
+        remove(kind, id);
+
+        for (auto &entry : entries)
+        {
+            if (entry.kind == kind && entry.id > id)
+            {
+                entry.id--;
+            }
+        }
+    }
+
+    void removeKind(uint8_t kind)
+    {
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [kind](const Spatial_Entry &entry) {
+            return entry.kind == kind;
+        }), entries.end());
+    }
+
+    // Points within radiusM of center, nearest first
+    void withinRadius(Geo_Point_E7 center, float radiusM, std::vector<Spatial_Match> &matches) const
+    {
+        matches.clear();
+        collect(center, radiusM, matches);
+        std::sort(matches.begin(), matches.end(), nearer);
+    }
+
+    // Up to count points nearest center and within maxRadiusM, nearest first
+    void nearest(Geo_Point_E7 center, size_t count, std::vector<Spatial_Match> &matches, float maxRadiusM = SPATIAL_MAX_RADIUS_M) const
+    {
+        matches.clear();
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        float radius = std::min(SPATIAL_NEAREST_START_M, maxRadiusM);
+
+        // Every point within the radius is found, so once there are count of them the nearest count are among them
+        while (true)
+        {
+            matches.clear();
+            collect(center, radius, matches);
+
+            if (matches.size() >= count || radius >= maxRadiusM || radius >= SPATIAL_MAX_RADIUS_M)
+            {
+                break;
+            }
+
+            radius = std::min(radius * 4, maxRadiusM);
+        }
+
+        size_t kept = std::min(count, matches.size());
+        std::partial_sort(matches.begin(), matches.begin() + kept, matches.end(), nearer);
+        matches.resize(kept);
+    }
+
+    static uint32_t Key(Geo_Point_E7 point)
+    {
+        return interleave(quantizeLng(point.lngE7) & CELL_MASK, quantizeLat(point.latE7));
+    }
+
+private:
+    static constexpr int64_t CELLS = 1LL << SPATIAL_KEY_BITS;
+    static constexpr uint32_t CELL_MASK = (uint32_t)CELLS - 1;
+
+    // Cell of a latitude, clamped to the poles
+    static uint32_t quantizeLat(int64_t latE7)
+    {
+        int64_t cell = floorDiv((latE7 + 900000000LL) * CELLS, 1800000000LL);
+        return (uint32_t)std::min<int64_t>(std::max<int64_t>(cell, 0), CELLS - 1);
+    }
+
+    // Cell of a longitude. Not wrapped, so a box across the antimeridian stays ordered.
+    static int64_t quantizeLng(int64_t lngE7)
+    {
+        return floorDiv((lngE7 + 1800000000LL) * CELLS, 3600000000LL);
+    }
+
+    static int64_t floorDiv(int64_t a, int64_t b)
+    {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    // Spreads the low 16 bits of v to the even bits
+    static uint32_t spread(uint32_t v)
+    {
+        v &= 0xFFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    }
+
+    static uint32_t interleave(uint32_t lngCell, uint32_t latCell)
+    {
+        return spread(lngCell) | (spread(latCell) << 1);
+    }
+
+    static bool keyBefore(uint32_t key, const Spatial_Entry &entry) { return key < entry.key; }
+    static bool entryBefore(const Spatial_Entry &entry, uint32_t key) { return entry.key < key; }
+
+    static bool nearer(const Spatial_Match &a, const Spatial_Match &b)
+    {
+        return a.vector.distanceM < b.vector.distanceM;
+    }
+
+    std::vector<Spatial_Entry>::iterator find(uint8_t kind, uint32_t id)
+    {
+        return std::find_if(entries.begin(), entries.end(), [kind, id](const Spatial_Entry &entry) {
+            return entry.kind == kind && entry.id == id;
+        });
+    }
+
+    void collect(Geo_Point_E7 center, float radiusM, std::vector<Spatial_Match> &matches) const
+    {
+        Geo_Projection projection(center);
+
+        if (radiusM >= SPATIAL_MAX_RADIUS_M)
+        {
+            scan(projection, center, radiusM, entries.begin(), entries.end(), matches);
+            return;
+        }
+
+        // Box around the circle, in 1e-7 degrees. Longitude spans everything when the circle reaches a pole.
+        double dLatE7 = radiusM / (double)GEO_METERS_PER_E7;
+        double latRad = Geo_Math::toDegrees(center.latE7) * M_PI / 180.0;
+        double poleGap = (90.0 - fabs(Geo_Math::toDegrees(center.latE7))) * GEO_E7;
+
+        int64_t minLat = center.latE7 - (int64_t)dLatE7 - 1;
+        int64_t maxLat = center.latE7 + (int64_t)dLatE7 + 1;
+
+        bool allLng = dLatE7 >= poleGap;
+        double dLngE7 = allLng ? 0 : dLatE7 / cos(latRad + (latRad < 0 ? -1 : 1) * dLatE7 / GEO_E7 * M_PI / 180.0);
+        allLng |= dLngE7 >= 1800000000.0;
+
+        int64_t minLngCell = quantizeLng(center.lngE7 - (int64_t)dLngE7 - 1);
+        int64_t maxLngCell = quantizeLng(center.lngE7 + (int64_t)dLngE7 + 1);
+        int64_t minLatCell = quantizeLat(minLat);
+        int64_t maxLatCell = quantizeLat(maxLat);
+
+        // Finest level that covers the box in a few cells
+        int level = SPATIAL_KEY_BITS;
+        int64_t latCells = 0;
+        int64_t lngCells = 0;
+
+        for (; level > 0; level--)
+        {
+            int shift = SPATIAL_KEY_BITS - level;
+            latCells = (maxLatCell >> shift) - (minLatCell >> shift) + 1;
+            lngCells = allLng ? ((int64_t)1 << level) : std::min<int64_t>((maxLngCell >> shift) - (minLngCell >> shift) + 1, 1LL << level);
+
+            if (latCells * lngCells <= SPATIAL_MAX_QUERY_CELLS)
+            {
+                break;
+            }
+        }
+
+        if (level == 0)
+        {
+            scan(projection, center, radiusM, entries.begin(), entries.end(), matches);
+            return;
+        }
+
+        int shift = SPATIAL_KEY_BITS - level;
+        int64_t levelMask = (1LL << level) - 1;
+        int64_t firstLatCell = minLatCell >> shift;
+        int64_t firstLngCell = allLng ? 0 : minLngCell >> shift;
+
+        for (int64_t lat = firstLatCell; lat < firstLatCell + latCells; lat++)
+        {
+            for (int64_t lng = firstLngCell; lng < firstLngCell + lngCells; lng++)
+            {
+                uint32_t low = interleave((uint32_t)(lng & levelMask) << shift, (uint32_t)lat << shift);
+                uint64_t high = (uint64_t)low + (1ULL << (2 * shift));
+
+                auto begin = std::lower_bound(entries.begin(), entries.end(), low, entryBefore);
+                auto end = high > UINT32_MAX ? entries.end() : std::lower_bound(begin, entries.end(), (uint32_t)high, entryBefore);
+
+                scan(projection, center, radiusM, begin, end, matches);
+            }
+        }
+    }
+
+    static void scan(const Geo_Projection &projection, Geo_Point_E7 center, float radiusM,
+                     std::vector<Spatial_Entry>::const_iterator begin, std::vector<Spatial_Entry>::const_iterator end,
+                     std::vector<Spatial_Match> &matches)
+    {
+        for (auto it = begin; it != end; it++)
+        {
+            Geo_Vector vector = projection.vectorTo(center, it->point);
+
+            if (vector.distanceM <= radiusM)
+            {
+                matches.push_back({it->kind, it->id, it->point, vector});
+            }
+        }
+    }
+
+    std::vector<Spatial_Entry> entries;
+};
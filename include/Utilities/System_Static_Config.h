@@ -0,0 +1,67 @@
+#pragma once
+
+/*
+    Allocation table for tasks, timers and queues registered through System_Utils.
+
+    With SYSTEM_STATIC_ALLOCATION set to 1, the dynamic registerTask, registerTimer and registerQueue overloads
+    take their memory from the buffers declared here instead of the heap. Tasks and timers are matched by name.
+    Registering one that is not declared fails and logs an error, so every allocation is known at build time.
+    The total is checked against SYSTEM_STATIC_RAM_BUDGET when System_Utils.cpp compiles.
+
+    Applications add their own tasks and timers by defining SYSTEM_STATIC_APP_TASKS and SYSTEM_STATIC_APP_TIMERS
+    in the same form, and may raise the budget.
+*/
+
+#ifndef SYSTEM_STATIC_ALLOCATION
+#define SYSTEM_STATIC_ALLOCATION 0
+#endif
+
+// Registry capacities. IDs index the registries and are reused once freed.
+#define SYSTEM_MAX_TASKS 16
+#define SYSTEM_MAX_TIMERS 16
+#define SYSTEM_MAX_QUEUES 16
+
+// X(identifier, task name, stack size in bytes)
+#define SYSTEM_STATIC_LIBRARY_TASKS(X) \
+    X(LED_TASK, "LED Task", 4096) \
+    X(RPC_LOOP, "RpcLoop", 8192) \
+    X(OTA_HANDLER, "OTA Handler", 8192) \
+    X(LOG_DRAIN, "Log Drain", 3072) \
+    X(PERSISTENCE, "Persistence", 4096) \
+    X(BOOT_WORKER, "Boot Worker", 6144) \
+    X(GPS, "GPS", 3072) \
+    X(HEADING, "Heading", 3072)
+
+#ifndef SYSTEM_STATIC_APP_TASKS
+#define SYSTEM_STATIC_APP_TASKS(X)
+#endif
+
+// X(identifier, timer name)
+#define SYSTEM_STATIC_LIBRARY_TIMERS(X) \
+    X(LOCK_SCREEN, "Lock Screen")
+
+#ifndef SYSTEM_STATIC_APP_TIMERS
+#define SYSTEM_STATIC_APP_TIMERS(X)
+#endif
+
+#define SYSTEM_STATIC_TASKS(X) SYSTEM_STATIC_LIBRARY_TASKS(X) SYSTEM_STATIC_APP_TASKS(X)
+#define SYSTEM_STATIC_TIMERS(X) SYSTEM_STATIC_LIBRARY_TIMERS(X) SYSTEM_STATIC_APP_TIMERS(X)
+
+// Storage for queues created without their own buffers, such as the ESP-NOW RPC queue.
+// Freed space is reclaimed when the most recently created queue is deleted.
+#ifndef SYSTEM_STATIC_QUEUE_ARENA_BYTES
+#define SYSTEM_STATIC_QUEUE_ARENA_BYTES 2048
+#endif
+
+#ifndef SYSTEM_STATIC_ARENA_QUEUES
+#define SYSTEM_STATIC_ARENA_QUEUES 4
+#endif
+
+// How long registerTask waits for the idle task to release the buffers of a task deleted just before
+#ifndef SYSTEM_STATIC_TASK_REUSE_WAIT_MS
+#define SYSTEM_STATIC_TASK_REUSE_WAIT_MS 100
+#endif
+
+#ifndef SYSTEM_STATIC_RAM_BUDGET
+#define SYSTEM_STATIC_RAM_BUDGET (48 * 1024)
+#endif
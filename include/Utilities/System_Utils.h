@@ -1,6 +1,7 @@
 #pragma once
 
 #include "globalDefines.h"
+#include "System_Static_Config.h"
 #include <Arduino.h>
 #include <unordered_map>
 #include <vector>
@@ -16,8 +17,15 @@
 #include "mbedtls/base64.h"
 
 #include "esp_rom_crc.h"
+#include "esp_heap_caps.h"
 
+#include "Trace_Utils.h"
+#include "Runtime_Profiler.h"
+#include "Log_Utils.h"
+#include "Heap_Utils.h"
 #include "FilesystemUtils.h"
+#include "Persistence_Utils.h"
+#include "Asset_Utils.h"
 #include "Bluetooth_Utils.h"
 #include "VersionUtils.h"
 
@@ -147,6 +155,18 @@ public:
     static void UploadOtaChunkRpc(JsonDocument &doc);
     static void EndOtaRpc(JsonDocument &doc);
 
+    // Runtime profiling
+    // Starts sampling tasks, queues and heap every RUNTIME_PROFILER_PERIOD_MS
+    static void startRuntimeProfiler();
+    static void sampleRuntimeStats(TimerHandle_t xTimer);
+
+    // Copies up to maxSamples history samples, oldest first. Returns the number copied.
+    static size_t RuntimeHistory(Runtime_Sample *samples, size_t maxSamples);
+
+    // Reports tasks, queues, timers and heap regions.
+    // Pass "history": n for the last n samples and "reset": true to clear peaks and timer stats.
+    static void GetRuntimeStatsRpc(JsonDocument &doc);
+
     // Debug Companion Functionality
     static void GetSystemInfoRpc(JsonDocument &doc);
     static void sendDisplayContents(Adafruit_SSD1306 *display);
@@ -171,21 +191,58 @@ private:
     static EventHandler disableInterrupts;
     static EventHandler systemShutdown;
 
-    // Timer functionality
-    static std::unordered_map<int, TimerHandle_t> systemTimers;
+    // Settings_Registry listeners
+    static void onUserIDChanged();
+    static void onDeviceNameChanged();
+    static void onSilentModeChanged();
+
+    // Registries. An ID is the index of its handle. Free slots hold nullptr.
+    static TimerHandle_t systemTimers[SYSTEM_MAX_TIMERS];
+    static TaskHandle_t systemTasks[SYSTEM_MAX_TASKS];
+    static QueueHandle_t systemQueues[SYSTEM_MAX_QUEUES];
+
+    // Timer slots are handed out round robin, so a deleted timer's slot is not reused while the timer daemon may still run it
     static int nextTimerID;
 
-    // Task functionality
-    static std::unordered_map<int, TaskHandle_t> systemTasks;
-    static int nextTaskID;
+    static bool isTimer(int timerID) { return timerID >= 0 && timerID < SYSTEM_MAX_TIMERS && systemTimers[timerID] != nullptr; }
+    static bool isTask(int taskID) { return taskID >= 0 && taskID < SYSTEM_MAX_TASKS && systemTasks[taskID] != nullptr; }
+    static bool isQueue(int queueID) { return queueID >= 0 && queueID < SYSTEM_MAX_QUEUES && systemQueues[queueID] != nullptr; }
 
-    // Queue functionality
-    static std::unordered_map<int, QueueHandle_t> systemQueues;
-    static int nextQueueID;
+    // Each returns the ID of the new entry, or -1 if the registry is full. Call with the registry locked.
+    static int addTimer(TimerHandle_t handle, int timerID);
+    static int addTask(TaskHandle_t handle);
+    static int addQueue(QueueHandle_t handle);
+    static int freeTimerSlot();
 
     // ADC Users
     static std::unordered_map<uint8_t, bool> adcUsers;
 
+    // Runtime profiling
+    // The mutex guards the registries above and the profiles below against the sampling timer
+    static SemaphoreHandle_t profilerMutex();
+    static void lockRegistry();
+    static void unlockRegistry();
+    static void profiledTimerCallback(TimerHandle_t xTimer);
+    static void addHeapRegion(JsonArray regions, const char *name, uint32_t caps);
+
+    static SemaphoreHandle_t _ProfilerMutex;
+    static StaticSemaphore_t _ProfilerMutexBuffer;
+
+    static Task_Profile taskProfiles[SYSTEM_MAX_TASKS];
+    static Queue_Profile queueProfiles[SYSTEM_MAX_QUEUES];
+    static Timer_Profile timerProfiles[SYSTEM_MAX_TIMERS];
+
+    static Runtime_History runtimeHistory;
+    static int64_t lastSampleUS;
+
+    #if configUSE_TRACE_FACILITY == 1
+    // Scheduler snapshot for sampleRuntimeStats. Only used from the timer daemon task.
+    static TaskStatus_t taskStatusBuffer[SYSTEM_MAX_TASKS + RUNTIME_PROFILER_SYSTEM_TASKS];
+    #endif
+
+    static StaticTimer_t profilerTimerBuffer;
+    static int profilerTimerID;
+
     static StaticTimer_t healthTimerBuffer;
     static int healthTimerID;
     static int otaTaskID;
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Arduino.h>
+#include "ArduinoJson.h"
+#include <atomic>
+
+// Set to 1 to compile in tracing. With 0 every TRACE_ macro compiles to nothing and no buffers are allocated.
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+// Events kept per core. Once full the oldest events are overwritten.
+#define TRACE_EVENTS_PER_CORE 256
+
+// Events dumped per GetTraceRpc call unless "count" is given
+#define TRACE_DEFAULT_DUMP_COUNT 48
+
+enum Trace_Event_ID : uint16_t
+{
+    TRACE_RADIO_RECEIVE,        // arg: sender
+    TRACE_RADIO_SEND,
+    TRACE_MESSAGE_RECEIVED,     // arg: sender
+    TRACE_RPC_CALL,             // arg: channel ID
+    TRACE_DISPLAY_COMMAND,      // arg: command type
+    TRACE_DISPLAY_DRAW,
+    TRACE_LED_FRAME,
+    TRACE_LED_SHOW,
+    NUM_TRACE_EVENTS,
+};
+
+enum Trace_Phase : uint8_t
+{
+    TRACE_PHASE_BEGIN,
+    TRACE_PHASE_END,
+    TRACE_PHASE_INSTANT,
+};
+
+struct Trace_Record
+{
+    // Claim number on its core plus one, stored last. 0 while the record is being written.
+    uint32_t sequence;
+
+    uint32_t timestampUS;
+
+    // Handle of the task that recorded the event
+    uint32_t task;
+    uint32_t arg;
+
+    uint16_t eventID;
+    uint8_t phase;
+    uint8_t core;
+};
+
+/*
+    Binary trace log for hot paths. Each core writes to its own ring buffer, claiming slots with an
+    atomic counter, so recording an event never takes a lock or touches Serial.
+
+    GetTraceRpc pages through the log oldest first, with the cores merged by timestamp. Events on one core keep the
+    order they claimed their slots in. Records a writer has not finished are skipped, and every event carries its
+    sequence so pages can be merged without duplicates. Send "hold": true to keep recording paused between pages,
+    and "format": "chrome" to get Chrome trace events. tools/trace_merge.py joins chrome pages into one trace with
+    task names.
+*/
+class Trace_Utils
+{
+public:
+    static void record(Trace_Event_ID eventID, Trace_Phase phase, uint32_t arg);
+
+    static const char *EventName(uint16_t eventID);
+
+    // Paused traces drop new events
+    static void setPaused(bool paused);
+    static void clear();
+
+    // Returns "total", then up to "count" events from "offset". Pass "clear": true to empty the log afterwards.
+    static void GetTraceRpc(JsonDocument &doc);
+
+private:
+#if TRACE_ENABLED == 1
+    static Trace_Record _Buffers[portNUM_PROCESSORS][TRACE_EVENTS_PER_CORE];
+    static std::atomic<uint32_t> _Heads[portNUM_PROCESSORS];
+    static std::atomic<bool> _Paused;
+
+    // Copies the oldest complete event left across all cores, merging the cores by timestamp.
+    // positions holds how far each core has been read and starts at 0. Incomplete records passed over are
+    // added to skipped. Returns false once every core is read.
+    static bool nextEvent(size_t positions[portNUM_PROCESSORS], Trace_Record &event, size_t &skipped);
+
+    // Copies the index'th oldest event recorded on one core. Returns false if its writer has not finished it.
+    static bool copyEvent(uint8_t core, size_t index, Trace_Record &event);
+    static size_t eventCount(uint8_t core);
+#endif
+};
+
+// Records a begin event on construction and an end event when it goes out of scope
+class Trace_Scope
+{
+public:
+    Trace_Scope(Trace_Event_ID eventID, uint32_t arg) : eventID(eventID), arg(arg)
+    {
+        Trace_Utils::record(eventID, TRACE_PHASE_BEGIN, arg);
+    }
+
+    ~Trace_Scope()
+    {
+        Trace_Utils::record(eventID, TRACE_PHASE_END, arg);
+    }
+
+private:
+    Trace_Event_ID eventID;
+    uint32_t arg;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#if TRACE_ENABLED == 1
+#define TRACE_SCOPE(eventID, arg) Trace_Scope TRACE_CONCAT(_traceScope, __LINE__)(eventID, (uint32_t)(arg))
+#define TRACE_BEGIN(eventID, arg) Trace_Utils::record(eventID, TRACE_PHASE_BEGIN, (uint32_t)(arg))
+#define TRACE_END(eventID, arg) Trace_Utils::record(eventID, TRACE_PHASE_END, (uint32_t)(arg))
+#define TRACE_INSTANT(eventID, arg) Trace_Utils::record(eventID, TRACE_PHASE_INSTANT, (uint32_t)(arg))
+#else
+#define TRACE_SCOPE(eventID, arg) do {} while (0)
+#define TRACE_BEGIN(eventID, arg) do {} while (0)
+#define TRACE_END(eventID, arg) do {} while (0)
+#define TRACE_INSTANT(eventID, arg) do {} while (0)
+#endif
@@ -33,6 +33,7 @@
 #define ACTION_CLEAR_LOCATIONS 28
 #define ACTION_CLEAR_MESSAGES 29
 #define ACTION_OPEN_WIFI_RPC_WINDOW 30
+#define ACTION_OPEN_NEARBY_WINDOW 31
 
 #define ACTION_CALL_FUNCTIONAL_WINDOW_STATE 0xFFFFFFFB
 #define ACTION_RETURN_FROM_FUNCTIONAL_WINDOW_STATE 0xFFFFFFFC
@@ -0,0 +1,265 @@
+#include "Keyframe_Pattern.h"
+#include "FilesystemUtils.h"
+#include <string.h>
+
+namespace
+{
+    LED_Easing parseEasing(const char *name)
+    {
+        if (name == nullptr)
+        {
+            return LED_EASE_LINEAR;
+        }
+
+        if (strcmp(name, "in") == 0)
+        {
+            return LED_EASE_IN;
+        }
+
+        if (strcmp(name, "out") == 0)
+        {
+            return LED_EASE_OUT;
+        }
+
+        if (strcmp(name, "inOut") == 0)
+        {
+            return LED_EASE_IN_OUT;
+        }
+
+        if (strcmp(name, "step") == 0)
+        {
+            return LED_EASE_STEP;
+        }
+
+        return LED_EASE_LINEAR;
+    }
+}
+
+Keyframe_Pattern::Keyframe_Pattern()
+{
+    memset(&program, 0, sizeof(program));
+    targetIdx = -1;
+}
+
+bool Keyframe_Pattern::CompileProgram(JsonVariantConst source, LED_Program &program)
+{
+    LED_Program compiled;
+    memset(&compiled, 0, sizeof(compiled));
+
+    JsonVariantConst lengthMS = source["lengthMS"];
+
+    // Negative, fractional or out of range lengths would otherwise be cut down silently
+    if (!lengthMS.isNull() && !lengthMS.is<uint32_t>())
+    {
+        return false;
+    }
+
+    compiled.lengthMS = lengthMS.isNull() ? 1000 : lengthMS.as<uint32_t>();
+
+    JsonArrayConst tracks = source["tracks"];
+
+    if (tracks.isNull() || tracks.size() == 0 || tracks.size() > MAX_LED_PROGRAM_TRACKS)
+    {
+        return false;
+    }
+
+    for (JsonObjectConst trackSource : tracks)
+    {
+        LED_Track &track = compiled.tracks[compiled.numTracks++];
+
+        track.target = trackSource["target"] | false;
+        track.beginIdx = trackSource["beginIdx"] | -1;
+        track.endIdx = trackSource["endIdx"] | track.beginIdx;
+
+        JsonArrayConst color = trackSource["color"];
+        track.useThemeColor = color.isNull();
+
+        if (!track.useThemeColor)
+        {
+            track.color = CRGB(color[0] | 0, color[1] | 0, color[2] | 0);
+        }
+
+        JsonArrayConst keyframes = trackSource["keyframes"];
+
+        if (keyframes.isNull() || keyframes.size() == 0 || compiled.numKeyframes + keyframes.size() > MAX_LED_PROGRAM_KEYFRAMES)
+        {
+            return false;
+        }
+
+        track.firstKeyframe = compiled.numKeyframes;
+        uint16_t lastPosition = 0;
+
+        for (JsonObjectConst keyframeSource : keyframes)
+        {
+            float t = keyframeSource["t"] | 0.0f;
+            t = constrain(t, 0.0f, 1.0f);
+
+            LED_Keyframe &keyframe = compiled.keyframes[compiled.numKeyframes++];
+            keyframe.position = (uint16_t)(t * UINT16_MAX);
+            keyframe.level = keyframeSource["level"] | 255;
+            keyframe.easing = parseEasing(keyframeSource["ease"].as<const char *>());
+
+            // Keyframes must be in order
+            if (track.numKeyframes > 0 && keyframe.position < lastPosition)
+            {
+                return false;
+            }
+
+            lastPosition = keyframe.position;
+            track.numKeyframes++;
+        }
+    }
+
+    program = compiled;
+    return true;
+}
+
+bool Keyframe_Pattern::loadProgram(JsonVariantConst source)
+{
+    LED_Program compiled;
+
+    if (!CompileProgram(source, compiled))
+    {
+        #if DEBUG == 1
+        Serial.println("Keyframe_Pattern::loadProgram: Invalid program");
+        #endif
+        return false;
+    }
+
+    setProgram(compiled);
+    return true;
+}
+
+bool Keyframe_Pattern::loadProgramFile(const std::string &filename)
+{
+    DynamicJsonDocument doc(1024);
+
+    if (FilesystemModule::Utilities::ReadFile(filename, doc) != FilesystemModule::FILESYSTEM_OK)
+    {
+        return false;
+    }
+
+    return loadProgram(doc.as<JsonVariantConst>());
+}
+
+void Keyframe_Pattern::setProgram(const LED_Program &program)
+{
+    clearPattern();
+    this->program = program;
+}
+
+void Keyframe_Pattern::setTarget(int ledIdx)
+{
+    targetIdx = ledIdx;
+}
+
+void Keyframe_Pattern::configurePattern(JsonDocument &config)
+{
+    if (config.containsKey("program"))
+    {
+        loadProgram(config["program"]);
+    }
+
+    if (config.containsKey("file"))
+    {
+        loadProgramFile(config["file"].as<std::string>());
+    }
+
+    if (config.containsKey("target"))
+    {
+        setTarget(config["target"].as<int>());
+    }
+}
+
+bool Keyframe_Pattern::trackRange(const LED_Track &track, int &begin, int &end)
+{
+    if (track.target)
+    {
+        begin = targetIdx;
+        end = targetIdx;
+    }
+    else
+    {
+        begin = track.beginIdx;
+        end = track.endIdx;
+    }
+
+    if (begin < 0 || end < begin)
+    {
+        return false;
+    }
+
+    end = min(end, (int)numLeds - 1);
+    return begin <= end && leds != nullptr;
+}
+
+bool Keyframe_Pattern::iterateFrame()
+{
+    if (program.numTracks == 0)
+    {
+        return true;
+    }
+
+    size_t lengthMS = animationMS > 0 ? animationMS : program.lengthMS;
+    size_t currMS = elapsedMS();
+    bool loopDone = lengthMS == 0 || currMS >= lengthMS;
+
+    if (loopDone)
+    {
+        clearPattern();
+        return true;
+    }
+
+    uint16_t position = LED_Program_Evaluator::Position(currMS, lengthMS);
+
+    for (uint8_t t = 0; t < program.numTracks; t++)
+    {
+        const LED_Track &track = program.tracks[t];
+        int begin, end;
+
+        if (!trackRange(track, begin, end))
+        {
+            continue;
+        }
+
+        CRGB color = track.useThemeColor ? themeColor : track.color;
+        color.nscale8(LED_Program_Evaluator::Level(program, track, position));
+
+        fill_solid(&leds[begin], end - begin + 1, color);
+    }
+
+    currTick++;
+    return false;
+}
+
+void Keyframe_Pattern::clearPattern()
+{
+    for (uint8_t t = 0; t < program.numTracks; t++)
+    {
+        int begin, end;
+
+        if (trackRange(program.tracks[t], begin, end))
+        {
+            fill_solid(&leds[begin], end - begin + 1, CRGB::Black);
+        }
+    }
+
+    resetPattern();
+}
+
+void Keyframe_Pattern::GetLayerRange(int &begin, int &end)
+{
+    begin = (int)numLeds;
+    end = -1;
+
+    for (uint8_t t = 0; t < program.numTracks; t++)
+    {
+        int trackBegin, trackEnd;
+
+        if (trackRange(program.tracks[t], trackBegin, trackEnd))
+        {
+            begin = min(begin, trackBegin);
+            end = max(end, trackEnd);
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#include "LED_Output_Stage.h"
+
+namespace
+{
+    // 2.2 gamma curve in 8.8 fixed point. The fraction is kept for dithering.
+    struct Gamma_Table
+    {
+        uint16_t levels[256];
+
+        Gamma_Table()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                levels[i] = (uint16_t)(powf(i / 255.0f, 2.2f) * (255.0f * 256.0f) + 0.5f);
+            }
+        }
+    };
+
+    const Gamma_Table gammaTable;
+}
+
+uint16_t LED_Output_Stage::_BudgetMA = LED_DEFAULT_BUDGET_MA;
+long LED_Output_Stage::_BatteryPercentage = 100;
+uint16_t LED_Output_Stage::_EffectiveBudgetMA = LED_DEFAULT_BUDGET_MA;
+
+bool LED_Output_Stage::_GammaEnabled = true;
+bool LED_Output_Stage::_DitherEnabled = true;
+
+uint8_t *LED_Output_Stage::_DitherError = nullptr;
+size_t LED_Output_Stage::_NumLeds = 0;
+
+uint32_t LED_Output_Stage::_LastEstimateMA = 0;
+uint32_t LED_Output_Stage::_LimitedFrames = 0;
+
+void LED_Output_Stage::init(size_t numLeds)
+{
+    if (_DitherError != nullptr && _NumLeds != numLeds)
+    {
+        delete[] _DitherError;
+        _DitherError = nullptr;
+    }
+
+    if (_DitherError == nullptr)
+    {
+        _DitherError = new uint8_t[numLeds * 3];
+    }
+
+    memset(_DitherError, 0, numLeds * 3);
+    _NumLeds = numLeds;
+}
+
+void LED_Output_Stage::setBudgetMA(uint16_t budgetMA)
+{
+    _BudgetMA = budgetMA;
+    updateEffectiveBudget();
+}
+
+void LED_Output_Stage::setBatteryPercentage(long percentage)
+{
+    _BatteryPercentage = constrain(percentage, 0L, 100L);
+    updateEffectiveBudget();
+}
+
+void LED_Output_Stage::updateEffectiveBudget()
+{
+    long percentage = min(_BatteryPercentage, (long)LED_FULL_BUDGET_BATTERY_PERCENT);
+    long budgetPercent = map(percentage, 0, LED_FULL_BUDGET_BATTERY_PERCENT, LED_EMPTY_BATTERY_BUDGET_PERCENT, 100);
+
+    _EffectiveBudgetMA = (uint32_t)_BudgetMA * budgetPercent / 100;
+}
+
+uint32_t LED_Output_Stage::EstimateMA(const CRGB *leds, size_t numLeds)
+{
+    uint32_t total = 0;
+
+    for (size_t i = 0; i < numLeds; i++)
+    {
+        total += leds[i].r + leds[i].g + leds[i].b;
+    }
+
+    return numLeds * LED_IDLE_MA + (total * LED_CHANNEL_MA + 254) / 255;
+}
+
+void LED_Output_Stage::render(const CRGB *frame, CRGB *output, size_t numLeds)
+{
+    if (frame == nullptr || output == nullptr)
+    {
+        return;
+    }
+
+    bool dither = _DitherEnabled && _DitherError != nullptr && numLeds <= _NumLeds;
+    size_t numChannels = numLeds * 3;
+
+    // Sum the gamma corrected frame in 8.8 fixed point
+    uint32_t total = 0;
+
+    for (size_t c = 0; c < numChannels; c++)
+    {
+        uint8_t level = frame[c / 3].raw[c % 3];
+        total += _GammaEnabled ? gammaTable.levels[level] : level << 8;
+    }
+
+    // Rounding back to 8 bits can add up to one step per channel, so leave room for it
+    uint32_t reservedMA = numLeds * LED_IDLE_MA + (numChannels * LED_CHANNEL_MA + 254) / 255;
+    uint32_t channelBudgetMA = _EffectiveBudgetMA > reservedMA ? _EffectiveBudgetMA - reservedMA : 0;
+
+    // Both sides are in units of 1 / (255 * 256) mA
+    uint64_t frameCurrent = (uint64_t)total * LED_CHANNEL_MA;
+    uint64_t budgetCurrent = (uint64_t)channelBudgetMA * 255 * 256;
+
+    // 16.16 scale applied to every channel
+    uint32_t scale = 0x10000;
+
+    if (frameCurrent > budgetCurrent)
+    {
+        scale = (uint32_t)((budgetCurrent << 16) / frameCurrent);
+        _LimitedFrames++;
+    }
+
+    uint32_t outputTotal = 0;
+
+    for (size_t c = 0; c < numChannels; c++)
+    {
+        uint8_t level = frame[c / 3].raw[c % 3];
+        uint32_t value = _GammaEnabled ? gammaTable.levels[level] : level << 8;
+        value = (value * scale) >> 16;
+
+        if (dither)
+        {
+            // Carry the remainder so the average over frames matches the 8.8 value
+            value += _DitherError[c];
+            _DitherError[c] = value & 0xFF;
+            value >>= 8;
+        }
+        else
+        {
+            value = (value + 0x80) >> 8;
+        }
+
+        output[c / 3].raw[c % 3] = value;
+        outputTotal += value;
+    }
+
+    _LastEstimateMA = numLeds * LED_IDLE_MA + (outputTotal * LED_CHANNEL_MA + 254) / 255;
+}
@@ -0,0 +1,49 @@
+#include "Ring_Kernels.h"
+
+namespace
+{
+    // Brightness out of 65536 indexed by distance from the point in 1/256ths of the fade width.
+    // The extra entry lets the kernel interpolate past the last index.
+    struct Falloff_Tables
+    {
+        uint16_t curves[NUM_RING_FALLOFFS][257];
+
+        Falloff_Tables()
+        {
+            for (uint32_t i = 0; i <= 256; i++)
+            {
+                curves[RING_FALLOFF_LINEAR][i] = min((256 - i) << 8, (uint32_t)UINT16_MAX);
+                curves[RING_FALLOFF_QUADRATIC][i] = min(65536 - i * i, (uint32_t)UINT16_MAX);
+            }
+        }
+    };
+
+    const Falloff_Tables falloffTables;
+}
+
+const uint16_t *Ring_Kernels::falloffTable(Ring_Falloff falloff)
+{
+    return falloffTables.curves[falloff < NUM_RING_FALLOFFS ? falloff : RING_FALLOFF_LINEAR];
+}
+
+void Ring_Kernels::renderPoint(CRGB *leds, int beginIdx, int endIdx, int ledSpan, uint32_t pointAngle, uint32_t fadeWidth, const CRGB &color, Ring_Falloff falloff)
+{
+    if (leds == nullptr || ledSpan <= 0)
+    {
+        return;
+    }
+
+    const uint16_t *table = falloffTable(falloff);
+    uint64_t fadeReciprocal = fadeWidth == 0 ? 0 : (1ULL << 48) / fadeWidth;
+
+    // LED angles are stepped so there is no division per LED
+    uint32_t angleStep = (uint32_t)(0x100000000ULL / (uint32_t)ledSpan);
+    uint32_t angle = 0;
+
+    for (int i = beginIdx; i <= endIdx; i++, angle += angleStep)
+    {
+        CRGB out = color;
+        out.nscale8(pointBrightness(angle, pointAngle, fadeWidth, fadeReciprocal, table));
+        leds[i] = out;
+    }
+}
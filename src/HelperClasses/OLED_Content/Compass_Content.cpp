@@ -4,7 +4,7 @@ Compass_Content *Compass_Content::thisInstance = nullptr;
 StaticTimer_t Compass_Content::updateTimerBuffer;
 TimerHandle_t Compass_Content::updateTimer = xTimerCreateStatic("CompassUpdate", pdMS_TO_TICKS(25), pdTRUE, (void *)0, updateCompass, &updateTimerBuffer);
 
-Compass_Content::Compass_Content(Adafruit_SSD1306 *disp)
+Compass_Content::Compass_Content(Display_Panel *disp)
 {
     display = disp;
     thisInstance = this;
@@ -69,7 +69,7 @@ void Compass_Content::printContent()
 
     display->display();
 
-    LED_Manager::pointNorth(NavigationUtils::GetAzimuth());
+    LED_Manager::pointNorth(Heading_Utils::GetAzimuth());
 }
 
 void Compass_Content::encUp()
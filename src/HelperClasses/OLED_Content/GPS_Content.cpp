@@ -20,8 +20,7 @@ void GPS_Content::printContent()
 {
     display->fillRect(0, 8, OLED_WIDTH, OLED_HEIGHT - 16, BLACK);
 
-    NavigationUtils::UpdateGPS();
-    TinyGPSLocation loc = NavigationUtils::GetLocation();
+    GPS_Fix loc = NavigationUtils::GetLocation();
 
     display->setCursor(0, 8);
     display->print(" Lat:");
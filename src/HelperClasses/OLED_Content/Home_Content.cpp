@@ -1,6 +1,6 @@
 #include "Home_Content.h"
 
-Home_Content::Home_Content(Adafruit_SSD1306 *display)
+Home_Content::Home_Content(Display_Panel *display)
 {
     this->type = ContentType::HOME;
     this->display = display;
@@ -16,10 +16,7 @@ Home_Content::~Home_Content()
 
 void Home_Content::printContent()
 {
-
-    NavigationUtils::UpdateGPS();
-    // TinyGPSDate date;
-    TinyGPSTime time = NavigationUtils::GetTime();
+    GPS_Time time = NavigationUtils::GetTime();
     if (time.isValid())
     {
         // Adjust for timezone -4
@@ -33,7 +30,7 @@ void Home_Content::printContent()
             hour -= 4;
         }
 
-        if (FilesystemModule::Utilities::SettingsFile()["24H Time"].as<bool>())
+        if (Settings_Registry::getBool(SETTING_24H_TIME))
         {
             display->setCursor(Display_Utils::alignTextRight(5), Display_Utils::selectTextLine(2));
             display->printf("%02d:%02d", hour, time.minute());
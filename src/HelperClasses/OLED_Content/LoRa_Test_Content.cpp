@@ -1,6 +1,6 @@
 #include "LoRa_Test_Content.h"
 
-LoRa_Test_Content::LoRa_Test_Content(Adafruit_SSD1306 *disp)
+LoRa_Test_Content::LoRa_Test_Content(Display_Panel *disp)
 {
     display = disp;
     type = ContentType::LORA_TEST;
@@ -96,8 +96,9 @@ void LoRa_Test_Content::printContent()
 
 uint8_t LoRa_Test_Content::sendBroadcast()
 {
-    uint32_t time = NavigationUtils::GetTime().value();
-    uint32_t date = NavigationUtils::GetDate().value();
+    GPS_Fix fix = NavigationUtils::GetFix();
+    uint32_t time = fix.time;
+    uint32_t date = fix.date;
     const char *senderName = Settings_Manager::settings["User"]["Name"]["cfgVal"].as<const char *>();
     MessageBase msg = MessageBase(time, date, 0, LoraUtils::UserID(), senderName, esp_random());
 
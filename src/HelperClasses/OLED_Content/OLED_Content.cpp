@@ -1,6 +1,6 @@
 #include "OLED_Content.h"
 
-Adafruit_SSD1306 *OLED_Content::display = nullptr;
+Display_Panel *OLED_Content::display = nullptr;
 QueueHandle_t OLED_Content::displayCommandQueue;
 int OLED_Content::refreshTimerID;
 
@@ -60,7 +60,7 @@ OLED_Content_List::OLED_Content_List()
     this->type = ContentType::LIST;
 }
 
-OLED_Content_List::OLED_Content_List(Adafruit_SSD1306 *display)
+OLED_Content_List::OLED_Content_List(Display_Panel *display)
 {
     this->display = display;
     this->head = NULL;
@@ -1,6 +1,6 @@
 #include "Save_Confirm_Content.h"
 
-Save_Confirm_Content::Save_Confirm_Content(Adafruit_SSD1306 *disp)
+Save_Confirm_Content::Save_Confirm_Content(Display_Panel *disp)
 {
     display = disp;
     type = ContentType::SAVE_CONFIRM; 
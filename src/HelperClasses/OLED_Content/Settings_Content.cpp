@@ -158,6 +158,20 @@ void Settings_Content::refresh()
     this->printContent();
 }
 
+// Drops any nested selection and points the content back at the top of the settings document
+void Settings_Content::resetToRoot(JsonDocument &settings)
+{
+    while (!variantStack.empty())
+    {
+        variantStack.pop();
+    }
+
+    ArduinoJson::JsonVariant variant = settings;
+    currentNode.variant = variant;
+    currentNode.type = Settings_Manager::getVariantType(variant);
+    currentNode.idx = 0;
+}
+
 size_t Settings_Content::getVariantDepth()
 {
 #if DEBUG == 1
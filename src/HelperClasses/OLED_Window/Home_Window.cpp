@@ -16,6 +16,7 @@ Home_Window::Home_Window() : OLED_Window()
     trackingState = new Tracking_State();
     selectMessageState = new Select_Message_State();
     selectLocationState = new Select_Location_State();
+    selectLocationState->setCurrentLocationName(CURR_LOC);
     selectionState = new SelectKeyValueState();
     saveLocationState = new SaveLocationState();
     lockState = new Lock_State();
@@ -142,29 +143,21 @@ void Home_Window::transferState(State_Transfer_Data &transferData)
 
         // Transfer to Select Message State
         delete transferData.serializedData;
-        transferData.serializedData = new DynamicJsonDocument(1024);
+        transferData.serializedData = nullptr;
 
-        JsonArray msgArray = (*transferData.serializedData).createNestedArray("Messages");
-
-        if (!useCurrLocation)
-        {
-            msgArray.add(locName);
-        }
-
-        LoraUtils::SerializeSavedMessageList(*transferData.serializedData);
+        selectMessageState->setLocationMessage(useCurrLocation ? std::string() : locName);
 
         newState = selectMessageState;
     }
     // Message selected. Time to send it
     else if (oldState == selectMessageState && transferData.serializedData != nullptr)
     {
+        GPS_Fix fix = NavigationUtils::GetFix();
+
         if (useCurrLocation)
         {
-            NavigationUtils::UpdateGPS();
-            auto loc = NavigationUtils::GetLocation();
-
-            latitude = loc.lat();
-            longitude = loc.lng();
+            latitude = fix.lat();
+            longitude = fix.lng();
         }
 
         DynamicJsonDocument *doc = (DynamicJsonDocument *)transferData.serializedData;
@@ -174,8 +167,8 @@ void Home_Window::transferState(State_Transfer_Data &transferData)
             // Send message
 
             MessagePing *newMsg = new MessagePing(
-                NavigationUtils::GetTime().value(),
-                NavigationUtils::GetDate().value(),
+                fix.time,
+                fix.date,
                 recipientID,
                 LoraUtils::UserID(),
                 LoraUtils::UserName().c_str(),
@@ -311,18 +304,6 @@ void Home_Window::transferState(State_Transfer_Data &transferData)
             delete transferData.serializedData;
             transferData.serializedData = nullptr;
         }
-        
-        NavigationUtils::UpdateGPS();
-
-        transferData.serializedData = new DynamicJsonDocument(16000);
-        (*transferData.serializedData).createNestedArray("Locations");
-        auto currLocObj = (*transferData.serializedData)["Locations"].createNestedObject();
-        currLocObj["Name"] = CURR_LOC;
-        currLocObj["Lat"] = NavigationUtils::GetLocation().lat();
-        currLocObj["Lng"] = NavigationUtils::GetLocation().lng();
-        
-        NavigationUtils::SerializeSavedLocations(*transferData.serializedData);
-        
     }
     // ***************** End mid-transfer logic *****************
 
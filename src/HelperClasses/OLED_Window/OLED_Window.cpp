@@ -1,6 +1,6 @@
 #include "OLED_Window.h"
 
-Adafruit_SSD1306 *OLED_Window::display;
+Display_Panel *OLED_Window::display;
 
 OLED_Window::OLED_Window()
 {
@@ -89,29 +89,29 @@ void OLED_Window::drawWindow()
 #if DEBUG == 1
         // Serial.println("State is not null");
 #endif
-        if (currentState->buttonCallbacks.find(BUTTON_1) != currentState->buttonCallbacks.end())
+        auto &buttonCallbacks = currentState->buttonCallbacks;
+        auto it = buttonCallbacks.find(BUTTON_1);
+        if (it != buttonCallbacks.end())
         {
-            display->setCursor(0, 0);
-
-            display->print(currentState->buttonCallbacks[BUTTON_1].displayText);
+            Display_Utils::printText(it->second.displayText, 0, 0);
         }
 
-        if (currentState->buttonCallbacks.find(BUTTON_2) != currentState->buttonCallbacks.end())
+        it = buttonCallbacks.find(BUTTON_2);
+        if (it != buttonCallbacks.end())
         {
-            display->setCursor(OLED_WIDTH - (strlen(currentState->buttonCallbacks[BUTTON_2].displayText) * 6), 0);
-            display->print(currentState->buttonCallbacks[BUTTON_2].displayText);
+            Display_Utils::printText(it->second.displayText, Display_Utils::alignTextRight(it->second.displayText), 0);
         }
 
-        if (currentState->buttonCallbacks.find(BUTTON_3) != currentState->buttonCallbacks.end())
+        it = buttonCallbacks.find(BUTTON_3);
+        if (it != buttonCallbacks.end())
         {
-            display->setCursor(0, OLED_HEIGHT - 8);
-            display->print(currentState->buttonCallbacks[BUTTON_3].displayText);
+            Display_Utils::printText(it->second.displayText, 0, OLED_HEIGHT - 8);
         }
 
-        if (currentState->buttonCallbacks.find(BUTTON_4) != currentState->buttonCallbacks.end())
+        it = buttonCallbacks.find(BUTTON_4);
+        if (it != buttonCallbacks.end())
         {
-            display->setCursor(OLED_WIDTH - (strlen(currentState->buttonCallbacks[BUTTON_4].displayText) * 6), OLED_HEIGHT - 8);
-            display->print(currentState->buttonCallbacks[BUTTON_4].displayText);
+            Display_Utils::printText(it->second.displayText, Display_Utils::alignTextRight(it->second.displayText), OLED_HEIGHT - 8);
         }
 
         #if DEBUG == 1
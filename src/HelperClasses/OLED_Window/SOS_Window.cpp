@@ -90,11 +90,11 @@ void SOS_Window::transferState(State_Transfer_Data &transferData)
 
 MessagePing *SOS_Window::createSosMessage()
 {
-    NavigationUtils::UpdateGPS();
+    GPS_Fix fix = NavigationUtils::GetFix();
 
     MessagePing *ping = new MessagePing(
-        NavigationUtils::GetTime().value(),
-        NavigationUtils::GetDate().value(),
+        fix.time,
+        fix.date,
         0,   // Recipient
         LoraUtils::UserID(),
         LoraUtils::UserName().c_str(),
@@ -102,8 +102,8 @@ MessagePing *SOS_Window::createSosMessage()
         255, // Red
         0,   // Green
         0,   // Blue
-        NavigationUtils::GetLocation().lat(),
-        NavigationUtils::GetLocation().lng(),
+        fix.lat(),
+        fix.lng(),
         "SOS"
     );
     
@@ -112,11 +112,11 @@ MessagePing *SOS_Window::createSosMessage()
 
 MessagePing *SOS_Window::createOkayMessage()
 {
-    NavigationUtils::UpdateGPS();
+    GPS_Fix fix = NavigationUtils::GetFix();
 
     MessagePing *ping = new MessagePing(
-        NavigationUtils::GetTime().value(),
-        NavigationUtils::GetDate().value(),
+        fix.time,
+        fix.date,
         0,
         LoraUtils::UserID(),
         LoraUtils::UserName().c_str(),
@@ -124,8 +124,8 @@ MessagePing *SOS_Window::createOkayMessage()
         0,
         255,
         0,
-        NavigationUtils::GetLocation().lat(),
-        NavigationUtils::GetLocation().lng(),
+        fix.lat(),
+        fix.lng(),
         "OK"
     );
     
@@ -37,6 +37,19 @@ Settings_Window::~Settings_Window()
 {
 }
 
+void Settings_Window::reuseWindow(OLED_Window *parent)
+{
+    if (FilesystemModule::Utilities::SettingsFile().isNull())
+    {
+        Settings_Manager::flashSettings();
+    }
+
+    this->saveSettings = false;
+    settingsState->resetToRoot();
+
+    OLED_Window::reuseWindow(parent);
+}
+
 void Settings_Window::callFunctionState(uint8_t inputID)
 {
     if (currentState == settingsState)
@@ -1,6 +1,7 @@
 #include "Display_Manager.h"
 
 TickType_t Display_Manager::lastButtonPressTick = 0;
+DisplayFrameStats Display_Manager::frameStats;
 
 // Display_Manager *Display_Manager::instance = NULL;
 OLED_Window *Display_Manager::currentWindow = NULL;
@@ -8,11 +9,15 @@ OLED_Window *Display_Manager::rootWindow = NULL;
 std::map<uint32_t, callbackPointer> Display_Manager::callbackMap;
 std::map<uint8_t, inputCallbackPointer> Display_Manager::inputCallbackMap;
 // std::unordered_map<size_t, uint8_t> Display_Manager::inputMap;
-Adafruit_SSD1306 Display_Manager::display = Adafruit_SSD1306(OLED_WIDTH, OLED_HEIGHT, &Wire);
+Display_Panel Display_Manager::display = Display_Panel(OLED_WIDTH, OLED_HEIGHT, &Wire);
 int Display_Manager::refreshTimerID;
 
 int Display_Manager::buttonFlashAnimationID = -1;
 
+Window_Pool_Slot<Menu_Window> Display_Manager::menuWindowSlot;
+Window_Pool_Slot<Settings_Window> Display_Manager::settingsWindowSlot;
+Window_Pool_Slot<ReceivedMessagesWindow> Display_Manager::receivedMessagesWindowSlot;
+
 Lock_State *Display_Manager::lockState = nullptr;
 int Display_Manager::lockStateTimerID = -1;
 
@@ -22,6 +27,13 @@ StaticQueue_t Display_Manager::displayCommandQueueBuffer;
 // QueueHandle_t Display_Manager::displayCommandQueue = xQueueCreateStatic(1, sizeof(DisplayCommandQueueItem), displayCommandQueueStorage, &Display_Manager::displayCommandQueueBuffer);
 QueueHandle_t Display_Manager::displayCommandQueue = nullptr;
 
+uint8_t Display_Manager::inputScript[INPUT_SCRIPT_MAX_INPUTS];
+size_t Display_Manager::inputScriptLength = 0;
+size_t Display_Manager::inputScriptNext = 0;
+portMUX_TYPE Display_Manager::inputScriptLock = portMUX_INITIALIZER_UNLOCKED;
+StaticTimer_t Display_Manager::inputScriptTimerBuffer;
+int Display_Manager::inputScriptTimerID = -1;
+
 void Display_Manager::init()
 {
     // Display_Manager::instance = new Display_Manager();
@@ -50,6 +62,7 @@ void Display_Manager::init()
 
     // display = Adafruit_SSD1306(OLED_WIDTH, OLED_HEIGHT, &Wire);
     display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+    Display_Utils::setFrameBuffer(display.getBuffer());
     display.clearDisplay();
 
     display.setTextSize(1);
@@ -72,10 +85,45 @@ void Display_Manager::init()
     // OLED_Content::setTimerID(Display_Manager::refreshTimerID);
     // Display_Utils::setRefreshTimerID(refreshTimerID);
 
+    registerRefreshSources();
+
+    // Plays back scripts queued by InjectInputsRpc, started on demand
+    inputScriptTimerID = System_Utils::registerTimer("Input Script", DEBOUNCE_DELAY * 2, inputScriptTimerCallback, inputScriptTimerBuffer);
+
     Display_Manager::initializeCallbacks();
     Display_Manager::generateHomeWindow(0);
 }
 
+void Display_Manager::registerRefreshSources()
+{
+    // Filtered heading, so magnetometer jitter alone does not redraw
+    Display_Utils::RegisterRefreshSource(REFRESH_DEPENDENCY_COMPASS, []() -> uint32_t {
+        return (uint32_t)Heading_Utils::GetAzimuth();
+    });
+
+    // Location changes below ~1m are ignored
+    Display_Utils::RegisterRefreshSource(REFRESH_DEPENDENCY_GPS, []() -> uint32_t {
+        auto location = NavigationUtils::GetLocation();
+        return Display_Utils::LocationRefreshValue(location.isValid(), location.lat(), location.lng());
+    });
+
+    Display_Utils::RegisterRefreshSource(REFRESH_DEPENDENCY_MESSAGES, []() -> uint32_t {
+        return LoraUtils::MessageStoreVersion();
+    });
+
+    // Changes once per second, counting uptime until the GPS has the time
+    Display_Utils::RegisterRefreshSource(REFRESH_DEPENDENCY_CLOCK, []() -> uint32_t {
+        GPS_Time time = NavigationUtils::GetTime();
+
+        if (!time.isValid())
+        {
+            return (uint32_t)(esp_timer_get_time() / 1000000);
+        }
+
+        return time.value() / 100;
+    });
+}
+
 OLED_Window *Display_Manager::attachNewWindow()
 {
     OLED_Window *newWindow;
@@ -111,15 +159,19 @@ void Display_Manager::attachNewWindow(OLED_Window *window)
 
 void Display_Manager::processCommandQueue(void *taskParams)
 {
+    HEAP_TASK_TAG(HEAP_TAG_DISPLAY);
+
     while (true)
     {
         // xTaskNotifyWait(ULONG_MAX, ULONG_MAX, &notification, portMAX_DELAY);
         DisplayCommandQueueItem displayCommand;
 
-        auto timeToWait = Display_Utils::RefreshTimerInterval() == 0 ? portMAX_DELAY : Display_Utils::RefreshTimerInterval();
+        auto timeToWait = Display_Utils::RefreshTimerInterval() == 0 ? portMAX_DELAY : pdMS_TO_TICKS(Display_Utils::NextRefreshWaitMS());
         auto queueItemReceived = xQueueReceive(displayCommandQueue, &displayCommand, timeToWait);
         if (queueItemReceived == pdTRUE)
         {
+            TRACE_SCOPE(TRACE_DISPLAY_COMMAND, displayCommand.commandType);
+
             switch (displayCommand.commandType)
             {
             case CommandType::INPUT_COMMAND:
@@ -158,7 +210,7 @@ void Display_Manager::processCommandQueue(void *taskParams)
                         processEventCallback(callbackData.callbackID, input);
                     }
 
-                    currentWindow->drawWindow();
+                    drawCurrentWindow();
 
                     lastButtonPressTick = xTaskGetTickCount();
                     System_Utils::enableInterruptsInvoke();
@@ -172,25 +224,40 @@ void Display_Manager::processCommandQueue(void *taskParams)
                 System_Utils::disableInterruptsInvoke();
                 processEventCallback(displayCommand.commandData.callbackCommand.resourceID, 0);
                 System_Utils::enableInterruptsInvoke();
-                currentWindow->drawWindow();
+                drawCurrentWindow();
                 break;
             }
             }
 
             // System_Utils::sendDisplayContents(&display);
-            Serial.println();
-            
         }
-        else
+        else if (Display_Utils::ShouldRefresh())
         {
-            if (currentWindow != nullptr)
-            {
-                currentWindow->drawWindow();
-            }
+            drawCurrentWindow();
         }
     }
 }
 
+void Display_Manager::drawCurrentWindow()
+{
+    if (currentWindow == nullptr)
+    {
+        return;
+    }
+
+    TRACE_SCOPE(TRACE_DISPLAY_DRAW, 0);
+
+    uint32_t flushes = display.Flushes();
+    uint64_t bytesFlushed = display.BytesFlushed();
+
+    int64_t startTime = esp_timer_get_time();
+    currentWindow->drawWindow();
+    uint32_t drawTime = (uint32_t)(esp_timer_get_time() - startTime);
+
+    // A window may flush more than once per frame, so count what the panel was actually sent
+    frameStats.record(drawTime, display.Flushes() - flushes, (uint32_t)(display.BytesFlushed() - bytesFlushed));
+}
+
 void Display_Manager::initializeCallbacks()
 {
 #if DEBUG == 1
@@ -217,6 +284,7 @@ void Display_Manager::initializeCallbacks()
     registerCallback(ACTION_SWITCH_WINDOW_STATE, switchWindowState);
     // registerCallback(ACTION_OPEN_OTA_WINDOW, openOTAWindow);
     registerCallback(ACTION_OPEN_SAVED_LOCATIONS_WINDOW, openSavedLocationsWindow);
+    registerCallback(ACTION_OPEN_NEARBY_WINDOW, openNearbyWindow);
     registerCallback(ACTION_OPEN_DIAGNOSTICS_WINDOW, openDiagnosticsWindow);
     registerCallback(ACTION_OPEN_WIFI_RPC_WINDOW, openWiFiRpcWindow);
 
@@ -291,7 +359,7 @@ void Display_Manager::goBack(uint8_t inputID)
     {
         OLED_Window *temp = Display_Manager::currentWindow;
         Display_Manager::currentWindow = Display_Manager::currentWindow->getParentWindow();
-        delete temp;
+        releaseWindow(temp);
         if (Display_Manager::currentWindow->isPaused)
         {
             Display_Manager::currentWindow->Resume();
@@ -302,6 +370,18 @@ void Display_Manager::goBack(uint8_t inputID)
     }
 }
 
+void Display_Manager::releaseWindow(OLED_Window *window)
+{
+    if (menuWindowSlot.release(window) ||
+        settingsWindowSlot.release(window) ||
+        receivedMessagesWindowSlot.release(window))
+    {
+        return;
+    }
+
+    delete window;
+}
+
 void Display_Manager::select(uint8_t inputID)
 {
     if (currentWindow != nullptr)
@@ -357,14 +437,26 @@ void Display_Manager::generatePingWindowBroadcast(void *arg)
 
 void Display_Manager::generateSettingsWindow(uint8_t inputID)
 {
-    Settings_Window *newWindow = new Settings_Window(currentWindow);
+    Settings_Window *newWindow = settingsWindowSlot.acquire(currentWindow);
+
+    if (newWindow == nullptr)
+    {
+        newWindow = new Settings_Window(currentWindow);
+    }
+
     Display_Manager::attachNewWindow(newWindow);
     // newWindow->drawWindow();
 }
 
 void Display_Manager::generateStatusesWindow(uint8_t inputID)
 {
-    ReceivedMessagesWindow *window = new ReceivedMessagesWindow(currentWindow);
+    ReceivedMessagesWindow *window = receivedMessagesWindowSlot.acquire(currentWindow);
+
+    if (window == nullptr)
+    {
+        window = new ReceivedMessagesWindow(currentWindow);
+    }
+
     Display_Manager::attachNewWindow(window);
 
     window->drawWindow();
@@ -372,12 +464,32 @@ void Display_Manager::generateStatusesWindow(uint8_t inputID)
 
 void Display_Manager::generateMenuWindow(uint8_t inputID)
 {
-    Menu_Window *menuWindow = new Menu_Window(currentWindow);
+    bool populateMenu = !menuWindowSlot.isConstructed();
+    Menu_Window *menuWindow = menuWindowSlot.acquire(currentWindow);
+
+    if (menuWindow == nullptr)
+    {
+        menuWindow = new Menu_Window(currentWindow);
+        populateMenu = true;
+    }
+
+    if (populateMenu)
+    {
+        populateMainMenu(menuWindow);
+    }
+    
+    Display_Manager::attachNewWindow(menuWindow);
 
+    currentWindow->drawWindow();
+}
+
+void Display_Manager::populateMainMenu(Menu_Window *menuWindow)
+{
     menuWindow->addMenuItem("Settings", ACTION_GENERATE_SETTINGS_WINDOW);
     menuWindow->addMenuItem("Pair With Terminal", ACTION_OPEN_WIFI_RPC_WINDOW);
     menuWindow->addMenuItem("Edit Status Messages", ACTION_OPEN_SAVED_MESSAGES_WINDOW);
     menuWindow->addMenuItem("Edit Saved Locations", ACTION_OPEN_SAVED_LOCATIONS_WINDOW);
+    menuWindow->addMenuItem("Nearby", ACTION_OPEN_NEARBY_WINDOW);
     menuWindow->addMenuItem("Received Messages", ACTION_GENERATE_STATUSES_WINDOW);
     menuWindow->addMenuItem("Flashlight", ACTION_TOGGLE_FLASHLIGHT);
     menuWindow->addMenuItem("Debug Compass", ACTION_GENERATE_COMPASS_WINDOW);
@@ -391,10 +503,6 @@ void Display_Manager::generateMenuWindow(uint8_t inputID)
     #endif
 
     menuWindow->addMenuItem("Pair Bluetooth", ACTION_INIT_BLE);
-    
-    Display_Manager::attachNewWindow(menuWindow);
-
-    currentWindow->drawWindow();
 }
 
 void Display_Manager::generateCompassWindow(uint8_t inputID)
@@ -459,8 +567,8 @@ void Display_Manager::toggleSilentMode(uint8_t inputID)
 {
     System_Utils::silentMode = !System_Utils::silentMode;
 
-    FilesystemModule::Utilities::SettingsFile()["Silent Mode"] = System_Utils::silentMode;
-    FilesystemModule::Utilities::WriteSettingsFileToFlash();
+    Settings_Registry::setBool(SETTING_SILENT_MODE, System_Utils::silentMode);
+    Settings_Registry::persist();
 }
 
 void Display_Manager::quickActionMenu(uint8_t inputID)
@@ -606,6 +714,13 @@ void Display_Manager::openSavedLocationsWindow(uint8_t inputID)
     window->drawWindow();
 }
 
+void Display_Manager::openNearbyWindow(uint8_t inputID)
+{
+    NearbyWindow *window = new NearbyWindow(currentWindow);
+    Display_Manager::attachNewWindow(window);
+    window->drawWindow();
+}
+
 void Display_Manager::openDiagnosticsWindow(uint8_t inputID)
 {
     DiagnosticsWindow *window = new DiagnosticsWindow(currentWindow);
@@ -627,4 +742,146 @@ void Display_Manager::initializeBle(uint8_t inputID)
     window->drawWindow();
 
     System_Utils::initBluetooth();
-}
\ No newline at end of file
+}
+
+void Display_Manager::GetFrameStatsRpc(JsonDocument &doc)
+{
+    bool reset = doc["reset"] | false;
+    DisplayFrameStats stats = frameStats;
+
+    if (reset)
+    {
+        ResetFrameStats();
+    }
+
+    doc.clear();
+    doc["frames"] = stats.frameCount;
+    doc["lastDrawUS"] = stats.lastDrawTimeUS;
+    doc["maxDrawUS"] = stats.maxDrawTimeUS;
+    doc["avgDrawUS"] = stats.frameCount > 0 ? (uint32_t)(stats.totalDrawTimeUS / stats.frameCount) : 0;
+    doc["flushes"] = stats.flushes;
+    doc["bytesFlushed"] = stats.bytesFlushed;
+    // Everything sent to the panel since boot, including draws outside the display task's frames
+    doc["panelFlushes"] = display.Flushes();
+    doc["panelBytesFlushed"] = display.BytesFlushed();
+    doc["refreshesDrawn"] = Display_Utils::RefreshesDrawn();
+    doc["refreshesSkipped"] = Display_Utils::RefreshesSkipped();
+}
+
+void Display_Manager::GetFrameSnapshotRpc(JsonDocument &doc)
+{
+    const size_t width = display.width();
+    const size_t height = display.height();
+
+    // The frame is read without locking the display task and may be torn mid draw
+    size_t pbmLength = Display_Utils::pbmLength(width, height);
+    std::unique_ptr<uint8_t[]> pbm(new uint8_t[pbmLength]);
+    Display_Utils::writePbm(display.getBuffer(), width, height, pbm.get());
+
+    size_t encodedLength = 0;
+    mbedtls_base64_encode(nullptr, 0, &encodedLength, pbm.get(), pbmLength);
+    std::unique_ptr<uint8_t[]> encoded(new uint8_t[encodedLength]);
+
+    doc.clear();
+
+    if (mbedtls_base64_encode(encoded.get(), encodedLength, &encodedLength, pbm.get(), pbmLength) != 0)
+    {
+        doc["error"] = "Base64 encode failed";
+        return;
+    }
+
+    doc["width"] = width;
+    doc["height"] = height;
+    doc["format"] = "pbm";
+    doc["frame"] = std::string((const char *)encoded.get(), encodedLength);
+}
+
+void Display_Manager::InjectInputsRpc(JsonDocument &doc)
+{
+    // Inputs closer together than the debounce delay are dropped by the display task
+    size_t intervalMS = doc["intervalMS"] | (DEBOUNCE_DELAY * 2);
+    if (intervalMS <= DEBOUNCE_DELAY)
+    {
+        intervalMS = DEBOUNCE_DELAY + 1;
+    }
+
+    uint8_t inputs[INPUT_SCRIPT_MAX_INPUTS];
+    size_t numInputs = 0;
+    bool tooLong = false;
+
+    if (doc["inputs"].is<JsonArray>())
+    {
+        for (JsonVariant input : doc["inputs"].as<JsonArray>())
+        {
+            if (numInputs == INPUT_SCRIPT_MAX_INPUTS)
+            {
+                tooLong = true;
+                break;
+            }
+
+            inputs[numInputs++] = input.as<uint8_t>();
+        }
+    }
+
+    doc.clear();
+
+    if (tooLong)
+    {
+        doc["error"] = "Too many inputs";
+        return;
+    }
+
+    if (inputScriptTimerID == -1)
+    {
+        doc["error"] = "Input script timer not registered";
+        return;
+    }
+
+    // Only the timer advances inputScriptNext, so a script is replaced only once it has finished
+    portENTER_CRITICAL(&inputScriptLock);
+    bool playing = inputScriptNext < inputScriptLength;
+    if (!playing)
+    {
+        memcpy(inputScript, inputs, numInputs);
+        inputScriptLength = numInputs;
+        inputScriptNext = 0;
+    }
+    portEXIT_CRITICAL(&inputScriptLock);
+
+    if (playing)
+    {
+        doc["error"] = "Input script already playing";
+        return;
+    }
+
+    if (numInputs > 0)
+    {
+        System_Utils::changeTimerPeriod(inputScriptTimerID, intervalMS);
+        System_Utils::startTimer(inputScriptTimerID);
+    }
+
+    doc["queued"] = numInputs;
+    doc["intervalMS"] = intervalMS;
+}
+
+void Display_Manager::inputScriptTimerCallback(TimerHandle_t xTimer)
+{
+    portENTER_CRITICAL(&inputScriptLock);
+    bool finished = inputScriptNext >= inputScriptLength;
+    uint8_t input = finished ? 0 : inputScript[inputScriptNext];
+    portEXIT_CRITICAL(&inputScriptLock);
+
+    // The timer task must not block, so a full queue retries the same input on the next tick
+    if (!finished && Display_Utils::trySendInputCommand(input))
+    {
+        portENTER_CRITICAL(&inputScriptLock);
+        inputScriptNext++;
+        finished = inputScriptNext >= inputScriptLength;
+        portEXIT_CRITICAL(&inputScriptLock);
+    }
+
+    if (finished)
+    {
+        xTimerStop(xTimer, 0);
+    }
+}
@@ -8,6 +8,7 @@ uint8_t LED_Manager::g = 0;
 uint8_t LED_Manager::b = 255;
 
 int LED_Manager::buttonFlashPatternID = -1;
+Button_Flash *LED_Manager::buttonFlash = nullptr;
 
 int LED_Manager::patternTaskID = -1;
 
@@ -16,11 +17,17 @@ void LED_Manager::init(size_t numLeds, uint8_t cpuCore)
     #if DEBUG == 1
     Serial.println("LED_Manager::init");
     #endif
-    leds = new CRGB[numLeds];
-    LED_Utils::setLeds(leds, numLeds);
+    CRGB *outputLeds = new CRGB[numLeds];
+    LED_Utils::setLeds(outputLeds, numLeds);
+    LED_Utils::init();
 
-    FastLED.addLeds<LED_TYPE, LED_PIN, LED_ORDER>(leds, NUM_LEDS);
+    // LED_Manager draws into the base layer. Patterns are composited over it by the LED task.
+    leds = LED_Utils::BaseLayer();
+
+    FastLED.addLeds<LED_TYPE, LED_PIN, LED_ORDER>(outputLeds, NUM_LEDS);
+    // Brightness and dithering are handled by LED_Output_Stage, so FastLED passes values through untouched
     FastLED.setBrightness(255);
+    FastLED.setDither(DISABLE_DITHER);
     FastLED.clear();
     FastLED.show();
 
@@ -40,9 +47,9 @@ void LED_Manager::InitializeInputIdLedPins(std::unordered_map<uint8_t, uint8_t>
 void LED_Manager::initializeButtonFlashAnimation()
 {
     auto inputIDLedIdx = LED_Utils::InputIdLedPins();
-    auto btnFlash = new Button_Flash(inputIDLedIdx);
+    buttonFlash = new Button_Flash(inputIDLedIdx);
 
-    buttonFlashPatternID = LED_Utils::registerPattern(btnFlash);
+    buttonFlashPatternID = LED_Utils::registerPattern(buttonFlash);
     LED_Utils::enablePattern(buttonFlashPatternID);
     LED_Utils::setAnimationLengthMS(buttonFlashPatternID, 300);
     Display_Utils::getInputRaised() += inputButtonFlash;
@@ -50,14 +57,18 @@ void LED_Manager::initializeButtonFlashAnimation()
 
 void LED_Manager::inputButtonFlash(uint8_t inputID)
 {
-    #if DEBUG == 1
-    Serial.print("Button flash input: ");
-    Serial.println(inputID);
-    #endif
-    StaticJsonDocument<64> cfg;
-    cfg["inputID"] = inputID;
+    LOG_VERBOSE("Button flash input: %u", inputID);
+
+    if (buttonFlash == nullptr)
+    {
+        return;
+    }
 
-    LED_Utils::configurePattern(buttonFlashPatternID, cfg);
+    // Set the flash target on the LED task. This runs on every input, so skip the JSON config path.
+    LED_Utils::applyToPattern(buttonFlashPatternID, [](LED_Pattern_Interface *pattern, int32_t argument)
+    {
+        ((Button_Flash *)pattern)->setInputID(argument);
+    }, inputID);
     LED_Utils::loopPattern(buttonFlashPatternID, 1);
 }
 
@@ -79,20 +90,8 @@ void LED_Manager::pointNorth(int Azimuth)
 
 void LED_Manager::pointToHeading(int Azimuth, double heading, double distanceAway, uint8_t r, uint8_t g, uint8_t b)
 {
-#if DEBUG == 1
-    static uint8_t refreshTicks = 0;
+    LOG_VERBOSE("Azimuth: %d Heading: %.1f Distance: %.1f", Azimuth, heading, distanceAway);
 
-    if (!refreshTicks)
-    {
-        Serial.print("Azimuth: ");
-        Serial.println(Azimuth);
-        Serial.print("Heading: ");
-        Serial.println(heading);
-        Serial.print("Distance: ");
-        Serial.println(distanceAway);
-    }
-    refreshTicks++;
-#endif
     double deg = heading - Azimuth;
     if (deg < 0)
     {
@@ -108,7 +107,7 @@ void LED_Manager::lightRing(uint8_t r, uint8_t g, uint8_t b)
     {
         leds[i] = CRGB(r, g, b);
     }
-    FastLED.show();
+    LED_Utils::requestFrame();
 }
 
 void LED_Manager::clearRing()
@@ -117,7 +116,7 @@ void LED_Manager::clearRing()
     {
         leds[i] = CRGB::Black;
     }
-    FastLED.show();
+    LED_Utils::requestFrame();
 }
 
 void LED_Manager::toggleFlashlight()
@@ -139,7 +138,7 @@ void LED_Manager::toggleFlashlight()
         {
             leds[i] = CRGB::Black;
         }
-        FastLED.show();
+        LED_Utils::requestFrame();
         flashlightOn = false;
     }
     else
@@ -148,7 +147,7 @@ void LED_Manager::toggleFlashlight()
         {
             leds[i] = CRGB::White;
         }
-        FastLED.show();
+        LED_Utils::requestFrame();
         flashlightOn = true;
     }
 }
@@ -167,7 +166,7 @@ void LED_Manager::ledShutdownAnimation()
         {
             leds[i] = CRGB(255 * brightness, 0, 0);
         }
-        FastLED.show();
+        LED_Utils::requestFrame();
         brightness -= 0.01f;
         delay(50);
     }
@@ -220,7 +219,7 @@ void LED_Manager::pulseCircle(uint8_t r, uint8_t g, uint8_t b, size_t tick)
     {
         leds[i] = CRGB(r * brightness, g * brightness, b * brightness);
     }
-    FastLED.show();
+    LED_Utils::requestFrame();
 }
 
 void LED_Manager::displayScrollWheel(size_t currentIdx, size_t listSize)
@@ -242,64 +241,14 @@ void LED_Manager::interpolateLEDsDegrees(double deg, double distanceAway, uint8_
     // LEDs should form a fine point when distance is greater
     // LEDs should light up to a quarter of the circle when distance is less
 
-    double ledDirection = (deg / 360.0f) * NUM_COMPASS_LEDS;
+    // Brightness falls off as 1 - m * d^2 with d in LEDs, so the point reaches zero at d = 1 / sqrt(m)
     float distanceMultiplier = (7.0f / 2000.0f) * (distanceAway - 20.0f) + (1.0f / 8.0f);
+    uint32_t fadeWidth = distanceMultiplier > 0.0f ? Ring_Kernels::degreesToWidth(360.0f / (NUM_COMPASS_LEDS * sqrtf(distanceMultiplier))) : UINT32_MAX;
 
-#if DEBUG == 1
-    static uint8_t refreshTicks = 0;
-
-    refreshTicks += 8;
-    if (!refreshTicks)
-    {
-        Serial.print("Distance: ");
-        Serial.println(distanceAway);
-        // Serial.print("Degrees: ");
-        // Serial.println(deg);
-        // Serial.print("Distance multiplier: ");
-        // Serial.println(distanceMultiplier);
-        // Serial.println("LED brightness: ");
-    }
-
-#endif
+    LOG_VERBOSE("Distance: %.1f", distanceAway);
 
-    for (int i = 0; i < NUM_COMPASS_LEDS; i++)
-    {
-
-        // Because circle math is linear and circles are not, we have to calculate 3 brightness values for the beginning and end  of the circle to look right
-        float brightness = -1.0f * distanceMultiplier * (i - ledDirection) * (i - ledDirection) + 1.0f;
-        float brightness2 = -1.0f * distanceMultiplier * (i - (ledDirection - NUM_COMPASS_LEDS)) * (i - (ledDirection - NUM_COMPASS_LEDS)) + 1.0f;
-        float brightness3 = -1.0f * distanceMultiplier * (i - (ledDirection + NUM_COMPASS_LEDS)) * (i - (ledDirection + NUM_COMPASS_LEDS)) + 1.0f;
-
-#if DEBUG == 1
-        if (!refreshTicks)
-        {
-
-            // Serial.print("LED ");
-            // Serial.print(i);
-            // Serial.print(": B1: ");
-            // Serial.print(brightness);
-            // Serial.print(" B2: ");
-            // Serial.print(brightness2);
-            // Serial.print(" B3: ");
-            // Serial.println(brightness3);
-        }
-
-#endif
-        brightness = max(brightness, brightness2);
-        brightness = max(brightness, brightness3);
-
-        if (brightness < 0.0f)
-        {
-            brightness = 0.0f;
-        }
-        else if (brightness > 1.0f)
-        {
-            brightness = 1.0f;
-        }
-
-        leds[i] = CRGB(r * brightness, g * brightness, b * brightness);
-    }
-    FastLED.show();
+    Ring_Kernels::renderPoint(leds, 0, NUM_COMPASS_LEDS - 1, NUM_COMPASS_LEDS, Ring_Kernels::degreesToAngle(deg), fadeWidth, CRGB(r, g, b), RING_FALLOFF_QUADRATIC);
+    LED_Utils::requestFrame();
 }
 
 // void LED_Manager::updatePattern(TimerHandle_t xTimer)
@@ -1,4 +1,5 @@
 #include "Settings_Manager.h"
+#include "Log_Utils.h"
 
 ArduinoJson::DynamicJsonDocument Settings_Manager::settings = ArduinoJson::DynamicJsonDocument(SIZE_SETTINGS_OBJECT);
 ArduinoJson::DynamicJsonDocument Settings_Manager::savedMessages = ArduinoJson::DynamicJsonDocument(SIZE_SAVED_MESSAGES_OBJECT);
@@ -16,10 +17,10 @@ void Settings_Manager::init()
     // #if UPLOAD_SETTINGS != 1
     readSettingsFromEEPROM();
 
-    Serial.println("SPIFFS Info:");
-    Serial.printf("Total Bytes: %u\n", SPIFFS.totalBytes());
-    Serial.printf("Used Bytes: %u\n", SPIFFS.usedBytes());
-    Serial.printf("Free Bytes: %u\n", SPIFFS.totalBytes() - SPIFFS.usedBytes());
+    // Printed by the log task so boot does not wait on Serial
+    size_t totalBytes = SPIFFS.totalBytes();
+    size_t usedBytes = SPIFFS.usedBytes();
+    LOG_INFO("SPIFFS Info: Total Bytes: %u, Used Bytes: %u, Free Bytes: %u", totalBytes, usedBytes, totalBytes - usedBytes);
     // #endif
 }
 
@@ -0,0 +1,221 @@
+#include "Asset_Utils.h"
+#include "Log_Utils.h"
+#include "esp_rom_crc.h"
+
+const uint8_t *Asset_Utils::_Base = nullptr;
+const Asset_Header *Asset_Utils::_Header = nullptr;
+const Asset_Index_Entry *Asset_Utils::_Index = nullptr;
+spi_flash_mmap_handle_t Asset_Utils::_MapHandle = 0;
+std::atomic<uint8_t> Asset_Utils::_InitState(ASSET_INIT_NONE);
+
+bool Asset_Utils::init()
+{
+    uint8_t expected = ASSET_INIT_NONE;
+
+    // Modules on both cores can reach the assets during boot. The first caller maps, the others wait for it.
+    if (!_InitState.compare_exchange_strong(expected, ASSET_INIT_RUNNING))
+    {
+        while (_InitState.load() != ASSET_INIT_DONE)
+        {
+            vTaskDelay(1);
+        }
+
+        return isMounted();
+    }
+
+    bool mounted = mapPartition();
+    _InitState = ASSET_INIT_DONE;
+
+    return mounted;
+}
+
+bool Asset_Utils::mapPartition()
+{
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)ASSET_PARTITION_SUBTYPE, ASSET_PARTITION_LABEL);
+
+    if (partition == nullptr)
+    {
+        LOG_INFO("Asset_Utils: no asset partition");
+        return false;
+    }
+
+    const void *mapped = nullptr;
+
+    if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &mapped, &_MapHandle) != ESP_OK)
+    {
+        LOG_WARN("Asset_Utils: failed to map asset partition");
+        return false;
+    }
+
+    if (!mount((const uint8_t *)mapped, partition->size))
+    {
+        LOG_WARN("Asset_Utils: invalid asset partition");
+        spi_flash_munmap(_MapHandle);
+        return false;
+    }
+
+    LOG_INFO("Asset_Utils: %u assets mapped", _Header->numEntries);
+    return true;
+}
+
+bool Asset_Utils::mount(const uint8_t *base, size_t size)
+{
+    const Asset_Header *header = (const Asset_Header *)base;
+
+    if (size < sizeof(Asset_Header) || header->magic != ASSET_MAGIC || header->version != ASSET_VERSION)
+    {
+        return false;
+    }
+
+    if (header->totalSize > size || header->totalSize < sizeof(Asset_Header) + header->numEntries * sizeof(Asset_Index_Entry))
+    {
+        return false;
+    }
+
+    if (esp_rom_crc32_le(0, base + sizeof(Asset_Header), header->totalSize - sizeof(Asset_Header)) != header->crc)
+    {
+        return false;
+    }
+
+    const Asset_Index_Entry *index = (const Asset_Index_Entry *)(base + sizeof(Asset_Header));
+
+    for (uint16_t i = 0; i < header->numEntries; i++)
+    {
+        if (index[i].nameOffset >= header->totalSize || index[i].offset > header->totalSize || index[i].length > header->totalSize - index[i].offset)
+        {
+            return false;
+        }
+    }
+
+    _Base = base;
+    _Index = index;
+    _Header = header;
+    return true;
+}
+
+uint32_t Asset_Utils::Hash(const char *name)
+{
+    uint32_t hash = 2166136261UL;
+
+    while (*name != '\0')
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+bool Asset_Utils::find(const char *name, Asset_View &view)
+{
+    if (!init() || name == nullptr)
+    {
+        return false;
+    }
+
+    uint32_t hash = Hash(name);
+
+    // Lower bound on the sorted hashes, then check names in case of collisions
+    uint16_t low = 0;
+    uint16_t high = _Header->numEntries;
+
+    while (low < high)
+    {
+        uint16_t mid = (low + high) / 2;
+
+        if (_Index[mid].nameHash < hash)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    for (uint16_t i = low; i < _Header->numEntries && _Index[i].nameHash == hash; i++)
+    {
+        const Asset_Index_Entry &entry = _Index[i];
+
+        if (strcmp((const char *)(_Base + entry.nameOffset), name) == 0)
+        {
+            view.data = _Base + entry.offset;
+            view.length = entry.length;
+            view.type = entry.type;
+            view.count = entry.count;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Asset_Utils::forEachString(const char *name, std::function<void(const char *value)> onString)
+{
+    Asset_View view;
+
+    if (!find(name, view) || view.type != ASSET_TYPE_STRINGS)
+    {
+        return false;
+    }
+
+    const char *value = (const char *)view.data;
+    const char *end = value + view.length;
+
+    for (uint16_t i = 0; i < view.count && value < end; i++)
+    {
+        onString(value);
+        value += strnlen(value, end - value) + 1;
+    }
+
+    return true;
+}
+
+const Asset_Location *Asset_Utils::locations(const char *name, uint16_t &count)
+{
+    Asset_View view;
+
+    if (!find(name, view) || view.type != ASSET_TYPE_LOCATIONS || view.length < view.count * sizeof(Asset_Location))
+    {
+        count = 0;
+        return nullptr;
+    }
+
+    count = view.count;
+    return (const Asset_Location *)view.data;
+}
+
+bool Asset_Utils::readDocument(const char *name, JsonDocument &doc)
+{
+    Asset_View view;
+
+    if (!find(name, view) || view.type != ASSET_TYPE_MSGPACK)
+    {
+        return false;
+    }
+
+    return deserializeMsgPack(doc, view.data, view.length) == DeserializationError::Ok;
+}
+
+void Asset_Utils::GetAssetsRpc(JsonDocument &doc)
+{
+    doc.clear();
+
+    if (!init())
+    {
+        doc["error"] = "No asset partition";
+        return;
+    }
+
+    doc["Size"] = _Header->totalSize;
+    JsonArray assets = doc.createNestedArray("Assets");
+
+    for (uint16_t i = 0; i < _Header->numEntries; i++)
+    {
+        JsonObject asset = assets.createNestedObject();
+        asset["Name"] = (const char *)(_Base + _Index[i].nameOffset);
+        asset["Type"] = (uint16_t)_Index[i].type;
+        asset["Count"] = _Index[i].count;
+        asset["Length"] = _Index[i].length;
+    }
+}
@@ -145,7 +145,7 @@ public:
 
 void Bluetooth_Utils::initBluetooth()
 {
-    std::string device_name = FilesystemModule::Utilities::SettingsFile()["Device Name"]["cfgVal"];
+    std::string device_name = Settings_Registry::getString(SETTING_DEVICE_NAME);
     std::string ble_name = "DegenBeacon " + device_name;
     BLEDevice::init(ble_name);
     NimBLEDevice::setMTU(BLE_ATT_MTU_MAX); // Use maximum MTU for largest packets.
@@ -0,0 +1,252 @@
+#include "Boot_Utils.h"
+#include "System_Utils.h"
+#include "esp_timer.h"
+
+Boot_Graph Boot_Utils::_Graph;
+
+int64_t Boot_Utils::_RunStartUS = 0;
+uint32_t Boot_Utils::_RunDurationUS = 0;
+
+SemaphoreHandle_t Boot_Utils::_Mutex = nullptr;
+StaticSemaphore_t Boot_Utils::_MutexBuffer;
+
+TaskHandle_t Boot_Utils::_Runners[2] = {nullptr, nullptr};
+SemaphoreHandle_t Boot_Utils::_WorkerDone = nullptr;
+StaticSemaphore_t Boot_Utils::_WorkerDoneBuffer;
+
+namespace
+{
+    const char *StateName(Boot_Module_State state)
+    {
+        switch (state)
+        {
+        case BOOT_MODULE_PENDING:
+            return "pending";
+        case BOOT_MODULE_RUNNING:
+            return "running";
+        case BOOT_MODULE_DONE:
+            return "done";
+        case BOOT_MODULE_FAILED:
+            return "failed";
+        case BOOT_MODULE_SKIPPED:
+            return "skipped";
+        default:
+            return "unknown";
+        }
+    }
+}
+
+int Boot_Utils::registerModule(const char *name, Boot_Init_Function init, std::initializer_list<int> dependencies, int8_t core)
+{
+    if (_Graph.numModules >= BOOT_MAX_MODULES || !init || core >= portNUM_PROCESSORS)
+    {
+        LOG_ERROR("Boot_Utils: cannot register %s", name);
+        return -1;
+    }
+
+    uint32_t dependencyMask = 0;
+
+    for (int dependency : dependencies)
+    {
+        if (dependency < 0 || dependency >= _Graph.numModules)
+        {
+            LOG_ERROR("Boot_Utils: %s depends on unregistered module %d", name, dependency);
+            return -1;
+        }
+
+        dependencyMask |= 1UL << dependency;
+    }
+
+    return _Graph.add(name, init, dependencyMask, core);
+}
+
+bool Boot_Utils::run()
+{
+    if (_Mutex == nullptr)
+    {
+        _Mutex = xSemaphoreCreateMutexStatic(&_MutexBuffer);
+        _WorkerDone = xSemaphoreCreateBinaryStatic(&_WorkerDoneBuffer);
+    }
+
+    int8_t core = xPortGetCoreID();
+    int8_t otherCore = core == 0 ? 1 : 0;
+
+    _RunStartUS = esp_timer_get_time();
+    _Runners[core] = xTaskGetCurrentTaskHandle();
+    _Runners[otherCore] = nullptr;
+
+    int workerID = -1;
+
+    // The worker is only worth starting if some module can run on the other core
+    if (_Graph.needsOtherCore(core) && portNUM_PROCESSORS > 1)
+    {
+        workerID = System_Utils::registerTask(workerTask, "Boot Worker", BOOT_WORKER_STACK_SIZE, nullptr, uxTaskPriorityGet(nullptr), otherCore);
+
+        if (workerID == -1)
+        {
+            LOG_WARN("Boot_Utils: unable to start worker, running every module on core %d", core);
+        }
+    }
+
+    // Without a worker, this task also runs modules pinned to the other core
+    runModules(workerID == -1 ? BOOT_ANY_CORE : core);
+
+    if (workerID != -1)
+    {
+        xSemaphoreTake(_WorkerDone, portMAX_DELAY);
+        System_Utils::deleteTask(workerID);
+    }
+
+    _Runners[core] = nullptr;
+
+    // Drop wakeups left over from the worker so they are not mistaken for the caller's own notifications
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    _RunDurationUS = esp_timer_get_time() - _RunStartUS;
+
+    LOG_INFO("Boot_Utils: %d modules initialized in %d ms", _Graph.numModules, _RunDurationUS / 1000);
+    return _Graph.succeeded();
+}
+
+void Boot_Utils::workerTask(void *pvParameters)
+{
+    int8_t core = xPortGetCoreID();
+    _Runners[core] = xTaskGetCurrentTaskHandle();
+
+    runModules(core);
+
+    _Runners[core] = nullptr;
+    xSemaphoreGive(_WorkerDone);
+
+    // Deleted by run()
+    vTaskSuspend(nullptr);
+}
+
+void Boot_Utils::runModules(int8_t core)
+{
+    while (true)
+    {
+        int moduleID = claimModule(core);
+
+        if (moduleID == BOOT_ALL_FINISHED)
+        {
+            return;
+        }
+
+        if (moduleID == BOOT_NONE_READY)
+        {
+            // Woken when the other runner finishes a module
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        Boot_Module &module = _Graph.modules[moduleID];
+        module.ranOnCore = xPortGetCoreID();
+
+        int64_t startUS = esp_timer_get_time();
+        module.startUS = startUS - _RunStartUS;
+
+        bool success = module.init();
+
+        module.durationUS = esp_timer_get_time() - startUS;
+        finishModule(moduleID, success);
+    }
+}
+
+int Boot_Utils::claimModule(int8_t core)
+{
+    uint32_t skipped = 0;
+
+    xSemaphoreTake(_Mutex, portMAX_DELAY);
+    int claimed = _Graph.claim(core, &skipped);
+    xSemaphoreGive(_Mutex);
+
+    for (uint8_t i = 0; i < _Graph.numModules; i++)
+    {
+        if (skipped & (1UL << i))
+        {
+            LOG_WARN("Boot_Utils: skipping %s", _Graph.modules[i].name);
+        }
+    }
+
+    // Skipped modules may have finished the run. Let the other runner see it is over.
+    if (claimed == BOOT_ALL_FINISHED)
+    {
+        wakeRunners();
+    }
+
+    return claimed;
+}
+
+void Boot_Utils::finishModule(int moduleID, bool success)
+{
+    xSemaphoreTake(_Mutex, portMAX_DELAY);
+    _Graph.finish(moduleID, success);
+    xSemaphoreGive(_Mutex);
+
+    if (!success)
+    {
+        LOG_ERROR("Boot_Utils: %s failed to initialize", _Graph.modules[moduleID].name);
+    }
+
+    wakeRunners();
+}
+
+void Boot_Utils::wakeRunners()
+{
+    for (TaskHandle_t runner : _Runners)
+    {
+        if (runner != nullptr && runner != xTaskGetCurrentTaskHandle())
+        {
+            xTaskNotifyGive(runner);
+        }
+    }
+}
+
+Boot_Module_State Boot_Utils::ModuleState(int moduleID)
+{
+    if (moduleID < 0 || moduleID >= _Graph.numModules)
+    {
+        return BOOT_MODULE_SKIPPED;
+    }
+
+    return _Graph.modules[moduleID].state;
+}
+
+void Boot_Utils::GetBootTimingsRpc(JsonDocument &doc)
+{
+    doc.clear();
+
+    uint32_t serialUS = 0;
+
+    JsonArray modules = doc.createNestedArray("modules");
+
+    for (uint8_t i = 0; i < _Graph.numModules; i++)
+    {
+        Boot_Module &module = _Graph.modules[i];
+        serialUS += module.durationUS;
+
+        JsonObject moduleStats = modules.createNestedObject();
+        moduleStats["id"] = i;
+        moduleStats["name"] = module.name;
+        moduleStats["state"] = StateName(module.state);
+        moduleStats["core"] = module.ranOnCore;
+        moduleStats["startUS"] = module.startUS;
+        moduleStats["durationUS"] = module.durationUS;
+
+        JsonArray dependencies = moduleStats.createNestedArray("deps");
+
+        for (uint8_t d = 0; d < i; d++)
+        {
+            if (module.dependencies & (1UL << d))
+            {
+                dependencies.add(d);
+            }
+        }
+    }
+
+    // Time from reset until run() started, mostly the bootloader and static constructors
+    doc["startUS"] = _RunStartUS;
+    doc["totalUS"] = _RunDurationUS;
+    doc["serialUS"] = serialUS;
+}
@@ -1,6 +1,16 @@
 #include "Display_Utils.h"
+#include "glcdfont.c"
+
+// Default Adafruit_GFX font cell, 5 glyph columns plus 1 column of spacing
+#define FONT_GLYPH_WIDTH 5
+#define FONT_CELL_WIDTH 6
+#define FONT_CELL_HEIGHT 8
+
+// Longest string printfFormattedText will format
+#define FORMATTED_TEXT_MAX 64
 
 Adafruit_GFX *Display_Utils::display = nullptr;
+uint8_t *Display_Utils::frameBuffer = nullptr;
 
 size_t Display_Utils::displayWidth = 0;
 size_t Display_Utils::displayHeight = 0;
@@ -8,6 +18,14 @@ size_t Display_Utils::displayHeight = 0;
 int Display_Utils::refreshTimerID = -1;
 uint32_t Display_Utils::refreshTimerInterval = 0;
 
+uint32_t Display_Utils::refreshDependencies = REFRESH_DEPENDENCY_NONE;
+uint32_t Display_Utils::refreshWaitMS = 0;
+bool Display_Utils::forceRefresh = true;
+RefreshSourceFunction Display_Utils::refreshSources[NUM_REFRESH_DEPENDENCIES] = {nullptr};
+uint32_t Display_Utils::refreshSourceValues[NUM_REFRESH_DEPENDENCIES] = {0};
+uint32_t Display_Utils::refreshesDrawn = 0;
+uint32_t Display_Utils::refreshesSkipped = 0;
+
 QueueHandle_t Display_Utils::displayCommandQueue = nullptr;
 
 EventHandlerT<uint8_t> Display_Utils::inputRaised;
@@ -27,6 +45,10 @@ void Display_Utils::setDisplay(Adafruit_GFX *display)
     Display_Utils::display = display; 
 }
 
+void Display_Utils::setFrameBuffer(uint8_t *buffer)
+{
+    frameBuffer = buffer;
+}
 
 void Display_Utils::setDisplayDimensions(size_t width, size_t height)
 {
@@ -93,8 +115,7 @@ void Display_Utils::printCenteredText(const char *text, bool clearDisplay)
     {
         Display_Utils::clearContentArea();
     }
-    display->setCursor(centerTextHorizontal(text), centerTextVertical());
-    display->print(text);
+    printText(text, centerTextHorizontal(text), centerTextVertical());
 }
 
 // Returns the Y cursor position for centering text vertically
@@ -113,6 +134,7 @@ uint16_t Display_Utils::selectTextLine(uint8_t line) { return (line - 1) * 8; }
 void Display_Utils::printFormattedText(const char *text, TextFormat &format) 
 {
     uint16_t xPos, yPos;
+    size_t textLength = strlen(text);
 
     switch (format.horizontalAlignment)
     {
@@ -120,10 +142,10 @@ void Display_Utils::printFormattedText(const char *text, TextFormat &format)
         xPos = alignTextLeft(format.distanceFrom);
         break;
     case ALIGN_RIGHT:
-        xPos = alignTextRight(text, format.distanceFrom);
+        xPos = alignTextRight(textLength, format.distanceFrom);
         break;
     case ALIGN_CENTER_HORIZONTAL:
-        xPos = centerTextHorizontal(text);
+        xPos = centerTextHorizontal(textLength);
         xPos += format.distanceFrom * 6;
         break;
     default:
@@ -160,8 +182,78 @@ void Display_Utils::printFormattedText(const char *text, TextFormat &format)
         // Serial.printf("Display_Utils::printFormattedText(): xPos: %d, yPos: %d\n", xPos, yPos);
     #endif
 
-    display->setCursor(xPos, yPos);
-    display->print(text);
+    printText(text, xPos, yPos);
+}
+
+void Display_Utils::printfFormattedText(TextFormat &format, const char *fmt, ...)
+{
+    char text[FORMATTED_TEXT_MAX + 1];
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+
+    printFormattedText(text, format);
+}
+
+void Display_Utils::printText(const char *text, int16_t x, int16_t y)
+{
+    size_t textLength = strlen(text);
+
+    // The UI always draws size 1 white on black text with the default font, which lets glyphs be copied
+    // a column at a time. Text that would wrap, clip or contains line breaks goes through Adafruit_GFX.
+    bool canBlit = frameBuffer != nullptr &&
+                   x >= 0 && y >= 0 &&
+                   x + (int)(textLength * FONT_CELL_WIDTH) <= (int)displayWidth &&
+                   y + FONT_CELL_HEIGHT <= (int)displayHeight &&
+                   strpbrk(text, "\r\n") == nullptr;
+
+    if (!canBlit)
+    {
+        display->setCursor(x, y);
+        display->print(text);
+        return;
+    }
+
+    // Framebuffer is stored in pages of 8 vertical pixels, one byte per column
+    const size_t page = y / FONT_CELL_HEIGHT;
+    const uint8_t shift = y % FONT_CELL_HEIGHT;
+    const bool spansPages = shift != 0 && (page + 1) < (displayHeight / FONT_CELL_HEIGHT);
+    uint8_t *upperPage = frameBuffer + (page * displayWidth) + x;
+    uint8_t *lowerPage = upperPage + displayWidth;
+
+    const uint8_t upperMask = ~(uint8_t)(0xFF << shift);
+    const uint8_t lowerMask = shift == 0 ? 0xFF : (uint8_t)(0xFF << shift);
+
+    for (size_t i = 0; i < textLength; i++)
+    {
+        uint8_t c = (uint8_t)text[i];
+
+        // Matches Adafruit_GFX with cp437 disabled
+        if (c >= 176)
+        {
+            c++;
+        }
+
+        const unsigned char *glyph = &font[c * FONT_GLYPH_WIDTH];
+
+        for (size_t col = 0; col < FONT_CELL_WIDTH; col++)
+        {
+            uint8_t bits = col < FONT_GLYPH_WIDTH ? pgm_read_byte(&glyph[col]) : 0x00;
+
+            *upperPage = (*upperPage & upperMask) | (uint8_t)(bits << shift);
+            if (spansPages)
+            {
+                *lowerPage = (*lowerPage & lowerMask) | (uint8_t)(bits >> (8 - shift));
+            }
+
+            upperPage++;
+            lowerPage++;
+        }
+    }
+
+    display->setCursor(x + (textLength * FONT_CELL_WIDTH), y);
 }
 
 // Returns the X cursor position for aligning text to the left
@@ -174,6 +266,38 @@ uint16_t Display_Utils::alignTextRight(size_t textSize, int distanceFrom ) { ret
 // Returns the X cursor position for aligning text to the right using the length of the string
 uint16_t Display_Utils::alignTextRight(const char *text, int distanceFrom) { return alignTextRight(strlen(text), distanceFrom); }
 
+size_t Display_Utils::pbmLength(size_t width, size_t height)
+{
+    return snprintf(nullptr, 0, "P4\n%d %d\n", (int)width, (int)height) + ((width + 7) / 8) * height;
+}
+
+size_t Display_Utils::writePbm(const uint8_t *framebuffer, size_t width, size_t height, uint8_t *out)
+{
+    const size_t rowBytes = (width + 7) / 8;
+    const size_t length = pbmLength(width, height);
+    const size_t headerLength = length - rowBytes * height;
+
+    char header[24];
+    snprintf(header, sizeof(header), "P4\n%d %d\n", (int)width, (int)height);
+    memcpy(out, header, headerLength);
+    memset(out + headerLength, 0, rowBytes * height);
+
+    // SSD1306 buffer is stored in 8 pixel tall pages, PBM is row major with the MSB leftmost
+    for (size_t y = 0; y < height; y++)
+    {
+        uint8_t *row = out + headerLength + (y * rowBytes);
+        for (size_t x = 0; x < width; x++)
+        {
+            if (framebuffer[x + (y / 8) * width] & (1 << (y & 7)))
+            {
+                row[x / 8] |= 0x80 >> (x & 7);
+            }
+        }
+    }
+
+    return length;
+}
+
 // Returns the number of characters in an integer
 size_t Display_Utils::getIntLength(int64_t num)
 {
@@ -213,12 +337,106 @@ size_t Display_Utils::getUintLength(uint64_t num)
 
 void Display_Utils::enableRefreshTimer(size_t timerPeriodMS)
 {
-   refreshTimerInterval = timerPeriodMS;
+    enableRefreshTimer(timerPeriodMS, REFRESH_DEPENDENCY_NONE);
+}
+
+void Display_Utils::enableRefreshTimer(size_t timerPeriodMS, uint32_t dependencies)
+{
+    refreshTimerInterval = timerPeriodMS;
+    refreshDependencies = dependencies;
+    refreshWaitMS = timerPeriodMS;
+    forceRefresh = true;
 }
 
 void Display_Utils::disableRefreshTimer()
 {
     refreshTimerInterval = 0;
+    refreshDependencies = REFRESH_DEPENDENCY_NONE;
+}
+
+void Display_Utils::RegisterRefreshSource(RefreshDependency dependency, RefreshSourceFunction source)
+{
+    for (size_t i = 0; i < NUM_REFRESH_DEPENDENCIES; i++)
+    {
+        if ((uint32_t)dependency == (1u << i))
+        {
+            refreshSources[i] = source;
+            return;
+        }
+    }
+}
+
+uint32_t Display_Utils::LocationRefreshValue(bool valid, double lat, double lng)
+{
+    if (!valid)
+    {
+        return 0;
+    }
+
+    int32_t latE5 = lat * 100000;
+    int32_t lngE5 = lng * 100000;
+    return ((uint32_t)latE5 * 31) ^ (uint32_t)lngE5;
+}
+
+uint32_t Display_Utils::NextRefreshWaitMS()
+{
+    if (refreshDependencies == REFRESH_DEPENDENCY_NONE)
+    {
+        return refreshTimerInterval;
+    }
+
+    return refreshWaitMS;
+}
+
+bool Display_Utils::ShouldRefresh()
+{
+    if (refreshDependencies == REFRESH_DEPENDENCY_NONE)
+    {
+        refreshesDrawn++;
+        return true;
+    }
+
+    bool changed = forceRefresh;
+    forceRefresh = false;
+
+    for (size_t i = 0; i < NUM_REFRESH_DEPENDENCIES; i++)
+    {
+        if ((refreshDependencies & (1 << i)) == 0)
+        {
+            continue;
+        }
+
+        // Without a registered source there is no way to tell, so treat it as changed
+        if (refreshSources[i] == nullptr)
+        {
+            changed = true;
+            continue;
+        }
+
+        uint32_t value = refreshSources[i]();
+        if (value != refreshSourceValues[i])
+        {
+            refreshSourceValues[i] = value;
+            changed = true;
+        }
+    }
+
+    if (changed)
+    {
+        refreshWaitMS = refreshTimerInterval;
+        refreshesDrawn++;
+        return true;
+    }
+
+    // Nothing changed, back off the check interval
+    refreshWaitMS *= 2;
+    if (refreshWaitMS > REFRESH_IDLE_MAX_MS)
+    {
+        refreshWaitMS = REFRESH_IDLE_MAX_MS > refreshTimerInterval ? REFRESH_IDLE_MAX_MS : refreshTimerInterval;
+    }
+
+    refreshesSkipped++;
+    return false;
 }
 
 
@@ -238,6 +456,19 @@ void Display_Utils::sendInputCommand(uint8_t inputID)
     xQueueSend(displayCommandQueue, &item, portMAX_DELAY);
 }
 
+bool Display_Utils::trySendInputCommand(uint8_t inputID)
+{
+    if (displayCommandQueue == nullptr)
+        return false;
+
+    DisplayCommandQueueItem item;
+
+    item.commandType = INPUT_COMMAND;
+    item.commandData.inputCommand.inputID = inputID;
+
+    return xQueueSend(displayCommandQueue, &item, 0) == pdTRUE;
+}
+
 // Sends a callback command to the display command queue
 void Display_Utils::sendCallbackCommand(uint32_t resourceID)
 {
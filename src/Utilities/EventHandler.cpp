@@ -2,32 +2,21 @@
 
 EventHandler::EventHandler() 
 {
-    _callbacks.clear();
 }
 
 // += operator to add a callback
 void EventHandler::operator+=(void (*callback)()) 
 {
-    if (std::find(_callbacks.begin(), _callbacks.end(), callback) == _callbacks.end())
-    {
-        _callbacks.push_back(callback);
-    }
+    _callbacks.add(callback);
 }
 
 // -= operator to remove callback
 void EventHandler::operator-=(void (*callback)()) 
 {
-    auto it = std::find(_callbacks.begin(), _callbacks.end(), callback);
-    if (it != _callbacks.end()) 
-    {
-        _callbacks.erase(it);
-    }
+    _callbacks.remove(callback);
 }
 
 void EventHandler::Invoke() 
 {
-    for (auto &callback : _callbacks) {
-        callback();
-    }
-
-}
\ No newline at end of file
+    _callbacks.invoke();
+}
@@ -1,6 +1,279 @@
 #include "FilesystemUtils.h"
+#include <vector>
+
+namespace
+{
+    // Checksums serialized bytes, optionally passing them on to another output
+    class Crc_Print : public Print
+    {
+    public:
+        explicit Crc_Print(Print *forward = nullptr) : forward(forward) {}
+
+        uint32_t crc = 0;
+        size_t length = 0;
+
+        size_t write(uint8_t c) override
+        {
+            return write(&c, 1);
+        }
+
+        size_t write(const uint8_t *buffer, size_t size) override
+        {
+            size_t written = forward != nullptr ? forward->write(buffer, size) : size;
+
+            crc = esp_rom_crc32_le(crc, buffer, written);
+            length += written;
+            return written;
+        }
+
+    private:
+        Print *forward;
+    };
+
+    // SPIFFS as seen by Atomic_File
+    struct Spiffs_Filesystem
+    {
+        typedef fs::File File;
+
+        File openRead(const char *path) { return SPIFFS.open(path, FILE_READ); }
+        File openWrite(const char *path) { return SPIFFS.open(path, FILE_WRITE); }
+        bool exists(const char *path) { return SPIFFS.exists(path); }
+        bool remove(const char *path) { return SPIFFS.remove(path); }
+        bool rename(const char *from, const char *to) { return SPIFFS.rename(from, to); }
+
+        static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t length) { return esp_rom_crc32_le(crc, data, length); }
+    };
+
+    typedef FilesystemModule::Atomic_File<Spiffs_Filesystem> Spiffs_Atomic_File;
+}
 
 DynamicJsonDocument FilesystemModule::Utilities::_SettingsFile(4096); 
 std::string FilesystemModule::Utilities::_SettingsFilename = "";
 
 EventHandlerT<ArduinoJson::JsonDocument &> FilesystemModule::Utilities::_SettingsUpdated;
+
+SemaphoreHandle_t FilesystemModule::Utilities::_WriteMutex = nullptr;
+StaticSemaphore_t FilesystemModule::Utilities::_WriteMutexBuffer;
+
+SemaphoreHandle_t FilesystemModule::Utilities::WriteMutex()
+{
+    if (_WriteMutex == nullptr)
+    {
+        _WriteMutex = xSemaphoreCreateMutexStatic(&_WriteMutexBuffer);
+    }
+
+    return _WriteMutex;
+}
+
+FilesystemModule::FilesystemReturnCode FilesystemModule::Utilities::LoadSettingsFile(JsonDocument &doc)
+{
+    auto returnCode = ReadFile(SettingsFileName(), doc);
+
+    // First boot. Start from the factory settings in the asset partition if there are any.
+    if (returnCode == FilesystemReturnCode::FILE_NOT_FOUND && Asset_Utils::readDocument(ASSET_SETTINGS_DEFAULTS, doc))
+    {
+        returnCode = FilesystemReturnCode::FILESYSTEM_OK;
+    }
+
+    if (returnCode == FilesystemReturnCode::FILESYSTEM_OK)
+    {
+        Settings_Registry::applyDelta(doc);
+
+        if (&doc == &_SettingsFile)
+        {
+            Settings_Registry::syncFromDocument(doc);
+        }
+    }
+
+    return returnCode;
+}
+
+FilesystemModule::FilesystemReturnCode FilesystemModule::Utilities::WriteSettingsFileToFlash()
+{
+    if (SettingsFileName().length() == 0 || SettingsFile().isNull())
+    {
+        Serial.println("Settings file not loaded.");
+        return FilesystemReturnCode::WRITE_FAILED;
+    }
+
+    auto returnCode = WriteFileAtomic(SettingsFileName(), SettingsFile());
+    if (returnCode == FilesystemReturnCode::FILESYSTEM_OK)
+    {
+        // The settings file now holds every change so the delta can go
+        Settings_Registry::clearDelta();
+        Settings_Registry::syncFromDocument(SettingsFile());
+
+        _SettingsUpdated.Invoke(SettingsFile());
+    }
+
+    return returnCode;
+}
+
+FilesystemModule::FilesystemReturnCode FilesystemModule::Utilities::WriteFileAtomic(const std::string &filename, JsonDocument &doc, size_t *bytesWritten)
+{
+    return WriteFileStreamed(filename, [&doc](MsgPack_Writer &writer) { writer.writeElement(doc.as<JsonVariantConst>()); }, bytesWritten);
+}
+
+FilesystemModule::FilesystemReturnCode FilesystemModule::Utilities::WriteFileStreamed(const std::string &filename, MsgPack_Producer produce, size_t *bytesWritten)
+{
+    // The header comes first, so the payload is produced once to checksum it and again to write it
+    Crc_Print checksum;
+    {
+        MsgPack_Writer writer(checksum);
+        produce(writer);
+    }
+
+    auto writePayload = [&produce](File &file, uint32_t &crc) {
+        // Counted below the buffer, so bytes the file refuses when the buffer is flushed come up short
+        Crc_Print payload(&file);
+        {
+            WriteBufferingPrint bufferedPayload(payload, 64);
+            MsgPack_Writer writer(bufferedPayload);
+            produce(writer);
+            bufferedPayload.flush();
+        }
+
+        crc = payload.crc;
+        return payload.length;
+    };
+
+    Spiffs_Filesystem fs;
+
+    xSemaphoreTake(WriteMutex(), portMAX_DELAY);
+    auto returnCode = Spiffs_Atomic_File::Write(fs, filename, checksum.length, checksum.crc, writePayload, bytesWritten);
+    xSemaphoreGive(WriteMutex());
+
+    if (returnCode == FilesystemReturnCode::CHECKSUM_MISMATCH)
+    {
+        LOG_WARN("Contents changed while writing: %s", filename);
+    }
+    else if (returnCode != FilesystemReturnCode::FILESYSTEM_OK)
+    {
+        LOG_WARN("Failed to write %s", filename);
+    }
+
+    return returnCode;
+}
+
+FilesystemModule::FilesystemReturnCode FilesystemModule::Utilities::ReadArrayFile(const std::string &filename, const char *key, size_t elementCapacity, MsgPack_Element_Callback onElement)
+{
+    if (!SPIFFS.exists(filename.c_str()))
+    {
+        return FilesystemReturnCode::FILE_NOT_FOUND;
+    }
+
+    File file = SPIFFS.open(filename.c_str(), FILE_READ);
+
+    if (!file)
+    {
+        return FilesystemReturnCode::READ_ERROR;
+    }
+
+    auto returnCode = CheckFileHeader(file);
+
+    if (returnCode != FilesystemReturnCode::FILESYSTEM_OK)
+    {
+        LOG_WARN("Corrupt file: %s", filename);
+        file.close();
+        return returnCode;
+    }
+
+    ReadBufferingStream bufferedFile(file, 64);
+    MsgPack_Reader reader(bufferedFile);
+
+    DynamicJsonDocument element(elementCapacity);
+    char entryKey[32];
+    uint32_t numEntries = 0;
+    bool found = false;
+
+    reader.readMapHeader(numEntries);
+
+    for (uint32_t i = 0; i < numEntries && !found && reader.ok(); i++)
+    {
+        if (!reader.readString(entryKey, sizeof(entryKey)))
+        {
+            break;
+        }
+
+        if (strcmp(entryKey, key) != 0)
+        {
+            reader.skipValue();
+            continue;
+        }
+
+        found = true;
+        uint32_t numElements = 0;
+        reader.readArrayHeader(numElements);
+
+        for (uint32_t j = 0; j < numElements && reader.readElement(element); j++)
+        {
+            onElement(element.as<JsonVariantConst>());
+            element.clear();
+        }
+    }
+
+    file.close();
+
+    if (!reader.ok())
+    {
+        LOG_WARN("Failed to read %s from %s", key, filename);
+        return FilesystemReturnCode::READ_ERROR;
+    }
+
+    return found ? FilesystemReturnCode::FILESYSTEM_OK : FilesystemReturnCode::READ_ERROR;
+}
+
+void FilesystemModule::Utilities::RemoveFile(const std::string &filename)
+{
+    xSemaphoreTake(WriteMutex(), portMAX_DELAY);
+
+    if (SPIFFS.exists(filename.c_str()))
+    {
+        SPIFFS.remove(filename.c_str());
+    }
+
+    xSemaphoreGive(WriteMutex());
+}
+
+void FilesystemModule::Utilities::RecoverFiles()
+{
+    const size_t suffixLength = strlen(PERSISTED_FILE_TEMP_SUFFIX);
+    std::vector<std::string> tempFilenames;
+
+    // Collected first, as recovering renames files under the directory being listed
+    File root = SPIFFS.open("/");
+
+    for (File file = root.openNextFile(); file; file = root.openNextFile())
+    {
+        std::string path = file.path();
+
+        if (path.length() > suffixLength && path.compare(path.length() - suffixLength, suffixLength, PERSISTED_FILE_TEMP_SUFFIX) == 0)
+        {
+            tempFilenames.push_back(path);
+        }
+
+        file.close();
+    }
+
+    root.close();
+
+    Spiffs_Filesystem fs;
+    xSemaphoreTake(WriteMutex(), portMAX_DELAY);
+
+    for (const auto &tempFilename : tempFilenames)
+    {
+        std::string filename = tempFilename.substr(0, tempFilename.length() - suffixLength);
+
+        if (Spiffs_Atomic_File::Recover(fs, filename))
+        {
+            LOG_WARN("Recovered interrupted write: %s", filename);
+        }
+    }
+
+    xSemaphoreGive(WriteMutex());
+}
+
+FilesystemModule::FilesystemReturnCode FilesystemModule::Utilities::CheckFileHeader(File &file)
+{
+    return Spiffs_Atomic_File::CheckHeader(file);
+}
@@ -0,0 +1,156 @@
+#include "Heading_Utils.h"
+#include "NavigationUtils.h"
+
+CompassInterface *Heading_Utils::_Compass = nullptr;
+Heading_Filter Heading_Utils::_Filter;
+
+Heading_Estimate Heading_Utils::_Estimate = {};
+portMUX_TYPE Heading_Utils::_EstimateLock = portMUX_INITIALIZER_UNLOCKED;
+
+uint32_t Heading_Utils::_LastSampleMS = 0;
+std::atomic<bool> Heading_Utils::_Paused(false);
+std::atomic<bool> Heading_Utils::_ResetRequested(false);
+
+uint32_t Heading_Utils::_Updates = 0;
+uint32_t Heading_Utils::_LastUpdateUS = 0;
+uint32_t Heading_Utils::_MaxUpdateUS = 0;
+uint64_t Heading_Utils::_TotalUpdateUS = 0;
+
+int Heading_Utils::_SampleTaskID = -1;
+
+void Heading_Utils::init(CompassInterface *compass)
+{
+    _Compass = compass;
+
+    if (_SampleTaskID != -1 || _Compass == nullptr)
+    {
+        return;
+    }
+
+    _SampleTaskID = System_Utils::registerTask(sampleTask, "Heading", HEADING_TASK_STACK_SIZE, nullptr, HEADING_TASK_PRIORITY);
+
+    if (_SampleTaskID == -1)
+    {
+        LOG_ERROR("Heading_Utils: unable to start heading task");
+    }
+}
+
+void Heading_Utils::sampleTask(void *pvParameters)
+{
+    HEAP_TASK_TAG(HEAP_TAG_NAVIGATION);
+
+    TickType_t lastWakeTime = xTaskGetTickCount();
+
+    while (true)
+    {
+        vTaskDelayUntil(&lastWakeTime, pdMS_TO_TICKS(HEADING_SAMPLE_PERIOD_MS));
+        sample();
+    }
+}
+
+void Heading_Utils::sample()
+{
+    if (_Paused || _Compass == nullptr)
+    {
+        return;
+    }
+
+    // The calibration changed the compass output, so the filter starts over from this sample
+    if (_ResetRequested.exchange(false))
+    {
+        _Filter.reset();
+    }
+
+    int64_t startTime = esp_timer_get_time();
+
+    int azimuth = _Compass->GetAzimuth();
+    uint32_t now = millis();
+
+    if (azimuth < 0)
+    {
+        return;
+    }
+
+    float dtS = _Filter.valid() ? (now - _LastSampleMS) / 1000.0f : HEADING_SAMPLE_PERIOD_MS / 1000.0f;
+    _LastSampleMS = now;
+
+    GPS_Fix fix = NavigationUtils::GetFix();
+    bool courseValid = fix.courseValid && fix.age() < HEADING_GPS_MAX_AGE_MS;
+
+    _Filter.update(azimuth, dtS, fix.courseDeg, fix.speedKmph, courseValid);
+
+    Heading_Estimate estimate;
+    estimate.headingDeg = _Filter.heading();
+    estimate.confidence = _Filter.confidence();
+    estimate.gpsWeight = _Filter.gpsWeight();
+    estimate.updatedMS = now;
+    estimate.valid = true;
+
+    portENTER_CRITICAL(&_EstimateLock);
+    _Estimate = estimate;
+    portEXIT_CRITICAL(&_EstimateLock);
+
+    uint32_t duration = (uint32_t)(esp_timer_get_time() - startTime);
+
+    _Updates++;
+    _LastUpdateUS = duration;
+    _TotalUpdateUS += duration;
+
+    if (duration > _MaxUpdateUS)
+    {
+        _MaxUpdateUS = duration;
+    }
+}
+
+Heading_Estimate Heading_Utils::GetHeading()
+{
+    portENTER_CRITICAL(&_EstimateLock);
+    Heading_Estimate estimate = _Estimate;
+    portEXIT_CRITICAL(&_EstimateLock);
+
+    return estimate;
+}
+
+int Heading_Utils::GetAzimuth()
+{
+    Heading_Estimate estimate = GetHeading();
+
+    if (!estimate.valid)
+    {
+        return -1;
+    }
+
+    return (int)lroundf(estimate.headingDeg) % 360;
+}
+
+void Heading_Utils::pause()
+{
+    _Paused = true;
+}
+
+void Heading_Utils::resume()
+{
+    // The filter belongs to the sample task, which resets it before its next sample
+    _ResetRequested = true;
+    _Paused = false;
+}
+
+void Heading_Utils::GetHeadingRpc(JsonDocument &doc)
+{
+    Heading_Estimate estimate = GetHeading();
+
+    doc.clear();
+
+    doc["valid"] = estimate.valid;
+    doc["heading"] = estimate.headingDeg;
+    doc["confidence"] = estimate.confidence;
+    doc["gpsWeight"] = estimate.gpsWeight;
+    doc["age"] = estimate.valid ? millis() - estimate.updatedMS : 0;
+    doc["paused"] = _Paused.load();
+
+    JsonObject cost = doc.createNestedObject("cost");
+    cost["updates"] = _Updates;
+    cost["lastUS"] = _LastUpdateUS;
+    cost["maxUS"] = _MaxUpdateUS;
+    cost["avgUS"] = _Updates ? (uint32_t)(_TotalUpdateUS / _Updates) : 0;
+}
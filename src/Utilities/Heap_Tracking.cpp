@@ -0,0 +1,309 @@
+#include "Heap_Utils.h"
+#include <new>
+
+// Tag accounting behind operator new. Kept apart from the snapshots and the RPC, so tools/heap_tracking_test.cpp
+// can build it on the host.
+
+uint8_t Heap_Utils::SizeClass(size_t size)
+{
+    uint8_t sizeClass = 0;
+    size_t limit = HEAP_SMALLEST_CLASS_BYTES;
+
+    while (size > limit && sizeClass < HEAP_SIZE_CLASSES - 1)
+    {
+        limit <<= 1;
+        sizeClass++;
+    }
+
+    return sizeClass;
+}
+
+#if HEAP_TRACKING_ENABLED == 1
+
+namespace
+{
+    const uint16_t HEAP_HEADER_MAGIC = 0x4854;
+
+    // Placed in front of every tracked allocation. Keeps the 8 byte alignment malloc returns.
+    struct Heap_Header
+    {
+        uint32_t size;
+        uint16_t magic;
+        uint8_t tag;
+        uint8_t sizeClass;
+    };
+
+    static_assert(sizeof(Heap_Header) == 8, "Heap_Header must preserve malloc alignment");
+}
+
+Heap_Tag_Stats Heap_Utils::_Tags[NUM_HEAP_TAGS];
+
+TaskHandle_t Heap_Utils::_TaggedTasks[HEAP_MAX_TAGGED_TASKS];
+Heap_Tag Heap_Utils::_TaskTags[HEAP_MAX_TAGGED_TASKS];
+
+portMUX_TYPE Heap_Utils::_Lock = portMUX_INITIALIZER_UNLOCKED;
+
+Heap_Tag Heap_Utils::setTaskTag(Heap_Tag tag)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    Heap_Tag previous = HEAP_TAG_UNTAGGED;
+    int freeSlot = -1;
+
+    portENTER_CRITICAL_SAFE(&_Lock);
+
+    for (int i = 0; i < HEAP_MAX_TAGGED_TASKS; i++)
+    {
+        if (_TaggedTasks[i] == task)
+        {
+            previous = _TaskTags[i];
+            freeSlot = i;
+            break;
+        }
+
+        if (_TaggedTasks[i] == nullptr && freeSlot == -1)
+        {
+            freeSlot = i;
+        }
+    }
+
+    // Untagged tasks give their slot back. A full table leaves the task untagged.
+    if (freeSlot != -1)
+    {
+        _TaggedTasks[freeSlot] = tag == HEAP_TAG_UNTAGGED ? nullptr : task;
+        _TaskTags[freeSlot] = tag;
+    }
+
+    portEXIT_CRITICAL_SAFE(&_Lock);
+
+    return previous;
+}
+
+Heap_Tag Heap_Utils::TaskTag()
+{
+    portENTER_CRITICAL_SAFE(&_Lock);
+    Heap_Tag tag = findTaskTag(xTaskGetCurrentTaskHandle());
+    portEXIT_CRITICAL_SAFE(&_Lock);
+
+    return tag;
+}
+
+void Heap_Utils::forgetTask(TaskHandle_t task)
+{
+    portENTER_CRITICAL_SAFE(&_Lock);
+
+    for (int i = 0; i < HEAP_MAX_TAGGED_TASKS; i++)
+    {
+        if (_TaggedTasks[i] == task)
+        {
+            _TaggedTasks[i] = nullptr;
+        }
+    }
+
+    portEXIT_CRITICAL_SAFE(&_Lock);
+}
+
+void Heap_Utils::CopyTagStats(Heap_Tag_Stats *stats, bool clearPeaks)
+{
+    portENTER_CRITICAL_SAFE(&_Lock);
+    memcpy(stats, _Tags, sizeof(_Tags));
+
+    if (clearPeaks)
+    {
+        for (auto &tagStats : _Tags)
+        {
+            tagStats.peakBytes = tagStats.liveBytes;
+        }
+    }
+
+    portEXIT_CRITICAL_SAFE(&_Lock);
+}
+
+void Heap_Utils::CopyLiveBytes(uint32_t *liveBytes)
+{
+    portENTER_CRITICAL_SAFE(&_Lock);
+
+    for (uint8_t tag = 0; tag < NUM_HEAP_TAGS; tag++)
+    {
+        liveBytes[tag] = _Tags[tag].liveBytes;
+    }
+
+    portEXIT_CRITICAL_SAFE(&_Lock);
+}
+
+Heap_Tag Heap_Utils::findTaskTag(TaskHandle_t task)
+{
+    if (task == nullptr)
+    {
+        return HEAP_TAG_UNTAGGED;
+    }
+
+    for (int i = 0; i < HEAP_MAX_TAGGED_TASKS; i++)
+    {
+        if (_TaggedTasks[i] == task)
+        {
+            return _TaskTags[i];
+        }
+    }
+
+    return HEAP_TAG_UNTAGGED;
+}
+
+void Heap_Utils::charge(Heap_Tag tag, size_t size, uint8_t sizeClass)
+{
+    Heap_Tag_Stats &stats = _Tags[tag];
+    stats.liveCount++;
+    stats.liveBytes += size;
+    stats.peakBytes = max(stats.peakBytes, stats.liveBytes);
+    stats.totalAllocations++;
+    stats.sizeClasses[sizeClass]++;
+}
+
+void Heap_Utils::credit(Heap_Tag tag, size_t size, uint8_t sizeClass)
+{
+    Heap_Tag_Stats &stats = _Tags[tag];
+    stats.liveCount--;
+    stats.liveBytes -= size;
+    stats.sizeClasses[sizeClass]--;
+}
+
+void *Heap_Utils::allocate(size_t size)
+{
+    // malloc takes its own lock, so it is called outside ours
+    Heap_Header *header = (Heap_Header *)malloc(sizeof(Heap_Header) + size);
+    uint8_t sizeClass = SizeClass(size);
+
+    portENTER_CRITICAL_SAFE(&_Lock);
+    Heap_Tag tag = findTaskTag(xTaskGetCurrentTaskHandle());
+
+    if (header == nullptr)
+    {
+        _Tags[tag].failedAllocations++;
+    }
+    else
+    {
+        charge(tag, size, sizeClass);
+    }
+
+    portEXIT_CRITICAL_SAFE(&_Lock);
+
+    if (header == nullptr)
+    {
+        return nullptr;
+    }
+
+    header->size = size;
+    header->magic = HEAP_HEADER_MAGIC;
+    header->tag = tag;
+    header->sizeClass = sizeClass;
+
+    return header + 1;
+}
+
+void *Heap_Utils::reallocate(void *ptr, size_t size)
+{
+    if (ptr == nullptr)
+    {
+        return allocate(size);
+    }
+
+    Heap_Header *header = (Heap_Header *)ptr - 1;
+
+    if (header->magic != HEAP_HEADER_MAGIC)
+    {
+        return realloc(ptr, size);
+    }
+
+    Heap_Header previous = *header;
+    Heap_Header *resized = (Heap_Header *)realloc(header, sizeof(Heap_Header) + size);
+
+    if (resized == nullptr)
+    {
+        portENTER_CRITICAL_SAFE(&_Lock);
+        _Tags[previous.tag].failedAllocations++;
+        portEXIT_CRITICAL_SAFE(&_Lock);
+
+        return nullptr;
+    }
+
+    // The block stays charged to the tag that allocated it
+    resized->size = size;
+    resized->sizeClass = SizeClass(size);
+
+    portENTER_CRITICAL_SAFE(&_Lock);
+    credit((Heap_Tag)previous.tag, previous.size, previous.sizeClass);
+    charge((Heap_Tag)previous.tag, size, resized->sizeClass);
+    _Tags[previous.tag].totalAllocations--;
+    portEXIT_CRITICAL_SAFE(&_Lock);
+
+    return resized + 1;
+}
+
+void Heap_Utils::release(void *ptr)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+
+    Heap_Header *header = (Heap_Header *)ptr - 1;
+
+    // Not allocated through here
+    if (header->magic != HEAP_HEADER_MAGIC)
+    {
+        free(ptr);
+        return;
+    }
+
+    portENTER_CRITICAL_SAFE(&_Lock);
+    credit((Heap_Tag)header->tag, header->size, header->sizeClass);
+    portEXIT_CRITICAL_SAFE(&_Lock);
+
+    header->magic = 0;
+    free(header);
+}
+
+namespace
+{
+    void *TrackedNew(size_t size)
+    {
+        void *ptr = Heap_Utils::allocate(size);
+
+        if (ptr == nullptr)
+        {
+#if __cpp_exceptions
+            throw std::bad_alloc();
+#else
+            abort();
+#endif
+        }
+
+        return ptr;
+    }
+}
+
+void *operator new(size_t size) { return TrackedNew(size); }
+void *operator new[](size_t size) { return TrackedNew(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return Heap_Utils::allocate(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return Heap_Utils::allocate(size); }
+
+void operator delete(void *ptr) noexcept { Heap_Utils::release(ptr); }
+void operator delete[](void *ptr) noexcept { Heap_Utils::release(ptr); }
+void operator delete(void *ptr, size_t size) noexcept { Heap_Utils::release(ptr); }
+void operator delete[](void *ptr, size_t size) noexcept { Heap_Utils::release(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { Heap_Utils::release(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { Heap_Utils::release(ptr); }
+
+#else
+
+Heap_Tag Heap_Utils::setTaskTag(Heap_Tag tag) { return HEAP_TAG_UNTAGGED; }
+Heap_Tag Heap_Utils::TaskTag() { return HEAP_TAG_UNTAGGED; }
+void Heap_Utils::forgetTask(TaskHandle_t task) {}
+
+void Heap_Utils::CopyTagStats(Heap_Tag_Stats *stats, bool clearPeaks) { memset(stats, 0, sizeof(Heap_Tag_Stats) * NUM_HEAP_TAGS); }
+void Heap_Utils::CopyLiveBytes(uint32_t *liveBytes) { memset(liveBytes, 0, sizeof(uint32_t) * NUM_HEAP_TAGS); }
+
+void *Heap_Utils::allocate(size_t size) { return malloc(size); }
+void *Heap_Utils::reallocate(void *ptr, size_t size) { return realloc(ptr, size); }
+void Heap_Utils::release(void *ptr) { free(ptr); }
+
+#endif
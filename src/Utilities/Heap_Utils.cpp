@@ -0,0 +1,197 @@
+#include "Heap_Utils.h"
+#include "System_Utils.h"
+#include "esp_idf_version.h"
+
+namespace
+{
+    const char *HEAP_TAG_NAMES[NUM_HEAP_TAGS] PROGMEM = {
+        "Untagged",
+        "System",
+        "Display",
+        "LoRa",
+        "Navigation",
+        "LED",
+        "Rpc",
+        "Filesystem",
+        "Network",
+    };
+}
+
+Heap_Snapshot Heap_Utils::_Snapshots[HEAP_SNAPSHOT_HISTORY];
+size_t Heap_Utils::_SnapshotHead = 0;
+size_t Heap_Utils::_SnapshotCount = 0;
+
+int Heap_Utils::_SnapshotTimerID = -1;
+StaticTimer_t Heap_Utils::_SnapshotTimerBuffer;
+
+void Heap_Utils::init()
+{
+    if (_SnapshotTimerID != -1)
+    {
+        return;
+    }
+
+    _SnapshotTimerID = System_Utils::registerTimer("Heap Snapshot", HEAP_SNAPSHOT_PERIOD_MS, snapshotTimerCallback, _SnapshotTimerBuffer);
+    System_Utils::startTimer(_SnapshotTimerID);
+    takeSnapshot();
+}
+
+const char *Heap_Utils::TagName(uint8_t tag)
+{
+    return tag < NUM_HEAP_TAGS ? HEAP_TAG_NAMES[tag] : "Unknown";
+}
+
+uint8_t Heap_Utils::FragmentationPercent()
+{
+    size_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+
+    if (freeBytes == 0)
+    {
+        return 0;
+    }
+
+    return 100 - (uint8_t)((uint64_t)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL) * 100 / freeBytes);
+}
+
+void Heap_Utils::fillRegion(Heap_Region_Snapshot &region, uint32_t caps)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+
+    region.freeBytes = info.total_free_bytes;
+    region.largestFreeBlock = info.largest_free_block;
+    region.minimumFreeBytes = info.minimum_free_bytes;
+    region.freeBlocks = info.free_blocks;
+    region.allocatedBlocks = info.allocated_blocks;
+    memset(region.freeSizeClasses, 0, sizeof(region.freeSizeClasses));
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+    // The free block map. Older IDF versions cannot walk the heap, so only the totals above are known there.
+    heap_caps_walk(caps, [](walker_heap_into_t heap, walker_block_info_t block, void *userData) {
+        if (!block.used)
+        {
+            uint16_t &count = ((Heap_Region_Snapshot *)userData)->freeSizeClasses[SizeClass(block.size)];
+            count = count < UINT16_MAX ? count + 1 : count;
+        }
+
+        return true;
+    }, &region);
+#endif
+}
+
+void Heap_Utils::snapshotTimerCallback(TimerHandle_t timer)
+{
+    takeSnapshot();
+}
+
+void Heap_Utils::takeSnapshot()
+{
+    Heap_Snapshot snapshot;
+    snapshot.timestampMS = millis();
+
+    fillRegion(snapshot.internal, MALLOC_CAP_INTERNAL);
+    fillRegion(snapshot.spiram, MALLOC_CAP_SPIRAM);
+
+    CopyLiveBytes(snapshot.liveBytes);
+
+    _Snapshots[_SnapshotHead] = snapshot;
+    _SnapshotHead = (_SnapshotHead + 1) % HEAP_SNAPSHOT_HISTORY;
+    _SnapshotCount = min(_SnapshotCount + 1, (size_t)HEAP_SNAPSHOT_HISTORY);
+}
+
+namespace
+{
+    void AddRegion(JsonObject snapshotObject, const char *name, const Heap_Region_Snapshot &region)
+    {
+        JsonObject regionObject = snapshotObject.createNestedObject(name);
+        regionObject["free"] = region.freeBytes;
+        regionObject["largest"] = region.largestFreeBlock;
+        regionObject["minFree"] = region.minimumFreeBytes;
+        regionObject["freeBlocks"] = region.freeBlocks;
+        regionObject["usedBlocks"] = region.allocatedBlocks;
+
+        JsonArray freeClasses = regionObject.createNestedArray("freeClasses");
+
+        for (uint16_t count : region.freeSizeClasses)
+        {
+            freeClasses.add(count);
+        }
+    }
+}
+
+void Heap_Utils::GetHeapStatsRpc(JsonDocument &doc)
+{
+    bool clearPeaks = doc["clear"] | false;
+    doc.clear();
+
+    doc["tracking"] = HEAP_TRACKING_ENABLED == 1;
+    doc["fragmentation"] = FragmentationPercent();
+
+    // Upper bound of each size class. The last class is unbounded.
+    JsonArray sizeClasses = doc.createNestedArray("sizeClasses");
+
+    for (uint8_t i = 0; i < HEAP_SIZE_CLASSES - 1; i++)
+    {
+        sizeClasses.add(HEAP_SMALLEST_CLASS_BYTES << i);
+    }
+
+    JsonArray tagNames = doc.createNestedArray("tagNames");
+
+    for (uint8_t tag = 0; tag < NUM_HEAP_TAGS; tag++)
+    {
+        tagNames.add(TagName(tag));
+    }
+
+#if HEAP_TRACKING_ENABLED == 1
+    // Copied out first. Adding to the document allocates, which cannot happen under the lock.
+    Heap_Tag_Stats tagStats[NUM_HEAP_TAGS];
+    CopyTagStats(tagStats, clearPeaks);
+
+    JsonArray tags = doc.createNestedArray("tags");
+
+    for (uint8_t tag = 0; tag < NUM_HEAP_TAGS; tag++)
+    {
+        const Heap_Tag_Stats &stats = tagStats[tag];
+
+        JsonObject tagObject = tags.createNestedObject();
+        tagObject["name"] = TagName(tag);
+        tagObject["liveCount"] = stats.liveCount;
+        tagObject["liveBytes"] = stats.liveBytes;
+        tagObject["peakBytes"] = stats.peakBytes;
+        tagObject["allocations"] = stats.totalAllocations;
+        tagObject["failed"] = stats.failedAllocations;
+
+        JsonArray liveClasses = tagObject.createNestedArray("liveClasses");
+
+        for (uint16_t count : stats.sizeClasses)
+        {
+            liveClasses.add(count);
+        }
+    }
+#endif
+
+    JsonArray snapshots = doc.createNestedArray("snapshots");
+
+    for (size_t i = 0; i < _SnapshotCount; i++)
+    {
+        const Heap_Snapshot &snapshot = _Snapshots[(_SnapshotHead + HEAP_SNAPSHOT_HISTORY - _SnapshotCount + i) % HEAP_SNAPSHOT_HISTORY];
+
+        JsonObject snapshotObject = snapshots.createNestedObject();
+        snapshotObject["t"] = snapshot.timestampMS;
+        AddRegion(snapshotObject, "internal", snapshot.internal);
+
+        if (snapshot.spiram.freeBytes > 0)
+        {
+            AddRegion(snapshotObject, "spiram", snapshot.spiram);
+        }
+
+#if HEAP_TRACKING_ENABLED == 1
+        JsonArray live = snapshotObject.createNestedArray("live");
+
+        for (uint32_t bytes : snapshot.liveBytes)
+        {
+            live.add(bytes);
+        }
+#endif
+    }
+}
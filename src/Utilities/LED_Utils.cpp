@@ -3,11 +3,31 @@
 std::unordered_map<uint8_t, uint8_t> LED_Utils::inputIdLedPins;
 CRGB LED_Utils::_ThemeColor;
 
-std::unordered_map<int, LED_Pattern_Status> LED_Utils::registeredPatterns;
-int LED_Utils::nextPatternID = 0;
+LED_Pattern_Table LED_Utils::_Patterns(LED_Utils::processCommand);
+std::atomic<uint32_t> LED_Utils::_ProgramPatternIDs(0);
 size_t LED_Utils::_PatternTickRateMS = 50;
 
 TaskHandle_t LED_Utils::_IteratePatternsTaskHandle = nullptr;
+LED_Frame_Clock LED_Utils::_FrameClock;
+
+int LED_Utils::_CommandQueueID = -1;
+StaticQueue_t LED_Utils::_CommandQueueBuffer;
+uint8_t LED_Utils::_CommandQueueStorage[LED_COMMAND_QUEUE_LENGTH * sizeof(LED_Command)];
+
+CRGB *LED_Utils::_OutputLeds = nullptr;
+CRGB *LED_Utils::_FrameLeds = nullptr;
+size_t LED_Utils::_LastBatteryCheckMS = 0;
+CRGB *LED_Utils::_BaseLayer = nullptr;
+size_t LED_Utils::_NumLeds = 0;
+
+void LED_Utils::init()
+{
+    if (!_Patterns.hasQueue())
+    {
+        _CommandQueueID = System_Utils::registerQueue(LED_COMMAND_QUEUE_LENGTH, sizeof(LED_Command), _CommandQueueStorage, _CommandQueueBuffer);
+        _Patterns.setQueue(System_Utils::getQueue(_CommandQueueID));
+    }
+}
 
 int LED_Utils::registerPattern(LED_Pattern_Interface *pattern)
 {
@@ -16,116 +36,254 @@ int LED_Utils::registerPattern(LED_Pattern_Interface *pattern)
         return -1;
     }
 
-    registeredPatterns[nextPatternID] = {nextPatternID, pattern, 0, false};
-    pattern->SetRegisteredPatternID(nextPatternID);
-    return nextPatternID++;
+    int patternID = _Patterns.registerPattern(pattern, _NumLeds);
+
+    if (patternID == LED_PATTERN_NO_SLOT)
+    {
+        LOG_WARN("LED_Utils::registerPattern: No free pattern slots");
+        return -1;
+    }
+
+    if (patternID == LED_PATTERN_NOT_ACCEPTED)
+    {
+        LOG_ERROR("LED_Utils::registerPattern: LED task not accepting commands");
+        return -1;
+    }
+
+    requestFrame();
+    return patternID;
 }
 
 void LED_Utils::unregisterPattern(int patternID)
 {
-    if (registeredPatterns.find(patternID) == registeredPatterns.end())
+    if (!_Patterns.unregisterPattern(patternID))
     {
         return;
     }
 
-    delete registeredPatterns[patternID].pattern;
-    registeredPatterns.erase(patternID);
-}
-
-void LED_Utils::resetPattern(int patternID)
-{
-    if (registeredPatterns.find(patternID) == registeredPatterns.end())
+    // Without a queue the pattern is already deleted
+    if (!_Patterns.hasQueue())
     {
+        _ProgramPatternIDs.fetch_and(~(1UL << patternID));
         return;
     }
 
-    registeredPatterns[patternID].pattern->resetPattern();
+    requestFrame();
 }
 
-void LED_Utils::setAnimationLengthMS(int patternID, size_t ms)
+void LED_Utils::resetPattern(int patternID)
 {
-    if (registeredPatterns.find(patternID) == registeredPatterns.end())
-    {
-        return;
-    }
+    LED_Command command = {LED_COMMAND_RESET, patternID};
+    sendCommand(command);
+}
 
-    registeredPatterns[patternID].pattern->setAnimationLengthMS(ms);
+void LED_Utils::setAnimationLengthMS(int patternID, size_t ms)
+{
+    LED_Command command = {LED_COMMAND_SET_LENGTH_MS, patternID};
+    command.value = ms;
+    sendCommand(command);
 }
 
 void LED_Utils::setAnimationLengthTicks(int patternID, size_t ticks)
 {
-    if (registeredPatterns.find(patternID) == registeredPatterns.end())
-    {
-        return;
-    }
-
-    registeredPatterns[patternID].pattern->setAnimationLengthTicks(ticks);
+    LED_Command command = {LED_COMMAND_SET_LENGTH_TICKS, patternID};
+    command.value = ticks;
+    sendCommand(command);
 }
 
 void LED_Utils::configurePattern(int patternID, JsonDocument &config)
 {
-    if (registeredPatterns.find(patternID) == registeredPatterns.end())
+    LED_Command command = {LED_COMMAND_CONFIGURE, patternID};
+
+    // The config is carried as MessagePack so the caller's document can go out of scope
+    size_t configLength = measureMsgPack(config);
+
+    if (configLength > LED_COMMAND_CONFIG_SIZE)
     {
+        LOG_WARN("LED_Utils::configurePattern: Config too large (%u bytes)", configLength);
+        _Patterns.countDroppedCommand();
         return;
     }
 
-    registeredPatterns[patternID].pattern->configurePattern(config);
+    command.configLength = serializeMsgPack(config, command.config, LED_COMMAND_CONFIG_SIZE);
+    sendCommand(command);
 }   
 
 void LED_Utils::loopPattern(int patternID, int numLoops)
 {
-    if (registeredPatterns.find(patternID) == registeredPatterns.end())
-    {
-        return;
-    }
+    LED_Command command = {LED_COMMAND_LOOP, patternID};
+    command.value = numLoops;
+    sendCommand(command);
+}
 
-    registeredPatterns[patternID].loopsRemaining = numLoops;
+void LED_Utils::enablePattern(int patternID)
+{
+    LED_Command command = {LED_COMMAND_ENABLE, patternID};
+    sendCommand(command);
+}
 
-    if (numLoops != 0)
-        vTaskResume(_IteratePatternsTaskHandle);
+void LED_Utils::disablePattern(int patternID)
+{
+    LED_Command command = {LED_COMMAND_DISABLE, patternID};
+    sendCommand(command);
 }
 
-void LED_Utils::enablePattern(int patternID)
+void LED_Utils::clearPattern(int patternID)
 {
-    if (registeredPatterns.find(patternID) == registeredPatterns.end())
+    LED_Command command = {LED_COMMAND_CLEAR, patternID};
+    sendCommand(command);
+}
+
+void LED_Utils::applyToPattern(int patternID, LED_Pattern_Function function, int32_t argument)
+{
+    if (function == nullptr)
     {
         return;
     }
 
-    registeredPatterns[patternID].enabled = true;
+    LED_Command command = {LED_COMMAND_APPLY, patternID};
+    command.function = function;
+    command.value = argument;
+    sendCommand(command);
 }
 
-void LED_Utils::disablePattern(int patternID)
+bool LED_Utils::sendCommand(LED_Command &command)
 {
-    if (registeredPatterns.find(patternID) == registeredPatterns.end())
+    if (!_Patterns.sendCommand(command))
     {
-        return;
+        if (_Patterns.hasQueue() && _Patterns.waitsForRoom(command))
+        {
+            LOG_ERROR("LED_Utils::sendCommand: Dropped command %u for pattern %d after %u ms", command.type, command.patternID, LED_COMMAND_SEND_TIMEOUT_MS);
+        }
+
+        return false;
     }
 
-    registeredPatterns[patternID].enabled = false;
-    clearPattern(patternID);
+    requestFrame();
+    return true;
 }
 
-void LED_Utils::clearPattern(int patternID)
+void LED_Utils::processCommands(size_t frameMS)
 {
-    if (registeredPatterns.find(patternID) == registeredPatterns.end())
+    uint32_t deletedIDs = _Patterns.processCommands(frameMS);
+    _ProgramPatternIDs.fetch_and(~deletedIDs);
+}
+
+void LED_Utils::processCommand(LED_Pattern_Status &status, LED_Command &command, size_t frameMS)
+{
+    LED_Pattern_Interface *pattern = status.pattern;
+
+    switch (command.type)
     {
-        return;
+    case LED_COMMAND_RESET:
+        pattern->resetPattern();
+        break;
+    case LED_COMMAND_SET_LENGTH_MS:
+        pattern->setAnimationLengthMS(command.value);
+        break;
+    case LED_COMMAND_SET_LENGTH_TICKS:
+        pattern->setAnimationLengthTicks(command.value);
+        break;
+    case LED_COMMAND_CONFIGURE:
+    {
+        StaticJsonDocument<LED_COMMAND_CONFIG_SIZE * 2> config;
+
+        if (deserializeMsgPack(config, command.config, command.configLength) != DeserializationError::Ok)
+        {
+            break;
+        }
+
+        if (config.containsKey("blendMode"))
+        {
+            pattern->setBlendMode((LED_Blend_Mode)config["blendMode"].as<uint8_t>(), config["alpha"] | pattern->BlendAlpha());
+        }
+
+        if (config.containsKey("zOrder"))
+        {
+            pattern->setZOrder(config["zOrder"]);
+        }
+
+        pattern->configurePattern(config);
+        break;
     }
+    case LED_COMMAND_LOOP:
+        status.loopsRemaining = command.value;
+        break;
+    case LED_COMMAND_ENABLE:
+        status.enabled = true;
+        break;
+    case LED_COMMAND_DISABLE:
+        status.enabled = false;
+        pattern->clearPattern();
+        status.visible = false;
+        status.loopsRemaining = 0;
+        break;
+    case LED_COMMAND_CLEAR:
+        pattern->clearPattern();
+        status.visible = false;
+        status.loopsRemaining = 0;
+        break;
+    case LED_COMMAND_ITERATE:
+        if (status.enabled)
+        {
+            pattern->setFrameTime(frameMS);
+            pattern->iterateFrame();
+            status.visible = true;
+        }
+        break;
+    case LED_COMMAND_APPLY:
+        command.function(pattern, command.value);
+        break;
+    default:
+        break;
+    }
+}
 
-    registeredPatterns[patternID].pattern->clearPattern();
+void LED_Utils::setLeds(CRGB *leds, size_t numLeds)
+{
+    if (_BaseLayer != nullptr && _NumLeds != numLeds)
+    {
+        delete[] _BaseLayer;
+        delete[] _FrameLeds;
+        _BaseLayer = nullptr;
+        _FrameLeds = nullptr;
+    }
 
-    if (registeredPatterns[patternID].loopsRemaining != 0)
+    if (_BaseLayer == nullptr)
     {
-        loopPattern(patternID, 0);
+        _BaseLayer = new CRGB[numLeds];
+        _FrameLeds = new CRGB[numLeds];
     }
 
-    FastLED.show();
+    fill_solid(_BaseLayer, numLeds, CRGB::Black);
+    fill_solid(_FrameLeds, numLeds, CRGB::Black);
+
+    _OutputLeds = leds;
+    _NumLeds = numLeds;
+    LED_Pattern_Interface::setNumLeds(numLeds);
+    LED_Output_Stage::init(numLeds);
 }
 
-void LED_Utils::setLeds(CRGB *leds, size_t numLeds)
+void LED_Utils::requestFrame()
+{
+    if (_IteratePatternsTaskHandle != nullptr)
+    {
+        xTaskNotifyGive(_IteratePatternsTaskHandle);
+    }
+}
+
+void LED_Utils::compositeFrame()
 {
-    LED_Pattern_Interface::setLeds(leds, numLeds);
+    if (_OutputLeds == nullptr || _BaseLayer == nullptr || _FrameLeds == nullptr)
+    {
+        return;
+    }
+
+    memcpy(_FrameLeds, _BaseLayer, _NumLeds * sizeof(CRGB));
+    _Patterns.composite(_FrameLeds, _NumLeds);
+
+    // Gamma, current limiting and dithering happen once on the finished frame
+    LED_Output_Stage::render(_FrameLeds, _OutputLeds, _NumLeds);
 }
 
 void LED_Utils::setTickRate(size_t ms)
@@ -142,61 +300,49 @@ void LED_Utils::setTickRate(size_t ms)
 
 void LED_Utils::iteratePatterns(void *pvParameters)
 {
+    HEAP_TASK_TAG(HEAP_TAG_LED);
+    _FrameClock.restart();
+
     while (true)
     {
-        bool workToDo = false;
-        
-        // Iterate all patterns that are enable with work to do
-        for (auto &pattern : registeredPatterns)
-        {
-            taskYIELD();
-            
-            if (pattern.second.loopsRemaining == 0 || !pattern.second.enabled)
-            {
-                continue;
-            }
-
-            if (pattern.second.pattern->iterateFrame())
-            {
-                if (pattern.second.loopsRemaining > 0)
-                {
-                    pattern.second.loopsRemaining--;
-                }
-            }
-
-            if (pattern.second.loopsRemaining != 0)
-            {
-                workToDo = true;
-            }
-        }
+        // Every pattern in a frame sees the time the frame was scheduled for, not when it happened to run
+        size_t frameMS = _FrameClock.FrameMS();
 
-        // Check task notification for single iteration
-        uint32_t notificationPatternID;
-        auto notificationReady = xTaskNotifyWait(0, ULONG_MAX, &notificationPatternID, 0);
-        int patternID = (int)notificationPatternID;
+        TRACE_BEGIN(TRACE_LED_FRAME, frameMS);
 
-        if (notificationReady == pdTRUE && registeredPatterns.find(patternID) != registeredPatterns.end())
+        // Apply everything queued since the last frame. Patterns are only touched by this task.
+        processCommands(frameMS);
+        
+        // Iterate all patterns that are enabled with work to do
+        bool workToDo = _Patterns.iterate(frameMS);
+
+        // The battery is sampled occasionally so the ADC read stays out of most frames
+        if (_LastBatteryCheckMS == 0 || frameMS - _LastBatteryCheckMS >= LED_BATTERY_CHECK_MS)
         {
-            // Clear the notification
-            xTaskNotifyStateClear(_IteratePatternsTaskHandle);
-            
-            #if DEBUG == 1
-            // Serial.println("LED_Utils::iteratePatterns: Single iteration");
-            #endif
-            if (registeredPatterns[patternID].enabled)
-            {
-                registeredPatterns[patternID].pattern->iterateFrame();
-            }
+            LED_Output_Stage::setBatteryPercentage(System_Utils::getBatteryPercentage());
+            _LastBatteryCheckMS = frameMS;
         }
 
+        compositeFrame();
+
+        TRACE_BEGIN(TRACE_LED_SHOW, 0);
         FastLED.show();
+        TRACE_END(TRACE_LED_SHOW, 0);
+
+        TRACE_END(TRACE_LED_FRAME, frameMS);
         
         if (!workToDo)
         {
-            vTaskSuspend(_IteratePatternsTaskHandle);
+            // Sleep until a command or frame request arrives. Notifications sent since the
+            // commands were processed are counted, so none are lost.
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+            // Restart the frame clock after sleeping. Time spent asleep is not missed frames.
+            _FrameClock.restart();
+            continue;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(_PatternTickRateMS));
+        _FrameClock.waitForNextFrame(_PatternTickRateMS);
     }
 }
 
@@ -205,12 +351,104 @@ void LED_Utils::iteratePattern(int patternID)
     #if DEBUG == 1
     // Serial.println("LED_Utils::iteratePattern");
     #endif
-    if (_IteratePatternsTaskHandle != nullptr && patternID > -1)
+    LED_Command command = {LED_COMMAND_ITERATE, patternID};
+    sendCommand(command);
+}
+
+void LED_Utils::LoadPatternProgramRpc(JsonDocument &doc)
+{
+    int patternID = doc["patternID"] | -1;
+    int loops = doc["loops"] | 0;
+
+    LED_Program program;
+    bool compiled = false;
+
+    if (doc.containsKey("program"))
     {
-        vTaskResume(_IteratePatternsTaskHandle);
-        uint32_t notificationPatternID = (uint32_t)patternID;
-        xTaskNotify(_IteratePatternsTaskHandle, notificationPatternID, eSetValueWithOverwrite);
+        compiled = Keyframe_Pattern::CompileProgram(doc["program"], program);
     }
+    else if (doc.containsKey("file"))
+    {
+        Keyframe_Pattern loader;
+        compiled = loader.loadProgramFile(doc["file"].as<std::string>());
+        program = loader.Program();
+    }
+    else
+    {
+        doc.clear();
+        doc["error"] = "Missing 'program' or 'file'";
+        return;
+    }
+
+    doc.clear();
+
+    if (!compiled)
+    {
+        doc["error"] = "Invalid program";
+        return;
+    }
+
+    // Patterns are owned by the LED task, so a reloaded program replaces the old pattern outright
+    if (patternID != -1)
+    {
+        if (patternID < 0 || patternID >= MAX_LED_PATTERNS || !(_ProgramPatternIDs.load() & (1UL << patternID)))
+        {
+            doc["error"] = "Unknown patternID";
+            return;
+        }
+
+        _ProgramPatternIDs.fetch_and(~(1UL << patternID));
+        unregisterPattern(patternID);
+    }
+
+    Keyframe_Pattern *pattern = new Keyframe_Pattern();
+    pattern->setProgram(program);
+    patternID = registerPattern(pattern);
+
+    if (patternID == -1)
+    {
+        delete pattern;
+        doc["error"] = "No free pattern slots";
+        return;
+    }
+
+    _ProgramPatternIDs.fetch_or(1UL << patternID);
+    enablePattern(patternID);
+
+    if (loops != 0)
+    {
+        loopPattern(patternID, loops);
+    }
+
+    doc["patternID"] = patternID;
+}
+
+void LED_Utils::SetLedPowerRpc(JsonDocument &doc)
+{
+    if (doc.containsKey("budgetMA"))
+    {
+        LED_Output_Stage::setBudgetMA(doc["budgetMA"].as<uint16_t>());
+    }
+
+    if (doc.containsKey("gamma"))
+    {
+        LED_Output_Stage::setGammaEnabled(doc["gamma"].as<bool>());
+    }
+
+    if (doc.containsKey("dither"))
+    {
+        LED_Output_Stage::setDitherEnabled(doc["dither"].as<bool>());
+    }
+
+    doc.clear();
+    doc["budgetMA"] = LED_Output_Stage::BudgetMA();
+    doc["effectiveBudgetMA"] = LED_Output_Stage::EffectiveBudgetMA();
+    doc["estimateMA"] = LED_Output_Stage::LastEstimateMA();
+    doc["limitedFrames"] = LED_Output_Stage::LimitedFrames();
+    doc["gamma"] = LED_Output_Stage::GammaEnabled();
+    doc["dither"] = LED_Output_Stage::DitherEnabled();
+
+    requestFrame();
 }
 
 void LED_Utils::setThemeColor(uint8_t r, uint8_t g, uint8_t b)
@@ -0,0 +1,174 @@
+#include "Log_Format.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+    const char LEVEL_CHARS[] = {'-', 'E', 'W', 'I', 'D', 'V'};
+
+    // Conversion characters that end a format spec
+    bool isConversion(char c)
+    {
+        return strchr("diouxXcfFeEgGaAsp", c) != nullptr;
+    }
+
+    // Length modifiers are replaced with ones that match the stored argument
+    bool isLengthModifier(char c)
+    {
+        return strchr("hlLqjzt", c) != nullptr;
+    }
+}
+
+void Log_Format::packArg(Log_Record &record, double value)
+{
+    if (record.numArgs < LOG_MAX_ARGS)
+    {
+        record.argTypes[record.numArgs] = LOG_ARG_FLOAT;
+        record.args[record.numArgs++].number = value;
+    }
+}
+
+void Log_Format::packArg(Log_Record &record, const char *value)
+{
+    if (record.numArgs >= LOG_MAX_ARGS)
+    {
+        return;
+    }
+
+    if (value == nullptr)
+    {
+        value = "(null)";
+    }
+
+    // Copy as much as fits. Strings that do not fit at all become empty.
+    size_t available = LOG_TEXT_BYTES - record.textUsed;
+    size_t length = available > 0 ? std::min(strlen(value), available - 1) : 0;
+
+    record.argTypes[record.numArgs] = LOG_ARG_TEXT;
+    record.args[record.numArgs++].textOffset = std::min((size_t)record.textUsed, (size_t)LOG_TEXT_BYTES - 1);
+
+    if (available > 0)
+    {
+        memcpy(&record.text[record.textUsed], value, length);
+        record.text[record.textUsed + length] = '\0';
+        record.textUsed += length + 1;
+    }
+    else
+    {
+        record.text[LOG_TEXT_BYTES - 1] = '\0';
+    }
+}
+
+size_t Log_Format::formatRecord(const Log_Record &record, char *buffer, size_t bufferSize)
+{
+    if (bufferSize == 0)
+    {
+        return 0;
+    }
+
+    size_t length = snprintf(buffer, bufferSize, "[%lu][%c] ", (unsigned long)record.timestampMS, LEVEL_CHARS[record.level < sizeof(LEVEL_CHARS) ? record.level : 0]);
+    uint8_t argIdx = 0;
+    const char *c = record.format;
+
+    while (*c != '\0' && length < bufferSize - 1)
+    {
+        if (*c != '%')
+        {
+            buffer[length++] = *c++;
+            continue;
+        }
+
+        if (c[1] == '%')
+        {
+            buffer[length++] = '%';
+            c += 2;
+            continue;
+        }
+
+        // Copy the flags, width and precision, dropping length modifiers
+        char spec[16] = {'%'};
+        size_t specLength = 1;
+        const char *end = c + 1;
+
+        while (*end != '\0' && !isConversion(*end))
+        {
+            if (!isLengthModifier(*end) && specLength < sizeof(spec) - 4)
+            {
+                spec[specLength++] = *end;
+            }
+
+            end++;
+        }
+
+        if (*end == '\0')
+        {
+            break;
+        }
+
+        char conversion = *end;
+        c = end + 1;
+
+        size_t remaining = bufferSize - length;
+        int written = 0;
+
+        if (argIdx >= record.numArgs)
+        {
+            written = snprintf(&buffer[length], remaining, "<?>");
+        }
+        else
+        {
+            const Log_Arg_Type type = record.argTypes[argIdx];
+            const Log_Arg &arg = record.args[argIdx++];
+
+            // Each conversion is formatted with the type it expects, whatever type was stored
+            switch (conversion)
+            {
+            case 's':
+                spec[specLength++] = 's';
+                spec[specLength] = '\0';
+                written = snprintf(&buffer[length], remaining, spec, type == LOG_ARG_TEXT ? &record.text[arg.textOffset] : "<?>");
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                written = snprintf(&buffer[length], remaining, spec, type == LOG_ARG_FLOAT ? arg.number : (double)arg.integer);
+                break;
+            case 'c':
+                spec[specLength++] = 'c';
+                spec[specLength] = '\0';
+                written = snprintf(&buffer[length], remaining, spec, (int)arg.integer);
+                break;
+            case 'p':
+                spec[specLength++] = 'p';
+                spec[specLength] = '\0';
+                written = snprintf(&buffer[length], remaining, spec, (void *)(uintptr_t)arg.integer);
+                break;
+            default:
+                spec[specLength++] = 'l';
+                spec[specLength++] = 'l';
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+
+                if (type == LOG_ARG_TEXT)
+                {
+                    written = snprintf(&buffer[length], remaining, "<?>");
+                }
+                else
+                {
+                    long long value = type == LOG_ARG_FLOAT ? (long long)arg.number : arg.integer;
+                    written = snprintf(&buffer[length], remaining, spec, value);
+                }
+                break;
+            }
+        }
+
+        if (written > 0)
+        {
+            length = std::min(length + written, bufferSize - 1);
+        }
+    }
+
+    buffer[length] = '\0';
+    return length;
+}
@@ -0,0 +1,72 @@
+#include "Log_Utils.h"
+#include "System_Utils.h"
+
+int Log_Utils::_QueueID = -1;
+QueueHandle_t Log_Utils::_Queue = nullptr;
+StaticQueue_t Log_Utils::_QueueBuffer;
+uint8_t Log_Utils::_QueueStorage[LOG_QUEUE_LENGTH * sizeof(Log_Record)];
+
+std::atomic<uint32_t> Log_Utils::_DroppedRecords(0);
+uint32_t Log_Utils::_ReportedDrops = 0;
+int Log_Utils::_DrainTaskID = -1;
+
+void Log_Utils::init()
+{
+    if (_Queue != nullptr)
+    {
+        return;
+    }
+
+    _QueueID = System_Utils::registerQueue(LOG_QUEUE_LENGTH, sizeof(Log_Record), _QueueStorage, _QueueBuffer);
+    _Queue = System_Utils::getQueue(_QueueID);
+
+    _DrainTaskID = System_Utils::registerTask(drainTask, "Log Drain", 3072, nullptr, 1);
+}
+
+void Log_Utils::submit(Log_Record &record)
+{
+    // Before the drain task exists there is nothing to defer to
+    if (_Queue == nullptr)
+    {
+        printRecord(record);
+        return;
+    }
+
+    if (xQueueSend(_Queue, &record, 0) != pdTRUE)
+    {
+        _DroppedRecords.fetch_add(1);
+    }
+}
+
+void Log_Utils::printRecord(const Log_Record &record)
+{
+    char line[LOG_LINE_BYTES];
+    Log_Format::formatRecord(record, line, sizeof(line));
+    Serial.println(line);
+}
+
+void Log_Utils::drainTask(void *pvParameters)
+{
+    HEAP_TASK_TAG(HEAP_TAG_SYSTEM);
+
+    Log_Record record;
+
+    while (true)
+    {
+        if (xQueueReceive(_Queue, &record, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+
+        printRecord(record);
+
+        // Report drops once the queue has room again
+        uint32_t dropped = _DroppedRecords.load();
+
+        if (dropped != _ReportedDrops)
+        {
+            Serial.printf("[%lu][W] Log: %lu records dropped\n", (unsigned long)millis(), (unsigned long)(dropped - _ReportedDrops));
+            _ReportedDrops = dropped;
+        }
+    }
+}
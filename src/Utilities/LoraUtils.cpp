@@ -1,7 +1,15 @@
 #include "LoraUtils.h"
+#include "MessagePing.h"
+
+namespace
+{
+    // Used when the asset partition has no messages/default. Keep in step with tools/assets.json.
+    const char *const FALLBACK_DEFAULT_MESSAGES[] = {"Meet here", "Point of interest", "I have a quest"};
+}
 
 std::map<uint32_t, MessageBase *> LoraUtils::_ReceivedMessages;
 std::map<uint32_t, MessageBase *> LoraUtils::_UnreadMessages;
+uint32_t LoraUtils::_MessageStoreVersion = 0;
 
 MessageBase *LoraUtils::_MyLastBroadcast = nullptr;
 
@@ -24,6 +32,12 @@ uint8_t LoraUtils::_NodeID = 0;
 StaticSemaphore_t LoraUtils::_MessageAccessMutexBuffer;
 SemaphoreHandle_t LoraUtils::_MessageAccessMutex;
 
+SemaphoreHandle_t LoraUtils::_SavedMessageListMutex = nullptr;
+StaticSemaphore_t LoraUtils::_SavedMessageListMutexBuffer;
+
+SemaphoreHandle_t LoraUtils::_UserInfoListMutex = nullptr;
+StaticSemaphore_t LoraUtils::_UserInfoListMutexBuffer;
+
 StaticQueue_t LoraUtils::_MessageQueueBuffer;
 uint8_t LoraUtils::_MessageQueueBufferStorage[MESSAGE_QUEUE_LENGTH * sizeof(OutboundMessageQueueItem)]; 
 
@@ -35,6 +49,8 @@ std::map<uint32_t, MessageBase *>::iterator LoraUtils::_UnreadMessageIterator;
 void LoraUtils::Init() 
 {
     _MessageAccessMutex = xSemaphoreCreateMutexStatic(&_MessageAccessMutexBuffer);
+    _SavedMessageListMutex = xSemaphoreCreateMutexStatic(&_SavedMessageListMutexBuffer);
+    _UserInfoListMutex = xSemaphoreCreateMutexStatic(&_UserInfoListMutexBuffer);
     _MessageSendQueueID =  System_Utils::registerQueue(MESSAGE_QUEUE_LENGTH, sizeof(OutboundMessageQueueItem), _MessageQueueBufferStorage, _MessageQueueBuffer);
 }
 
@@ -86,6 +102,8 @@ void LoraUtils::MarkMessageOpened(uint64_t userID) {
             } else {
                 _UnreadMessages.erase(userID);
             }
+
+            _MessageStoreVersion++;
         }
         
         xSemaphoreGive(_MessageAccessMutex);
@@ -130,6 +148,7 @@ void LoraUtils::SetMyLastBroadcast(MessageBase *msg) {
 void LoraUtils::SetReceivedMessage(uint64_t userID, MessageBase *msg) {
     if (xSemaphoreTake(_MessageAccessMutex, portMAX_DELAY) == pdTRUE) {
         bool isMsgNew = true;
+        bool replacedPing = false;
 
         if (_ReceivedMessages.find(userID) != _ReceivedMessages.end())
         {
@@ -138,6 +157,7 @@ void LoraUtils::SetReceivedMessage(uint64_t userID, MessageBase *msg) {
                 isMsgNew = false;
             }
 
+            replacedPing = _ReceivedMessages[userID]->GetInstanceMessageType() == MessagePing::MessageType();
             delete _ReceivedMessages[userID];
         }
         _ReceivedMessages[userID] = msg->clone();
@@ -151,6 +171,20 @@ void LoraUtils::SetReceivedMessage(uint64_t userID, MessageBase *msg) {
 
             _UnreadMessages[userID] = msg->clone();
         }
+
+        if (msg->GetInstanceMessageType() == MessagePing::MessageType())
+        {
+            MessagePing *ping = (MessagePing *)msg;
+            NavigationUtils::IndexPing(userID, ping->senderName, ping->lat, ping->lng);
+        }
+        else if (replacedPing)
+        {
+            // Only the latest message per user is kept, so the sender's ping is gone and leaves the nearby index
+            NavigationUtils::IndexPing(userID, "", 0, 0);
+        }
+
+        // Bumped after the nearby index, so a screen refreshing on REFRESH_DEPENDENCY_MESSAGES sees the new ping
+        _MessageStoreVersion++;
         xSemaphoreGive(_MessageAccessMutex);
     }
 }
@@ -270,7 +304,9 @@ bool LoraUtils::MessagePackSanityCheck(JsonDocument &doc)
 
 void LoraUtils::AddSavedMessage(std::string msg, bool flash)
 {
+    xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
     _SavedMessageList.push_back(msg);
+    xSemaphoreGive(_SavedMessageListMutex);
 
     if (flash)
         _SavedMessageListUpdated.Invoke();
@@ -278,24 +314,49 @@ void LoraUtils::AddSavedMessage(std::string msg, bool flash)
 
 void LoraUtils::DeleteSavedMessage(std::vector<std::string>::iterator &it)
 {
+    xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
     it = _SavedMessageList.erase(it);
+    xSemaphoreGive(_SavedMessageListMutex);
 
     _SavedMessageListUpdated.Invoke();
 }
 
 void LoraUtils::ClearSavedMessages()
 {
-    _SavedMessageList.clear();
+    xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
 
-    _SavedMessageList.push_back("Meet here");
-    _SavedMessageList.push_back("Point of interest");
+    _SavedMessageList.clear();
+    appendDefaultMessages();
+    xSemaphoreGive(_SavedMessageListMutex);
 
     _SavedMessageListUpdated.Invoke();
 }
 
+void LoraUtils::LoadDefaultMessages()
+{
+    xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
+    appendDefaultMessages();
+    xSemaphoreGive(_SavedMessageListMutex);
+}
+
+void LoraUtils::appendDefaultMessages()
+{
+    if (Asset_Utils::forEachString(ASSET_DEFAULT_MESSAGES, [](const char *msg) { _SavedMessageList.push_back(msg); }))
+    {
+        return;
+    }
+
+    for (const char *msg : FALLBACK_DEFAULT_MESSAGES)
+    {
+        _SavedMessageList.push_back(msg);
+    }
+}
+
 void LoraUtils::UpdateSavedMessage(std::vector<std::string>::iterator &it, std::string msg)
 {
+    xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
     *it = msg;
+    xSemaphoreGive(_SavedMessageListMutex);
 }
 
 // RPC
@@ -305,6 +366,9 @@ void LoraUtils::RpcGetSavedMessage(JsonDocument &doc)
     {
         auto idx = doc["Idx"].as<int>();
         doc.clear();
+
+        xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
+
         if (idx >= 0 && idx < _SavedMessageList.size())
         {
             doc["Message"] = _SavedMessageList[idx];
@@ -313,6 +377,8 @@ void LoraUtils::RpcGetSavedMessage(JsonDocument &doc)
         {
             doc["Message"] = "";
         }
+
+        xSemaphoreGive(_SavedMessageListMutex);
     }
 }
 
@@ -321,10 +387,15 @@ void LoraUtils::RpcGetSavedMessages(JsonDocument &doc)
     doc.clear();
     auto msgArray = doc.createNestedArray("Messages");
     size_t idx = 0;
+
+    xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
+
     for (auto msg : _SavedMessageList)
     {
         msgArray.add(msg);
     }
+
+    xSemaphoreGive(_SavedMessageListMutex);
 }
 
 void LoraUtils::RpcAddSavedMessage(JsonDocument &doc)
@@ -361,13 +432,21 @@ void LoraUtils::RpcDeleteSavedMessage(JsonDocument &doc)
     if (doc.containsKey("Idx"))
     {
         auto idx = doc["Idx"].as<int>();
-        
+
+        xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
+
         if (idx >= 0 && idx < _SavedMessageList.size())
         {
             success = true;
-            auto it = _SavedMessageList.begin() + idx;
-            DeleteSavedMessage(it);
+            _SavedMessageList.erase(_SavedMessageList.begin() + idx);
         }
+
+        xSemaphoreGive(_SavedMessageListMutex);
+    }
+
+    if (success)
+    {
+        _SavedMessageListUpdated.Invoke();
     }
 
     doc.clear();
@@ -377,7 +456,10 @@ void LoraUtils::RpcDeleteSavedMessage(JsonDocument &doc)
 
 void LoraUtils::RpcDeleteSavedMessages(JsonDocument &doc)
 {
+    xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
     _SavedMessageList.clear();
+    xSemaphoreGive(_SavedMessageListMutex);
+
     _SavedMessageListUpdated.Invoke();
     doc.clear();
 }
@@ -388,12 +470,16 @@ void LoraUtils::RpcUpdateSavedMessage(JsonDocument &doc)
     if (doc.containsKey("Idx") && doc.containsKey("Message"))
     {
         auto idx = doc["Idx"].as<int>();
+
+        xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
+
         if (idx >= 0 && idx < _SavedMessageList.size())
         {
             success = true;
-            auto it = _SavedMessageList.begin() + idx;
-            UpdateSavedMessage(it, doc["Message"].as<std::string>());
+            _SavedMessageList[idx] = doc["Message"].as<std::string>();
         }
+
+        xSemaphoreGive(_SavedMessageListMutex);
     }
 
     doc.clear();
@@ -414,41 +500,75 @@ void LoraUtils::SerializeSavedMessageList(JsonDocument &doc)
         msgArray = doc.createNestedArray("Messages");
     }
 
+    xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
+
     for (auto msg : _SavedMessageList)
     {
         msgArray.add(msg);
     }
+
+    xSemaphoreGive(_SavedMessageListMutex);
 }   
 
 void LoraUtils::DeserializeSavedMessageList(JsonDocument &doc)
 {
     auto msgArray = doc["Messages"].as<JsonArray>();
+
+    xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
+
     _SavedMessageList.clear();
 
     for (auto msg : msgArray)
     {
         _SavedMessageList.push_back(msg.as<std::string>());
     }
+
+    xSemaphoreGive(_SavedMessageListMutex);
+}
+
+void LoraUtils::SerializeSavedMessageList(MsgPack_Writer &writer)
+{
+    writer.beginMap(1);
+    writer.writeString("Messages");
+    writer.beginArray(_SavedMessageList.size());
+
+    for (const auto &msg : _SavedMessageList)
+    {
+        writer.writeString(msg.c_str());
+    }
+}
+
+void LoraUtils::DeserializeSavedMessage(JsonVariantConst message)
+{
+    xSemaphoreTake(_SavedMessageListMutex, portMAX_DELAY);
+    _SavedMessageList.push_back(message.as<std::string>());
+    xSemaphoreGive(_SavedMessageListMutex);
 }
 
 void LoraUtils::AddUserInfo(UserInfo userInfo)
 {
+    xSemaphoreTake(_UserInfoListMutex, portMAX_DELAY);
     _UserInfoList.push_back(userInfo);
+    xSemaphoreGive(_UserInfoListMutex);
 
     _UserInfoListUpdated.Invoke();
 }
 
 void LoraUtils::DeleteUserInfo(std::vector<UserInfo>::iterator &it)
 {
+    xSemaphoreTake(_UserInfoListMutex, portMAX_DELAY);
     it = _UserInfoList.erase(it);
+    xSemaphoreGive(_UserInfoListMutex);
 
     _UserInfoListUpdated.Invoke();
 }
 
 void LoraUtils::UpdateUserInfo(std::vector<UserInfo>::iterator &it, UserInfo userInfo)
 {
+    xSemaphoreTake(_UserInfoListMutex, portMAX_DELAY);
     it->Name = userInfo.Name;
     it->UserID = userInfo.UserID;
+    xSemaphoreGive(_UserInfoListMutex);
     
     _UserInfoListUpdated.Invoke();
 }
@@ -457,6 +577,8 @@ void LoraUtils::SerializeUserInfoList(JsonDocument &doc)
 {
     auto userArray = doc.createNestedArray("users");
 
+    xSemaphoreTake(_UserInfoListMutex, portMAX_DELAY);
+
     for (auto kv : _UserInfoList)
     {
         auto userObj = userArray.createNestedObject();
@@ -464,11 +586,16 @@ void LoraUtils::SerializeUserInfoList(JsonDocument &doc)
         userObj["userID"] = kv.UserID;
         userObj["name"] = kv.Name;
     }
+
+    xSemaphoreGive(_UserInfoListMutex);
 }
 
 void LoraUtils::DeserializeUserInfoList(JsonDocument &doc)
 {
     auto userArray = doc["users"].as<JsonArray>();
+
+    xSemaphoreTake(_UserInfoListMutex, portMAX_DELAY);
+
     _UserInfoList.clear();
 
     for (auto userObj : userArray)
@@ -479,12 +606,39 @@ void LoraUtils::DeserializeUserInfoList(JsonDocument &doc)
         user.Name = userObj["name"].as<std::string>();
         _UserInfoList.push_back(user);
     }
+
+    xSemaphoreGive(_UserInfoListMutex);
+}
+
+void LoraUtils::SerializeUserInfoList(MsgPack_Writer &writer)
+{
+    writer.beginMap(1);
+    writer.writeString("users");
+    writer.beginArray(_UserInfoList.size());
+
+    for (const auto &user : _UserInfoList)
+    {
+        StaticJsonDocument<JSON_OBJECT_SIZE(2)> element;
+        element["userID"] = user.UserID;
+        element["name"] = user.Name.c_str();
+
+        writer.writeElement(element.as<JsonVariantConst>());
+    }
+}
+
+void LoraUtils::DeserializeUserInfo(JsonVariantConst userObj)
+{
+    UserInfo user;
+
+    user.UserID = userObj["userID"].as<uint32_t>();
+    user.Name = userObj["name"].as<std::string>();
+
+    xSemaphoreTake(_UserInfoListMutex, portMAX_DELAY);
+    _UserInfoList.push_back(user);
+    xSemaphoreGive(_UserInfoListMutex);
 }
 
 void LoraUtils::FlashDefaultMessages()
 {
-    _SavedMessageList.clear();
-    _SavedMessageList.push_back("Meet here");
-    _SavedMessageList.push_back("Point of interest");
-    _SavedMessageListUpdated.Invoke();
+    ClearSavedMessages();
 }
\ No newline at end of file
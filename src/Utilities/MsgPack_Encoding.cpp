@@ -0,0 +1,180 @@
+#include "MsgPack_Encoding.h"
+
+void MsgPack_Encoder::beginMap(uint32_t size)
+{
+    writeHeader(0x80, 15, 0xde, 0xdf, size);
+}
+
+void MsgPack_Encoder::beginArray(uint32_t size)
+{
+    writeHeader(0x90, 15, 0xdc, 0xdd, size);
+}
+
+void MsgPack_Encoder::writeString(const char *value)
+{
+    if (value == nullptr)
+    {
+        value = "";
+    }
+
+    uint32_t length = strlen(value);
+
+    if (length < 32)
+    {
+        writeByte(0xa0 | length);
+    }
+    else if (length <= UINT8_MAX)
+    {
+        writeByte(0xd9);
+        writeBigEndian(length, 1);
+    }
+    else
+    {
+        writeHeader(0, 0, 0xda, 0xdb, length);
+    }
+
+    bytesWritten += output.write((const uint8_t *)value, length);
+}
+
+void MsgPack_Encoder::writeRaw(const uint8_t *data, size_t length)
+{
+    bytesWritten += output.write(data, length);
+}
+
+void MsgPack_Encoder::writeHeader(uint8_t fixType, uint8_t fixMax, uint8_t type16, uint8_t type32, uint32_t size)
+{
+    if (fixType != 0 && size <= fixMax)
+    {
+        writeByte(fixType | size);
+    }
+    else if (size <= UINT16_MAX)
+    {
+        writeByte(type16);
+        writeBigEndian(size, 2);
+    }
+    else
+    {
+        writeByte(type32);
+        writeBigEndian(size, 4);
+    }
+}
+
+void MsgPack_Encoder::writeByte(uint8_t value)
+{
+    bytesWritten += output.write(value);
+}
+
+void MsgPack_Encoder::writeBigEndian(uint32_t value, uint8_t bytes)
+{
+    for (int8_t shift = (bytes - 1) * 8; shift >= 0; shift -= 8)
+    {
+        writeByte((value >> shift) & 0xff);
+    }
+}
+
+bool MsgPack_Decoder::readMapHeader(uint32_t &size)
+{
+    return readHeader(0x80, 0xf0, 0xde, 0xdf, size);
+}
+
+bool MsgPack_Decoder::readArrayHeader(uint32_t &size)
+{
+    return readHeader(0x90, 0xf0, 0xdc, 0xdd, size);
+}
+
+bool MsgPack_Decoder::readString(char *buffer, size_t bufferSize)
+{
+    if (!valid)
+    {
+        return false;
+    }
+
+    int type = input.read();
+    uint32_t length = 0;
+
+    if (type >= 0xa0 && type <= 0xbf)
+    {
+        length = type & 0x1f;
+    }
+    else if (type == 0xd9)
+    {
+        valid = readBigEndian(length, 1);
+    }
+    else if (type == 0xda)
+    {
+        valid = readBigEndian(length, 2);
+    }
+    else if (type == 0xdb)
+    {
+        valid = readBigEndian(length, 4);
+    }
+    else
+    {
+        valid = false;
+    }
+
+    if (!valid || bufferSize == 0)
+    {
+        return false;
+    }
+
+    size_t copied = min((size_t)length, bufferSize - 1);
+    valid = input.readBytes(buffer, copied) == copied;
+    buffer[copied] = '\0';
+
+    // Drop the part that did not fit
+    for (uint32_t i = copied; valid && i < length; i++)
+    {
+        valid = input.read() >= 0;
+    }
+
+    return valid;
+}
+
+bool MsgPack_Decoder::readHeader(uint8_t fixType, uint8_t fixMask, uint8_t type16, uint8_t type32, uint32_t &size)
+{
+    if (!valid)
+    {
+        return false;
+    }
+
+    int type = input.read();
+
+    if (type >= 0 && (type & fixMask) == fixType)
+    {
+        size = type & ~fixMask;
+    }
+    else if (type == type16)
+    {
+        valid = readBigEndian(size, 2);
+    }
+    else if (type == type32)
+    {
+        valid = readBigEndian(size, 4);
+    }
+    else
+    {
+        valid = false;
+    }
+
+    return valid;
+}
+
+bool MsgPack_Decoder::readBigEndian(uint32_t &value, uint8_t bytes)
+{
+    value = 0;
+
+    for (uint8_t i = 0; i < bytes; i++)
+    {
+        int next = input.read();
+
+        if (next < 0)
+        {
+            return false;
+        }
+
+        value = (value << 8) | (uint8_t)next;
+    }
+
+    return true;
+}
@@ -0,0 +1,33 @@
+#include "MsgPack_Stream.h"
+
+void MsgPack_Writer::writeElement(JsonVariantConst element)
+{
+    bytesWritten += serializeMsgPack(element, output);
+}
+
+bool MsgPack_Reader::readElement(JsonDocument &doc)
+{
+    if (!valid)
+    {
+        return false;
+    }
+
+    // An element that does not fit may be partially consumed, so the rest of the stream cannot be trusted
+    valid = deserializeMsgPack(doc, input) == DeserializationError::Ok;
+    return valid;
+}
+
+bool MsgPack_Reader::skipValue()
+{
+    if (!valid)
+    {
+        return false;
+    }
+
+    StaticJsonDocument<16> filter;
+    filter.set(false);
+
+    StaticJsonDocument<16> discarded;
+    valid = deserializeMsgPack(discarded, input, DeserializationOption::Filter(filter)) == DeserializationError::Ok;
+    return valid;
+}
@@ -2,54 +2,139 @@
 
 CompassInterface *NavigationUtils::_Compass = nullptr;
 TinyGPSPlus NavigationUtils::_GPS;
-Stream &NavigationUtils::_GpsInputStream = Serial2;
+Stream *NavigationUtils::_GpsInputStream = &Serial2;
 
-TinyGPSLocation NavigationUtils::_LastCoordinate;
+TaskHandle_t NavigationUtils::_GpsTask = nullptr;
+
+Seqlock<GPS_Fix> NavigationUtils::_Fix;
+
+Geo_Projection NavigationUtils::_Projection;
+portMUX_TYPE NavigationUtils::_ProjectionLock = portMUX_INITIALIZER_UNLOCKED;
 
 EventHandler NavigationUtils::_SavedLocationsUpdated;
 std::vector<SavedLocation> NavigationUtils::_SavedLocations;
 
+Spatial_Index NavigationUtils::_NearbyIndex;
+std::map<uint32_t, std::string> NavigationUtils::_PingNames;
+SemaphoreHandle_t NavigationUtils::_NearbyMutex = nullptr;
+StaticSemaphore_t NavigationUtils::_NearbyMutexBuffer;
+
 void NavigationUtils::Init(CompassInterface *compass)
 {
+    nearbyMutex();
     _Compass = compass;
+    Heading_Utils::init(compass);
 }
 
 void NavigationUtils::Init(CompassInterface *compass, Stream &gpsInputStream)
 {
+    nearbyMutex();
     _Compass = compass;
-    _GpsInputStream = gpsInputStream;
+    Heading_Utils::init(compass);
+    _GpsInputStream = &gpsInputStream;
+
+    if (_GpsTask == nullptr)
+    {
+        int taskID = System_Utils::registerTask(gpsTask, "GPS", GPS_TASK_STACK_SIZE, nullptr, GPS_TASK_PRIORITY);
+        _GpsTask = System_Utils::getTask(taskID);
+
+        if (_GpsTask == nullptr)
+        {
+            LOG_ERROR("NavigationUtils: unable to start GPS task, GPS input will be parsed by readers");
+        }
+    }
 }
 
-void NavigationUtils::UpdateGPS()
+void NavigationUtils::Init(CompassInterface *compass, HardwareSerial &gpsSerial)
 {
-    while (_GpsInputStream.available() > 0) {
-        _GPS.encode(_GpsInputStream.read());
+    Init(compass, (Stream &)gpsSerial);
+
+    gpsSerial.onReceive([]() {
+        if (_GpsTask != nullptr)
+        {
+            xTaskNotifyGive(_GpsTask);
+        }
+    });
+}
+
+void NavigationUtils::gpsTask(void *pvParameters)
+{
+    HEAP_TASK_TAG(HEAP_TAG_NAVIGATION);
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(GPS_POLL_INTERVAL_MS));
+        parseAvailable();
     }
+}
+
+bool NavigationUtils::parseAvailable()
+{
+    bool sentenceParsed = false;
 
-    if (_GPS.location.isValid())
+    while (_GpsInputStream->available() > 0)
     {
-        _LastCoordinate = _GPS.location;
+        sentenceParsed |= _GPS.encode(_GpsInputStream->read());
     }
+
+    if (sentenceParsed)
+    {
+        publishFix();
+    }
+
+    return sentenceParsed;
 }
 
-bool NavigationUtils::IsGPSConnected()
+void NavigationUtils::publishFix()
+{
+    GPS_Fix fix = GPS_Fix::FromParser(_GPS);
+    _Fix.write(fix);
+
+    if (fix.locationValid)
+    {
+        Geo_Point_E7 position = Geo_Math::toE7(fix.latitude, fix.longitude);
+
+        // Only this task writes the projection, so it can be read here without the lock
+        if (!_Projection.valid() || _Projection.distanceFromOrigin(position) > GEO_PROJECTION_REFRESH_M)
+        {
+            Geo_Projection projection(position);
+
+            portENTER_CRITICAL(&_ProjectionLock);
+            _Projection = projection;
+            portEXIT_CRITICAL(&_ProjectionLock);
+        }
+    }
+}
+
+void NavigationUtils::UpdateGPS()
 {
-    return _LastCoordinate.isValid();
+    if (_GpsTask == nullptr)
+    {
+        parseAvailable();
+    }
 }
 
-TinyGPSLocation NavigationUtils::GetLocation()
+GPS_Fix NavigationUtils::GetFix()
 {
-    return _LastCoordinate;
+    UpdateGPS();
+    return _Fix.read();
 }
 
-TinyGPSTime NavigationUtils::GetTime()
+bool NavigationUtils::IsGPSConnected()
 {
-    return _GPS.time;
+    return GetFix().locationValid;
 }
 
-TinyGPSDate NavigationUtils::GetDate()
+GPS_Time NavigationUtils::GetTime()
 {
-    return _GPS.date;
+    GPS_Fix fix = GetFix();
+    return {fix.time, fix.timeValid};
+}
+
+GPS_Date NavigationUtils::GetDate()
+{
+    GPS_Fix fix = GetFix();
+    return {fix.date, fix.dateValid};
 }
 
 uint64_t NavigationUtils::GetTimeDifference(uint32_t time1, uint32_t date1, uint32_t time2, uint32_t date2)
@@ -218,12 +303,9 @@ uint64_t NavigationUtils::GetTimeDifference(uint32_t time1, uint32_t date1, uint
 
 uint64_t NavigationUtils::GetTimeDifference(uint32_t time1, uint32_t date1)
 {
-    NavigationUtils::UpdateGPS();
+    GPS_Fix fix = GetFix();
 
-    uint32_t time2 = GetTime().value();
-    uint32_t date2 = GetDate().value();
-
-    return GetTimeDifference(time1, date1, time2, date2);
+    return GetTimeDifference(time1, date1, fix.time, fix.date);
 }
 
 int NavigationUtils::GetAzimuth()
@@ -238,39 +320,56 @@ int NavigationUtils::GetAzimuth()
 
 double NavigationUtils::GetDistanceTo(double lat, double lon)
 {
-    UpdateGPS();
+    Geo_Vector vector;
 
-    // if (!_LastCoordinate.isValid())
-    // {
-    //     return -1;
-    // }
-
-    #if DEBUG == 1
-    Serial.println("GetDistanceTo()");
-    Serial.print("My Lat: ");
-    Serial.println(_LastCoordinate.lat());
-    Serial.print("My Lon: ");
-    Serial.println(_LastCoordinate.lng());
-    Serial.print("Target Lat: ");
-    Serial.println(lat);
-    Serial.print("Target Lon: ");
-    Serial.println(lon);
-    #endif
+    if (!GetVectorTo(lat, lon, vector))
+    {
+        return -1;
+    }
 
-    return _GPS.distanceBetween(_LastCoordinate.lat(), _LastCoordinate.lng(), lat, lon);
+    return vector.distanceM;
 }
 
 double NavigationUtils::GetHeadingTo(double lat, double lon)
 {
-    UpdateGPS();
+    Geo_Vector vector;
 
-    if (!_LastCoordinate.isValid())
+    if (!GetVectorTo(lat, lon, vector))
     {
         return -1;
     }
 
-    return _GPS.courseTo(_LastCoordinate.lat(), _LastCoordinate.lng(), lat, lon);
+    return vector.bearingDeg;
+}
+
+bool NavigationUtils::GetVectorTo(double lat, double lon, Geo_Vector &vector)
+{
+    Geo_Point_E7 target = Geo_Math::toE7(lat, lon);
+    return GetVectorsTo(&target, 1, &vector);
+}
+
+bool NavigationUtils::GetVectorsTo(const Geo_Point_E7 *targets, size_t numTargets, Geo_Vector *vectors)
+{
+    GPS_Fix fix = GetFix();
+
+    if (!fix.isValid())
+    {
+        return false;
+    }
+
+    GetProjection().vectorsTo(Geo_Math::toE7(fix.lat(), fix.lng()), targets, numTargets, vectors);
+    return true;
+}
+
+Geo_Projection NavigationUtils::GetProjection()
+{
+    portENTER_CRITICAL(&_ProjectionLock);
+    Geo_Projection projection = _Projection;
+    portEXIT_CRITICAL(&_ProjectionLock);
+
+    return projection;
 }
+
 // Implement later. Was only used for debug screen
 int NavigationUtils::GetX()
 {
@@ -289,7 +388,10 @@ int NavigationUtils::GetZ()
 
 void NavigationUtils::AddSavedLocation(SavedLocation location, bool updateSavedLocations)
 {
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
     _SavedLocations.push_back(location);
+    indexSavedLocation(_SavedLocations.size() - 1);
+    xSemaphoreGive(nearbyMutex());
 
     if (updateSavedLocations)
         _SavedLocationsUpdated.Invoke();
@@ -297,22 +399,35 @@ void NavigationUtils::AddSavedLocation(SavedLocation location, bool updateSavedL
 
 void NavigationUtils::RemoveSavedLocation(std::vector<SavedLocation>::iterator &locationIt)
 {
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
+    size_t idx = std::distance(_SavedLocations.begin(), locationIt);
     locationIt = _SavedLocations.erase(locationIt);
+    _NearbyIndex.removeAndShift(SPATIAL_SAVED_LOCATION, idx);
+    xSemaphoreGive(nearbyMutex());
 
     _SavedLocationsUpdated.Invoke();
 }
 
 void NavigationUtils::ClearSavedLocations()
 {
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
     _SavedLocations.clear();
+    reindexSavedLocations();
+    xSemaphoreGive(nearbyMutex());
+
     _SavedLocationsUpdated.Invoke();
 }
 
 void NavigationUtils::UpdateSavedLocation(std::vector<SavedLocation>::iterator &locationIt, SavedLocation location)
 {
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
     locationIt->Name = location.Name;
     locationIt->Latitude = location.Latitude;
     locationIt->Longitude = location.Longitude;
+
+    size_t idx = std::distance(_SavedLocations.begin(), locationIt);
+    _NearbyIndex.update(SPATIAL_SAVED_LOCATION, idx, Geo_Math::toE7(location.Latitude, location.Longitude));
+    xSemaphoreGive(nearbyMutex());
 }
 
 void NavigationUtils::SerializeSavedLocations(JsonDocument &doc)
@@ -328,7 +443,9 @@ void NavigationUtils::SerializeSavedLocations(JsonDocument &doc)
         locationArray = doc.createNestedArray("Locations");
     }
 
-    for (auto location : _SavedLocations)
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
+
+    for (const auto &location : _SavedLocations)
     {
         JsonObject locationObject = locationArray.createNestedObject();
         locationObject["Name"] = location.Name;
@@ -336,6 +453,8 @@ void NavigationUtils::SerializeSavedLocations(JsonDocument &doc)
         locationObject["Lng"] = location.Longitude;
     }
 
+    xSemaphoreGive(nearbyMutex());
+
     #if DEBUG == 1
     // Serial.println("Saving location list: ");
     // serializeJson(doc, Serial);
@@ -346,6 +465,8 @@ void NavigationUtils::SerializeSavedLocations(JsonDocument &doc)
 void NavigationUtils::DeserializeSavedLocations(JsonDocument &doc)
 {
     auto locationArray = doc["Locations"].as<JsonArray>();
+
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
     _SavedLocations.clear();
 
     for (auto location : locationArray)
@@ -356,6 +477,41 @@ void NavigationUtils::DeserializeSavedLocations(JsonDocument &doc)
         savedLocation.Longitude = location["Lng"].as<double>();
         _SavedLocations.push_back(savedLocation);
     }
+
+    reindexSavedLocations();
+    xSemaphoreGive(nearbyMutex());
+}
+
+// Runs on the persistence task with the saved locations mutex held, see NavigationManager
+void NavigationUtils::SerializeSavedLocations(MsgPack_Writer &writer)
+{
+    writer.beginMap(1);
+    writer.writeString("Locations");
+    writer.beginArray(_SavedLocations.size());
+
+    for (const auto &location : _SavedLocations)
+    {
+        // Name is stored by pointer, so only the object itself needs room
+        StaticJsonDocument<JSON_OBJECT_SIZE(3)> element;
+        element["Name"] = location.Name.c_str();
+        element["Lat"] = location.Latitude;
+        element["Lng"] = location.Longitude;
+
+        writer.writeElement(element.as<JsonVariantConst>());
+    }
+}
+
+void NavigationUtils::DeserializeSavedLocation(JsonVariantConst location)
+{
+    SavedLocation savedLocation;
+    savedLocation.Name = location["Name"].as<std::string>();
+    savedLocation.Latitude = location["Lat"].as<double>();
+    savedLocation.Longitude = location["Lng"].as<double>();
+
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
+    _SavedLocations.push_back(savedLocation);
+    indexSavedLocation(_SavedLocations.size() - 1);
+    xSemaphoreGive(nearbyMutex());
 }
 
 void NavigationUtils::RpcAddSavedLocation(JsonDocument &doc)
@@ -399,12 +555,20 @@ void NavigationUtils::RpcRemoveSavedLocation(JsonDocument &doc)
     if (doc.containsKey("Idx"))
     {
         auto idx = doc["Idx"].as<int>();
+
+        xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
         if (idx >= 0 && idx < _SavedLocations.size())
         {
             success = true;
-            auto locationIt = _SavedLocations.begin() + idx;
-            RemoveSavedLocation(locationIt);
+            _SavedLocations.erase(_SavedLocations.begin() + idx);
+            _NearbyIndex.removeAndShift(SPATIAL_SAVED_LOCATION, idx);
         }
+        xSemaphoreGive(nearbyMutex());
+    }
+
+    if (success)
+    {
+        _SavedLocationsUpdated.Invoke();
     }
 
     doc.clear();
@@ -424,12 +588,16 @@ void NavigationUtils::RpcUpdateSavedLocation(JsonDocument &doc)
     if (doc.containsKey("Idx") && doc.containsKey("Name") && doc.containsKey("Lat") && doc.containsKey("Lng"))
     {
         auto idx = doc["Idx"].as<int>();
+        SavedLocation location = {doc["Name"].as<std::string>(), doc["Lat"].as<double>(), doc["Lng"].as<double>()};
+
+        xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
         if (idx >= 0 && idx < _SavedLocations.size())
         {
             success = true;
-            auto locationIt = _SavedLocations.begin() + idx;
-            UpdateSavedLocation(locationIt, {doc["Name"].as<std::string>(), doc["Lat"].as<double>(), doc["Lng"].as<double>()});
+            _SavedLocations[idx] = location;
+            _NearbyIndex.update(SPATIAL_SAVED_LOCATION, idx, Geo_Math::toE7(location.Latitude, location.Longitude));
         }
+        xSemaphoreGive(nearbyMutex());
     }
 
     doc.clear();
@@ -443,6 +611,8 @@ void NavigationUtils::RpcGetSavedLocation(JsonDocument &doc)
     {
         auto idx = doc["Idx"].as<int>();
         doc.clear();
+
+        xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
         if (idx >= 0 && idx < _SavedLocations.size())
         {
             auto locationIt = _SavedLocations.begin() + idx;
@@ -450,6 +620,7 @@ void NavigationUtils::RpcGetSavedLocation(JsonDocument &doc)
             doc["Lat"] = locationIt->Latitude;
             doc["Lng"] = locationIt->Longitude;
         }
+        xSemaphoreGive(nearbyMutex());
     }
 }
 
@@ -457,13 +628,16 @@ void NavigationUtils::RpcGetSavedLocations(JsonDocument &doc)
 {
     doc.clear();
     JsonArray locationArray = doc.createNestedArray("Locations");
-    for (auto location : _SavedLocations)
+
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
+    for (const auto &location : _SavedLocations)
     {
         JsonObject locationObject = locationArray.createNestedObject();
         locationObject["Name"] = location.Name;
         locationObject["Lat"] = location.Latitude;
         locationObject["Lng"] = location.Longitude;
     }
+    xSemaphoreGive(nearbyMutex());
 
     #if DEBUG == 1
     serializeJsonPretty(doc, Serial);
@@ -473,8 +647,30 @@ void NavigationUtils::RpcGetSavedLocations(JsonDocument &doc)
 
 void NavigationUtils::FlashSampleLocations()
 {
+    uint16_t numSamples = 0;
+    const Asset_Location *samples = Asset_Utils::locations(ASSET_SAMPLE_LOCATIONS, numSamples);
+
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
     _SavedLocations.clear();
 
+    if (samples != nullptr)
+    {
+        for (uint16_t i = 0; i < numSamples; i++)
+        {
+            SavedLocation location;
+            location.Name.assign(samples[i].name, strnlen(samples[i].name, ASSET_LOCATION_NAME_LENGTH));
+            location.Latitude = samples[i].latitude;
+            location.Longitude = samples[i].longitude;
+            _SavedLocations.push_back(location);
+        }
+
+        reindexSavedLocations();
+        xSemaphoreGive(nearbyMutex());
+
+        _SavedLocationsUpdated.Invoke();
+        return;
+    }
+
     SavedLocation nyc;
     nyc.Name = "NYC";
     nyc.Latitude = 40.7128;
@@ -493,5 +689,127 @@ void NavigationUtils::FlashSampleLocations()
     atl.Longitude = -84.3880;
     _SavedLocations.push_back(atl);
 
+    reindexSavedLocations();
+    xSemaphoreGive(nearbyMutex());
+
     _SavedLocationsUpdated.Invoke();
 }
+
+SemaphoreHandle_t NavigationUtils::nearbyMutex()
+{
+    // Created by Init, before the persistence task or RPCs can reach the saved locations
+    if (_NearbyMutex == nullptr)
+    {
+        _NearbyMutex = xSemaphoreCreateMutexStatic(&_NearbyMutexBuffer);
+    }
+
+    return _NearbyMutex;
+}
+
+void NavigationUtils::indexSavedLocation(size_t idx)
+{
+    const SavedLocation &location = _SavedLocations[idx];
+    _NearbyIndex.insert(SPATIAL_SAVED_LOCATION, idx, Geo_Math::toE7(location.Latitude, location.Longitude));
+}
+
+void NavigationUtils::reindexSavedLocations()
+{
+    _NearbyIndex.removeKind(SPATIAL_SAVED_LOCATION);
+
+    for (size_t i = 0; i < _SavedLocations.size(); i++)
+    {
+        _NearbyIndex.insert(SPATIAL_SAVED_LOCATION, i, Geo_Math::toE7(_SavedLocations[i].Latitude, _SavedLocations[i].Longitude));
+    }
+}
+
+void NavigationUtils::IndexPing(uint32_t userID, const char *name, double lat, double lon)
+{
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
+
+    if (lat == 0 && lon == 0)
+    {
+        _NearbyIndex.remove(SPATIAL_PING, userID);
+        _PingNames.erase(userID);
+    }
+    else
+    {
+        _NearbyIndex.update(SPATIAL_PING, userID, Geo_Math::toE7(lat, lon));
+        _PingNames[userID] = name;
+    }
+
+    xSemaphoreGive(nearbyMutex());
+}
+
+std::vector<Nearby_Item> NavigationUtils::GetNearby(size_t count, float radiusM)
+{
+    std::vector<Nearby_Item> items;
+    GPS_Fix fix = GetFix();
+
+    if (!fix.isValid())
+    {
+        return items;
+    }
+
+    std::vector<Spatial_Match> matches;
+
+    xSemaphoreTake(nearbyMutex(), portMAX_DELAY);
+    _NearbyIndex.nearest(Geo_Math::toE7(fix.lat(), fix.lng()), count, matches, radiusM);
+
+    for (const auto &match : matches)
+    {
+        Nearby_Item item;
+        item.kind = match.kind;
+        item.id = match.id;
+        item.latitude = Geo_Math::toDegrees(match.point.latE7);
+        item.longitude = Geo_Math::toDegrees(match.point.lngE7);
+        item.vector = match.vector;
+
+        if (match.kind == SPATIAL_SAVED_LOCATION && match.id < _SavedLocations.size())
+        {
+            item.name = _SavedLocations[match.id].Name;
+        }
+        else if (match.kind == SPATIAL_PING)
+        {
+            item.name = _PingNames[match.id];
+        }
+
+        items.push_back(item);
+    }
+
+    xSemaphoreGive(nearbyMutex());
+
+    return items;
+}
+
+void NavigationUtils::RpcGetNearby(JsonDocument &doc)
+{
+    int count = doc["Count"] | NEARBY_DEFAULT_COUNT;
+    float radius = doc["Radius"] | SPATIAL_MAX_RADIUS_M;
+
+    if (count <= 0 || count > NEARBY_MAX_COUNT)
+    {
+        count = count <= 0 ? NEARBY_DEFAULT_COUNT : NEARBY_MAX_COUNT;
+    }
+
+    doc.clear();
+
+    if (!GetFix().isValid())
+    {
+        doc["error"] = "No GPS fix";
+        return;
+    }
+
+    JsonArray nearbyArray = doc.createNestedArray("Nearby");
+
+    for (const auto &item : GetNearby(count, radius))
+    {
+        JsonObject itemObject = nearbyArray.createNestedObject();
+        itemObject["Type"] = item.kind == SPATIAL_PING ? "Ping" : "Location";
+        itemObject[item.kind == SPATIAL_PING ? "User" : "Idx"] = item.id;
+        itemObject["Name"] = item.name;
+        itemObject["Lat"] = item.latitude;
+        itemObject["Lng"] = item.longitude;
+        itemObject["Dist"] = item.vector.distanceM;
+        itemObject["Heading"] = item.vector.bearingDeg;
+    }
+}
@@ -0,0 +1,194 @@
+#include "Persistence_Utils.h"
+#include "System_Utils.h"
+
+Persisted_Collection Persistence_Utils::_Collections[PERSISTENCE_MAX_COLLECTIONS];
+uint8_t Persistence_Utils::_NumCollections = 0;
+
+std::atomic<uint32_t> Persistence_Utils::_DirtyMask(0);
+volatile TickType_t Persistence_Utils::_FirstMarkTick = 0;
+volatile TickType_t Persistence_Utils::_LastMarkTick = 0;
+
+int Persistence_Utils::_TaskID = -1;
+TaskHandle_t Persistence_Utils::_Task = nullptr;
+
+portMUX_TYPE Persistence_Utils::_RegisterLock = portMUX_INITIALIZER_UNLOCKED;
+
+SemaphoreHandle_t Persistence_Utils::_WriteMutex = nullptr;
+StaticSemaphore_t Persistence_Utils::_WriteMutexBuffer;
+
+void Persistence_Utils::init()
+{
+    if (_Task != nullptr)
+    {
+        return;
+    }
+
+    if (_WriteMutex == nullptr)
+    {
+        _WriteMutex = xSemaphoreCreateMutexStatic(&_WriteMutexBuffer);
+    }
+
+    _TaskID = System_Utils::registerTask(persistenceTask, "Persistence", 4096, nullptr, 1);
+    _Task = System_Utils::getTask(_TaskID);
+
+    System_Utils::getSystemShutdown() += flush;
+}
+
+int Persistence_Utils::registerCollection(const char *filename, Persistence_Serializer serialize, SemaphoreHandle_t lock)
+{
+    int collectionID = -1;
+
+    // Managers on both cores register during boot. The entry is filled before the count makes it visible.
+    portENTER_CRITICAL(&_RegisterLock);
+
+    if (_NumCollections < PERSISTENCE_MAX_COLLECTIONS && serialize != nullptr && lock != nullptr)
+    {
+        Persisted_Collection &collection = _Collections[_NumCollections];
+        collection = {};
+        collection.filename = filename;
+        collection.serialize = serialize;
+        collection.lock = lock;
+
+        collectionID = _NumCollections++;
+    }
+
+    portEXIT_CRITICAL(&_RegisterLock);
+
+    if (collectionID == -1)
+    {
+        LOG_ERROR("Persistence_Utils: cannot register %s", filename);
+    }
+
+    return collectionID;
+}
+
+void Persistence_Utils::markDirty(int collectionID)
+{
+    if (collectionID < 0 || collectionID >= _NumCollections)
+    {
+        return;
+    }
+
+    uint32_t bit = 1UL << collectionID;
+    TickType_t now = xTaskGetTickCount();
+
+    _LastMarkTick = now;
+    uint32_t previous = _DirtyMask.fetch_or(bit);
+
+    if (previous == 0)
+    {
+        _FirstMarkTick = now;
+    }
+    else if (previous & bit)
+    {
+        _Collections[collectionID].coalesced++;
+    }
+
+    if (_Task != nullptr)
+    {
+        xTaskNotifyGive(_Task);
+    }
+    else
+    {
+        flush();
+    }
+}
+
+bool Persistence_Utils::isDirty(int collectionID)
+{
+    return collectionID >= 0 && (_DirtyMask.load() & (1UL << collectionID)) != 0;
+}
+
+void Persistence_Utils::flush()
+{
+    if (_WriteMutex == nullptr)
+    {
+        _WriteMutex = xSemaphoreCreateMutexStatic(&_WriteMutexBuffer);
+    }
+
+    xSemaphoreTake(_WriteMutex, portMAX_DELAY);
+
+    uint32_t dirty = _DirtyMask.exchange(0);
+
+    for (uint8_t i = 0; i < _NumCollections; i++)
+    {
+        if ((dirty & (1UL << i)) && !writeCollection(i))
+        {
+            // Retried on the next change or flush
+            _DirtyMask.fetch_or(1UL << i);
+        }
+    }
+
+    xSemaphoreGive(_WriteMutex);
+}
+
+bool Persistence_Utils::writeCollection(int collectionID)
+{
+    Persisted_Collection &collection = _Collections[collectionID];
+
+    size_t bytesWritten = 0;
+
+    xSemaphoreTake(collection.lock, portMAX_DELAY);
+    auto returnCode = FilesystemModule::Utilities::WriteFileStreamed(collection.filename, collection.serialize, &bytesWritten);
+    xSemaphoreGive(collection.lock);
+
+    if (returnCode != FilesystemModule::FilesystemReturnCode::FILESYSTEM_OK)
+    {
+        LOG_WARN("Persistence_Utils: failed to write %s. Error code: %d", collection.filename, (int)returnCode);
+        collection.failures++;
+        return false;
+    }
+
+    collection.writes++;
+    collection.bytesWritten += bytesWritten;
+    return true;
+}
+
+void Persistence_Utils::persistenceTask(void *pvParameters)
+{
+    HEAP_TASK_TAG(HEAP_TAG_FILESYSTEM);
+
+    const TickType_t debounceTicks = pdMS_TO_TICKS(PERSISTENCE_DEBOUNCE_MS);
+    const TickType_t maxDelayTicks = pdMS_TO_TICKS(PERSISTENCE_MAX_DELAY_MS);
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Wait for the burst of changes to settle. New marks wake the task early and restart the wait.
+        while (_DirtyMask.load() != 0)
+        {
+            TickType_t now = xTaskGetTickCount();
+            TickType_t quietTicks = now - _LastMarkTick;
+
+            if (quietTicks >= debounceTicks || now - _FirstMarkTick >= maxDelayTicks)
+            {
+                flush();
+                break;
+            }
+
+            ulTaskNotifyTake(pdTRUE, debounceTicks - quietTicks);
+        }
+    }
+}
+
+void Persistence_Utils::GetPersistenceStatsRpc(JsonDocument &doc)
+{
+    doc.clear();
+
+    uint32_t dirty = _DirtyMask.load();
+    JsonArray collections = doc.createNestedArray("Collections");
+
+    for (uint8_t i = 0; i < _NumCollections; i++)
+    {
+        const Persisted_Collection &collection = _Collections[i];
+        JsonObject entry = collections.createNestedObject();
+
+        entry["File"] = collection.filename;
+        entry["Dirty"] = (dirty & (1UL << i)) != 0;
+        entry["Writes"] = collection.writes;
+        entry["Bytes"] = collection.bytesWritten;
+        entry["Coalesced"] = collection.coalesced;
+        entry["Failures"] = collection.failures;
+    }
+}
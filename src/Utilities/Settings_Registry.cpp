@@ -0,0 +1,289 @@
+#include "Settings_Registry.h"
+#include "FilesystemUtils.h"
+
+Settings_Store Settings_Registry::_Store;
+EventHandler Settings_Registry::_Changed[NUM_SETTINGS];
+
+size_t Settings_Registry::_LastPersistBytes = 0;
+
+SemaphoreHandle_t Settings_Registry::_Mutex = nullptr;
+StaticSemaphore_t Settings_Registry::_MutexBuffer;
+
+SemaphoreHandle_t Settings_Registry::mutex()
+{
+    // Created on first use, which is during single threaded startup
+    if (_Mutex == nullptr)
+    {
+        _Mutex = xSemaphoreCreateMutexStatic(&_MutexBuffer);
+    }
+
+    return _Mutex;
+}
+
+bool Settings_Registry::has(Setting_Key key)
+{
+    return _Store.has(key);
+}
+
+bool Settings_Registry::getBool(Setting_Key key, bool defaultValue)
+{
+    return has(key) ? _Store.value(key).boolean : defaultValue;
+}
+
+int32_t Settings_Registry::getInt(Setting_Key key, int32_t defaultValue)
+{
+    return has(key) ? _Store.value(key).integer : defaultValue;
+}
+
+float Settings_Registry::getFloat(Setting_Key key, float defaultValue)
+{
+    return has(key) ? _Store.value(key).number : defaultValue;
+}
+
+std::string Settings_Registry::getString(Setting_Key key, const char *defaultValue)
+{
+    if (!has(key))
+    {
+        return defaultValue;
+    }
+
+    // Copied under the lock so a concurrent set cannot tear the string
+    xSemaphoreTake(mutex(), portMAX_DELAY);
+    std::string value = _Store.value(key).text;
+    xSemaphoreGive(mutex());
+
+    return value;
+}
+
+void Settings_Registry::setBool(Setting_Key key, bool value)
+{
+    Setting_Value newValue = {true};
+    newValue.boolean = value;
+    store(key, newValue);
+}
+
+void Settings_Registry::setInt(Setting_Key key, int32_t value)
+{
+    Setting_Value newValue = {true};
+    newValue.integer = value;
+    store(key, newValue);
+}
+
+void Settings_Registry::setFloat(Setting_Key key, float value)
+{
+    Setting_Value newValue = {true};
+    newValue.number = value;
+    store(key, newValue);
+}
+
+void Settings_Registry::setString(Setting_Key key, const char *value)
+{
+    store(key, Settings_Store::Parse(key, value));
+}
+
+void Settings_Registry::setFromString(Setting_Key key, const char *value)
+{
+    if (value != nullptr)
+    {
+        store(key, Settings_Store::Parse(key, value));
+    }
+}
+
+EventHandler &Settings_Registry::Changed(Setting_Key key)
+{
+    return _Changed[key < NUM_SETTINGS ? key : 0];
+}
+
+bool Settings_Registry::readValue(Setting_Key key, JsonVariantConst variant, Setting_Value &value)
+{
+    // Most settings are configurable objects holding their value in cfgVal. Some are stored bare.
+    JsonVariantConst source = variant.is<JsonObjectConst>() ? variant["cfgVal"] : variant;
+
+    if (source.isNull())
+    {
+        return false;
+    }
+
+    // Values updated over RPC may have been stored as text
+    if (source.is<const char *>())
+    {
+        value = Settings_Store::Parse(key, source.as<const char *>());
+        return true;
+    }
+
+    value.present = true;
+
+    switch (Descriptor(key).type)
+    {
+    case SETTING_TYPE_BOOL:
+        value.boolean = source.as<bool>();
+        break;
+    case SETTING_TYPE_INT:
+        value.integer = source.as<int32_t>();
+        break;
+    case SETTING_TYPE_FLOAT:
+        value.number = source.as<float>();
+        break;
+    case SETTING_TYPE_STRING:
+    default:
+        value.text[0] = '\0';
+        break;
+    }
+
+    return true;
+}
+
+void Settings_Registry::writeValue(Setting_Key key, JsonVariant variant)
+{
+    JsonVariant target = variant.is<JsonObject>() ? variant["cfgVal"] : variant;
+    const Setting_Value &value = _Store.value(key);
+
+    switch (Descriptor(key).type)
+    {
+    case SETTING_TYPE_BOOL:
+        target.set(value.boolean);
+        break;
+    case SETTING_TYPE_INT:
+        target.set(value.integer);
+        break;
+    case SETTING_TYPE_FLOAT:
+        target.set(value.number);
+        break;
+    case SETTING_TYPE_STRING:
+    default:
+        // A non-const pointer makes ArduinoJson copy the text instead of pointing into _Store
+        target.set((char *)value.text);
+        break;
+    }
+}
+
+void Settings_Registry::store(Setting_Key key, const Setting_Value &value)
+{
+    if (key >= NUM_SETTINGS)
+    {
+        return;
+    }
+
+    xSemaphoreTake(mutex(), portMAX_DELAY);
+
+    bool changed = _Store.set(key, value);
+
+    if (changed)
+    {
+        writeValue(key, FilesystemModule::Utilities::SettingsFile()[Descriptor(key).name]);
+    }
+
+    xSemaphoreGive(mutex());
+
+    if (changed)
+    {
+        _Changed[key].Invoke();
+    }
+}
+
+void Settings_Registry::syncFromDocument(JsonDocument &settings)
+{
+    uint32_t changedKeys = 0;
+
+    xSemaphoreTake(mutex(), portMAX_DELAY);
+
+    for (uint8_t key = 0; key < NUM_SETTINGS; key++)
+    {
+        Setting_Value value = {false};
+
+        if (readValue((Setting_Key)key, settings[Descriptor((Setting_Key)key).name], value) && _Store.load((Setting_Key)key, value))
+        {
+            changedKeys |= 1UL << key;
+        }
+    }
+
+    xSemaphoreGive(mutex());
+
+    for (uint8_t key = 0; key < NUM_SETTINGS; key++)
+    {
+        if (changedKeys & (1UL << key))
+        {
+            _Changed[key].Invoke();
+        }
+    }
+}
+
+void Settings_Registry::applyDelta(JsonDocument &settings)
+{
+    StaticJsonDocument<512> delta;
+
+    if (FilesystemModule::Utilities::ReadFile(SETTINGS_DELTA_FILENAME, delta) != FilesystemModule::FILESYSTEM_OK)
+    {
+        return;
+    }
+
+    xSemaphoreTake(mutex(), portMAX_DELAY);
+
+    for (JsonPair pair : delta.as<JsonObject>())
+    {
+        Setting_Key key = Find(pair.key().c_str());
+        Setting_Value value = {false};
+
+        if (key == NUM_SETTINGS || !readValue(key, pair.value(), value))
+        {
+            continue;
+        }
+
+        _Store.loadDelta(key, value);
+        writeValue(key, settings[Descriptor(key).name]);
+    }
+
+    xSemaphoreGive(mutex());
+}
+
+bool Settings_Registry::persist()
+{
+    uint8_t delta[SETTINGS_DELTA_MAX_BYTES];
+
+    xSemaphoreTake(mutex(), portMAX_DELAY);
+
+    uint32_t persistedKeys = _Store.dirtyKeys();
+
+    if (persistedKeys == 0)
+    {
+        xSemaphoreGive(mutex());
+        return true;
+    }
+
+    // The delta file holds every key changed since the last full write, so older changes survive
+    size_t length = _Store.encodeDelta(delta, sizeof(delta));
+
+    xSemaphoreGive(mutex());
+
+    if (length == 0)
+    {
+        LOG_WARN("Settings_Registry: delta does not fit in %u bytes", SETTINGS_DELTA_MAX_BYTES);
+        return false;
+    }
+
+    size_t bytesWritten = 0;
+    auto produce = [&delta, length](MsgPack_Writer &writer) { writer.writeRaw(delta, length); };
+
+    if (FilesystemModule::Utilities::WriteFileStreamed(SETTINGS_DELTA_FILENAME, produce, &bytesWritten) != FilesystemModule::FILESYSTEM_OK)
+    {
+        LOG_WARN("Settings_Registry: failed to write %s", SETTINGS_DELTA_FILENAME);
+        return false;
+    }
+
+    _LastPersistBytes = bytesWritten;
+
+    xSemaphoreTake(mutex(), portMAX_DELAY);
+    _Store.markPersisted(persistedKeys);
+    xSemaphoreGive(mutex());
+
+    return true;
+}
+
+void Settings_Registry::clearDelta()
+{
+    FilesystemModule::Utilities::RemoveFile(SETTINGS_DELTA_FILENAME);
+
+    xSemaphoreTake(mutex(), portMAX_DELAY);
+    _Store.clearDelta();
+    xSemaphoreGive(mutex());
+}
@@ -0,0 +1,274 @@
+#include "Settings_Store.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+    // Indexed by Setting_Key
+    const Setting_Descriptor SETTING_DESCRIPTORS[NUM_SETTINGS] = {
+        {"Device Name", SETTING_TYPE_STRING},
+        {"UserID", SETTING_TYPE_INT},
+        {"WiFi Provisioning", SETTING_TYPE_INT},
+        {"Silent Mode", SETTING_TYPE_BOOL},
+        {"24H Time", SETTING_TYPE_BOOL},
+    };
+
+    static_assert(NUM_SETTINGS <= 15, "The delta is encoded as a fixmap");
+
+    bool parseBool(const char *text)
+    {
+        return strcmp(text, "true") == 0 || strcmp(text, "1") == 0;
+    }
+
+    // Appends MessagePack to a fixed buffer. Everything written after the buffer fills is dropped.
+    struct Delta_Buffer
+    {
+        uint8_t *data;
+        size_t size;
+        size_t used;
+
+        bool fits() const { return used <= size; }
+
+        void writeByte(uint8_t value)
+        {
+            if (used < size)
+            {
+                data[used] = value;
+            }
+
+            used++;
+        }
+
+        void writeBigEndian(uint32_t value, uint8_t bytes)
+        {
+            for (int8_t shift = (bytes - 1) * 8; shift >= 0; shift -= 8)
+            {
+                writeByte((value >> shift) & 0xff);
+            }
+        }
+
+        void writeString(const char *value)
+        {
+            size_t length = strlen(value);
+
+            if (length < 32)
+            {
+                writeByte(0xa0 | length);
+            }
+            else
+            {
+                writeByte(0xd9);
+                writeByte(length);
+            }
+
+            for (size_t i = 0; i < length; i++)
+            {
+                writeByte(value[i]);
+            }
+        }
+
+        // Smallest encoding of the value, as ArduinoJson writes it
+        void writeInteger(int32_t value)
+        {
+            if (value >= 0)
+            {
+                if (value <= 0x7f)
+                {
+                    writeByte(value);
+                }
+                else if (value <= UINT8_MAX)
+                {
+                    writeByte(0xcc);
+                    writeBigEndian(value, 1);
+                }
+                else if (value <= UINT16_MAX)
+                {
+                    writeByte(0xcd);
+                    writeBigEndian(value, 2);
+                }
+                else
+                {
+                    writeByte(0xce);
+                    writeBigEndian(value, 4);
+                }
+            }
+            else if (value >= -32)
+            {
+                writeByte(0xe0 | (value & 0x1f));
+            }
+            else if (value >= INT8_MIN)
+            {
+                writeByte(0xd0);
+                writeBigEndian((uint32_t)value, 1);
+            }
+            else if (value >= INT16_MIN)
+            {
+                writeByte(0xd1);
+                writeBigEndian((uint32_t)value, 2);
+            }
+            else
+            {
+                writeByte(0xd2);
+                writeBigEndian((uint32_t)value, 4);
+            }
+        }
+
+        void writeFloat(float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+
+            writeByte(0xca);
+            writeBigEndian(bits, 4);
+        }
+    };
+}
+
+const Setting_Descriptor &Settings_Store::Descriptor(Setting_Key key)
+{
+    return SETTING_DESCRIPTORS[key < NUM_SETTINGS ? key : 0];
+}
+
+Setting_Key Settings_Store::Find(const char *name)
+{
+    if (name == nullptr)
+    {
+        return NUM_SETTINGS;
+    }
+
+    for (uint8_t key = 0; key < NUM_SETTINGS; key++)
+    {
+        if (strcmp(SETTING_DESCRIPTORS[key].name, name) == 0)
+        {
+            return (Setting_Key)key;
+        }
+    }
+
+    return NUM_SETTINGS;
+}
+
+Setting_Value Settings_Store::Parse(Setting_Key key, const char *text)
+{
+    Setting_Value value = {};
+    value.present = true;
+
+    if (text == nullptr)
+    {
+        text = "";
+    }
+
+    switch (Descriptor(key).type)
+    {
+    case SETTING_TYPE_BOOL:
+        value.boolean = parseBool(text);
+        break;
+    case SETTING_TYPE_INT:
+        value.integer = atol(text);
+        break;
+    case SETTING_TYPE_FLOAT:
+        value.number = atof(text);
+        break;
+    case SETTING_TYPE_STRING:
+    default:
+        strncpy(value.text, text, SETTING_STRING_LENGTH - 1);
+        break;
+    }
+
+    return value;
+}
+
+bool Settings_Store::Equal(Setting_Key key, const Setting_Value &a, const Setting_Value &b)
+{
+    if (a.present != b.present)
+    {
+        return false;
+    }
+
+    switch (Descriptor(key).type)
+    {
+    case SETTING_TYPE_BOOL:
+        return a.boolean == b.boolean;
+    case SETTING_TYPE_INT:
+        return a.integer == b.integer;
+    case SETTING_TYPE_FLOAT:
+        return a.number == b.number;
+    case SETTING_TYPE_STRING:
+    default:
+        return strcmp(a.text, b.text) == 0;
+    }
+}
+
+bool Settings_Store::set(Setting_Key key, const Setting_Value &value)
+{
+    if (!load(key, value))
+    {
+        return false;
+    }
+
+    dirty |= 1UL << key;
+    delta |= 1UL << key;
+    return true;
+}
+
+bool Settings_Store::load(Setting_Key key, const Setting_Value &value)
+{
+    if (key >= NUM_SETTINGS || Equal(key, values[key], value))
+    {
+        return false;
+    }
+
+    values[key] = value;
+    return true;
+}
+
+void Settings_Store::loadDelta(Setting_Key key, const Setting_Value &value)
+{
+    if (key < NUM_SETTINGS)
+    {
+        values[key] = value;
+        delta |= 1UL << key;
+    }
+}
+
+size_t Settings_Store::encodeDelta(uint8_t *buffer, size_t bufferSize) const
+{
+    Delta_Buffer output = {buffer, bufferSize, 0};
+    uint8_t count = 0;
+
+    for (uint8_t key = 0; key < NUM_SETTINGS; key++)
+    {
+        count += (delta >> key) & 1;
+    }
+
+    output.writeByte(0x80 | count);
+
+    for (uint8_t key = 0; key < NUM_SETTINGS; key++)
+    {
+        if (!(delta & (1UL << key)))
+        {
+            continue;
+        }
+
+        const Setting_Value &value = values[key];
+        output.writeString(SETTING_DESCRIPTORS[key].name);
+
+        switch (SETTING_DESCRIPTORS[key].type)
+        {
+        case SETTING_TYPE_BOOL:
+            output.writeByte(value.boolean ? 0xc3 : 0xc2);
+            break;
+        case SETTING_TYPE_INT:
+            output.writeInteger(value.integer);
+            break;
+        case SETTING_TYPE_FLOAT:
+            output.writeFloat(value.number);
+            break;
+        case SETTING_TYPE_STRING:
+        default:
+            output.writeString(value.text);
+            break;
+        }
+    }
+
+    return output.fits() ? output.used : 0;
+}
@@ -1,20 +1,37 @@
 #include "System_Utils.h"
+#include "ConnectivityUtils.h"
+#if SYSTEM_STATIC_ALLOCATION == 1
+#include "esp_freertos_hooks.h"
+#endif
 std::string System_Utils::DeviceName = "ESP32";
 size_t System_Utils::DeviceID = 0;
 
 bool System_Utils::silentMode = true;
 bool System_Utils::time24Hour = false;
 
-std::unordered_map<int, TimerHandle_t> System_Utils::systemTimers;
+TimerHandle_t System_Utils::systemTimers[SYSTEM_MAX_TIMERS];
+TaskHandle_t System_Utils::systemTasks[SYSTEM_MAX_TASKS];
+QueueHandle_t System_Utils::systemQueues[SYSTEM_MAX_QUEUES];
 int System_Utils::nextTimerID = 0;
 
-std::unordered_map<int, TaskHandle_t> System_Utils::systemTasks;
-int System_Utils::nextTaskID = 0;
+std::unordered_map<uint8_t, bool> System_Utils::adcUsers;
 
-std::unordered_map<int, QueueHandle_t> System_Utils::systemQueues;
-int System_Utils::nextQueueID = 0;
+SemaphoreHandle_t System_Utils::_ProfilerMutex = nullptr;
+StaticSemaphore_t System_Utils::_ProfilerMutexBuffer;
 
-std::unordered_map<uint8_t, bool> System_Utils::adcUsers;
+Task_Profile System_Utils::taskProfiles[SYSTEM_MAX_TASKS];
+Queue_Profile System_Utils::queueProfiles[SYSTEM_MAX_QUEUES];
+Timer_Profile System_Utils::timerProfiles[SYSTEM_MAX_TIMERS];
+
+Runtime_History System_Utils::runtimeHistory;
+int64_t System_Utils::lastSampleUS = 0;
+
+#if configUSE_TRACE_FACILITY == 1
+TaskStatus_t System_Utils::taskStatusBuffer[SYSTEM_MAX_TASKS + RUNTIME_PROFILER_SYSTEM_TASKS];
+#endif
+
+StaticTimer_t System_Utils::profilerTimerBuffer;
+int System_Utils::profilerTimerID = -1;
 
 StaticTimer_t System_Utils::healthTimerBuffer;
 int System_Utils::healthTimerID;
@@ -29,11 +46,23 @@ EventHandler System_Utils::systemShutdown;
 
 void System_Utils::init()
 {
+    Log_Utils::init();
+    Heap_Utils::init();
+    Persistence_Utils::init();
+    Asset_Utils::init();
+
+    Settings_Registry::Changed(SETTING_USER_ID) += onUserIDChanged;
+    Settings_Registry::Changed(SETTING_DEVICE_NAME) += onDeviceNameChanged;
+    Settings_Registry::Changed(SETTING_SILENT_MODE) += onSilentModeChanged;
+    Settings_Registry::Changed(SETTING_WIFI_PROVISIONING) += ConnectivityModule::Utilities::OnProvisioningSettingChanged;
+
 #if HARDWARE_VERSION == 1
     healthTimerID = registerTimer("System Health Monitor", 60000, monitorSystemHealth, healthTimerBuffer);
     startTimer(healthTimerID);
     monitorSystemHealth(nullptr);
 #endif
+
+    startRuntimeProfiler();
 }
 
 // TODO: Make actual battery curve
@@ -109,6 +138,201 @@ void System_Utils::systemShutdownInvoke()
     systemShutdown.Invoke();
 }
 
+#if SYSTEM_STATIC_ALLOCATION == 1
+namespace
+{
+    // Buffers for every task and timer in the allocation table
+    #define DECLARE_STATIC_TASK(id, name, stackSize) StackType_t id##_Stack[stackSize]; StaticTask_t id##_TCB;
+    #define DECLARE_STATIC_TIMER(id, name) StaticTimer_t id##_Timer;
+    SYSTEM_STATIC_TASKS(DECLARE_STATIC_TASK)
+    SYSTEM_STATIC_TIMERS(DECLARE_STATIC_TIMER)
+
+    struct Static_Task_Slot
+    {
+        const char *name;
+        uint32_t stackSize;
+        StackType_t *stack;
+        StaticTask_t *tcb;
+        int taskID;
+
+        // Set by deleteTask. The idle task may still be cleaning up the TCB, so the buffers stay reserved until
+        // the task is off every list and each idle task has run a full pass after that was first seen.
+        TaskHandle_t retired;
+        bool retiredSeen;
+        uint32_t retiredIdleRuns[portNUM_PROCESSORS];
+    };
+
+    struct Static_Timer_Slot
+    {
+        const char *name;
+        StaticTimer_t *buffer;
+        int timerID;
+
+        // Deleted timers are stopped and parked here. Freeing the buffer could race the timer daemon's delete.
+        TimerHandle_t parked;
+    };
+
+    struct Static_Queue_Slot
+    {
+        StaticQueue_t buffer;
+        size_t offset;
+        size_t bytes;
+        int queueID;
+    };
+
+    #define STATIC_TASK_SLOT(id, name, stackSize) {name, stackSize, id##_Stack, &id##_TCB, -1, nullptr, false, {}},
+    #define STATIC_TIMER_SLOT(id, name) {name, &id##_Timer, -1, nullptr},
+
+    Static_Task_Slot staticTasks[] = {SYSTEM_STATIC_TASKS(STATIC_TASK_SLOT)};
+    Static_Timer_Slot staticTimers[] = {SYSTEM_STATIC_TIMERS(STATIC_TIMER_SLOT)};
+
+    uint8_t staticQueueArena[SYSTEM_STATIC_QUEUE_ARENA_BYTES];
+    size_t staticQueueArenaUsed = 0;
+    Static_Queue_Slot staticQueues[SYSTEM_STATIC_ARENA_QUEUES];
+
+    #define STATIC_TASK_BYTES(id, name, stackSize) + stackSize * sizeof(StackType_t) + sizeof(StaticTask_t)
+    #define STATIC_TIMER_BYTES(id, name) + sizeof(StaticTimer_t)
+
+    const size_t SYSTEM_STATIC_RAM_BYTES = 0
+        SYSTEM_STATIC_TASKS(STATIC_TASK_BYTES)
+        SYSTEM_STATIC_TIMERS(STATIC_TIMER_BYTES)
+        + SYSTEM_STATIC_QUEUE_ARENA_BYTES
+        + sizeof(staticQueues);
+
+    static_assert(SYSTEM_STATIC_RAM_BYTES <= SYSTEM_STATIC_RAM_BUDGET, "Static task, timer and queue buffers exceed SYSTEM_STATIC_RAM_BUDGET");
+
+    Static_Task_Slot *findStaticTask(const char *name)
+    {
+        for (auto &slot : staticTasks)
+        {
+            if (strcmp(slot.name, name) == 0)
+            {
+                return &slot;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Idle hook passes per core, counted once a static task has been deleted
+    volatile uint32_t idleRuns[portNUM_PROCESSORS];
+    bool idleHooksRegistered = false;
+
+    bool countIdleRun()
+    {
+        idleRuns[xPortGetCoreID()]++;
+        return true;
+    }
+
+    // True once the buffers of the task deleted from slot can be reused
+    bool retiredTaskGone(Static_Task_Slot &slot)
+    {
+        if (slot.retired == nullptr)
+        {
+            return true;
+        }
+
+        if (eTaskGetState(slot.retired) != eDeleted)
+        {
+            return false;
+        }
+
+        if (!slot.retiredSeen)
+        {
+            slot.retiredSeen = true;
+
+            for (int core = 0; core < portNUM_PROCESSORS; core++)
+            {
+                slot.retiredIdleRuns[core] = idleRuns[core];
+            }
+
+            return false;
+        }
+
+        // The hook runs at the end of each idle pass, so two counts mean a whole pass started after the delete
+        for (int core = 0; core < portNUM_PROCESSORS; core++)
+        {
+            if (idleRuns[core] - slot.retiredIdleRuns[core] < 2)
+            {
+                return false;
+            }
+        }
+
+        slot.retired = nullptr;
+        return true;
+    }
+
+    Static_Timer_Slot *findStaticTimer(const char *name)
+    {
+        for (auto &slot : staticTimers)
+        {
+            if (strcmp(slot.name, name) == 0)
+            {
+                return &slot;
+            }
+        }
+
+        return nullptr;
+    }
+}
+#endif
+
+// Registries
+
+int System_Utils::freeTimerSlot()
+{
+    for (int i = 0; i < SYSTEM_MAX_TIMERS; i++)
+    {
+        int timerID = (nextTimerID + i) % SYSTEM_MAX_TIMERS;
+
+        if (systemTimers[timerID] == nullptr)
+        {
+            nextTimerID = (timerID + 1) % SYSTEM_MAX_TIMERS;
+            return timerID;
+        }
+    }
+
+    return -1;
+}
+
+int System_Utils::addTimer(TimerHandle_t handle, int timerID)
+{
+    systemTimers[timerID] = handle;
+    return timerID;
+}
+
+int System_Utils::addTask(TaskHandle_t handle)
+{
+    for (int taskID = 0; taskID < SYSTEM_MAX_TASKS; taskID++)
+    {
+        if (systemTasks[taskID] == nullptr)
+        {
+            systemTasks[taskID] = handle;
+            taskProfiles[taskID] = Task_Profile();
+            return taskID;
+        }
+    }
+
+    return -1;
+}
+
+int System_Utils::addQueue(QueueHandle_t handle)
+{
+    for (int queueID = 0; queueID < SYSTEM_MAX_QUEUES; queueID++)
+    {
+        if (systemQueues[queueID] == nullptr)
+        {
+            systemQueues[queueID] = handle;
+            queueProfiles[queueID] = Queue_Profile();
+            return queueID;
+        }
+    }
+
+    return -1;
+}
+
+// Timer functionality
+
 int System_Utils::registerTimer(const char *timerName, size_t periodMS, TimerCallbackFunction_t callback)
 {
 #if DEBUG == 1
@@ -116,17 +340,64 @@ int System_Utils::registerTimer(const char *timerName, size_t periodMS, TimerCal
     // Serial.println(timerName);
 #endif
 
-    TimerHandle_t handle = xTimerCreate(timerName, periodMS, pdTRUE, (void *)0, callback);
+#if SYSTEM_STATIC_ALLOCATION == 1
+    Static_Timer_Slot *slot = findStaticTimer(timerName);
 
-    if (handle != nullptr)
+    if (slot == nullptr || slot->timerID != -1)
     {
-        systemTimers[nextTimerID] = handle;
-        return nextTimerID++;
+        LOG_ERROR("Timer %s is not declared in SYSTEM_STATIC_TIMERS or is already registered", timerName);
+        return -1;
     }
-    else
+
+    if (slot->parked == nullptr)
     {
-        return -1;
+        slot->timerID = registerTimer(timerName, periodMS, callback, *slot->buffer);
+        return slot->timerID;
+    }
+
+    // Reuse the parked timer
+    lockRegistry();
+
+    int timerID = freeTimerSlot();
+
+    if (timerID != -1)
+    {
+        Timer_Profile &profile = timerProfiles[timerID];
+        profile = Timer_Profile();
+        profile.callback = callback;
+
+        vTimerSetTimerID(slot->parked, (void *)&profile);
+        addTimer(slot->parked, timerID);
+
+        // Changing the period starts a dormant timer
+        xTimerChangePeriod(slot->parked, periodMS, portMAX_DELAY);
+        xTimerStop(slot->parked, portMAX_DELAY);
+
+        slot->parked = nullptr;
+        slot->timerID = timerID;
+    }
+
+    unlockRegistry();
+    return timerID;
+#else
+    lockRegistry();
+
+    int timerID = freeTimerSlot();
+
+    if (timerID != -1)
+    {
+        // The profile is passed as the timer ID so the callback can find it without a lookup
+        Timer_Profile &profile = timerProfiles[timerID];
+        profile = Timer_Profile();
+        profile.callback = callback;
+
+        TimerHandle_t handle = xTimerCreate(timerName, periodMS, pdTRUE, (void *)&profile, profiledTimerCallback);
+        timerID = handle != nullptr ? addTimer(handle, timerID) : -1;
     }
+
+    unlockRegistry();
+    return timerID;
+#endif
 }
 
 int System_Utils::registerTimer(const char *timerName, size_t periodMS, TimerCallbackFunction_t callback, StaticTimer_t &timerBuffer)
@@ -135,17 +406,22 @@ int System_Utils::registerTimer(const char *timerName, size_t periodMS, TimerCal
     // Serial.print("Registering static timer: ");
     // Serial.println(timerName);
 #endif
-    TimerHandle_t handle = xTimerCreateStatic(timerName, periodMS, pdTRUE, (void *)0, callback, &timerBuffer);
+    lockRegistry();
 
-    if (handle != nullptr)
-    {
-        systemTimers[nextTimerID] = handle;
-        return nextTimerID++;
-    }
-    else
+    int timerID = freeTimerSlot();
+
+    if (timerID != -1)
     {
-        return -1;
+        Timer_Profile &profile = timerProfiles[timerID];
+        profile = Timer_Profile();
+        profile.callback = callback;
+
+        TimerHandle_t handle = xTimerCreateStatic(timerName, periodMS, pdTRUE, (void *)&profile, profiledTimerCallback, &timerBuffer);
+        timerID = handle != nullptr ? addTimer(handle, timerID) : -1;
     }
+
+    unlockRegistry();
+    return timerID;
 }
 
 void System_Utils::deleteTimer(int timerID)
@@ -155,11 +431,35 @@ void System_Utils::deleteTimer(int timerID)
     // Serial.println(timerID);
 #endif
 
-    if (systemTimers.find(timerID) != systemTimers.end())
+    lockRegistry();
+
+    if (isTimer(timerID))
     {
-        xTimerDelete(systemTimers[timerID], 0);
-        systemTimers.erase(timerID);
+        bool parked = false;
+
+#if SYSTEM_STATIC_ALLOCATION == 1
+        for (auto &slot : staticTimers)
+        {
+            if (slot.timerID == timerID)
+            {
+                xTimerStop(systemTimers[timerID], 0);
+                slot.parked = systemTimers[timerID];
+                slot.timerID = -1;
+                parked = true;
+            }
+        }
+#endif
+
+        if (!parked)
+        {
+            xTimerDelete(systemTimers[timerID], 0);
+        }
+
+        systemTimers[timerID] = nullptr;
+        timerProfiles[timerID].deleted = true;
     }
+
+    unlockRegistry();
 }
 
 bool System_Utils::isTimerActive(int timerID)
@@ -168,7 +468,7 @@ bool System_Utils::isTimerActive(int timerID)
     // Serial.print("Checking if timer is active: ");
     // Serial.println(timerID);
 #endif
-    if (systemTimers.find(timerID) != systemTimers.end())
+    if (isTimer(timerID))
     {
         return xTimerIsTimerActive(systemTimers[timerID]);
     }
@@ -182,7 +482,7 @@ void System_Utils::startTimer(int timerID)
     // Serial.println(timerID);
 #endif
 
-    if (systemTimers.find(timerID) != systemTimers.end())
+    if (isTimer(timerID))
     {
         xTimerStart(systemTimers[timerID], 1000);
     }
@@ -195,7 +495,7 @@ void System_Utils::stopTimer(int timerID)
     // Serial.println(timerID);
 #endif
 
-    if (systemTimers.find(timerID) != systemTimers.end())
+    if (isTimer(timerID))
     {
         if (xTimerStop(systemTimers[timerID], 1000) == pdFAIL)
         {
@@ -219,7 +519,7 @@ void System_Utils::resetTimer(int timerID)
     // Serial.println(timerID);
 #endif
 
-    if (systemTimers.find(timerID) != systemTimers.end())
+    if (isTimer(timerID))
     {
         xTimerReset(systemTimers[timerID], 0);
     }
@@ -232,7 +532,7 @@ void System_Utils::changeTimerPeriod(int timerID, size_t timerPeriodMS)
     // Serial.println(timerID);
 #endif
 
-    if (systemTimers.find(timerID) != systemTimers.end())
+    if (isTimer(timerID))
     {
         xTimerChangePeriod(systemTimers[timerID], pdMS_TO_TICKS(timerPeriodMS), 0);
     }
@@ -242,17 +542,63 @@ void System_Utils::changeTimerPeriod(int timerID, size_t timerPeriodMS)
 
 int System_Utils::registerQueue(size_t queueLength, size_t itemSize)
 {
+#if SYSTEM_STATIC_ALLOCATION == 1
+    // Carved from the queue arena, aligned for any item type
+    size_t bytes = (queueLength * itemSize + 3) & ~(size_t)3;
+    int queueID = -1;
+
+    lockRegistry();
+
+    for (auto &slot : staticQueues)
+    {
+        if (slot.bytes != 0 || staticQueueArenaUsed + bytes > SYSTEM_STATIC_QUEUE_ARENA_BYTES)
+        {
+            continue;
+        }
+
+        QueueHandle_t handle = xQueueCreateStatic(queueLength, itemSize, &staticQueueArena[staticQueueArenaUsed], &slot.buffer);
+        queueID = handle != nullptr ? addQueue(handle) : -1;
+
+        if (queueID != -1)
+        {
+            slot.offset = staticQueueArenaUsed;
+            slot.bytes = bytes;
+            slot.queueID = queueID;
+            staticQueueArenaUsed += bytes;
+        }
+
+        break;
+    }
+
+    unlockRegistry();
+
+    if (queueID == -1)
+    {
+        LOG_ERROR("Queue of %u x %u bytes does not fit in the static queue arena", queueLength, itemSize);
+    }
+
+    return queueID;
+#else
     QueueHandle_t handle = xQueueCreate(queueLength, itemSize);
 
     if (handle != nullptr)
     {
-        systemQueues[nextQueueID] = handle;
-        return nextQueueID++;
+        lockRegistry();
+        int queueID = addQueue(handle);
+        unlockRegistry();
+
+        if (queueID == -1)
+        {
+            vQueueDelete(handle);
+        }
+
+        return queueID;
     }
     else
     {
         return -1;
     }
+#endif
 }
 
 int System_Utils::registerQueue(size_t queueLength, size_t itemSize, uint8_t *queueData, StaticQueue_t &queueBuffer)
@@ -261,8 +607,11 @@ int System_Utils::registerQueue(size_t queueLength, size_t itemSize, uint8_t *qu
 
     if (handle != nullptr)
     {
-        systemQueues[nextQueueID] = handle;
-        return nextQueueID++;
+        lockRegistry();
+        int queueID = addQueue(handle);
+        unlockRegistry();
+
+        return queueID;
     }
     else
     {
@@ -272,7 +621,7 @@ int System_Utils::registerQueue(size_t queueLength, size_t itemSize, uint8_t *qu
 
 QueueHandle_t System_Utils::getQueue(int queueID)
 {
-    if (systemQueues.find(queueID) != systemQueues.end())
+    if (isQueue(queueID))
     {
         return systemQueues[queueID];
     }
@@ -284,16 +633,37 @@ QueueHandle_t System_Utils::getQueue(int queueID)
 
 void System_Utils::deleteQueue(int queueID)
 {
-    if (systemQueues.find(queueID) != systemQueues.end())
+    lockRegistry();
+
+    if (isQueue(queueID))
     {
         vQueueDelete(systemQueues[queueID]);
-        systemQueues.erase(queueID);
+        systemQueues[queueID] = nullptr;
+
+#if SYSTEM_STATIC_ALLOCATION == 1
+        for (auto &slot : staticQueues)
+        {
+            if (slot.bytes != 0 && slot.queueID == queueID)
+            {
+                // Only the most recent queue can give its space back
+                if (slot.offset + slot.bytes == staticQueueArenaUsed)
+                {
+                    staticQueueArenaUsed = slot.offset;
+                }
+
+                slot.bytes = 0;
+                slot.queueID = -1;
+            }
+        }
+#endif
     }
+
+    unlockRegistry();
 }
 
 void System_Utils::resetQueue(int queueID)
 {
-    if (systemQueues.find(queueID) != systemQueues.end())
+    if (isQueue(queueID))
     {
         xQueueReset(systemQueues[queueID]);
     }
@@ -301,9 +671,19 @@ void System_Utils::resetQueue(int queueID)
 
 bool System_Utils::sendToQueue(int queueID, void *item, size_t timeoutMS)
 {
-    if (systemQueues.find(queueID) != systemQueues.end())
+    if (isQueue(queueID))
     {
-        return xQueueSend(systemQueues[queueID], item, pdMS_TO_TICKS(timeoutMS)) == pdPASS;
+        QueueHandle_t queue = systemQueues[queueID];
+        bool sent = xQueueSend(queue, item, pdMS_TO_TICKS(timeoutMS)) == pdPASS;
+
+        // Catch peaks between samples for queues fed through here
+        uint32_t depth = uxQueueMessagesWaiting(queue);
+
+        lockRegistry();
+        queueProfiles[queueID].record(depth);
+        unlockRegistry();
+
+        return sent;
     }
     else
     {
@@ -320,19 +700,7 @@ int System_Utils::registerTask(
     void *taskParameters, 
     UBaseType_t taskPriority)
 {
-    TaskHandle_t handle;
-    BaseType_t status = xTaskCreate(taskFunction, taskName, taskStackSize, taskParameters, taskPriority, &handle);
-
-    if (status == pdPASS)
-    {
-        // Add task to systemTasks
-        systemTasks[nextTaskID] = handle;
-        return nextTaskID++;
-    }
-    else
-    {
-        return -1;
-    }
+    return registerTask(taskFunction, taskName, taskStackSize, taskParameters, taskPriority, tskNO_AFFINITY);
 }
 
 int System_Utils::registerTask(
@@ -343,14 +711,49 @@ int System_Utils::registerTask(
     UBaseType_t taskPriority, 
     BaseType_t coreID)
 {
+#if SYSTEM_STATIC_ALLOCATION == 1
+    Static_Task_Slot *slot = findStaticTask(taskName);
+
+    if (slot == nullptr || slot->taskID != -1 || slot->stackSize < taskStackSize)
+    {
+        LOG_ERROR("Task %s is not declared in SYSTEM_STATIC_TASKS with %u bytes of stack, or is already running", taskName, taskStackSize);
+        return -1;
+    }
+
+    // A task registered again right after deleteTask waits for the idle task to release its buffers
+    TickType_t waitStart = xTaskGetTickCount();
+
+    while (!retiredTaskGone(*slot))
+    {
+        if (xTaskGetTickCount() - waitStart > pdMS_TO_TICKS(SYSTEM_STATIC_TASK_REUSE_WAIT_MS))
+        {
+            LOG_ERROR("Task %s was deleted but its buffers are still in use", taskName);
+            return -1;
+        }
+
+        vTaskDelay(1);
+    }
+
+    slot->taskID = registerTask(taskFunction, taskName, slot->stackSize, taskParameters, taskPriority, *slot->stack, *slot->tcb, coreID);
+    return slot->taskID;
+#else
     TaskHandle_t handle;
     BaseType_t status = xTaskCreatePinnedToCore(taskFunction, taskName, taskStackSize, taskParameters, taskPriority, &handle, coreID);
 
     if (status == pdPASS)
     {
         // Add task to systemTasks
-        systemTasks[nextTaskID] = handle;
-        return nextTaskID++;
+        lockRegistry();
+        int taskID = addTask(handle);
+        unlockRegistry();
+
+        if (taskID == -1)
+        {
+            LOG_ERROR("Task registry is full, raise SYSTEM_MAX_TASKS");
+            vTaskDelete(handle);
+        }
+
+        return taskID;
     }
     else
     {
@@ -360,7 +763,7 @@ int System_Utils::registerTask(
         #endif
         return -1;
     }
-    
+#endif
 }
 
 int System_Utils::registerTask(
@@ -372,19 +775,7 @@ int System_Utils::registerTask(
     StackType_t &stackBuffer, 
     StaticTask_t &taskBuffer)
 {
-    auto handle = xTaskCreateStatic(taskFunction, taskName, taskStackSize, taskParameters, taskPriority, &stackBuffer, &taskBuffer);
-
-    if (handle != nullptr)
-    {
-        // Add task to systemTasks
-        systemTasks[nextTaskID] = handle;
-        return nextTaskID++;
-    }
-    else
-    {
-        return -1;
-    }
-
+    return registerTask(taskFunction, taskName, taskStackSize, taskParameters, taskPriority, stackBuffer, taskBuffer, tskNO_AFFINITY);
 }
 
 int System_Utils::registerTask(
@@ -402,8 +793,17 @@ int System_Utils::registerTask(
     if (handle != nullptr)
     {
         // Add task to systemTasks
-        systemTasks[nextTaskID] = handle;
-        return nextTaskID++;
+        lockRegistry();
+        int taskID = addTask(handle);
+        unlockRegistry();
+
+        if (taskID == -1)
+        {
+            LOG_ERROR("Task registry is full, raise SYSTEM_MAX_TASKS");
+            vTaskDelete(handle);
+        }
+
+        return taskID;
     }
     else
     {
@@ -413,7 +813,7 @@ int System_Utils::registerTask(
 
 void System_Utils::suspendTask(int taskID)
 {
-    if (systemTasks.find(taskID) != systemTasks.end())
+    if (isTask(taskID))
     {
         vTaskSuspend(systemTasks[taskID]);
     }
@@ -421,7 +821,7 @@ void System_Utils::suspendTask(int taskID)
 
 void System_Utils::resumeTask(int taskID)
 {
-    if (systemTasks.find(taskID) != systemTasks.end())
+    if (isTask(taskID))
     {
         vTaskResume(systemTasks[taskID]);
     }
@@ -429,16 +829,53 @@ void System_Utils::resumeTask(int taskID)
 
 void System_Utils::deleteTask(int taskID)
 {
-    if (systemTasks.find(taskID) != systemTasks.end())
+    TaskHandle_t handle = nullptr;
+
+    lockRegistry();
+
+    if (isTask(taskID))
+    {
+        handle = systemTasks[taskID];
+        systemTasks[taskID] = nullptr;
+
+#if SYSTEM_STATIC_ALLOCATION == 1
+        // The idle task cleans up a task that deletes itself or is running on the other core, so the slot only
+        // frees its buffers once registerTask sees that has happened
+        for (auto &slot : staticTasks)
+        {
+            if (slot.taskID == taskID)
+            {
+                slot.taskID = -1;
+                slot.retired = handle;
+                slot.retiredSeen = false;
+            }
+        }
+
+        if (!idleHooksRegistered)
+        {
+            for (int core = 0; core < portNUM_PROCESSORS; core++)
+            {
+                esp_register_freertos_idle_hook_for_cpu(countIdleRun, core);
+            }
+
+            idleHooksRegistered = true;
+        }
+#endif
+    }
+
+    unlockRegistry();
+
+    // Deleted outside the lock in case a task is deleting itself
+    if (handle != nullptr)
     {
-        vTaskDelete(systemTasks[taskID]);
-        systemTasks.erase(taskID);
+        Heap_Utils::forgetTask(handle);
+        vTaskDelete(handle);
     }
 }
 
 TaskHandle_t System_Utils::getTask(int taskID)
 {
-    if (systemTasks.find(taskID) != systemTasks.end())
+    if (isTask(taskID))
     {
         return systemTasks[taskID];
     }
@@ -448,6 +885,291 @@ TaskHandle_t System_Utils::getTask(int taskID)
     }
 }
 
+// Runtime profiling
+
+SemaphoreHandle_t System_Utils::profilerMutex()
+{
+    // Created on first use, which is during single threaded startup
+    if (_ProfilerMutex == nullptr)
+    {
+        _ProfilerMutex = xSemaphoreCreateMutexStatic(&_ProfilerMutexBuffer);
+    }
+
+    return _ProfilerMutex;
+}
+
+void System_Utils::lockRegistry()
+{
+    xSemaphoreTake(profilerMutex(), portMAX_DELAY);
+}
+
+void System_Utils::unlockRegistry()
+{
+    xSemaphoreGive(profilerMutex());
+}
+
+void System_Utils::profiledTimerCallback(TimerHandle_t xTimer)
+{
+    Timer_Profile *profile = (Timer_Profile *)pvTimerGetTimerID(xTimer);
+
+    if (profile != nullptr)
+    {
+        profile->run(xTimer);
+    }
+}
+
+void System_Utils::startRuntimeProfiler()
+{
+    if (profilerTimerID != -1)
+    {
+        return;
+    }
+
+    // Take the first sample before the timer can fire, so the status buffer is never used by two tasks
+    sampleRuntimeStats(nullptr);
+
+    profilerTimerID = registerTimer("Runtime Profiler", RUNTIME_PROFILER_PERIOD_MS, sampleRuntimeStats, profilerTimerBuffer);
+    startTimer(profilerTimerID);
+}
+
+void System_Utils::sampleRuntimeStats(TimerHandle_t xTimer)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsedUS = lastSampleUS > 0 ? (uint32_t)(now - lastSampleUS) : 0;
+    lastSampleUS = now;
+
+    Runtime_Sample sample;
+    sample.timeMS = (uint32_t)(now / 1000);
+    sample.freeInternal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    sample.largestInternal = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    sample.freeSpiram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    sample.numTasks = 0;
+
+    #if configUSE_TRACE_FACILITY == 1
+    // Registered tasks are looked up in the scheduler's list, so tasks that deleted themselves are never touched.
+    // The snapshot is 0 tasks if the buffer is too small, and the sample then has no task entries.
+    TaskStatus_t *systemState = taskStatusBuffer;
+    UBaseType_t numSystemTasks = uxTaskGetSystemState(systemState, SYSTEM_MAX_TASKS + RUNTIME_PROFILER_SYSTEM_TASKS, nullptr);
+
+    if (numSystemTasks == 0)
+    {
+        LOG_WARN("System_Utils::sampleRuntimeStats: %u tasks exceed RUNTIME_PROFILER_SYSTEM_TASKS", uxTaskGetNumberOfTasks());
+    }
+    #endif
+
+    lockRegistry();
+
+    for (int taskID = 0; taskID < SYSTEM_MAX_TASKS; taskID++)
+    {
+        TaskHandle_t handle = systemTasks[taskID];
+
+        if (handle == nullptr)
+        {
+            continue;
+        }
+
+        Task_Profile &profile = taskProfiles[taskID];
+        uint32_t stackFree = 0;
+        bool alive = false;
+
+        #if configUSE_TRACE_FACILITY == 1
+        for (UBaseType_t i = 0; i < numSystemTasks; i++)
+        {
+            if (systemState[i].xHandle != handle)
+            {
+                continue;
+            }
+
+            alive = true;
+            stackFree = systemState[i].usStackHighWaterMark;
+
+            #if configGENERATE_RUN_TIME_STATS == 1
+            profile.update(systemState[i].ulRunTimeCounter, elapsedUS);
+            #endif
+            break;
+        }
+        #else
+        alive = true;
+        stackFree = uxTaskGetStackHighWaterMark(handle);
+        #endif
+
+        if (alive)
+        {
+            sample.addTask(taskID, profile.cpuPercent, stackFree);
+        }
+    }
+
+    for (int queueID = 0; queueID < SYSTEM_MAX_QUEUES; queueID++)
+    {
+        if (systemQueues[queueID] != nullptr)
+        {
+            queueProfiles[queueID].record(uxQueueMessagesWaiting(systemQueues[queueID]));
+        }
+    }
+
+    runtimeHistory.add(sample);
+
+    unlockRegistry();
+}
+
+size_t System_Utils::RuntimeHistory(Runtime_Sample *samples, size_t maxSamples)
+{
+    lockRegistry();
+    size_t count = runtimeHistory.copy(samples, maxSamples);
+    unlockRegistry();
+    return count;
+}
+
+void System_Utils::addHeapRegion(JsonArray regions, const char *name, uint32_t caps)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+
+    if (info.total_free_bytes == 0 && info.total_allocated_bytes == 0)
+    {
+        return;
+    }
+
+    JsonObject region = regions.createNestedObject();
+    region["region"] = name;
+    region["free"] = info.total_free_bytes;
+    region["largest"] = info.largest_free_block;
+    region["minFree"] = info.minimum_free_bytes;
+    region["allocated"] = info.total_allocated_bytes;
+}
+
+void System_Utils::GetRuntimeStatsRpc(JsonDocument &doc)
+{
+    size_t historyLength = doc["history"] | 0;
+    bool reset = doc["reset"] | false;
+    doc.clear();
+
+    doc["uptimeMS"] = (uint32_t)(esp_timer_get_time() / 1000);
+
+    lockRegistry();
+
+    JsonArray tasks = doc.createNestedArray("tasks");
+    const Runtime_Sample &latest = runtimeHistory.latest();
+
+    for (size_t i = 0; runtimeHistory.count() > 0 && i < latest.numTasks; i++)
+    {
+        int taskID = latest.tasks[i].taskID;
+
+        if (!isTask(taskID))
+        {
+            continue;
+        }
+
+        JsonObject task = tasks.createNestedObject();
+        task["id"] = taskID;
+        task["name"] = pcTaskGetName(systemTasks[taskID]);
+        task["stackFree"] = latest.tasks[i].stackFree;
+
+        if (latest.tasks[i].cpuPercent != RUNTIME_CPU_UNAVAILABLE)
+        {
+            task["cpu"] = latest.tasks[i].cpuPercent;
+        }
+    }
+
+    JsonArray queues = doc.createNestedArray("queues");
+
+    for (int queueID = 0; queueID < SYSTEM_MAX_QUEUES; queueID++)
+    {
+        QueueHandle_t queue = systemQueues[queueID];
+
+        if (queue == nullptr)
+        {
+            continue;
+        }
+
+        Queue_Profile &profile = queueProfiles[queueID];
+        uint32_t depth = uxQueueMessagesWaiting(queue);
+        profile.record(depth);
+
+        JsonObject queueStats = queues.createNestedObject();
+        queueStats["id"] = queueID;
+        queueStats["depth"] = depth;
+        queueStats["length"] = depth + uxQueueSpacesAvailable(queue);
+        queueStats["peak"] = profile.peakDepth;
+
+        if (reset)
+        {
+            profile.reset(depth);
+        }
+    }
+
+    JsonArray timers = doc.createNestedArray("timers");
+
+    for (int timerID = 0; timerID < SYSTEM_MAX_TIMERS; timerID++)
+    {
+        TimerHandle_t timer = systemTimers[timerID];
+
+        if (timer == nullptr)
+        {
+            continue;
+        }
+
+        Timer_Profile &profile = timerProfiles[timerID];
+
+        JsonObject timerStats = timers.createNestedObject();
+        timerStats["id"] = timerID;
+        timerStats["name"] = pcTimerGetName(timer);
+        timerStats["active"] = xTimerIsTimerActive(timer) != pdFALSE;
+        timerStats["calls"] = profile.calls;
+        timerStats["lastUS"] = profile.lastUS;
+        timerStats["maxUS"] = profile.maxUS;
+        timerStats["avgUS"] = profile.averageUS();
+
+        if (reset)
+        {
+            profile.resetStats();
+        }
+    }
+
+#if SYSTEM_STATIC_ALLOCATION == 1
+    JsonObject staticAllocation = doc.createNestedObject("static");
+    staticAllocation["bytes"] = SYSTEM_STATIC_RAM_BYTES;
+    staticAllocation["budget"] = SYSTEM_STATIC_RAM_BUDGET;
+    staticAllocation["queueArenaUsed"] = staticQueueArenaUsed;
+#endif
+
+    unlockRegistry();
+
+    JsonArray heap = doc.createNestedArray("heap");
+    addHeapRegion(heap, "internal", MALLOC_CAP_INTERNAL);
+    addHeapRegion(heap, "dma", MALLOC_CAP_DMA);
+    addHeapRegion(heap, "spiram", MALLOC_CAP_SPIRAM);
+
+    if (historyLength > 0)
+    {
+        historyLength = min(historyLength, (size_t)RUNTIME_PROFILER_HISTORY);
+        std::unique_ptr<Runtime_Sample[]> samples(new Runtime_Sample[historyLength]);
+        historyLength = RuntimeHistory(samples.get(), historyLength);
+
+        JsonArray history = doc.createNestedArray("history");
+
+        for (size_t i = 0; i < historyLength; i++)
+        {
+            JsonObject entry = history.createNestedObject();
+            entry["t"] = samples[i].timeMS;
+            entry["free"] = samples[i].freeInternal;
+            entry["largest"] = samples[i].largestInternal;
+            entry["spiram"] = samples[i].freeSpiram;
+
+            // Each task is [id, cpu %, free stack]. CPU is -1 if run time stats are disabled.
+            JsonArray taskSamples = entry.createNestedArray("tasks");
+
+            for (size_t t = 0; t < samples[i].numTasks; t++)
+            {
+                JsonArray taskSample = taskSamples.createNestedArray();
+                taskSample.add(samples[i].tasks[t].taskID);
+                taskSample.add(samples[i].tasks[t].cpuPercent == RUNTIME_CPU_UNAVAILABLE ? -1 : samples[i].tasks[t].cpuPercent);
+                taskSample.add(samples[i].tasks[t].stackFree);
+            }
+        }
+    }
+}
+
 // TODO: kill this
 bool System_Utils::enableWiFi()
 {
@@ -758,13 +1480,28 @@ void System_Utils::sendDisplayContents(Adafruit_SSD1306 *display)
 
 void System_Utils::UpdateSettings(JsonDocument &settings)
 {
-    if (settings.containsKey("UserID"))
+    if (Settings_Registry::has(SETTING_USER_ID))
     {
-        DeviceID = 0 | settings["UserID"]["cfgVal"].as<int>();
+        DeviceID = Settings_Registry::getInt(SETTING_USER_ID);
     }
 
-    if (settings.containsKey("Device Name"))
+    if (Settings_Registry::has(SETTING_DEVICE_NAME))
     {
-        DeviceName = settings["Device Name"]["cfgVal"].as<std::string>();
+        DeviceName = Settings_Registry::getString(SETTING_DEVICE_NAME);
     }
+}
+
+void System_Utils::onUserIDChanged()
+{
+    DeviceID = Settings_Registry::getInt(SETTING_USER_ID, DeviceID);
+}
+
+void System_Utils::onDeviceNameChanged()
+{
+    DeviceName = Settings_Registry::getString(SETTING_DEVICE_NAME, DeviceName.c_str());
+}
+
+void System_Utils::onSilentModeChanged()
+{
+    silentMode = Settings_Registry::getBool(SETTING_SILENT_MODE, silentMode);
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "Trace_Utils.h"
+#include <memory>
+
+namespace
+{
+    const char *TRACE_EVENT_NAMES[NUM_TRACE_EVENTS] PROGMEM = {
+        "RadioReceive",
+        "RadioSend",
+        "MessageReceived",
+        "RpcCall",
+        "DisplayCommand",
+        "DisplayDraw",
+        "LedFrame",
+        "LedShow",
+    };
+}
+
+const char *Trace_Utils::EventName(uint16_t eventID)
+{
+    return eventID < NUM_TRACE_EVENTS ? TRACE_EVENT_NAMES[eventID] : "Unknown";
+}
+
+#if TRACE_ENABLED == 1
+
+namespace
+{
+    // Chrome trace phase for each Trace_Phase
+    const char PHASE_CHARS[] = {'B', 'E', 'i'};
+}
+
+Trace_Record Trace_Utils::_Buffers[portNUM_PROCESSORS][TRACE_EVENTS_PER_CORE];
+std::atomic<uint32_t> Trace_Utils::_Heads[portNUM_PROCESSORS];
+std::atomic<bool> Trace_Utils::_Paused(false);
+
+void Trace_Utils::record(Trace_Event_ID eventID, Trace_Phase phase, uint32_t arg)
+{
+    if (_Paused.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    // A task can migrate cores after reading the core ID. The slot is still claimed atomically, so this only costs ordering.
+    uint8_t core = xPortGetCoreID();
+    uint32_t claim = _Heads[core].fetch_add(1, std::memory_order_relaxed);
+
+    // Readers skip the slot until the sequence is stored again
+    Trace_Record &event = _Buffers[core][claim % TRACE_EVENTS_PER_CORE];
+    __atomic_store_n(&event.sequence, 0, __ATOMIC_RELAXED);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.timestampUS = (uint32_t)esp_timer_get_time();
+    event.task = (uint32_t)xTaskGetCurrentTaskHandle();
+    event.arg = arg;
+    event.eventID = eventID;
+    event.phase = phase;
+    event.core = core;
+
+    __atomic_store_n(&event.sequence, claim + 1, __ATOMIC_RELEASE);
+}
+
+void Trace_Utils::setPaused(bool paused)
+{
+    _Paused = paused;
+}
+
+void Trace_Utils::clear()
+{
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        _Heads[core] = 0;
+
+        // Claims start again from 0, so old sequences would pass for new records
+        for (Trace_Record &event : _Buffers[core])
+        {
+            __atomic_store_n(&event.sequence, 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+size_t Trace_Utils::eventCount(uint8_t core)
+{
+    return min(_Heads[core].load(), (uint32_t)TRACE_EVENTS_PER_CORE);
+}
+
+bool Trace_Utils::copyEvent(uint8_t core, size_t index, Trace_Record &event)
+{
+    uint32_t head = _Heads[core].load();
+    uint32_t claim = head - min(head, (uint32_t)TRACE_EVENTS_PER_CORE) + index;
+    const Trace_Record &slot = _Buffers[core][claim % TRACE_EVENTS_PER_CORE];
+
+    // Still being written, or already overwritten by a writer that claimed the slot again
+    if (__atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE) != claim + 1)
+    {
+        return false;
+    }
+
+    memcpy(&event, &slot, sizeof(Trace_Record));
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return __atomic_load_n(&slot.sequence, __ATOMIC_RELAXED) == claim + 1;
+}
+
+bool Trace_Utils::nextEvent(size_t positions[portNUM_PROCESSORS], Trace_Record &event, size_t &skipped)
+{
+    Trace_Record candidates[portNUM_PROCESSORS];
+    int oldestCore = -1;
+
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        size_t count = eventCount(core);
+
+        while (positions[core] < count && !copyEvent(core, positions[core], candidates[core]))
+        {
+            positions[core]++;
+            skipped++;
+        }
+
+        if (positions[core] >= count)
+        {
+            continue;
+        }
+
+        // Compared as a signed difference so the order survives the microsecond clock wrapping
+        if (oldestCore == -1 || (int32_t)(candidates[core].timestampUS - candidates[oldestCore].timestampUS) < 0)
+        {
+            oldestCore = core;
+        }
+    }
+
+    if (oldestCore == -1)
+    {
+        return false;
+    }
+
+    event = candidates[oldestCore];
+    positions[oldestCore]++;
+    return true;
+}
+
+void Trace_Utils::GetTraceRpc(JsonDocument &doc)
+{
+    size_t offset = doc["offset"] | 0;
+    size_t count = doc["count"] | TRACE_DEFAULT_DUMP_COUNT;
+    bool hold = doc["hold"] | false;
+    bool clearLog = doc["clear"] | false;
+    bool chromeFormat = doc["format"] == "chrome";
+    doc.clear();
+
+    // Stop recording while reading. Writers that claimed a slot before the pause may still be filling it,
+    // and those records are skipped.
+    setPaused(true);
+
+    size_t total = 0;
+
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        total += eventCount(core);
+    }
+
+    doc["total"] = total;
+    JsonArray events = doc.createNestedArray(chromeFormat ? "traceEvents" : "events");
+
+    // Pages are cut from the merged order, so every page walks the merge from the oldest event
+    size_t positions[portNUM_PROCESSORS] = {};
+    size_t skipped = 0;
+    Trace_Record event;
+
+    for (size_t i = 0; i < offset + count && nextEvent(positions, event, skipped); i++)
+    {
+        if (i < offset)
+        {
+            continue;
+        }
+
+        if (chromeFormat)
+        {
+            JsonObject traceEvent = events.createNestedObject();
+            traceEvent["name"] = EventName(event.eventID);
+            traceEvent["ph"] = String(PHASE_CHARS[event.phase < sizeof(PHASE_CHARS) ? event.phase : TRACE_PHASE_INSTANT]);
+            traceEvent["ts"] = event.timestampUS;
+            traceEvent["pid"] = event.core;
+            traceEvent["tid"] = event.task;
+            traceEvent["args"]["arg"] = event.arg;
+            traceEvent["args"]["seq"] = event.sequence;
+        }
+        else
+        {
+            // [timestamp us, core, task, event ID, phase, arg, sequence]
+            JsonArray compact = events.createNestedArray();
+            compact.add(event.timestampUS);
+            compact.add(event.core);
+            compact.add(event.task);
+            compact.add(event.eventID);
+            compact.add(event.phase);
+            compact.add(event.arg);
+            compact.add(event.sequence);
+        }
+    }
+
+    // Incomplete records passed over up to the end of this page
+    doc["skipped"] = skipped;
+
+    // Task and event names are sent with the first page
+    if (offset == 0)
+    {
+        if (!chromeFormat)
+        {
+            JsonArray names = doc.createNestedArray("names");
+
+            for (uint16_t id = 0; id < NUM_TRACE_EVENTS; id++)
+            {
+                names.add(EventName(id));
+            }
+        }
+
+        #if configUSE_TRACE_FACILITY == 1
+        UBaseType_t numTasks = uxTaskGetNumberOfTasks() + 2;
+        std::unique_ptr<TaskStatus_t[]> tasks(new TaskStatus_t[numTasks]);
+        numTasks = uxTaskGetSystemState(tasks.get(), numTasks, nullptr);
+
+        JsonObject taskNames = doc.createNestedObject("tasks");
+
+        for (UBaseType_t i = 0; i < numTasks; i++)
+        {
+            taskNames[String((uint32_t)tasks[i].xHandle)] = tasks[i].pcTaskName;
+        }
+        #endif
+    }
+
+    if (clearLog)
+    {
+        clear();
+    }
+
+    setPaused(hold);
+}
+
+#else
+
+void Trace_Utils::record(Trace_Event_ID eventID, Trace_Phase phase, uint32_t arg) {}
+void Trace_Utils::setPaused(bool paused) {}
+void Trace_Utils::clear() {}
+
+void Trace_Utils::GetTraceRpc(JsonDocument &doc)
+{
+    doc.clear();
+    doc["error"] = "Tracing not compiled in. Build with TRACE_ENABLED=1";
+}
+
+#endif
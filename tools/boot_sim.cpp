@@ -0,0 +1,520 @@
+/*
+    Runs the boot module graph the way Boot_Utils::run() does and checks the claim and skip logic under real
+    concurrency, and estimates boot time for a graph.
+
+        g++ -O2 -Wall -pthread -I host -I ../include/Utilities boot_sim.cpp -o boot_sim
+        ./boot_sim [graph.txt]
+
+    Claiming and skipping is the real Boot_Graph that Boot_Utils keeps its modules in. Two runner threads
+    stand in for setup() on core 1 and the boot worker on core 0, and loop as Boot_Utils::runModules does,
+    waiting on a counting wakeup in place of a task notification. Each module's init sleeps for its latency,
+    as most of boot is waiting on flash, radios and sensors.
+
+    The graph has one module per line in registration order: name, latency in ms, the core it is pinned to
+    or * for either, and the names of modules listed earlier that it depends on. A latency ending in ! fails
+    the module. Without a file the firmware's graph is used:
+
+        System      15   *
+        Filesystem  180  *  System
+        Display     70   1  Filesystem
+
+    Latencies can be taken from durationUS in a GetBootTimingsRpc response to replay a device's boot against
+    a different graph.
+
+    The graph is run with both runners and then with setup() alone, as when the worker cannot start, and
+    then a few hundred random graphs with short latencies, pinned modules and failures. Every run must end,
+    run each module at most once and only after its dependencies finished, keep pinned modules on their core,
+    and skip exactly the modules below a failure. Exits with 1 on any failure.
+*/
+
+#include "Boot_Graph.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// setup() runs on core 1 and the worker on the other
+#define CALLER_CORE 1
+#define WORKER_CORE 0
+
+#define RANDOM_GRAPHS 400
+
+// A run that has not ended by then is stuck
+#define RUN_TIMEOUT_MS 10000
+
+typedef std::chrono::steady_clock Clock;
+
+struct Sim_Module
+{
+    std::string name;
+    uint32_t latencyUS;
+    int8_t core;
+    bool fails;
+    uint32_t dependencies;
+};
+
+// What a run did to each module
+struct Sim_Record
+{
+    std::atomic<int> calls{0};
+    int8_t core = -1;
+    Clock::time_point start;
+    Clock::time_point end;
+};
+
+// The firmware's modules and their dependencies, with typical latencies
+static const char *DEFAULT_GRAPH = R"(
+    System      15   *
+    Filesystem  180  *  System
+    LED         25   *  System
+    Settings    40   *  Filesystem
+    LoRa        120  *  Settings
+    Navigation  210  *  Filesystem
+    Bluetooth   90   *  Settings
+    Display     70   1  LoRa Navigation LED
+)";
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what, long value = 0)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL %s (%ld)\n", what, value);
+        failures++;
+    }
+}
+
+static bool parseGraph(const char *text, std::vector<Sim_Module> &modules)
+{
+    const char *line = text;
+
+    while (*line)
+    {
+        const char *lineEnd = strchr(line, '\n');
+        std::string content(line, lineEnd ? lineEnd - line : strlen(line));
+        line = lineEnd ? lineEnd + 1 : line + content.size();
+
+        std::vector<std::string> words;
+        char *save = nullptr;
+
+        for (char *word = strtok_r(&content[0], " \t\r", &save); word != nullptr && word[0] != '#'; word = strtok_r(nullptr, " \t\r", &save))
+        {
+            words.push_back(word);
+        }
+
+        if (words.empty())
+        {
+            continue;
+        }
+
+        if (words.size() < 3 || modules.size() >= BOOT_MAX_MODULES)
+        {
+            fprintf(stderr, "Bad module line: %s\n", words[0].c_str());
+            return false;
+        }
+
+        Sim_Module module;
+        module.name = words[0];
+        module.latencyUS = (uint32_t)(strtod(words[1].c_str(), nullptr) * 1000);
+        module.fails = words[1].back() == '!';
+        module.core = words[2] == "*" ? BOOT_ANY_CORE : atoi(words[2].c_str());
+        module.dependencies = 0;
+
+        for (size_t w = 3; w < words.size(); w++)
+        {
+            size_t d = 0;
+
+            while (d < modules.size() && modules[d].name != words[w])
+            {
+                d++;
+            }
+
+            if (d == modules.size())
+            {
+                fprintf(stderr, "%s depends on %s, which is not listed before it\n", module.name.c_str(), words[w].c_str());
+                return false;
+            }
+
+            module.dependencies |= 1UL << d;
+        }
+
+        modules.push_back(module);
+    }
+
+    return !modules.empty();
+}
+
+// A runner's task notification: gives count up, a take waits for one and clears them all, as ulTaskNotifyTake(pdTRUE)
+struct Sim_Runner
+{
+    int8_t core;
+    std::mutex lock;
+    std::condition_variable wake;
+    uint32_t notifications = 0;
+
+    void give()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        notifications++;
+        wake.notify_one();
+    }
+
+    void take()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        wake.wait(guard, [this]() { return notifications > 0; });
+        notifications = 0;
+    }
+};
+
+struct Sim_Run
+{
+    Boot_Graph graph;
+    std::mutex graphLock;
+    std::vector<Sim_Runner *> runners;
+    std::vector<Sim_Record> records;
+
+    std::atomic<int> running{0};
+    std::atomic<int> mostRunning{0};
+    Clock::time_point start;
+
+    Sim_Run(size_t numModules) : records(numModules) {}
+
+    void wakeRunners(Sim_Runner *self)
+    {
+        for (Sim_Runner *runner : runners)
+        {
+            if (runner != self)
+            {
+                runner->give();
+            }
+        }
+    }
+
+    // As Boot_Utils::runModules, claimModule and finishModule
+    void runModules(Sim_Runner *self)
+    {
+        while (true)
+        {
+            int moduleID;
+
+            {
+                std::lock_guard<std::mutex> guard(graphLock);
+                moduleID = graph.claim(self->core);
+            }
+
+            if (moduleID == BOOT_ALL_FINISHED)
+            {
+                wakeRunners(self);
+                return;
+            }
+
+            if (moduleID == BOOT_NONE_READY)
+            {
+                self->take();
+                continue;
+            }
+
+            Sim_Record &record = records[moduleID];
+            record.calls++;
+            record.core = self->core;
+
+            int nowRunning = ++running;
+            int seen = mostRunning.load();
+
+            while (nowRunning > seen && !mostRunning.compare_exchange_weak(seen, nowRunning))
+            {
+            }
+
+            record.start = Clock::now();
+            bool success = graph.modules[moduleID].init();
+            record.end = Clock::now();
+            running--;
+
+            {
+                std::lock_guard<std::mutex> guard(graphLock);
+                graph.finish(moduleID, success);
+            }
+
+            wakeRunners(self);
+        }
+    }
+};
+
+static double elapsedMS(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// Runs the graph with both runners, or with the caller alone. Returns the wall time in ms.
+static double simulate(const std::vector<Sim_Module> &modules, bool withWorker, bool print)
+{
+    Sim_Run run(modules.size());
+
+    for (const Sim_Module &module : modules)
+    {
+        uint32_t latencyUS = module.latencyUS;
+        bool fails = module.fails;
+
+        run.graph.add(module.name.c_str(), [latencyUS, fails]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(latencyUS));
+            return !fails;
+        }, module.dependencies, module.core);
+    }
+
+    Sim_Runner caller;
+    Sim_Runner worker;
+    caller.core = withWorker ? CALLER_CORE : BOOT_ANY_CORE;
+    worker.core = WORKER_CORE;
+
+    run.runners.push_back(&caller);
+
+    if (withWorker)
+    {
+        run.runners.push_back(&worker);
+    }
+
+    std::mutex doneLock;
+    std::condition_variable doneWake;
+    bool done = false;
+
+    run.start = Clock::now();
+
+    std::thread runnerThreads[2];
+
+    for (size_t r = 0; r < run.runners.size(); r++)
+    {
+        runnerThreads[r] = std::thread([&, r]() { run.runModules(run.runners[r]); });
+    }
+
+    std::thread waiter([&]() {
+        for (size_t r = 0; r < run.runners.size(); r++)
+        {
+            runnerThreads[r].join();
+        }
+
+        std::lock_guard<std::mutex> guard(doneLock);
+        done = true;
+        doneWake.notify_one();
+    });
+
+    {
+        std::unique_lock<std::mutex> guard(doneLock);
+
+        if (!doneWake.wait_for(guard, std::chrono::milliseconds(RUN_TIMEOUT_MS), [&]() { return done; }))
+        {
+            fprintf(stderr, "FAIL run of %zu modules did not end\n", modules.size());
+            exit(1);
+        }
+    }
+
+    waiter.join();
+    double wallMS = elapsedMS(run.start, Clock::now());
+
+    // Expected end state: failed where init fails, skipped below any failure or skip, done otherwise
+    uint32_t notDone = 0;
+
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        const Sim_Module &module = modules[i];
+        const Sim_Record &record = run.records[i];
+        Boot_Module_State state = run.graph.modules[i].state;
+
+        if (module.dependencies & notDone)
+        {
+            check(state == BOOT_MODULE_SKIPPED, "module below a failure was not skipped", i);
+            check(record.calls == 0, "skipped module ran", i);
+            notDone |= 1UL << i;
+            continue;
+        }
+
+        check(record.calls == 1, "module did not run exactly once", i * 100 + record.calls);
+        check(state == (module.fails ? BOOT_MODULE_FAILED : BOOT_MODULE_DONE), "module state", i * 100 + state);
+
+        if (module.fails)
+        {
+            notDone |= 1UL << i;
+        }
+
+        if (withWorker && module.core != BOOT_ANY_CORE)
+        {
+            check(record.core == module.core, "pinned module ran on the other core", i);
+        }
+
+        for (size_t d = 0; d < i; d++)
+        {
+            if (module.dependencies & (1UL << d))
+            {
+                check(record.start >= run.records[d].end, "module started before a dependency finished", i * 100 + d);
+            }
+        }
+    }
+
+    check(run.mostRunning.load() <= (int)run.runners.size(), "more modules ran at once than runners", run.mostRunning.load());
+    check(run.graph.succeeded() == (notDone == 0), "succeeded() does not match the module states", notDone);
+
+    if (print)
+    {
+        printf("%s\n\n", withWorker ? "setup() and the worker" : "setup() alone");
+        printf("%-20s %4s %9s %9s  %s\n", "module", "core", "start ms", "end ms", "state");
+
+        for (size_t i = 0; i < modules.size(); i++)
+        {
+            const Sim_Record &record = run.records[i];
+
+            if (record.calls > 0)
+            {
+                printf("%-20s %4d %9.1f %9.1f  %s\n", modules[i].name.c_str(), record.core, elapsedMS(run.start, record.start),
+                       elapsedMS(run.start, record.end), modules[i].fails ? "failed" : "done");
+            }
+            else
+            {
+                printf("%-20s %4s %9s %9s  skipped\n", modules[i].name.c_str(), "-", "-", "-");
+            }
+        }
+
+        printf("\n");
+    }
+
+    return wallMS;
+}
+
+// Longest chain of latencies through the dependencies, which no number of cores can beat
+static double criticalPathMS(const std::vector<Sim_Module> &modules)
+{
+    std::vector<double> finishMS(modules.size());
+    double longest = 0;
+
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        double startMS = 0;
+
+        for (size_t d = 0; d < i; d++)
+        {
+            if (modules[i].dependencies & (1UL << d))
+            {
+                startMS = max(startMS, finishMS[d]);
+            }
+        }
+
+        finishMS[i] = startMS + modules[i].latencyUS / 1000.0;
+        longest = max(longest, finishMS[i]);
+    }
+
+    return longest;
+}
+
+static uint32_t randomState = 0x9E3779B9;
+
+static uint32_t nextRandom()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static std::vector<Sim_Module> randomGraph()
+{
+    std::vector<Sim_Module> modules(1 + nextRandom() % BOOT_MAX_MODULES);
+
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        Sim_Module &module = modules[i];
+        module.name = "module " + std::to_string(i);
+        module.latencyUS = nextRandom() % 300;
+        module.fails = nextRandom() % 20 == 0;
+
+        uint32_t pin = nextRandom() % 5;
+        module.core = pin < 3 ? BOOT_ANY_CORE : pin - 3;
+
+        module.dependencies = 0;
+
+        for (size_t d = 0; d < i; d++)
+        {
+            if (nextRandom() % 4 == 0)
+            {
+                module.dependencies |= 1UL << d;
+            }
+        }
+    }
+
+    return modules;
+}
+
+int main(int argc, char **argv)
+{
+    std::string text = DEFAULT_GRAPH;
+
+    if (argc > 1)
+    {
+        FILE *file = fopen(argv[1], "r");
+
+        if (file == nullptr)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+
+        char buffer[256];
+        text.clear();
+
+        while (fgets(buffer, sizeof(buffer), file) != nullptr)
+        {
+            text += buffer;
+        }
+
+        fclose(file);
+    }
+
+    std::vector<Sim_Module> modules;
+
+    if (!parseGraph(text.c_str(), modules))
+    {
+        fprintf(stderr, "No modules in %s\n", argc > 1 ? argv[1] : "the default graph");
+        return 1;
+    }
+
+    double serialMS = 0;
+
+    for (const Sim_Module &module : modules)
+    {
+        serialMS += module.latencyUS / 1000.0;
+    }
+
+    double parallelMS = simulate(modules, true, true);
+    double aloneMS = simulate(modules, false, false);
+    double pathMS = criticalPathMS(modules);
+
+    printf("parallel:            %8.1f ms\n", parallelMS);
+    printf("setup() alone:       %8.1f ms\n", aloneMS);
+    printf("serial:              %8.1f ms\n", serialMS);
+    printf("critical path:       %8.1f ms\n", pathMS);
+
+    if (parallelMS > 0)
+    {
+        printf("speedup:             %8.2fx\n", serialMS / parallelMS);
+    }
+
+    check(parallelMS >= pathMS, "faster than the critical path", (long)parallelMS);
+    check(aloneMS >= serialMS, "setup() alone faster than serial", (long)aloneMS);
+
+    for (int g = 0; g < RANDOM_GRAPHS; g++)
+    {
+        std::vector<Sim_Module> graph = randomGraph();
+        simulate(graph, g % 4 != 0, false);
+    }
+
+    printf("random graphs:       %8d\n", RANDOM_GRAPHS);
+    printf("failures:            %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
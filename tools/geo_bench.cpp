@@ -0,0 +1,219 @@
+/*
+    Checks Geo_Projection against the great circle formulas and times both for a batch of targets.
+
+        g++ -O2 -I ../include/Utilities geo_bench.cpp -o geo_bench
+        ./geo_bench [numTargets] [seed]
+
+    Accuracy is checked the way NavigationUtils uses the projection: origins at latitudes up to 70 degrees,
+    the current fix up to GEO_PROJECTION_REFRESH_M from the origin and targets up to GEO_PROJECTION_RANGE_M
+    from it. Exits with 1 if any result is outside the limits below, so it can gate changes to Geo_Math.h.
+
+    Host timings only compare the two paths. The ESP32 has no double precision FPU, so the gap is wider there.
+*/
+
+#include "Geo_Math.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Distance error allowed, as a fraction of the distance, plus a fixed part for E7 rounding and float resolution
+#define MAX_DISTANCE_ERROR_FRACTION 0.0001
+#define MAX_DISTANCE_ERROR_M 0.05
+
+// Bearings to targets closer than this are not checked, as rounding to 1e-7 degrees dominates
+#define MIN_BEARING_DISTANCE_M 10.0
+#define MAX_BEARING_ERROR_DEG 0.01
+
+#define ACCURACY_CASES 200
+
+static double wrap180(double deg)
+{
+    deg = fmod(deg, 360.0);
+
+    if (deg > 180.0)
+    {
+        deg -= 360.0;
+    }
+    else if (deg < -180.0)
+    {
+        deg += 360.0;
+    }
+
+    return deg;
+}
+
+// Point at distance and bearing from lat, lng on the sphere
+static Geo_Point_E7 destination(double lat, double lng, double distanceM, double bearingDeg)
+{
+    double angular = distanceM / GEO_EARTH_RADIUS_M;
+    double bearing = bearingDeg * M_PI / 180.0;
+    double lat1 = lat * M_PI / 180.0;
+    double lng1 = lng * M_PI / 180.0;
+
+    double lat2 = asin(sin(lat1) * cos(angular) + cos(lat1) * sin(angular) * cos(bearing));
+    double lng2 = lng1 + atan2(sin(bearing) * sin(angular) * cos(lat1), cos(angular) - sin(lat1) * sin(lat2));
+
+    double lngDeg = wrap180(lng2 * 180.0 / M_PI);
+    return Geo_Math::toE7(lat2 * 180.0 / M_PI, lngDeg);
+}
+
+struct Scenario
+{
+    Geo_Projection projection;
+    Geo_Point_E7 fix;
+    std::vector<Geo_Point_E7> targets;
+};
+
+static Scenario makeScenario(std::mt19937 &rng, size_t numTargets, double maxTargetM)
+{
+    std::uniform_real_distribution<double> latitude(-70.0, 70.0);
+    std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+    std::uniform_real_distribution<double> bearing(0.0, 360.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    double originLat = latitude(rng);
+    double originLng = longitude(rng);
+
+    Scenario scenario;
+    scenario.projection.setOrigin(Geo_Math::toE7(originLat, originLng));
+    scenario.fix = destination(originLat, originLng, unit(rng) * GEO_PROJECTION_REFRESH_M, bearing(rng));
+
+    double fixLat = Geo_Math::toDegrees(scenario.fix.latE7);
+    double fixLng = Geo_Math::toDegrees(scenario.fix.lngE7);
+
+    for (size_t i = 0; i < numTargets; i++)
+    {
+        // Spread over orders of magnitude, since nearby targets matter most on the ring
+        double distance = pow(10.0, unit(rng) * log10(maxTargetM));
+        scenario.targets.push_back(destination(fixLat, fixLng, distance, bearing(rng)));
+    }
+
+    return scenario;
+}
+
+static int checkAccuracy(std::mt19937 &rng, size_t numTargets)
+{
+    double worstFraction = 0;
+    double worstDistanceM = 0;
+    double worstBearingDeg = 0;
+    size_t failures = 0;
+    size_t projected = 0;
+    size_t checked = 0;
+
+    // Keep targets inside the projection range however far the fix is from the origin
+    double maxTargetM = GEO_PROJECTION_RANGE_M - GEO_PROJECTION_REFRESH_M;
+
+    for (int c = 0; c < ACCURACY_CASES; c++)
+    {
+        Scenario scenario = makeScenario(rng, numTargets, maxTargetM);
+        std::vector<Geo_Vector> vectors(numTargets);
+        scenario.projection.vectorsTo(scenario.fix, scenario.targets.data(), numTargets, vectors.data());
+
+        for (size_t i = 0; i < numTargets; i++)
+        {
+            Geo_Vector reference = Geo_Math::greatCircle(scenario.fix, scenario.targets[i]);
+
+            float east;
+            float north;
+            scenario.projection.project(scenario.targets[i], east, north);
+            projected += scenario.projection.inRange(east, north);
+
+            double distanceError = fabs((double)vectors[i].distanceM - reference.distanceM);
+            double allowed = reference.distanceM * MAX_DISTANCE_ERROR_FRACTION + MAX_DISTANCE_ERROR_M;
+            bool failed = distanceError > allowed;
+
+            if (reference.distanceM > 1.0)
+            {
+                double fraction = distanceError / reference.distanceM;
+                worstFraction = fraction > worstFraction ? fraction : worstFraction;
+            }
+
+            worstDistanceM = distanceError > worstDistanceM ? distanceError : worstDistanceM;
+
+            if (reference.distanceM > MIN_BEARING_DISTANCE_M)
+            {
+                double bearingError = fabs(wrap180((double)vectors[i].bearingDeg - reference.bearingDeg));
+                worstBearingDeg = bearingError > worstBearingDeg ? bearingError : worstBearingDeg;
+                failed |= bearingError > MAX_BEARING_ERROR_DEG;
+            }
+
+            failures += failed;
+            checked++;
+        }
+    }
+
+    printf("accuracy, %zu targets, %zu projected:\n", checked, projected);
+    printf("  worst distance error:  %.3f m, %.4f%% of distance\n", worstDistanceM, worstFraction * 100);
+    printf("  worst bearing error:   %.4f deg\n", worstBearingDeg);
+    printf("  outside limits:        %zu\n\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
+
+static void benchmark(std::mt19937 &rng, size_t numTargets)
+{
+    Scenario scenario = makeScenario(rng, numTargets, GEO_PROJECTION_RANGE_M / 2);
+    std::vector<Geo_Vector> vectors(numTargets);
+
+    const int rounds = 2000;
+    volatile float sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < rounds; r++)
+    {
+        double fixLat = Geo_Math::toDegrees(scenario.fix.latE7);
+        double fixLng = Geo_Math::toDegrees(scenario.fix.lngE7);
+
+        for (size_t i = 0; i < numTargets; i++)
+        {
+            double lat = Geo_Math::toDegrees(scenario.targets[i].latE7);
+            double lng = Geo_Math::toDegrees(scenario.targets[i].lngE7);
+
+            vectors[i].distanceM = Geo_Math::distanceBetween(fixLat, fixLng, lat, lng);
+            vectors[i].bearingDeg = Geo_Math::courseTo(fixLat, fixLng, lat, lng);
+        }
+
+        sink = sink + vectors[r % numTargets].distanceM;
+    }
+
+    auto reference = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < rounds; r++)
+    {
+        scenario.projection.vectorsTo(scenario.fix, scenario.targets.data(), numTargets, vectors.data());
+        sink = sink + vectors[r % numTargets].distanceM;
+    }
+
+    auto batch = std::chrono::steady_clock::now() - start;
+
+    double referenceUS = std::chrono::duration<double, std::micro>(reference).count() / rounds;
+    double batchUS = std::chrono::duration<double, std::micro>(batch).count() / rounds;
+
+    printf("%zu targets, per batch on this host:\n", numTargets);
+    printf("  great circle, double:  %8.1f us\n", referenceUS);
+    printf("  projected batch:       %8.1f us  (%.1fx)\n", batchUS, referenceUS / batchUS);
+}
+
+int main(int argc, char **argv)
+{
+    size_t numTargets = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000;
+    unsigned seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+
+    if (numTargets == 0)
+    {
+        fprintf(stderr, "usage: %s [numTargets] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 rng(seed);
+
+    int result = checkAccuracy(rng, numTargets < 100 ? numTargets : 100);
+    benchmark(rng, numTargets);
+
+    return result;
+}
@@ -0,0 +1,329 @@
+/*
+    Hammers the GPS fix seqlock from reader threads while a writer publishes, and checks no reader ever gets a
+    torn fix.
+
+        g++ -O2 -Wall -pthread -I host -I ../include/Utilities gps_fix_test.cpp -o gps_fix_test
+        ./gps_fix_test [seconds] [readers]
+
+    The lock is the real Seqlock<GPS_Fix> that NavigationUtils::GetFix reads and publishFix writes, over the host
+    portMUX. The writer publishes fixes as fast as it can, every field worked out from a counter, so a reader
+    can tell whether all of a fix came from the same write. Readers check every field, that the counter never
+    goes backwards and that they keep getting through while the writer runs.
+
+    With a copy of TinyGPS++, the writer instead parses a generated NMEA stream of GGA and RMC sentences with
+    TinyGPSPlus and publishes GPS_Fix::FromParser after each complete sentence, as the GPS task does. That
+    reports sentences and bytes parsed per second against a 9600 baud GPS, and checks every sentence passed
+    its checksum and that each fix's position belongs to its time:
+
+        g++ -O2 -Wall -pthread -DARDUINO=100 -DGPS_FIX_TEST_TINYGPS -I host -I ../include/Utilities \
+            -I $TINYGPS/src gps_fix_test.cpp $TINYGPS/src/TinyGPS++.cpp -o gps_fix_test
+
+    where $TINYGPS is a checkout of mikalhart/TinyGPSPlus. Exits with 1 on any failure.
+*/
+
+#include "GPS_Fix.h"
+#include "Seqlock.h"
+
+#ifdef GPS_FIX_TEST_TINYGPS
+#include "TinyGPS++.h"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// UART rate of the GPS module, 8N1
+#define GPS_BAUD 9600
+
+typedef std::chrono::steady_clock Clock;
+
+static Seqlock<GPS_Fix> fixes;
+static std::atomic<bool> writing(true);
+
+struct Reader_Result
+{
+    uint64_t reads = 0;
+    uint64_t torn = 0;
+    uint64_t backwards = 0;
+    uint32_t distinct = 0;
+};
+
+#ifndef GPS_FIX_TEST_TINYGPS
+
+// Every field of fix n, so a mix of two writes is caught
+static GPS_Fix counterFix(uint32_t n)
+{
+    GPS_Fix fix = {};
+
+    fix.latitude = 47.0 + n * 1e-7;
+    fix.longitude = -122.0 - n * 1e-7;
+    fix.time = n;
+    fix.date = n * 3;
+    fix.hdop = (n % 1000) / 10.0f;
+    fix.speedKmph = n % 500;
+    fix.courseDeg = n % 360;
+    fix.satellites = n % 256;
+    fix.locationValid = true;
+    fix.timeValid = n & 1;
+    fix.dateValid = n & 2;
+    fix.courseValid = n & 4;
+    fix.locationMS = n * 7;
+    fix.passedChecksums = n;
+    fix.failedChecksums = ~n;
+
+    return fix;
+}
+
+static bool counterFixIntact(const GPS_Fix &fix)
+{
+    // Readers can start before the first write
+    if (fix.time == 0)
+    {
+        return fix.latitude == 0 && fix.longitude == 0 && fix.date == 0 && !fix.locationValid &&
+               fix.passedChecksums == 0 && fix.failedChecksums == 0;
+    }
+
+    GPS_Fix expected = counterFix(fix.time);
+
+    return fix.latitude == expected.latitude && fix.longitude == expected.longitude && fix.date == expected.date &&
+           fix.hdop == expected.hdop && fix.speedKmph == expected.speedKmph && fix.courseDeg == expected.courseDeg &&
+           fix.satellites == expected.satellites && fix.locationValid == expected.locationValid &&
+           fix.timeValid == expected.timeValid && fix.dateValid == expected.dateValid &&
+           fix.courseValid == expected.courseValid && fix.locationMS == expected.locationMS &&
+           fix.passedChecksums == expected.passedChecksums && fix.failedChecksums == expected.failedChecksums;
+}
+
+#else
+
+// Second of the day of a TinyGPS hhmmsscc time
+static uint32_t secondOfDay(uint32_t time)
+{
+    return (time / 1000000) * 3600 + ((time / 10000) % 100) * 60 + (time / 100) % 100;
+}
+
+// Latitude minutes of the sentences for a second, so a reader can check a fix's position against its time
+static double latitudeMinutes(uint32_t second)
+{
+    return 10.0 + (second % 1000) * 0.01;
+}
+
+static bool nmeaFixIntact(const GPS_Fix &fix)
+{
+    if (!fix.locationValid || !fix.timeValid)
+    {
+        return true;
+    }
+
+    double expected = 47.0 + latitudeMinutes(secondOfDay(fix.time)) / 60.0;
+    return fabs(fix.latitude - expected) < 1e-6;
+}
+
+static size_t appendSentence(char *out, const char *body)
+{
+    uint8_t checksum = 0;
+
+    for (const char *c = body; *c; c++)
+    {
+        checksum ^= *c;
+    }
+
+    return sprintf(out, "$%s*%02X\r\n", body, checksum);
+}
+
+// GGA then RMC for a second of the day
+static size_t nmeaSecond(uint32_t second, char *out)
+{
+    char time[16];
+    char latitude[16];
+    char body[128];
+
+    sprintf(time, "%02u%02u%02u.00", second / 3600, (second / 60) % 60, second % 60);
+    sprintf(latitude, "47%08.5f", latitudeMinutes(second));
+
+    size_t length = 0;
+
+    sprintf(body, "GPGGA,%s,%s,N,12218.00000,W,1,08,0.9,45.4,M,-17.0,M,,", time, latitude);
+    length += appendSentence(out + length, body);
+
+    sprintf(body, "GPRMC,%s,A,%s,N,12218.00000,W,0.5,54.7,191026,,,A", time, latitude);
+    length += appendSentence(out + length, body);
+
+    return length;
+}
+
+#endif
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    int numReaders = argc > 2 ? atoi(argv[2]) : 4;
+
+    if (seconds <= 0 || numReaders <= 0)
+    {
+        fprintf(stderr, "usage: %s [seconds] [readers]\n", argv[0]);
+        return 1;
+    }
+
+    size_t failures = 0;
+
+    // Before any write a reader gets an empty fix
+    GPS_Fix empty = fixes.read();
+
+    if (empty.isValid() || empty.time != 0 || fixes.Writes() != 0)
+    {
+        fprintf(stderr, "FAIL: fix not empty before the first write\n");
+        failures++;
+    }
+
+#ifdef GPS_FIX_TEST_TINYGPS
+    bool (*intact)(const GPS_Fix &) = nmeaFixIntact;
+    const char *writerName = "TinyGPSPlus, NMEA";
+#else
+    bool (*intact)(const GPS_Fix &) = counterFixIntact;
+    const char *writerName = "counter";
+#endif
+
+    std::vector<Reader_Result> results(numReaders);
+    std::vector<std::thread> readers;
+
+    for (int r = 0; r < numReaders; r++)
+    {
+        readers.emplace_back([&, r]() {
+            Reader_Result &result = results[r];
+            uint32_t lastWrite = 0;
+            uint32_t lastTime = 0;
+
+            while (writing.load(std::memory_order_relaxed))
+            {
+                uint32_t writesBefore = fixes.Writes();
+                GPS_Fix fix = fixes.read();
+                result.reads++;
+
+                if (!intact(fix))
+                {
+                    result.torn++;
+                }
+
+                // Fixes only move forward, though a reader can see the same one twice
+                if (writesBefore < lastWrite || fix.time < lastTime)
+                {
+                    result.backwards++;
+                }
+
+                if (fix.time != lastTime)
+                {
+                    result.distinct++;
+                }
+
+                lastWrite = writesBefore;
+                lastTime = fix.time;
+            }
+        });
+    }
+
+    auto start = Clock::now();
+    auto end = start + std::chrono::duration<double>(seconds);
+
+#ifdef GPS_FIX_TEST_TINYGPS
+    TinyGPSPlus gps;
+    char stream[256];
+    uint64_t bytesParsed = 0;
+    uint64_t sentences = 0;
+
+    // Stops at midnight rather than wrapping, as fix times must not go backwards
+    for (uint32_t second = 0; second < 86400 && Clock::now() < end; second++)
+    {
+        size_t length = nmeaSecond(second, stream);
+
+        for (size_t i = 0; i < length; i++)
+        {
+            if (gps.encode(stream[i]))
+            {
+                fixes.write(GPS_Fix::FromParser(gps));
+                sentences++;
+            }
+        }
+
+        bytesParsed += length;
+    }
+#else
+    uint32_t n = 1;
+
+    for (; Clock::now() < end; n++)
+    {
+        fixes.write(counterFix(n));
+    }
+#endif
+
+    writing = false;
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    for (std::thread &reader : readers)
+    {
+        reader.join();
+    }
+
+    GPS_Fix last = fixes.read();
+    uint64_t reads = 0;
+    uint64_t torn = 0;
+    uint64_t backwards = 0;
+
+    for (int r = 0; r < numReaders; r++)
+    {
+        reads += results[r].reads;
+        torn += results[r].torn;
+        backwards += results[r].backwards;
+
+        // The writer must not starve a reader
+        if (results[r].distinct < 2)
+        {
+            fprintf(stderr, "FAIL: reader %d saw %u distinct fixes\n", r, results[r].distinct);
+            failures++;
+        }
+    }
+
+    if (torn > 0)
+    {
+        fprintf(stderr, "FAIL: %llu torn fixes\n", (unsigned long long)torn);
+        failures++;
+    }
+
+    if (backwards > 0)
+    {
+        fprintf(stderr, "FAIL: %llu reads went backwards\n", (unsigned long long)backwards);
+        failures++;
+    }
+
+    printf("%.1f s, %d readers, writer: %s\n\n", elapsed.count(), numReaders, writerName);
+    printf("fixes written:       %10u, %.0f per second\n", fixes.Writes(), fixes.Writes() / elapsed.count());
+    printf("fixes read:          %10llu, %.0f per second\n", (unsigned long long)reads, reads / elapsed.count());
+
+#ifdef GPS_FIX_TEST_TINYGPS
+    double bytesPerSecond = bytesParsed / elapsed.count();
+
+    printf("sentences parsed:    %10llu, %.0f per second\n", (unsigned long long)sentences, sentences / elapsed.count());
+    printf("bytes parsed:        %10.0f per second, %.0fx a %d baud GPS\n", bytesPerSecond, bytesPerSecond / (GPS_BAUD / 10), GPS_BAUD);
+
+    if (last.failedChecksums != 0 || last.passedChecksums != sentences)
+    {
+        fprintf(stderr, "FAIL: %u sentences passed and %u failed their checksum, of %llu\n", last.passedChecksums,
+                last.failedChecksums, (unsigned long long)sentences);
+        failures++;
+    }
+#else
+    if (last.time != n - 1)
+    {
+        fprintf(stderr, "FAIL: last read is fix %u of %u\n", last.time, n - 1);
+        failures++;
+    }
+#endif
+
+    printf("torn fixes:          %10llu\n", (unsigned long long)torn);
+    printf("failures:            %10zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,364 @@
+/*
+    Replays a sensor trace through Heading_Filter and reports how far the output is from the truth, and what
+    each update costs on the host.
+
+        g++ -O2 -I ../include/Utilities heading_replay.cpp -o heading_replay
+        ./heading_replay [trace.csv|-] [magTimeConstantS] [gpsMaxWeight] [maxRmsDeg]
+        ./heading_replay --generate > trace.csv
+
+    Without a trace, or with -, it replays a generated one: a compass sampled every HEADING_SAMPLE_PERIOD_MS
+    while standing, walking and riding, with turns that cross north. The compass reads the truth plus a
+    heading dependent bias, noise and the odd spike, and the GPS course updates once a second while moving.
+    The generator is seeded, so every run sees the same trace. --generate prints it in the trace format.
+
+    The trace has one sample per line, with an optional header line:
+
+        t_ms,mag_deg,course_deg,speed_kmph,course_valid,truth_deg
+
+    truth_deg may be left empty where it is unknown. Those samples are filtered but not scored.
+
+    Exits with 1 if the filtered heading's RMS error is above maxRmsDeg, 6.5 by default, or no better than
+    the raw compass, or if the filtered heading steps more than the raw one.
+*/
+
+#include "Heading_Filter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Compass and GPS rates of Heading_Utils and the GPS module
+#define TRACE_SAMPLE_PERIOD_MS 50
+#define TRACE_GPS_PERIOD_MS 1000
+
+// Default pass threshold of the filtered heading's RMS error. On the generated trace the compass bias while
+// standing, which no GPS course can correct, leaves about 6 degrees, and without the GPS blend it is about 7.
+#define DEFAULT_MAX_RMS_DEG 6.5
+
+struct Trace_Sample
+{
+    double tMS;
+    float magDeg;
+    float courseDeg;
+    float speedKmph;
+    bool courseValid;
+    bool hasTruth;
+    float truthDeg;
+};
+
+struct Error_Stats
+{
+    double sumSquares = 0;
+    double maxError = 0;
+    size_t count = 0;
+
+    void add(float error)
+    {
+        error = fabsf(error);
+        sumSquares += (double)error * error;
+        maxError = error > maxError ? error : maxError;
+        count++;
+    }
+
+    double rms() const { return count ? sqrt(sumSquares / count) : 0; }
+};
+
+static bool parseLine(char *line, Trace_Sample &sample)
+{
+    char *fields[6] = {};
+    size_t numFields = 0;
+
+    for (char *field = line; field != nullptr && numFields < 6; numFields++)
+    {
+        fields[numFields] = field;
+        field = strchr(field, ',');
+
+        if (field != nullptr)
+        {
+            *field++ = '\0';
+        }
+    }
+
+    if (numFields < 5)
+    {
+        return false;
+    }
+
+    char *end;
+    sample.tMS = strtod(fields[0], &end);
+
+    // Header or comment
+    if (end == fields[0])
+    {
+        return false;
+    }
+
+    sample.magDeg = strtof(fields[1], nullptr);
+    sample.courseDeg = strtof(fields[2], nullptr);
+    sample.speedKmph = strtof(fields[3], nullptr);
+    sample.courseValid = atoi(fields[4]) != 0;
+
+    sample.hasTruth = numFields > 5 && strspn(fields[5], " \t\r\n") != strlen(fields[5]);
+    sample.truthDeg = sample.hasTruth ? strtof(fields[5], nullptr) : 0;
+
+    return true;
+}
+
+// Truth of the generated trace: heading and speed for a time
+struct Trace_Leg
+{
+    double durationS;
+    float endHeadingDeg;
+    float endSpeedKmph;
+};
+
+// Standing, walking, a right turn, riding, a left turn across north, riding and stopping
+static const Trace_Leg TRACE_LEGS[] = {
+    {15, 30, 0},   {3, 30, 5},     {27, 30, 5},  {3, 120, 12}, {30, 120, 15},
+    {6, -30, 15},  {30, -30, 15},  {6, -30, 0},  {10, -30, 0},
+};
+
+// xorshift, so the trace is the same on every host
+static uint32_t traceRandomState = 0x2545F491;
+
+static float traceUniform()
+{
+    traceRandomState ^= traceRandomState << 13;
+    traceRandomState ^= traceRandomState >> 17;
+    traceRandomState ^= traceRandomState << 5;
+    return (traceRandomState >> 8) / 16777216.0f;
+}
+
+static float traceGaussian()
+{
+    float u = traceUniform() + 1e-7f;
+    return sqrtf(-2.0f * logf(u)) * cosf(2.0f * (float)M_PI * traceUniform());
+}
+
+static void generateTrace(std::vector<Trace_Sample> &samples)
+{
+    float headingDeg = TRACE_LEGS[0].endHeadingDeg;
+    float speedKmph = TRACE_LEGS[0].endSpeedKmph;
+    double tMS = 0;
+
+    float courseDeg = 0;
+    float courseSpeedKmph = 0;
+    double nextGpsMS = 0;
+
+    for (const Trace_Leg &leg : TRACE_LEGS)
+    {
+        size_t steps = (size_t)(leg.durationS * 1000 / TRACE_SAMPLE_PERIOD_MS);
+        float headingStep = Heading_Filter::wrap180(leg.endHeadingDeg - headingDeg) / steps;
+        float speedStep = (leg.endSpeedKmph - speedKmph) / steps;
+
+        for (size_t i = 0; i < steps; i++)
+        {
+            headingDeg = Heading_Filter::wrap360(headingDeg + headingStep);
+            speedKmph += speedStep;
+            tMS += TRACE_SAMPLE_PERIOD_MS;
+
+            // Uncorrected hard and soft iron, then noise and the odd spike from a passing car or a motor
+            float headingRad = headingDeg * (float)M_PI / 180.0f;
+            float magDeg = headingDeg + 4.0f + 6.0f * sinf(headingRad) + 6.0f * traceGaussian();
+
+            if (traceUniform() < 0.01f)
+            {
+                magDeg += traceUniform() < 0.5f ? 40.0f : -40.0f;
+            }
+
+            if (tMS >= nextGpsMS)
+            {
+                courseDeg = Heading_Filter::wrap360(headingDeg + 2.0f * traceGaussian());
+                courseSpeedKmph = fmaxf(0, speedKmph + 0.5f * traceGaussian());
+                nextGpsMS += TRACE_GPS_PERIOD_MS;
+            }
+
+            Trace_Sample sample;
+            sample.tMS = tMS;
+            sample.magDeg = Heading_Filter::wrap360(magDeg);
+            sample.courseDeg = courseDeg;
+            sample.speedKmph = courseSpeedKmph;
+            sample.courseValid = courseSpeedKmph > 1.0f;
+            sample.hasTruth = true;
+            sample.truthDeg = headingDeg;
+            samples.push_back(sample);
+        }
+    }
+}
+
+static bool loadTrace(const char *path, std::vector<Trace_Sample> &samples)
+{
+    FILE *file = fopen(path, "r");
+
+    if (file == nullptr)
+    {
+        perror(path);
+        return false;
+    }
+
+    char line[256];
+
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        Trace_Sample sample;
+
+        if (parseLine(line, sample))
+        {
+            samples.push_back(sample);
+        }
+    }
+
+    fclose(file);
+
+    if (samples.empty())
+    {
+        fprintf(stderr, "No samples in %s\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<Trace_Sample> samples;
+
+    if (argc > 1 && strcmp(argv[1], "--generate") == 0)
+    {
+        generateTrace(samples);
+        printf("t_ms,mag_deg,course_deg,speed_kmph,course_valid,truth_deg\n");
+
+        for (const auto &sample : samples)
+        {
+            printf("%.0f,%.2f,%.2f,%.2f,%d,%.2f\n", sample.tMS, sample.magDeg, sample.courseDeg, sample.speedKmph,
+                   sample.courseValid, sample.truthDeg);
+        }
+
+        return 0;
+    }
+
+    const char *tracePath = argc > 1 && strcmp(argv[1], "-") != 0 ? argv[1] : nullptr;
+
+    if (tracePath == nullptr)
+    {
+        generateTrace(samples);
+    }
+    else if (!loadTrace(tracePath, samples))
+    {
+        return 1;
+    }
+
+    Heading_Filter_Config config;
+
+    if (argc > 2)
+    {
+        config.magTimeConstantS = strtof(argv[2], nullptr);
+    }
+
+    if (argc > 3)
+    {
+        config.gpsMaxWeight = strtof(argv[3], nullptr);
+    }
+
+    double maxRmsDeg = argc > 4 ? strtod(argv[4], nullptr) : DEFAULT_MAX_RMS_DEG;
+
+    Heading_Filter filter(config);
+
+    Error_Stats rawError;
+    Error_Stats filteredError;
+    Error_Stats movingError;
+    double confidenceSum = 0;
+
+    // Jitter is the sample to sample change of the output, which is what makes the ring flicker
+    double rawJitter = 0;
+    double filteredJitter = 0;
+    float lastRaw = samples[0].magDeg;
+    float lastFiltered = samples[0].magDeg;
+
+    double lastMS = samples[0].tMS;
+    std::chrono::nanoseconds updateTime(0);
+
+    for (const auto &sample : samples)
+    {
+        float dtS = (float)(sample.tMS - lastMS) / 1000.0f;
+        lastMS = sample.tMS;
+
+        auto start = std::chrono::steady_clock::now();
+        filter.update(sample.magDeg, dtS, sample.courseDeg, sample.speedKmph, sample.courseValid);
+        updateTime += std::chrono::steady_clock::now() - start;
+
+        rawJitter += fabsf(Heading_Filter::wrap180(sample.magDeg - lastRaw));
+        filteredJitter += fabsf(Heading_Filter::wrap180(filter.heading() - lastFiltered));
+        lastRaw = sample.magDeg;
+        lastFiltered = filter.heading();
+
+        confidenceSum += filter.confidence();
+
+        if (sample.hasTruth)
+        {
+            rawError.add(Heading_Filter::wrap180(sample.magDeg - sample.truthDeg));
+            filteredError.add(Heading_Filter::wrap180(filter.heading() - sample.truthDeg));
+
+            if (filter.gpsWeight() > 0)
+            {
+                movingError.add(Heading_Filter::wrap180(filter.heading() - sample.truthDeg));
+            }
+        }
+    }
+
+    size_t n = samples.size();
+    double durationS = (samples.back().tMS - samples.front().tMS) / 1000.0;
+
+    printf("trace:              %s\n", tracePath != nullptr ? tracePath : "generated");
+    printf("samples:            %zu over %.1f s\n", n, durationS);
+    printf("magTimeConstantS:   %.2f\n", config.magTimeConstantS);
+    printf("gpsMaxWeight:       %.2f\n", config.gpsMaxWeight);
+    printf("\n");
+
+    if (filteredError.count)
+    {
+        printf("%-20s %8s %8s\n", "error deg", "rms", "max");
+        printf("%-20s %8.2f %8.2f\n", "raw compass", rawError.rms(), rawError.maxError);
+        printf("%-20s %8.2f %8.2f\n", "filtered", filteredError.rms(), filteredError.maxError);
+
+        if (movingError.count)
+        {
+            printf("%-20s %8.2f %8.2f  (%zu samples)\n", "filtered, moving", movingError.rms(), movingError.maxError, movingError.count);
+        }
+
+        printf("\n");
+    }
+    else
+    {
+        printf("No truth_deg in trace, error not scored\n\n");
+    }
+
+    printf("mean step deg:      raw %.2f, filtered %.2f\n", rawJitter / n, filteredJitter / n);
+    printf("mean confidence:    %.0f\n", confidenceSum / n);
+    printf("update cost:        %.1f ns on this host\n", (double)updateTime.count() / n);
+
+    size_t failures = 0;
+
+    if (filteredError.count && filteredError.rms() > maxRmsDeg)
+    {
+        fprintf(stderr, "FAIL: filtered rms error %.2f deg above %.2f\n", filteredError.rms(), maxRmsDeg);
+        failures++;
+    }
+
+    if (filteredError.count && filteredError.rms() >= rawError.rms())
+    {
+        fprintf(stderr, "FAIL: filtered rms error %.2f deg no better than the raw compass\n", filteredError.rms());
+        failures++;
+    }
+
+    if (filteredJitter >= rawJitter)
+    {
+        fprintf(stderr, "FAIL: filtered heading steps more than the raw compass\n");
+        failures++;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+Analyzes GetHeapStatsRpc responses saved from a device.
+
+    heap_analyze.py response.json [response2.json ...]
+
+Each file holds one response, or one response per line. Snapshots from every file are merged by
+timestamp, so responses collected over a long run show the whole trend even though the device only
+keeps the last few snapshots.
+
+Reports fragmentation and free heap over time, the rate free heap is shrinking, and with
+HEAP_TRACKING_ENABLED builds the live allocations per tag and which tags are growing.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load_responses(paths):
+    responses = []
+    for path in paths:
+        with open(path) as f:
+            text = f.read().strip()
+        try:
+            responses.append(json.loads(text))
+        except json.JSONDecodeError:
+            responses.extend(json.loads(line) for line in text.splitlines() if line.strip())
+    return responses
+
+
+def slope_per_hour(points):
+    """Least squares slope of (ms, value) points, in units per hour."""
+    if len(points) < 2:
+        return 0.0
+    n = len(points)
+    mean_t = sum(t for t, _ in points) / n
+    mean_v = sum(v for _, v in points) / n
+    var = sum((t - mean_t) ** 2 for t, _ in points)
+    if var == 0:
+        return 0.0
+    cov = sum((t - mean_t) * (v - mean_v) for t, v in points)
+    return cov / var * 3600 * 1000
+
+
+def fragmentation(region):
+    if region["free"] == 0:
+        return 0
+    return 100 - region["largest"] * 100 // region["free"]
+
+
+def class_label(bounds, i):
+    if i < len(bounds):
+        return f"<={bounds[i]}"
+    return f">{bounds[-1]}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("responses", nargs="+")
+    args = parser.parse_args()
+
+    responses = load_responses(args.responses)
+    if not responses:
+        sys.exit("No responses")
+
+    latest = responses[-1]
+    bounds = latest["sizeClasses"]
+    tag_names = latest["tagNames"]
+
+    snapshots = {}
+    for response in responses:
+        for snapshot in response.get("snapshots", []):
+            snapshots[snapshot["t"]] = snapshot
+    ordered = [snapshots[t] for t in sorted(snapshots)]
+
+    print(f"{'time s':>8} {'free':>8} {'largest':>8} {'frag %':>6} {'blocks':>7}")
+    for snapshot in ordered:
+        internal = snapshot["internal"]
+        print(f"{snapshot['t'] / 1000:>8.0f} {internal['free']:>8} {internal['largest']:>8} "
+              f"{fragmentation(internal):>6} {internal['freeBlocks']:>7}")
+
+    free_trend = slope_per_hour([(s["t"], s["internal"]["free"]) for s in ordered])
+    largest_trend = slope_per_hour([(s["t"], s["internal"]["largest"]) for s in ordered])
+    print()
+    print(f"free heap trend:     {free_trend:+.0f} bytes/hour")
+    print(f"largest block trend: {largest_trend:+.0f} bytes/hour")
+
+    if ordered and any(ordered[-1]["internal"]["freeClasses"]):
+        print()
+        print("free blocks by size, latest snapshot:")
+        for i, count in enumerate(ordered[-1]["internal"]["freeClasses"]):
+            if count:
+                print(f"  {class_label(bounds, i):>8} {count:>6}")
+
+    if not latest.get("tracking"):
+        print()
+        print("Tag accounting is off. Build with HEAP_TRACKING_ENABLED=1 for per tag results.")
+        return
+
+    print()
+    print(f"{'tag':<12} {'live':>6} {'bytes':>8} {'peak':>8} {'allocs':>8} {'failed':>6} {'trend/h':>9}  largest classes")
+    for i, tag in enumerate(latest["tags"]):
+        points = [(s["t"], s["live"][i]) for s in ordered if "live" in s]
+        classes = sorted(((count, j) for j, count in enumerate(tag["liveClasses"]) if count), reverse=True)[:3]
+        top = ", ".join(f"{class_label(bounds, j)}:{count}" for count, j in classes)
+        print(f"{tag_names[i]:<12} {tag['liveCount']:>6} {tag['liveBytes']:>8} {tag['peakBytes']:>8} "
+              f"{tag['allocations']:>8} {tag['failed']:>6} {slope_per_hour(points):>+9.0f}  {top}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,479 @@
+/*
+    Checks the heap tag accounting: every charge is credited back, reallocations stay with their tag and
+    pointers from plain malloc pass through untouched.
+
+        g++ -O2 -Wall -pthread -DHEAP_TRACKING_ENABLED=1 -I host/ui -I host -I ../include/Utilities \
+            heap_tracking_test.cpp ../src/Utilities/Heap_Tracking.cpp -o heap_tracking_test
+        ./heap_tracking_test
+
+    Heap_Tracking.cpp is the firmware's, operator new and delete included, so everything the host process
+    allocates goes through it. Tasks are threads and the tag lock is a portMUX, from the host FreeRTOS shims.
+
+        balance     allocations of every size class are charged to the task's tag and credited on release
+        realloc     growing and shrinking from a task with another tag re-accounts the bytes and size class
+                    to the tag that allocated, keeps the data and counts no new allocation
+        foreign     pointers from malloc are freed and reallocated without touching any tag
+        threads     tagged threads allocate, reallocate and release, and hand some of their blocks to other
+                    threads to release. Every tag must come back to where it started.
+        new         operator new and HEAP_TAG_SCOPE charge the scope's tag and restore the one before
+        tasks       the tag table holds HEAP_MAX_TAGGED_TASKS tasks, leaves the rest untagged and forgets tasks
+
+    Exits with 1 on any failure.
+*/
+
+#include "Heap_Utils.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define THREAD_ITERATIONS 50000
+#define THREAD_LIVE_BLOCKS 32
+#define HANDOFF_SLOTS 256
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what, long value = 0)
+{
+    if (!condition)
+    {
+        if (failures < 20)
+        {
+            fprintf(stderr, "FAIL %s (%ld)\n", what, value);
+        }
+
+        failures++;
+    }
+}
+
+// Blocks from new are stored here, so the compiler cannot leave out a new and delete pair
+static void *volatile escaped;
+
+static Heap_Tag_Stats tagStats(Heap_Tag tag)
+{
+    Heap_Tag_Stats stats[NUM_HEAP_TAGS];
+    Heap_Utils::CopyTagStats(stats, false);
+    return stats[tag];
+}
+
+// Live counts, bytes and size classes must match. Totals and peaks only grow.
+static bool sameLive(const Heap_Tag_Stats &a, const Heap_Tag_Stats &b)
+{
+    return a.liveCount == b.liveCount && a.liveBytes == b.liveBytes &&
+           memcmp(a.sizeClasses, b.sizeClasses, sizeof(a.sizeClasses)) == 0;
+}
+
+// Runs fn on a thread that carries tag, as a task that called setTaskTag would
+template <typename Function>
+static void onTask(Heap_Tag tag, Function fn)
+{
+    std::thread task([&]() {
+        Heap_Utils::setTaskTag(tag);
+        fn();
+        Heap_Utils::setTaskTag(HEAP_TAG_UNTAGGED);
+    });
+
+    task.join();
+}
+
+static void checkBalance()
+{
+    static const size_t SIZES[] = {1, 16, 17, 100, 4096, 70000};
+    const size_t count = sizeof(SIZES) / sizeof(SIZES[0]);
+
+    Heap_Tag_Stats before = tagStats(HEAP_TAG_LED);
+    void *blocks[count];
+    uint32_t bytes = 0;
+
+    onTask(HEAP_TAG_LED, [&]() {
+        for (size_t i = 0; i < count; i++)
+        {
+            blocks[i] = Heap_Utils::allocate(SIZES[i]);
+            memset(blocks[i], 0xA5, SIZES[i]);
+            bytes += SIZES[i];
+        }
+    });
+
+    Heap_Tag_Stats charged = tagStats(HEAP_TAG_LED);
+
+    check(charged.liveCount == before.liveCount + count, "balance: live count", charged.liveCount);
+    check(charged.liveBytes == before.liveBytes + bytes, "balance: live bytes", charged.liveBytes);
+    check(charged.totalAllocations == before.totalAllocations + count, "balance: allocations", charged.totalAllocations);
+    check(charged.peakBytes >= charged.liveBytes, "balance: peak below live", charged.peakBytes);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        before.sizeClasses[Heap_Utils::SizeClass(SIZES[i])]++;
+    }
+
+    check(memcmp(charged.sizeClasses, before.sizeClasses, sizeof(before.sizeClasses)) == 0, "balance: size classes");
+
+    for (size_t i = 0; i < count; i++)
+    {
+        before.sizeClasses[Heap_Utils::SizeClass(SIZES[i])]--;
+    }
+
+    // Released from an untagged task, still credited to the LED tag
+    for (void *block : blocks)
+    {
+        Heap_Utils::release(block);
+    }
+
+    Heap_Tag_Stats released = tagStats(HEAP_TAG_LED);
+
+    check(sameLive(released, before), "balance: not credited back", released.liveBytes);
+    check(released.peakBytes == charged.peakBytes, "balance: release moved the peak", released.peakBytes);
+
+    Heap_Tag_Stats stats[NUM_HEAP_TAGS];
+    Heap_Utils::CopyTagStats(stats, true);
+    released = tagStats(HEAP_TAG_LED);
+    check(released.peakBytes == released.liveBytes, "balance: clearing peaks", released.peakBytes);
+}
+
+static void checkRealloc()
+{
+    Heap_Tag_Stats navigation = tagStats(HEAP_TAG_NAVIGATION);
+    Heap_Tag_Stats display = tagStats(HEAP_TAG_DISPLAY);
+
+    uint8_t *block = nullptr;
+
+    onTask(HEAP_TAG_NAVIGATION, [&]() {
+        block = (uint8_t *)Heap_Utils::allocate(10);
+
+        for (int i = 0; i < 10; i++)
+        {
+            block[i] = i * 7;
+        }
+    });
+
+    void *displayBlock = nullptr;
+
+    onTask(HEAP_TAG_DISPLAY, [&]() {
+        for (size_t size : {5000, 20, 300000, 10})
+        {
+            block = (uint8_t *)Heap_Utils::reallocate(block, size);
+
+            Heap_Tag_Stats stats = tagStats(HEAP_TAG_NAVIGATION);
+            Heap_Tag_Stats expected = navigation;
+            expected.liveCount++;
+            expected.liveBytes += size;
+            expected.sizeClasses[Heap_Utils::SizeClass(size)]++;
+
+            check(sameLive(stats, expected), "realloc: not re-accounted to the allocating tag", size);
+            check(stats.totalAllocations == navigation.totalAllocations + 1, "realloc: counted as an allocation", size);
+            check(sameLive(tagStats(HEAP_TAG_DISPLAY), display), "realloc: charged to the reallocating task", size);
+
+            bool intact = true;
+
+            for (int i = 0; i < 10; i++)
+            {
+                intact = intact && block[i] == i * 7;
+            }
+
+            check(intact, "realloc: data lost", size);
+        }
+
+        // From nothing, it is a new allocation for the calling task
+        displayBlock = Heap_Utils::reallocate(nullptr, 64);
+    });
+
+    Heap_Tag_Stats displayCharged = tagStats(HEAP_TAG_DISPLAY);
+    check(displayCharged.liveBytes == display.liveBytes + 64 && displayCharged.totalAllocations == display.totalAllocations + 1,
+          "realloc: null pointer not charged to the caller", displayCharged.liveBytes);
+
+    Heap_Utils::release(block);
+    Heap_Utils::release(displayBlock);
+
+    check(sameLive(tagStats(HEAP_TAG_NAVIGATION), navigation), "realloc: navigation not credited back");
+    check(sameLive(tagStats(HEAP_TAG_DISPLAY), display), "realloc: display not credited back");
+}
+
+static void checkForeign()
+{
+    Heap_Tag_Stats before[NUM_HEAP_TAGS];
+    Heap_Tag_Stats after[NUM_HEAP_TAGS];
+
+    // Only plain malloc and the calls under test run between the copies
+    Heap_Utils::CopyTagStats(before, false);
+
+    void *freed = malloc(64);
+    Heap_Utils::release(freed);
+
+    uint8_t *foreign = (uint8_t *)malloc(32);
+
+    for (int i = 0; i < 32; i++)
+    {
+        foreign[i] = 255 - i;
+    }
+
+    for (size_t size : {4096, 8, 200000})
+    {
+        foreign = (uint8_t *)Heap_Utils::reallocate(foreign, size);
+        check(foreign != nullptr, "foreign: reallocate failed", size);
+    }
+
+    bool intact = true;
+
+    for (int i = 0; i < 8; i++)
+    {
+        intact = intact && foreign[i] == 255 - i;
+    }
+
+    check(intact, "foreign: data lost", 0);
+
+    Heap_Utils::release(foreign);
+    Heap_Utils::release(nullptr);
+
+    Heap_Utils::CopyTagStats(after, false);
+    check(memcmp(before, after, sizeof(before)) == 0, "foreign: a tag was charged or credited");
+}
+
+// Blocks passed between threads, released by whichever thread takes them
+struct Handoff
+{
+    std::mutex lock;
+    void *blocks[HANDOFF_SLOTS];
+    size_t count = 0;
+
+    bool put(void *block)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (count == HANDOFF_SLOTS)
+        {
+            return false;
+        }
+
+        blocks[count++] = block;
+        return true;
+    }
+
+    void *take()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return count > 0 ? blocks[--count] : nullptr;
+    }
+};
+
+static void checkThreads()
+{
+    static const Heap_Tag TAGS[] = {HEAP_TAG_SYSTEM, HEAP_TAG_LORA, HEAP_TAG_RPC, HEAP_TAG_NETWORK};
+    const size_t numThreads = sizeof(TAGS) / sizeof(TAGS[0]);
+
+    Heap_Tag_Stats before[NUM_HEAP_TAGS];
+    Heap_Utils::CopyTagStats(before, false);
+
+    Handoff handoff;
+    uint32_t allocations[numThreads] = {};
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([&, t]() {
+            Heap_Utils::setTaskTag(TAGS[t]);
+
+            // No allocation here but the ones under test
+            void *live[THREAD_LIVE_BLOCKS] = {};
+            uint32_t random = 2463534242u + t;
+
+            for (int i = 0; i < THREAD_ITERATIONS; i++)
+            {
+                random ^= random << 13;
+                random ^= random >> 17;
+                random ^= random << 5;
+
+                void *&slot = live[random % THREAD_LIVE_BLOCKS];
+                size_t size = 1 + (random >> 8) % 3000;
+
+                switch ((random >> 24) % 4)
+                {
+                case 0:
+                    if (slot == nullptr)
+                    {
+                        slot = Heap_Utils::allocate(size);
+                        allocations[t]++;
+                    }
+                    break;
+                case 1:
+                    if (slot != nullptr)
+                    {
+                        slot = Heap_Utils::reallocate(slot, size);
+                    }
+                    break;
+                case 2:
+                    if (slot != nullptr && handoff.put(slot))
+                    {
+                        slot = nullptr;
+                    }
+                    break;
+                default:
+                    Heap_Utils::release(handoff.take());
+                    break;
+                }
+            }
+
+            for (void *block : live)
+            {
+                Heap_Utils::release(block);
+            }
+
+            Heap_Utils::setTaskTag(HEAP_TAG_UNTAGGED);
+        });
+    }
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    while (void *block = handoff.take())
+    {
+        Heap_Utils::release(block);
+    }
+
+    Heap_Tag_Stats after[NUM_HEAP_TAGS];
+    Heap_Utils::CopyTagStats(after, false);
+
+    uint32_t total = 0;
+
+    for (size_t t = 0; t < numThreads; t++)
+    {
+        const Heap_Tag_Stats &was = before[TAGS[t]];
+        const Heap_Tag_Stats &is = after[TAGS[t]];
+
+        check(sameLive(is, was), "threads: tag not back where it started", TAGS[t]);
+        check(is.totalAllocations == was.totalAllocations + allocations[t], "threads: allocations miscounted", TAGS[t]);
+        check(is.failedAllocations == was.failedAllocations, "threads: failed allocations", TAGS[t]);
+        check(is.peakBytes > was.liveBytes, "threads: peak never rose", TAGS[t]);
+
+        total += allocations[t];
+    }
+
+    printf("thread allocations:  %8u across %zu tagged threads\n", total, numThreads);
+}
+
+static void checkOperatorNew()
+{
+    Heap_Tag_Stats before = tagStats(HEAP_TAG_FILESYSTEM);
+    Heap_Tag_Stats during;
+    Heap_Tag inner = HEAP_TAG_UNTAGGED;
+    Heap_Tag restored = HEAP_TAG_UNTAGGED;
+
+    onTask(HEAP_TAG_LED, [&]() {
+        {
+            HEAP_TAG_SCOPE(HEAP_TAG_FILESYSTEM);
+            int *values = new int[100];
+            uint64_t *value = new uint64_t(7);
+            escaped = values;
+            escaped = value;
+
+            {
+                HEAP_TAG_SCOPE(HEAP_TAG_RPC);
+                inner = Heap_Utils::TaskTag();
+            }
+
+            during = tagStats(HEAP_TAG_FILESYSTEM);
+
+            delete value;
+            delete[] values;
+        }
+
+        restored = Heap_Utils::TaskTag();
+    });
+
+    check(during.liveCount == before.liveCount + 2, "new: not charged to the scope's tag", during.liveCount);
+    check(during.liveBytes == before.liveBytes + 100 * sizeof(int) + sizeof(uint64_t), "new: bytes", during.liveBytes);
+    check(inner == HEAP_TAG_RPC, "new: nested scope", inner);
+    check(restored == HEAP_TAG_LED, "new: scope did not restore the task's tag", restored);
+    check(sameLive(tagStats(HEAP_TAG_FILESYSTEM), before), "new: delete not credited");
+}
+
+static void checkTaskTable()
+{
+    const int numTasks = HEAP_MAX_TAGGED_TASKS + 3;
+
+    std::atomic<int> tagged(0);
+    std::atomic<int> checked(0);
+    std::atomic<int> withTag(0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < numTasks; t++)
+    {
+        threads.emplace_back([&]() {
+            Heap_Utils::setTaskTag(HEAP_TAG_NETWORK);
+            tagged++;
+
+            // Every task holds its tag until all have tried to take one
+            while (tagged.load() < numTasks)
+            {
+                std::this_thread::yield();
+            }
+
+            if (Heap_Utils::TaskTag() == HEAP_TAG_NETWORK)
+            {
+                withTag++;
+            }
+
+            checked++;
+
+            while (checked.load() < numTasks)
+            {
+                std::this_thread::yield();
+            }
+
+            Heap_Utils::setTaskTag(HEAP_TAG_UNTAGGED);
+        });
+    }
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    check(withTag.load() == HEAP_MAX_TAGGED_TASKS, "tasks: tagged tasks past the table", withTag.load());
+
+    // A deleted task's handle can be reused, so its tag is forgotten
+    std::atomic<TaskHandle_t> handle(nullptr);
+    std::atomic<bool> forgotten(false);
+    Heap_Tag tagAfter = HEAP_TAG_LED;
+
+    std::thread task([&]() {
+        Heap_Utils::setTaskTag(HEAP_TAG_LED);
+        handle = xTaskGetCurrentTaskHandle();
+
+        while (!forgotten.load())
+        {
+            std::this_thread::yield();
+        }
+
+        tagAfter = Heap_Utils::TaskTag();
+    });
+
+    while (handle.load() == nullptr)
+    {
+        std::this_thread::yield();
+    }
+
+    Heap_Utils::forgetTask(handle.load());
+    forgotten = true;
+    task.join();
+
+    check(tagAfter == HEAP_TAG_UNTAGGED, "tasks: forgotten task kept its tag", tagAfter);
+}
+
+int main()
+{
+    checkBalance();
+    checkRealloc();
+    checkForeign();
+    checkThreads();
+    checkOperatorNew();
+    checkTaskTable();
+
+    printf("failures:            %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+/*
+    The few Arduino core helpers used by the sources the host tools compile.
+    Only for the tools, never part of the firmware build.
+*/
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "FreeRTOS.h"
+
+#define PROGMEM
+
+// Math helpers of the Arduino core, as TinyGPS++ uses them
+#define TWO_PI 6.283185307179586476925286766559
+#define radians(deg) ((deg) * 0.017453292519943295769236907684886)
+#define degrees(rad) ((rad) * 57.295779513082320876798154814105)
+#define sq(x) ((x) * (x))
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+
+template <typename T>
+inline T min(T a, T b) { return a < b ? a : b; }
+
+template <typename T>
+inline T max(T a, T b) { return a > b ? a : b; }
+
+template <typename T>
+inline T constrain(T value, T low, T high) { return value < low ? low : (value > high ? high : value); }
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+inline int64_t esp_timer_get_time()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Host_FreeRTOS::start).count();
+}
+
+inline unsigned long millis() { return xTaskGetTickCount(); }
+inline unsigned long micros() { return (unsigned long)esp_timer_get_time(); }
+inline void delay(unsigned long ms) { vTaskDelay(ms); }
+
+// Print and Stream, with only the members the host tools use
+class Print
+{
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t value) = 0;
+
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t written = 0;
+
+        while (written < size && write(buffer[written]) == 1)
+        {
+            written++;
+        }
+
+        return written;
+    }
+
+    size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+    size_t print(const std::string &text) { return write((const uint8_t *)text.data(), text.size()); }
+    size_t print(char value) { return write((uint8_t)value); }
+    size_t print(int value) { return printf("%d", value); }
+    size_t print(unsigned int value) { return printf("%u", value); }
+    size_t print(long value) { return printf("%ld", value); }
+    size_t print(unsigned long value) { return printf("%lu", value); }
+    size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+
+    template <typename T>
+    size_t println(const T &value) { return print(value) + println(); }
+
+    size_t println() { return print("\r\n"); }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char text[128];
+
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+
+        return length > 0 ? write((const uint8_t *)text, min((size_t)length, sizeof(text) - 1)) : 0;
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    // Stops at the end of the stream, there is no timeout to wait for
+    size_t readBytes(char *buffer, size_t length)
+    {
+        size_t count = 0;
+
+        for (int next; count < length && (next = read()) >= 0; count++)
+        {
+            buffer[count] = (char)next;
+        }
+
+        return count;
+    }
+};
+
+// Debug output from the sources is dropped, so the tools only print their own results
+class HardwareSerial : public Print
+{
+public:
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t *, size_t size) override { return size; }
+};
+
+inline HardwareSerial Serial;
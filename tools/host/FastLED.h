@@ -0,0 +1,123 @@
+#pragma once
+
+/*
+    The parts of FastLED the LED kernels use, with FastLED's default ESP32 behaviour (FASTLED_SCALE8_FIXED), so
+    host tools get the same bytes as the firmware. Only for the tools, never part of the firmware build.
+*/
+
+#include "Arduino.h"
+
+inline uint8_t scale8(uint8_t i, uint8_t scale)
+{
+    return ((uint16_t)i * (1 + (uint16_t)scale)) >> 8;
+}
+
+inline uint8_t lerp8by8(uint8_t a, uint8_t b, uint8_t frac)
+{
+    return b > a ? a + scale8(b - a, frac) : a - scale8(a - b, frac);
+}
+
+inline uint8_t ease8InOutQuad(uint8_t i)
+{
+    uint8_t j = i & 0x80 ? 255 - i : i;
+    uint8_t jj2 = scale8(j, j) << 1;
+    return i & 0x80 ? 255 - jj2 : jj2;
+}
+
+struct CRGB
+{
+    union
+    {
+        struct
+        {
+            uint8_t r;
+            uint8_t g;
+            uint8_t b;
+        };
+        uint8_t raw[3];
+    };
+
+    enum HTMLColorCode
+    {
+        Black = 0x000000,
+        White = 0xFFFFFF,
+    };
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+    CRGB(HTMLColorCode code) : r((code >> 16) & 0xFF), g((code >> 8) & 0xFF), b(code & 0xFF) {}
+
+    CRGB &nscale8(uint8_t scale)
+    {
+        r = scale8(r, scale);
+        g = scale8(g, scale);
+        b = scale8(b, scale);
+        return *this;
+    }
+
+    // Saturating add, as qadd8 on each channel
+    CRGB &operator+=(const CRGB &rhs)
+    {
+        r = r + rhs.r > 255 ? 255 : r + rhs.r;
+        g = g + rhs.g > 255 ? 255 : g + rhs.g;
+        b = b + rhs.b > 255 ? 255 : b + rhs.b;
+        return *this;
+    }
+
+    // Brighter of each channel
+    CRGB &operator|=(const CRGB &rhs)
+    {
+        r = rhs.r > r ? rhs.r : r;
+        g = rhs.g > g ? rhs.g : g;
+        b = rhs.b > b ? rhs.b : b;
+        return *this;
+    }
+
+    bool operator==(const CRGB &other) const { return r == other.r && g == other.g && b == other.b; }
+    bool operator!=(const CRGB &other) const { return !(*this == other); }
+};
+
+// FASTLED_BLEND_FIXED
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB)
+{
+    uint16_t partial = a * (255 - amountOfB) + a + b * amountOfB + b;
+    return partial >> 8;
+}
+
+inline CRGB &nblend(CRGB &existing, const CRGB &overlay, uint8_t amountOfOverlay)
+{
+    if (amountOfOverlay == 0)
+    {
+        return existing;
+    }
+
+    if (amountOfOverlay == 255)
+    {
+        existing = overlay;
+        return existing;
+    }
+
+    existing.r = blend8(existing.r, overlay.r, amountOfOverlay);
+    existing.g = blend8(existing.g, overlay.g, amountOfOverlay);
+    existing.b = blend8(existing.b, overlay.b, amountOfOverlay);
+    return existing;
+}
+
+inline void fill_solid(CRGB *leds, int numLeds, const CRGB &color)
+{
+    for (int i = 0; i < numLeds; i++)
+    {
+        leds[i] = color;
+    }
+}
+
+// FastLED.show() only counts the frames that would have gone out
+class CFastLED
+{
+public:
+    void show() { shows++; }
+
+    uint32_t shows = 0;
+};
+
+inline CFastLED FastLED;
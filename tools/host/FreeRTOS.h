@@ -0,0 +1,211 @@
+#pragma once
+
+/*
+    The FreeRTOS calls the host tools compile against, over std::thread primitives. Only for the tools, never
+    part of the firmware build.
+
+    Ticks are milliseconds since the program started, as with the ESP32's 1 kHz tick. Tasks are threads, and a
+    portMUX is a spinlock that the thread holding it may take again, as on one ESP32 core. Queues copy items
+    and honour their timeouts.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define errQUEUE_FULL 0
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+namespace Host_FreeRTOS
+{
+    // Boot, for the tick count and esp_timer
+    inline const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+}
+
+inline TickType_t xTaskGetTickCount()
+{
+    return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - Host_FreeRTOS::start).count();
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline void vTaskDelayUntil(TickType_t *previousWake, TickType_t period)
+{
+    *previousWake += period;
+    TickType_t now = xTaskGetTickCount();
+
+    if ((int32_t)(*previousWake - now) > 0)
+    {
+        vTaskDelay(*previousWake - now);
+    }
+}
+
+#define taskYIELD() std::this_thread::yield()
+
+// A task is its thread. The handle is unique per thread and stays valid while the thread runs.
+typedef void *TaskHandle_t;
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    static thread_local char task;
+    return &task;
+}
+
+// Copies start unlocked, so classes holding one stay copyable as on the ESP32
+struct portMUX_TYPE
+{
+    constexpr portMUX_TYPE() {}
+    portMUX_TYPE(const portMUX_TYPE &) {}
+    portMUX_TYPE &operator=(const portMUX_TYPE &) { return *this; }
+
+    std::atomic<TaskHandle_t> owner{nullptr};
+    uint32_t count = 0;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+
+inline void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    if (mux->owner.load(std::memory_order_relaxed) != self)
+    {
+        TaskHandle_t expected = nullptr;
+
+        while (!mux->owner.compare_exchange_weak(expected, self, std::memory_order_acquire))
+        {
+            expected = nullptr;
+            std::this_thread::yield();
+        }
+    }
+
+    mux->count++;
+}
+
+inline void vPortExitCritical(portMUX_TYPE *mux)
+{
+    if (--mux->count == 0)
+    {
+        mux->owner.store(nullptr, std::memory_order_release);
+    }
+}
+
+#define portENTER_CRITICAL(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux) vPortExitCritical(mux)
+#define portENTER_CRITICAL_SAFE(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_SAFE(mux) vPortExitCritical(mux)
+
+// Queues copy items in and out, like xQueueCreate's
+struct Host_Queue
+{
+    Host_Queue(UBaseType_t length, UBaseType_t itemSize) : length(length), itemSize(itemSize) {}
+
+    const UBaseType_t length;
+    const UBaseType_t itemSize;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+typedef Host_Queue *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    return new Host_Queue(length, itemSize);
+}
+
+inline void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+namespace Host_FreeRTOS
+{
+    // Waits on the queue until ready() holds or the ticks run out. Called with the queue locked.
+    template <typename Ready>
+    inline bool wait(QueueHandle_t queue, std::unique_lock<std::mutex> &lock, TickType_t ticks, Ready ready)
+    {
+        if (ticks == portMAX_DELAY)
+        {
+            queue->changed.wait(lock, ready);
+            return true;
+        }
+
+        return queue->changed.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+    }
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+
+    if (!Host_FreeRTOS::wait(queue, lock, ticks, [queue]() { return queue->items.size() < queue->length; }))
+    {
+        return errQUEUE_FULL;
+    }
+
+    queue->items.emplace_back((const uint8_t *)item, (const uint8_t *)item + queue->itemSize);
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+#define xQueueSendToBack xQueueSend
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+
+    if (!Host_FreeRTOS::wait(queue, lock, ticks, [queue]() { return !queue->items.empty(); }))
+    {
+        return pdFALSE;
+    }
+
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->items.clear();
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->items.size();
+}
+
+// Timers are only declared, so signatures that take them compile
+typedef struct Host_Timer *TimerHandle_t;
+typedef struct Host_Static_Timer StaticTimer_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
@@ -0,0 +1,14 @@
+#pragma once
+
+/*
+    The heap capability flags, so headers that include esp_heap_caps.h compile. The host has one heap and no
+    capability queries. Only for the tools, never part of the firmware build.
+*/
+
+#define MALLOC_CAP_EXEC (1 << 0)
+#define MALLOC_CAP_32BIT (1 << 1)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
@@ -0,0 +1,466 @@
+#pragma once
+
+/*
+    Adafruit_GFX for the host UI tools, with the classic 5x7 font only. The drawing routines follow
+    Adafruit_GFX 1.11, so shapes and text land on the same pixels as on the device and go through the same
+    per pixel calls. Only for the tools, never part of the firmware build.
+*/
+
+#include <Arduino.h>
+
+#include <vector>
+
+class Adafruit_GFX : public Print
+{
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h), _width(w), _height(h) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    virtual void startWrite() {}
+    virtual void endWrite() {}
+    virtual void writePixel(int16_t x, int16_t y, uint16_t color) { drawPixel(x, y, color); }
+    virtual void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { fillRect(x, y, w, h, color); }
+    virtual void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { drawFastVLine(x, y, h, color); }
+    virtual void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { drawFastHLine(x, y, w, color); }
+
+    virtual void writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        bool steep = abs(y1 - y0) > abs(x1 - x0);
+
+        if (steep)
+        {
+            swap(x0, y0);
+            swap(x1, y1);
+        }
+
+        if (x0 > x1)
+        {
+            swap(x0, x1);
+            swap(y0, y1);
+        }
+
+        int16_t dx = x1 - x0;
+        int16_t dy = abs(y1 - y0);
+        int16_t err = dx / 2;
+        int16_t ystep = y0 < y1 ? 1 : -1;
+
+        for (; x0 <= x1; x0++)
+        {
+            if (steep)
+            {
+                writePixel(y0, x0, color);
+            }
+            else
+            {
+                writePixel(x0, y0, color);
+            }
+
+            err -= dy;
+
+            if (err < 0)
+            {
+                y0 += ystep;
+                err += dx;
+            }
+        }
+    }
+
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { writeLine(x, y, x, y + h - 1, color); }
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { writeLine(x, y, x + w - 1, y, color); }
+
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+        for (int16_t i = x; i < x + w; i++)
+        {
+            writeFastVLine(i, y, h, color);
+        }
+    }
+
+    virtual void fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
+
+    virtual void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+        if (x0 == x1)
+        {
+            if (y0 > y1)
+            {
+                swap(y0, y1);
+            }
+
+            drawFastVLine(x0, y0, y1 - y0 + 1, color);
+        }
+        else if (y0 == y1)
+        {
+            if (x0 > x1)
+            {
+                swap(x0, x1);
+            }
+
+            drawFastHLine(x0, y0, x1 - x0 + 1, color);
+        }
+        else
+        {
+            writeLine(x0, y0, x1, y1, color);
+        }
+    }
+
+    virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+        writeFastHLine(x, y, w, color);
+        writeFastHLine(x, y + h - 1, w, color);
+        writeFastVLine(x, y, h, color);
+        writeFastVLine(x + w - 1, y, h, color);
+    }
+
+    void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+    {
+        int16_t f = 1 - r;
+        int16_t ddF_x = 1;
+        int16_t ddF_y = -2 * r;
+        int16_t x = 0;
+        int16_t y = r;
+
+        writePixel(x0, y0 + r, color);
+        writePixel(x0, y0 - r, color);
+        writePixel(x0 + r, y0, color);
+        writePixel(x0 - r, y0, color);
+
+        while (x < y)
+        {
+            if (f >= 0)
+            {
+                y--;
+                ddF_y += 2;
+                f += ddF_y;
+            }
+
+            x++;
+            ddF_x += 2;
+            f += ddF_x;
+
+            writePixel(x0 + x, y0 + y, color);
+            writePixel(x0 - x, y0 + y, color);
+            writePixel(x0 + x, y0 - y, color);
+            writePixel(x0 - x, y0 - y, color);
+            writePixel(x0 + y, y0 + x, color);
+            writePixel(x0 - y, y0 + x, color);
+            writePixel(x0 + y, y0 - x, color);
+            writePixel(x0 - y, y0 - x, color);
+        }
+    }
+
+    void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+    {
+        writeFastVLine(x0, y0 - r, 2 * r + 1, color);
+        fillCircleHelper(x0, y0, r, 3, 0, color);
+    }
+
+    void fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color)
+    {
+        int16_t f = 1 - r;
+        int16_t ddF_x = 1;
+        int16_t ddF_y = -2 * r;
+        int16_t x = 0;
+        int16_t y = r;
+        int16_t px = x;
+        int16_t py = y;
+
+        delta++;
+
+        while (x < y)
+        {
+            if (f >= 0)
+            {
+                y--;
+                ddF_y += 2;
+                f += ddF_y;
+            }
+
+            x++;
+            ddF_x += 2;
+            f += ddF_x;
+
+            if (x < (y + 1))
+            {
+                if (corners & 1)
+                {
+                    writeFastVLine(x0 + x, y0 - y, 2 * y + delta, color);
+                }
+
+                if (corners & 2)
+                {
+                    writeFastVLine(x0 - x, y0 - y, 2 * y + delta, color);
+                }
+            }
+
+            if (y != py)
+            {
+                if (corners & 1)
+                {
+                    writeFastVLine(x0 + py, y0 - px, 2 * px + delta, color);
+                }
+
+                if (corners & 2)
+                {
+                    writeFastVLine(x0 - py, y0 - px, 2 * px + delta, color);
+                }
+
+                py = y;
+            }
+
+            px = x;
+        }
+    }
+
+    void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+    {
+        drawLine(x0, y0, x1, y1, color);
+        drawLine(x1, y1, x2, y2, color);
+        drawLine(x2, y2, x0, y0, color);
+    }
+
+    void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
+    {
+        int16_t a, b, y, last;
+
+        if (y0 > y1)
+        {
+            swap(y0, y1);
+            swap(x0, x1);
+        }
+
+        if (y1 > y2)
+        {
+            swap(y2, y1);
+            swap(x2, x1);
+        }
+
+        if (y0 > y1)
+        {
+            swap(y0, y1);
+            swap(x0, x1);
+        }
+
+        if (y0 == y2)
+        {
+            a = b = x0;
+            a = min(a, min(x1, x2));
+            b = max(b, max(x1, x2));
+            writeFastHLine(a, y0, b - a + 1, color);
+            return;
+        }
+
+        int16_t dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0, dx12 = x2 - x1, dy12 = y2 - y1;
+        int32_t sa = 0, sb = 0;
+
+        last = y1 == y2 ? y1 : y1 - 1;
+
+        for (y = y0; y <= last; y++)
+        {
+            a = x0 + sa / dy01;
+            b = x0 + sb / dy02;
+            sa += dx01;
+            sb += dx02;
+
+            if (a > b)
+            {
+                swap(a, b);
+            }
+
+            writeFastHLine(a, y, b - a + 1, color);
+        }
+
+        sa = (int32_t)dx12 * (y - y1);
+        sb = (int32_t)dx02 * (y - y0);
+
+        for (; y <= y2; y++)
+        {
+            a = x1 + sa / dy12;
+            b = x0 + sb / dy02;
+            sa += dx12;
+            sb += dx02;
+
+            if (a > b)
+            {
+                swap(a, b);
+            }
+
+            writeFastHLine(a, y, b - a + 1, color);
+        }
+    }
+
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t sizeX, uint8_t sizeY);
+
+    size_t write(uint8_t c) override
+    {
+        if (c == '\n')
+        {
+            cursor_x = 0;
+            cursor_y += textsize_y * 8;
+        }
+        else if (c != '\r')
+        {
+            if (wrap && (cursor_x + textsize_x * 6) > _width)
+            {
+                cursor_x = 0;
+                cursor_y += textsize_y * 8;
+            }
+
+            drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x, textsize_y);
+            cursor_x += textsize_x * 6;
+        }
+
+        return 1;
+    }
+
+    using Print::write;
+
+    void setCursor(int16_t x, int16_t y)
+    {
+        cursor_x = x;
+        cursor_y = y;
+    }
+
+    void setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+
+    void setTextColor(uint16_t c, uint16_t bg)
+    {
+        textcolor = c;
+        textbgcolor = bg;
+    }
+
+    void setTextSize(uint8_t s) { textsize_x = textsize_y = s > 0 ? s : 1; }
+    void setTextWrap(bool w) { wrap = w; }
+    void cp437(bool x = true) { _cp437 = x; }
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+    int16_t getCursorX() const { return cursor_x; }
+    int16_t getCursorY() const { return cursor_y; }
+    uint8_t getRotation() const { return rotation; }
+
+protected:
+    const int16_t WIDTH;
+    const int16_t HEIGHT;
+    int16_t _width;
+    int16_t _height;
+    int16_t cursor_x = 0;
+    int16_t cursor_y = 0;
+    uint16_t textcolor = 0xFFFF;
+    uint16_t textbgcolor = 0xFFFF;
+    uint8_t textsize_x = 1;
+    uint8_t textsize_y = 1;
+    uint8_t rotation = 0;
+    bool wrap = true;
+    bool _cp437 = false;
+
+    static void swap(int16_t &a, int16_t &b)
+    {
+        int16_t t = a;
+        a = b;
+        b = t;
+    }
+};
+
+#include "glcdfont.c"
+
+inline void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t sizeX, uint8_t sizeY)
+{
+    if (x >= _width || y >= _height || (x + 6 * sizeX - 1) < 0 || (y + 8 * sizeY - 1) < 0)
+    {
+        return;
+    }
+
+    if (!_cp437 && c >= 176)
+    {
+        c++;
+    }
+
+    for (int8_t i = 0; i < 5; i++)
+    {
+        uint8_t line = pgm_read_byte(&font[c * 5 + i]);
+
+        for (int8_t j = 0; j < 8; j++, line >>= 1)
+        {
+            if (line & 1)
+            {
+                if (sizeX == 1 && sizeY == 1)
+                {
+                    writePixel(x + i, y + j, color);
+                }
+                else
+                {
+                    writeFillRect(x + i * sizeX, y + j * sizeY, sizeX, sizeY, color);
+                }
+            }
+            else if (bg != color)
+            {
+                if (sizeX == 1 && sizeY == 1)
+                {
+                    writePixel(x + i, y + j, bg);
+                }
+                else
+                {
+                    writeFillRect(x + i * sizeX, y + j * sizeY, sizeX, sizeY, bg);
+                }
+            }
+        }
+    }
+
+    if (bg != color)
+    {
+        if (sizeX == 1 && sizeY == 1)
+        {
+            writeFastVLine(x + 5, y, 8, bg);
+        }
+        else
+        {
+            writeFillRect(x + 5 * sizeX, y, sizeX, 8 * sizeY, bg);
+        }
+    }
+}
+
+// 1 bit canvas, row major with the leftmost pixel in the MSB, as in Adafruit_GFX. The rows are a PBM (P4) body.
+class GFXcanvas1 : public Adafruit_GFX
+{
+public:
+    GFXcanvas1(uint16_t w, uint16_t h) : Adafruit_GFX(w, h), buffer(((w + 7) / 8) * h, 0) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override
+    {
+        if (x < 0 || y < 0 || x >= _width || y >= _height)
+        {
+            return;
+        }
+
+        uint8_t *ptr = &buffer[(x / 8) + y * ((WIDTH + 7) / 8)];
+
+        if (color)
+        {
+            *ptr |= 0x80 >> (x & 7);
+        }
+        else
+        {
+            *ptr &= ~(0x80 >> (x & 7));
+        }
+    }
+
+    bool getPixel(int16_t x, int16_t y) const
+    {
+        if (x < 0 || y < 0 || x >= _width || y >= _height)
+        {
+            return false;
+        }
+
+        return buffer[(x / 8) + y * ((WIDTH + 7) / 8)] & (0x80 >> (x & 7));
+    }
+
+    void fillScreen(uint16_t color) override { memset(buffer.data(), color ? 0xFF : 0x00, buffer.size()); }
+
+    uint8_t *getBuffer() { return buffer.data(); }
+    size_t bufferSize() const { return buffer.size(); }
+
+private:
+    std::vector<uint8_t> buffer;
+};
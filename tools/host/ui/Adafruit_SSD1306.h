@@ -0,0 +1,116 @@
+#pragma once
+
+/*
+    Adafruit_SSD1306 for the host UI tools. Drawing goes into the same paged RAM as the library's, so
+    Display_Utils can blit into getBuffer(). display() stands in for the I2C transfer: it copies the RAM onto
+    a GFXcanvas1 that plays the panel glass, which is what the tools read back and dump. Rotation 0 only.
+    Only for the tools, never part of the firmware build.
+*/
+
+#include "Adafruit_GFX.h"
+#include "Wire.h"
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_INVERSE 2
+
+#define BLACK SSD1306_BLACK
+#define WHITE SSD1306_WHITE
+#define INVERSE SSD1306_INVERSE
+
+#define SSD1306_EXTERNALVCC 0x01
+#define SSD1306_SWITCHCAPVCC 0x02
+
+class Adafruit_SSD1306 : public Adafruit_GFX
+{
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire * = &Wire, int8_t = -1, uint32_t = 400000UL, uint32_t = 100000UL)
+        : Adafruit_GFX(w, h), panel(w, h), buffer(w * ((h + 7) / 8), 0)
+    {
+    }
+
+    bool begin(uint8_t = SSD1306_SWITCHCAPVCC, uint8_t = 0, bool = true, bool = true) { return true; }
+
+    // The I2C transfer. Every page is sent, as in the library.
+    void display()
+    {
+        panel.fillScreen(0);
+
+        for (int16_t y = 0; y < HEIGHT; y++)
+        {
+            for (int16_t x = 0; x < WIDTH; x++)
+            {
+                if (buffer[x + (y / 8) * WIDTH] & (1 << (y & 7)))
+                {
+                    panel.drawPixel(x, y, 1);
+                }
+            }
+        }
+
+        panelFrames++;
+    }
+
+    void clearDisplay() { memset(buffer.data(), 0, buffer.size()); }
+    void invertDisplay(bool) {}
+    void dim(bool) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override
+    {
+        if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+        {
+            return;
+        }
+
+        uint8_t &page = buffer[x + (y / 8) * WIDTH];
+        uint8_t bit = 1 << (y & 7);
+
+        switch (color)
+        {
+        case SSD1306_WHITE:
+            page |= bit;
+            break;
+        case SSD1306_BLACK:
+            page &= ~bit;
+            break;
+        case SSD1306_INVERSE:
+            page ^= bit;
+            break;
+        }
+    }
+
+    // The library writes these straight into its RAM instead of going through drawPixel
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override
+    {
+        for (int16_t i = 0; i < w; i++)
+        {
+            Adafruit_SSD1306::drawPixel(x + i, y, color);
+        }
+    }
+
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override
+    {
+        for (int16_t i = 0; i < h; i++)
+        {
+            Adafruit_SSD1306::drawPixel(x, y + i, color);
+        }
+    }
+
+    bool getPixel(int16_t x, int16_t y) const
+    {
+        if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+        {
+            return false;
+        }
+
+        return buffer[x + (y / 8) * WIDTH] & (1 << (y & 7));
+    }
+
+    uint8_t *getBuffer() { return buffer.data(); }
+
+    // What the panel shows, as of the last display()
+    GFXcanvas1 panel;
+    uint32_t panelFrames = 0;
+
+private:
+    std::vector<uint8_t> buffer;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+    ArduinoJson for the host UI tools. Documents accept writes and hold nothing, so the UI code that reports
+    to the LEDs through them compiles. Only for the tools, never part of the firmware build.
+*/
+
+#include <stddef.h>
+
+namespace ArduinoJson
+{
+    class JsonVariant
+    {
+    public:
+        template <typename T>
+        JsonVariant &operator=(const T &) { return *this; }
+
+        template <typename Key>
+        JsonVariant operator[](const Key &) const { return JsonVariant(); }
+
+        bool isNull() const { return true; }
+    };
+
+    class JsonDocument
+    {
+    public:
+        template <typename Key>
+        JsonVariant operator[](const Key &) { return JsonVariant(); }
+
+        bool containsKey(const char *) const { return false; }
+        void clear() {}
+    };
+
+    class DynamicJsonDocument : public JsonDocument
+    {
+    public:
+        explicit DynamicJsonDocument(size_t) {}
+    };
+
+    template <typename Allocator>
+    class BasicJsonDocument : public JsonDocument
+    {
+    public:
+        explicit BasicJsonDocument(size_t) {}
+    };
+
+    template <size_t Capacity>
+    class StaticJsonDocument : public JsonDocument
+    {
+    };
+}
+
+using namespace ArduinoJson;
@@ -0,0 +1,10 @@
+#pragma once
+
+// LED_Manager for the host UI tools. Windows clear the ring when they close, there is no ring on the host.
+// Only for the tools, never part of the firmware build.
+
+class LED_Manager
+{
+public:
+    static void clearRing() {}
+};
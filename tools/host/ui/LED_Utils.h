@@ -0,0 +1,15 @@
+#pragma once
+
+// LED_Utils for the host UI tools. Menus drive the scroll wheel pattern, there is no ring on the host.
+// Only for the tools, never part of the firmware build.
+
+#include <ArduinoJson.h>
+
+class LED_Utils
+{
+public:
+    static void configurePattern(int, JsonDocument &) {}
+    static void enablePattern(int) {}
+    static void disablePattern(int) {}
+    static void iteratePattern(int) {}
+};
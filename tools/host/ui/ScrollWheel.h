@@ -0,0 +1,10 @@
+#pragma once
+
+// ScrollWheel for the host UI tools. No pattern is registered on the host.
+// Only for the tools, never part of the firmware build.
+
+class ScrollWheel
+{
+public:
+    static int RegisteredPatternID() { return -1; }
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+// System_Utils for the host UI tools. The UI sources compiled there use nothing from it.
+// Only for the tools, never part of the firmware build.
+
+#include <Arduino.h>
@@ -0,0 +1,9 @@
+#pragma once
+
+// Wire for the host UI tools. The fake SSD1306 never talks to it. Only for the tools, never part of the firmware build.
+
+class TwoWire
+{
+};
+
+inline TwoWire Wire;
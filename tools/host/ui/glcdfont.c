@@ -0,0 +1,270 @@
+// Stand-in for Adafruit_GFX's glcdfont.c in the host UI tools. Same layout as the library's: 256 glyphs of
+// 5 column bytes, LSB at the top, indexed as font[c * 5]. Printable ASCII uses a common 5x7 font. The other
+// codes hold distinct filler patterns, not the library's cp437 glyphs, so a lookup that is off by one still
+// shows up in a comparison. Only for the tools, never part of the firmware build.
+
+#ifndef FONT5X7_H
+#define FONT5X7_H
+
+#include <Arduino.h>
+
+static const unsigned char font[] PROGMEM = {
+    0x05, 0x11, 0x1B, 0x27, 0x31,
+    0x2B, 0x35, 0x41, 0x4B, 0x57,
+    0x4F, 0x5B, 0x65, 0x71, 0x7B,
+    0x75, 0x7F, 0x0B, 0x15, 0x21,
+    0x19, 0x25, 0x2F, 0x3B, 0x45,
+    0x3F, 0x49, 0x55, 0x5F, 0x6B,
+    0x63, 0x6F, 0x79, 0x05, 0x0F,
+    0x09, 0x13, 0x1F, 0x29, 0x35,
+    0x2D, 0x39, 0x43, 0x4F, 0x59,
+    0x53, 0x5D, 0x69, 0x73, 0x7F,
+    0x77, 0x03, 0x0D, 0x19, 0x23,
+    0x1D, 0x27, 0x33, 0x3D, 0x49,
+    0x41, 0x4D, 0x57, 0x63, 0x6D,
+    0x67, 0x71, 0x7D, 0x07, 0x13,
+    0x0B, 0x17, 0x21, 0x2D, 0x37,
+    0x31, 0x3B, 0x47, 0x51, 0x5D,
+    0x55, 0x61, 0x6B, 0x77, 0x01,
+    0x7B, 0x05, 0x11, 0x1B, 0x27,
+    0x1F, 0x2B, 0x35, 0x41, 0x4B,
+    0x45, 0x4F, 0x5B, 0x65, 0x71,
+    0x69, 0x75, 0x7F, 0x0B, 0x15,
+    0x0F, 0x19, 0x25, 0x2F, 0x3B,
+    0x33, 0x3F, 0x49, 0x55, 0x5F,
+    0x59, 0x63, 0x6F, 0x79, 0x05,
+    0x7D, 0x09, 0x13, 0x1F, 0x29,
+    0x23, 0x2D, 0x39, 0x43, 0x4F,
+    0x47, 0x53, 0x5D, 0x69, 0x73,
+    0x6D, 0x77, 0x03, 0x0D, 0x19,
+    0x11, 0x1D, 0x27, 0x33, 0x3D,
+    0x37, 0x41, 0x4D, 0x57, 0x63,
+    0x5B, 0x67, 0x71, 0x7D, 0x07,
+    0x01, 0x0B, 0x17, 0x21, 0x2D,
+    0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x5F, 0x00, 0x00,
+    0x00, 0x07, 0x00, 0x07, 0x00,
+    0x14, 0x7F, 0x14, 0x7F, 0x14,
+    0x24, 0x2A, 0x7F, 0x2A, 0x12,
+    0x23, 0x13, 0x08, 0x64, 0x62,
+    0x36, 0x49, 0x56, 0x20, 0x50,
+    0x00, 0x08, 0x07, 0x03, 0x00,
+    0x00, 0x1C, 0x22, 0x41, 0x00,
+    0x00, 0x41, 0x22, 0x1C, 0x00,
+    0x2A, 0x1C, 0x7F, 0x1C, 0x2A,
+    0x08, 0x08, 0x3E, 0x08, 0x08,
+    0x00, 0x80, 0x70, 0x30, 0x00,
+    0x08, 0x08, 0x08, 0x08, 0x08,
+    0x00, 0x00, 0x60, 0x60, 0x00,
+    0x20, 0x10, 0x08, 0x04, 0x02,
+    0x3E, 0x51, 0x49, 0x45, 0x3E,
+    0x00, 0x42, 0x7F, 0x40, 0x00,
+    0x72, 0x49, 0x49, 0x49, 0x46,
+    0x21, 0x41, 0x49, 0x4D, 0x33,
+    0x18, 0x14, 0x12, 0x7F, 0x10,
+    0x27, 0x45, 0x45, 0x45, 0x39,
+    0x3C, 0x4A, 0x49, 0x49, 0x31,
+    0x41, 0x21, 0x11, 0x09, 0x07,
+    0x36, 0x49, 0x49, 0x49, 0x36,
+    0x46, 0x49, 0x49, 0x29, 0x1E,
+    0x00, 0x00, 0x14, 0x00, 0x00,
+    0x00, 0x40, 0x34, 0x00, 0x00,
+    0x00, 0x08, 0x14, 0x22, 0x41,
+    0x14, 0x14, 0x14, 0x14, 0x14,
+    0x00, 0x41, 0x22, 0x14, 0x08,
+    0x02, 0x01, 0x59, 0x09, 0x06,
+    0x3E, 0x41, 0x5D, 0x59, 0x4E,
+    0x7C, 0x12, 0x11, 0x12, 0x7C,
+    0x7F, 0x49, 0x49, 0x49, 0x36,
+    0x3E, 0x41, 0x41, 0x41, 0x22,
+    0x7F, 0x41, 0x41, 0x41, 0x3E,
+    0x7F, 0x49, 0x49, 0x49, 0x41,
+    0x7F, 0x09, 0x09, 0x09, 0x01,
+    0x3E, 0x41, 0x41, 0x51, 0x73,
+    0x7F, 0x08, 0x08, 0x08, 0x7F,
+    0x00, 0x41, 0x7F, 0x41, 0x00,
+    0x20, 0x40, 0x41, 0x3F, 0x01,
+    0x7F, 0x08, 0x14, 0x22, 0x41,
+    0x7F, 0x40, 0x40, 0x40, 0x40,
+    0x7F, 0x02, 0x1C, 0x02, 0x7F,
+    0x7F, 0x04, 0x08, 0x10, 0x7F,
+    0x3E, 0x41, 0x41, 0x41, 0x3E,
+    0x7F, 0x09, 0x09, 0x09, 0x06,
+    0x3E, 0x41, 0x51, 0x21, 0x5E,
+    0x7F, 0x09, 0x19, 0x29, 0x46,
+    0x26, 0x49, 0x49, 0x49, 0x32,
+    0x03, 0x01, 0x7F, 0x01, 0x03,
+    0x3F, 0x40, 0x40, 0x40, 0x3F,
+    0x1F, 0x20, 0x40, 0x20, 0x1F,
+    0x3F, 0x40, 0x38, 0x40, 0x3F,
+    0x63, 0x14, 0x08, 0x14, 0x63,
+    0x03, 0x04, 0x78, 0x04, 0x03,
+    0x61, 0x59, 0x49, 0x4D, 0x43,
+    0x00, 0x7F, 0x41, 0x41, 0x41,
+    0x02, 0x04, 0x08, 0x10, 0x20,
+    0x00, 0x41, 0x41, 0x41, 0x7F,
+    0x04, 0x02, 0x01, 0x02, 0x04,
+    0x40, 0x40, 0x40, 0x40, 0x40,
+    0x00, 0x03, 0x07, 0x08, 0x00,
+    0x20, 0x54, 0x54, 0x78, 0x40,
+    0x7F, 0x28, 0x44, 0x44, 0x38,
+    0x38, 0x44, 0x44, 0x44, 0x28,
+    0x38, 0x44, 0x44, 0x28, 0x7F,
+    0x38, 0x54, 0x54, 0x54, 0x18,
+    0x00, 0x08, 0x7E, 0x09, 0x02,
+    0x18, 0xA4, 0xA4, 0x9C, 0x78,
+    0x7F, 0x08, 0x04, 0x04, 0x78,
+    0x00, 0x44, 0x7D, 0x40, 0x00,
+    0x20, 0x40, 0x40, 0x3D, 0x00,
+    0x7F, 0x10, 0x28, 0x44, 0x00,
+    0x00, 0x41, 0x7F, 0x40, 0x00,
+    0x7C, 0x04, 0x78, 0x04, 0x78,
+    0x7C, 0x08, 0x04, 0x04, 0x78,
+    0x38, 0x44, 0x44, 0x44, 0x38,
+    0xFC, 0x18, 0x24, 0x24, 0x18,
+    0x18, 0x24, 0x24, 0x18, 0xFC,
+    0x7C, 0x08, 0x04, 0x04, 0x08,
+    0x48, 0x54, 0x54, 0x54, 0x24,
+    0x04, 0x04, 0x3F, 0x44, 0x24,
+    0x3C, 0x40, 0x40, 0x20, 0x7C,
+    0x1C, 0x20, 0x40, 0x20, 0x1C,
+    0x3C, 0x40, 0x30, 0x40, 0x3C,
+    0x44, 0x28, 0x10, 0x28, 0x44,
+    0x4C, 0x90, 0x90, 0x90, 0x7C,
+    0x44, 0x64, 0x54, 0x4C, 0x44,
+    0x00, 0x08, 0x36, 0x41, 0x00,
+    0x00, 0x00, 0x77, 0x00, 0x00,
+    0x00, 0x41, 0x36, 0x08, 0x00,
+    0x02, 0x01, 0x02, 0x04, 0x02,
+    0x61, 0x6B, 0x77, 0x01, 0x0D,
+    0x05, 0x11, 0x1B, 0x27, 0x31,
+    0x2B, 0x35, 0x41, 0x4B, 0x57,
+    0x4F, 0x5B, 0x65, 0x71, 0x7B,
+    0x75, 0x7F, 0x0B, 0x15, 0x21,
+    0x19, 0x25, 0x2F, 0x3B, 0x45,
+    0x3F, 0x49, 0x55, 0x5F, 0x6B,
+    0x63, 0x6F, 0x79, 0x05, 0x0F,
+    0x09, 0x13, 0x1F, 0x29, 0x35,
+    0x2D, 0x39, 0x43, 0x4F, 0x59,
+    0x53, 0x5D, 0x69, 0x73, 0x7F,
+    0x77, 0x03, 0x0D, 0x19, 0x23,
+    0x1D, 0x27, 0x33, 0x3D, 0x49,
+    0x41, 0x4D, 0x57, 0x63, 0x6D,
+    0x67, 0x71, 0x7D, 0x07, 0x13,
+    0x0B, 0x17, 0x21, 0x2D, 0x37,
+    0x31, 0x3B, 0x47, 0x51, 0x5D,
+    0x55, 0x61, 0x6B, 0x77, 0x01,
+    0x7B, 0x05, 0x11, 0x1B, 0x27,
+    0x1F, 0x2B, 0x35, 0x41, 0x4B,
+    0x45, 0x4F, 0x5B, 0x65, 0x71,
+    0x69, 0x75, 0x7F, 0x0B, 0x15,
+    0x0F, 0x19, 0x25, 0x2F, 0x3B,
+    0x33, 0x3F, 0x49, 0x55, 0x5F,
+    0x59, 0x63, 0x6F, 0x79, 0x05,
+    0x7D, 0x09, 0x13, 0x1F, 0x29,
+    0x23, 0x2D, 0x39, 0x43, 0x4F,
+    0x47, 0x53, 0x5D, 0x69, 0x73,
+    0x6D, 0x77, 0x03, 0x0D, 0x19,
+    0x11, 0x1D, 0x27, 0x33, 0x3D,
+    0x37, 0x41, 0x4D, 0x57, 0x63,
+    0x5B, 0x67, 0x71, 0x7D, 0x07,
+    0x01, 0x0B, 0x17, 0x21, 0x2D,
+    0x25, 0x31, 0x3B, 0x47, 0x51,
+    0x4B, 0x55, 0x61, 0x6B, 0x77,
+    0x6F, 0x7B, 0x05, 0x11, 0x1B,
+    0x15, 0x1F, 0x2B, 0x35, 0x41,
+    0x39, 0x45, 0x4F, 0x5B, 0x65,
+    0x5F, 0x69, 0x75, 0x7F, 0x0B,
+    0x03, 0x0F, 0x19, 0x25, 0x2F,
+    0x29, 0x33, 0x3F, 0x49, 0x55,
+    0x4D, 0x59, 0x63, 0x6F, 0x79,
+    0x73, 0x7D, 0x09, 0x13, 0x1F,
+    0x17, 0x23, 0x2D, 0x39, 0x43,
+    0x3D, 0x47, 0x53, 0x5D, 0x69,
+    0x61, 0x6D, 0x77, 0x03, 0x0D,
+    0x07, 0x11, 0x1D, 0x27, 0x33,
+    0x2B, 0x37, 0x41, 0x4D, 0x57,
+    0x51, 0x5B, 0x67, 0x71, 0x7D,
+    0x75, 0x01, 0x0B, 0x17, 0x21,
+    0x1B, 0x25, 0x31, 0x3B, 0x47,
+    0x3F, 0x4B, 0x55, 0x61, 0x6B,
+    0x65, 0x6F, 0x7B, 0x05, 0x11,
+    0x09, 0x15, 0x1F, 0x2B, 0x35,
+    0x2F, 0x39, 0x45, 0x4F, 0x5B,
+    0x53, 0x5F, 0x69, 0x75, 0x7F,
+    0x79, 0x03, 0x0F, 0x19, 0x25,
+    0x1D, 0x29, 0x33, 0x3F, 0x49,
+    0x43, 0x4D, 0x59, 0x63, 0x6F,
+    0x67, 0x73, 0x7D, 0x09, 0x13,
+    0x0D, 0x17, 0x23, 0x2D, 0x39,
+    0x31, 0x3D, 0x47, 0x53, 0x5D,
+    0x57, 0x61, 0x6D, 0x77, 0x03,
+    0x7B, 0x07, 0x11, 0x1D, 0x27,
+    0x21, 0x2B, 0x37, 0x41, 0x4D,
+    0x45, 0x51, 0x5B, 0x67, 0x71,
+    0x6B, 0x75, 0x01, 0x0B, 0x17,
+    0x0F, 0x1B, 0x25, 0x31, 0x3B,
+    0x35, 0x3F, 0x4B, 0x55, 0x61,
+    0x59, 0x65, 0x6F, 0x7B, 0x05,
+    0x7F, 0x09, 0x15, 0x1F, 0x2B,
+    0x23, 0x2F, 0x39, 0x45, 0x4F,
+    0x49, 0x53, 0x5F, 0x69, 0x75,
+    0x6D, 0x79, 0x03, 0x0F, 0x19,
+    0x13, 0x1D, 0x29, 0x33, 0x3F,
+    0x37, 0x43, 0x4D, 0x59, 0x63,
+    0x5D, 0x67, 0x73, 0x7D, 0x09,
+    0x01, 0x0D, 0x17, 0x23, 0x2D,
+    0x27, 0x31, 0x3D, 0x47, 0x53,
+    0x4B, 0x57, 0x61, 0x6D, 0x77,
+    0x71, 0x7B, 0x07, 0x11, 0x1D,
+    0x15, 0x21, 0x2B, 0x37, 0x41,
+    0x3B, 0x45, 0x51, 0x5B, 0x67,
+    0x5F, 0x6B, 0x75, 0x01, 0x0B,
+    0x05, 0x0F, 0x1B, 0x25, 0x31,
+    0x29, 0x35, 0x3F, 0x4B, 0x55,
+    0x4F, 0x59, 0x65, 0x6F, 0x7B,
+    0x73, 0x7F, 0x09, 0x15, 0x1F,
+    0x19, 0x23, 0x2F, 0x39, 0x45,
+    0x3D, 0x49, 0x53, 0x5F, 0x69,
+    0x63, 0x6D, 0x79, 0x03, 0x0F,
+    0x07, 0x13, 0x1D, 0x29, 0x33,
+    0x2D, 0x37, 0x43, 0x4D, 0x59,
+    0x51, 0x5D, 0x67, 0x73, 0x7D,
+    0x77, 0x01, 0x0D, 0x17, 0x23,
+    0x1B, 0x27, 0x31, 0x3D, 0x47,
+    0x41, 0x4B, 0x57, 0x61, 0x6D,
+    0x65, 0x71, 0x7B, 0x07, 0x11,
+    0x0B, 0x15, 0x21, 0x2B, 0x37,
+    0x2F, 0x3B, 0x45, 0x51, 0x5B,
+    0x55, 0x5F, 0x6B, 0x75, 0x01,
+    0x79, 0x05, 0x0F, 0x1B, 0x25,
+    0x1F, 0x29, 0x35, 0x3F, 0x4B,
+    0x43, 0x4F, 0x59, 0x65, 0x6F,
+    0x69, 0x73, 0x7F, 0x09, 0x15,
+    0x0D, 0x19, 0x23, 0x2F, 0x39,
+    0x33, 0x3D, 0x49, 0x53, 0x5F,
+    0x57, 0x63, 0x6D, 0x79, 0x03,
+    0x7D, 0x07, 0x13, 0x1D, 0x29,
+    0x21, 0x2D, 0x37, 0x43, 0x4D,
+    0x47, 0x51, 0x5D, 0x67, 0x73,
+    0x6B, 0x77, 0x01, 0x0D, 0x17,
+    0x11, 0x1B, 0x27, 0x31, 0x3D,
+    0x35, 0x41, 0x4B, 0x57, 0x61,
+    0x5B, 0x65, 0x71, 0x7B, 0x07,
+    0x7F, 0x0B, 0x15, 0x21, 0x2B,
+    0x25, 0x2F, 0x3B, 0x45, 0x51,
+    0x49, 0x55, 0x5F, 0x6B, 0x75,
+    0x6F, 0x79, 0x05, 0x0F, 0x1B,
+    0x13, 0x1F, 0x29, 0x35, 0x3F,
+    0x39, 0x43, 0x4F, 0x59, 0x65,
+    0x5D, 0x69, 0x73, 0x7F, 0x09,
+    0x03, 0x0D, 0x19, 0x23, 0x2F,
+    0x27, 0x33, 0x3D, 0x49, 0x53,
+    0x4D, 0x57, 0x63, 0x6D, 0x79,
+    0x71, 0x7D, 0x07, 0x13, 0x1D,
+    0x17, 0x21, 0x2D, 0x37, 0x43,
+    0x3B, 0x47, 0x51, 0x5D, 0x67,
+    0x61, 0x6B, 0x77, 0x01, 0x0D,
+};
+
+#endif
@@ -0,0 +1,221 @@
+/*
+    Checks LED_Program_Evaluator against the float patterns the built in programs replaced, and times both.
+
+        g++ -O2 -I host -I ../include/HelperClasses/LED_Patterns keyframe_test.cpp -o keyframe_test
+        ./keyframe_test
+
+    The references are Ring_Pulse::iterateFrame and Button_Flash::iterateFrame as they were before Keyframe_Pattern.
+    Every millisecond of the loop is rendered for several loop lengths and colours, and every channel must be within
+    one LSB of the reference. Easing curves and keyframe lookup are checked on a program of their own.
+    Exits with 1 on any failure.
+
+    The timing is of the colour for one frame only. A host FPU makes the float path cheap; the saving on the device
+    is mostly the JSON documents the old patterns were configured through.
+*/
+
+#include "LED_Program.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#define BENCH_FRAMES 1000000
+
+typedef std::chrono::steady_clock Clock;
+
+static const CRGB colors[] = {CRGB(255, 255, 255), CRGB(255, 128, 0), CRGB(37, 200, 3), CRGB(1, 2, 254)};
+static const uint32_t lengthsMS[] = {150, 300, 1000, 2000};
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what, uint32_t value)
+{
+    if (!condition)
+    {
+        if (failures < 10)
+        {
+            fprintf(stderr, "%s at %u\n", what, value);
+        }
+
+        failures++;
+    }
+}
+
+static CRGB scaled(const CRGB &color, float brightness)
+{
+    return CRGB(color.r * brightness, color.g * brightness, color.b * brightness);
+}
+
+// Ring_Pulse before Keyframe_Pattern
+static CRGB referencePulse(const CRGB &color, uint32_t currMS, uint32_t animationMS)
+{
+    float brightness;
+
+    if (currMS < animationMS / 2)
+    {
+        brightness = (float)currMS / (float)(animationMS / 2);
+    }
+    else
+    {
+        brightness = 1.0 - (float)(currMS - (animationMS / 2)) / (float)(animationMS / 2);
+    }
+
+    return scaled(color, brightness);
+}
+
+// Button_Flash before Keyframe_Pattern
+static CRGB referenceFlash(const CRGB &color, uint32_t currMS, uint32_t animationMS)
+{
+    return scaled(color, 1.0 - (float)currMS / (float)animationMS);
+}
+
+// As Keyframe_Pattern::iterateFrame colours a track
+static CRGB evaluate(const LED_Program &program, const CRGB &color, uint32_t currMS, uint32_t lengthMS)
+{
+    CRGB out = color;
+    out.nscale8(LED_Program_Evaluator::Level(program, program.tracks[0], LED_Program_Evaluator::Position(currMS, lengthMS)));
+    return out;
+}
+
+template <typename Reference>
+static int comparePort(const char *name, const LED_Program &program, Reference reference)
+{
+    int maxError = 0;
+
+    for (uint32_t lengthMS : lengthsMS)
+    {
+        for (uint32_t currMS = 0; currMS < lengthMS; currMS++)
+        {
+            for (const CRGB &color : colors)
+            {
+                CRGB expected = reference(color, currMS, lengthMS);
+                CRGB actual = evaluate(program, color, currMS, lengthMS);
+
+                for (int c = 0; c < 3; c++)
+                {
+                    int error = abs((int)expected.raw[c] - (int)actual.raw[c]);
+                    maxError = max(maxError, error);
+
+                    if (error > 1 && failures < 10)
+                    {
+                        fprintf(stderr, "%s: %u of %u ms channel %d expected %d got %d\n", name, currMS, lengthMS, c, expected.raw[c], actual.raw[c]);
+                    }
+
+                    failures += error > 1;
+                }
+            }
+        }
+    }
+
+    return maxError;
+}
+
+static void checkEasing()
+{
+    const LED_Easing curves[] = {LED_EASE_LINEAR, LED_EASE_IN, LED_EASE_OUT, LED_EASE_IN_OUT};
+
+    for (LED_Easing easing : curves)
+    {
+        uint8_t last = LED_Program_Evaluator::Ease(0, easing);
+        check(last == 0, "easing does not start at 0", easing);
+        check(LED_Program_Evaluator::Ease(255, easing) >= 254, "easing does not end at 255", easing);
+
+        for (uint32_t fraction = 1; fraction <= 255; fraction++)
+        {
+            uint8_t eased = LED_Program_Evaluator::Ease(fraction, easing);
+            check(eased >= last, "easing is not monotonic", fraction);
+            last = eased;
+        }
+    }
+
+    check(LED_Program_Evaluator::Ease(200, LED_EASE_STEP) == 0, "step easing moves before the keyframe", 200);
+}
+
+// Two tracks sharing the keyframe array, one holding then stepping, one easing in and out
+static void checkKeyframes()
+{
+    LED_Program program = {};
+
+    program.lengthMS = 1000;
+    program.numTracks = 2;
+    program.numKeyframes = 5;
+
+    program.tracks[0].firstKeyframe = 0;
+    program.tracks[0].numKeyframes = 2;
+    program.keyframes[0] = {16384, 40, LED_EASE_LINEAR};
+    program.keyframes[1] = {49152, 200, LED_EASE_STEP};
+
+    program.tracks[1].firstKeyframe = 2;
+    program.tracks[1].numKeyframes = 3;
+    program.keyframes[2] = {0, 0, LED_EASE_LINEAR};
+    program.keyframes[3] = {32768, 255, LED_EASE_IN_OUT};
+    program.keyframes[4] = {UINT16_MAX, 10, LED_EASE_OUT};
+
+    const LED_Track &hold = program.tracks[0];
+    const LED_Track &pulse = program.tracks[1];
+
+    check(LED_Program_Evaluator::Level(program, hold, 0) == 40, "level before the first keyframe", 0);
+    check(LED_Program_Evaluator::Level(program, hold, 30000) == 40, "step easing left the previous level", 30000);
+    check(LED_Program_Evaluator::Level(program, hold, 49152) == 200, "level at a keyframe", 49152);
+    check(LED_Program_Evaluator::Level(program, hold, UINT16_MAX) == 200, "level after the last keyframe", UINT16_MAX);
+
+    uint8_t last = 0;
+
+    for (uint32_t position = 0; position <= UINT16_MAX; position += 64)
+    {
+        uint8_t level = LED_Program_Evaluator::Level(program, pulse, position);
+
+        check(position >= 32768 || level >= last, "rising half is not monotonic", position);
+        check(position <= 32768 || level <= last, "falling half is not monotonic", position);
+        last = level;
+    }
+
+    check(LED_Program_Evaluator::Level(program, pulse, 32768) == 255, "level at the peak keyframe", 32768);
+    check(LED_Program_Evaluator::Position(1000, 1000) == UINT16_MAX, "position past the end of the loop", 1000);
+    check(LED_Program_Evaluator::Position(500, 1000) == UINT16_MAX / 2, "position halfway through the loop", 500);
+
+    // Loops longer than 16 bits of milliseconds
+    program.lengthMS = 120000;
+    check(program.lengthMS == 120000, "program length cut down", program.lengthMS);
+    check(LED_Program_Evaluator::Position(60000, program.lengthMS) == UINT16_MAX / 2, "position halfway through a two minute loop", 60000);
+}
+
+template <typename Render>
+static double nsPerFrame(Render render)
+{
+    uint32_t sink = 0;
+    auto start = Clock::now();
+
+    for (uint32_t frame = 0; frame < BENCH_FRAMES; frame++)
+    {
+        sink += render(frame % 1000).r;
+    }
+
+    // Keep the frames from being optimised away
+    volatile uint32_t keep = sink;
+    (void)keep;
+
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / BENCH_FRAMES;
+}
+
+int main()
+{
+    int pulseError = comparePort("Ring_Pulse", LED_Program_Evaluator::RingPulse(), referencePulse);
+    int flashError = comparePort("Button_Flash", LED_Program_Evaluator::ButtonFlash(), referenceFlash);
+
+    checkEasing();
+    checkKeyframes();
+
+    static const LED_Program pulse = LED_Program_Evaluator::RingPulse();
+
+    double floatNS = nsPerFrame([](uint32_t ms) { return referencePulse(colors[1], ms, 1000); });
+    double programNS = nsPerFrame([](uint32_t ms) { return evaluate(pulse, colors[1], ms, 1000); });
+
+    printf("Ring_Pulse as a program:   max error %d LSB\n", pulseError);
+    printf("Button_Flash as a program: max error %d LSB\n", flashError);
+    printf("colour per frame:          float %.1f ns, program %.1f ns\n", floatNS, programNS);
+    printf("program size:              %zu bytes\n", sizeof(LED_Program));
+    printf("failures:                  %zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/*
+    Checks that LED_Output_Stage never sends a frame over its current budget.
+
+        g++ -O2 -I host -I ../include/HelperClasses/LED_Patterns led_budget_test.cpp \
+            ../src/HelperClasses/LED_Patterns/LED_Output_Stage.cpp -o led_budget_test
+        ./led_budget_test [frames] [seed]
+
+    Random frames, from sparse dim ones to full white, are rendered back to back so dither error carries between
+    them. Budgets and battery levels are swept, with gamma and dithering on and off. Each output frame's estimated
+    current must be within the effective budget. A budget below the current of the dark string must give a dark
+    frame. Frames well under budget must not be scaled, and a steady frame must dither to its 8.8 average.
+    Exits with 1 on any failure.
+*/
+
+#include "LED_Output_Stage.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// As the larger of the two boards in globalDefines.h
+#define NUM_LEDS 31
+
+typedef std::chrono::steady_clock Clock;
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what, size_t frame, uint32_t estimate, uint32_t budget)
+{
+    if (!condition)
+    {
+        if (failures < 10)
+        {
+            fprintf(stderr, "frame %zu: %s (estimate %u mA, budget %u mA)\n", frame, what, estimate, budget);
+        }
+
+        failures++;
+    }
+}
+
+static void randomFrame(std::mt19937 &rng, CRGB *frame)
+{
+    uint32_t kind = rng() % 4;
+
+    for (int i = 0; i < NUM_LEDS; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            switch (kind)
+            {
+            case 0:
+                frame[i].raw[c] = 255;
+                break;
+            case 1:
+                frame[i].raw[c] = rng() % 8 == 0 ? rng() % 256 : 0;
+                break;
+            case 2:
+                frame[i].raw[c] = rng() % 64;
+                break;
+            default:
+                frame[i].raw[c] = rng() % 256;
+                break;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t framesPerCase = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+    unsigned seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+
+    std::mt19937 rng(seed);
+
+    CRGB frame[NUM_LEDS];
+    CRGB output[NUM_LEDS];
+
+    const uint16_t budgets[] = {0, 15, 25, 60, 150, 300, LED_DEFAULT_BUDGET_MA, 1200, 5000};
+    const long batteries[] = {100, 60, 50, 30, 10, 0};
+
+    LED_Output_Stage::init(NUM_LEDS);
+
+    size_t frames = 0;
+    uint32_t darkMA = NUM_LEDS * LED_IDLE_MA;
+    double renderNS = 0;
+
+    for (uint16_t budget : budgets)
+    {
+        for (long battery : batteries)
+        {
+            for (int mode = 0; mode < 4; mode++)
+            {
+                LED_Output_Stage::setBudgetMA(budget);
+                LED_Output_Stage::setBatteryPercentage(battery);
+                LED_Output_Stage::setGammaEnabled(mode & 1);
+                LED_Output_Stage::setDitherEnabled(mode & 2);
+
+                uint32_t effective = LED_Output_Stage::EffectiveBudgetMA();
+                check(effective <= budget, "derated budget above the set budget", frames, effective, budget);
+
+                for (size_t f = 0; f < framesPerCase; f++, frames++)
+                {
+                    randomFrame(rng, frame);
+
+                    auto start = Clock::now();
+                    LED_Output_Stage::render(frame, output, NUM_LEDS);
+                    renderNS += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+                    uint32_t estimate = LED_Output_Stage::EstimateMA(output, NUM_LEDS);
+                    check(estimate == LED_Output_Stage::LastEstimateMA(), "last estimate does not match the output", frames, estimate, effective);
+
+                    if (effective >= darkMA)
+                    {
+                        check(estimate <= effective, "frame over budget", frames, estimate, effective);
+                    }
+                    else
+                    {
+                        check(estimate == darkMA, "budget below the dark string but LEDs lit", frames, estimate, effective);
+                    }
+                }
+            }
+        }
+    }
+
+    // A dim frame far under budget passes without scaling, and its dithered average matches the 8.8 gamma value
+    LED_Output_Stage::setBudgetMA(5000);
+    LED_Output_Stage::setBatteryPercentage(100);
+    LED_Output_Stage::setGammaEnabled(true);
+    LED_Output_Stage::setDitherEnabled(true);
+    LED_Output_Stage::init(NUM_LEDS);
+
+    fill_solid(frame, NUM_LEDS, CRGB(40, 40, 40));
+
+    uint32_t limitedBefore = LED_Output_Stage::LimitedFrames();
+    uint32_t sum = 0;
+    const uint32_t averageFrames = 256;
+
+    for (uint32_t f = 0; f < averageFrames; f++)
+    {
+        LED_Output_Stage::render(frame, output, NUM_LEDS);
+        sum += output[0].r;
+    }
+
+    // The gamma table's curve in 8 bits, without its 8.8 rounding
+    double expected = pow(40 / 255.0, 2.2) * 255.0;
+    double average = (double)sum / averageFrames;
+
+    check(LED_Output_Stage::LimitedFrames() == limitedBefore, "frame under budget was scaled", frames, 0, 5000);
+    check(fabs(average - expected) < 0.01, "dithered average drifted from the gamma value", frames, 0, 5000);
+
+    printf("%zu frames of %d LEDs\n\n", frames, NUM_LEDS);
+    printf("frames limited:        %8u\n", LED_Output_Stage::LimitedFrames());
+    printf("render:                %8.1f ns per frame\n", renderNS / frames);
+    printf("dithered average:      %8.3f, expected %.3f\n", average, expected);
+    printf("failures:              %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
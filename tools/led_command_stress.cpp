@@ -0,0 +1,295 @@
+/*
+    Hammers the LED command protocol from several threads and checks nothing leaks.
+
+        g++ -O1 -g -fsanitize=address -pthread -I host/ui -I host -I ../include -I ../include/Interfaces \
+            -I ../include/Utilities led_command_stress.cpp ../src/HelperClasses/LED_Patterns/LED_Pattern_Interface.cpp \
+            -o led_command_stress
+        ./led_command_stress [threads] [iterations]
+
+    Registering, sending, unregistering, draining the queue, deleting patterns and compositing are the real
+    LED_Pattern_Table that LED_Utils uses, over the host FreeRTOS queue. Only the command handler is the test's:
+    it enables patterns, counts configures and fills the layer on iterate, as LED_Utils::processCommand marks it
+    visible. The LED thread runs processCommands then composite every frame, like iteratePatterns, so layers are
+    composited while other threads register and unregister them. Built with AddressSanitizer, so compositing a
+    deleted layer fails the run.
+
+    The LED thread stalls for longer than LED_COMMAND_SEND_TIMEOUT_MS now and then, so full queues, dropped
+    frames and failed registers all happen. A register that finds every ID claimed is retried after a short wait,
+    so each thread gets through all its iterations. At the end every pattern and layer must be deleted, every ID free,
+    and the drop counter must match the drops the callers saw. Every composited LED must be black or a layer's
+    colour. Exits with 1 otherwise.
+*/
+
+#include "LED_Pattern_Table.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+// As LED_Utils.h
+#define LED_COMMAND_QUEUE_LENGTH 16
+
+// The LED thread stalls past the send timeout once every this many frames
+#define STALL_EVERY_FRAMES 400
+#define STALL_MS (LED_COMMAND_SEND_TIMEOUT_MS + 50)
+
+#define NUM_LEDS 16
+
+// Every layer is filled with this on iterate
+static const CRGB LAYER_COLOR(10, 20, 30);
+
+static std::atomic<int> livePatterns(0);
+static std::atomic<int> liveArrays(0);
+
+// Layers are the only arrays the test allocates with new[]
+void *operator new[](size_t size)
+{
+    void *memory = malloc(size);
+
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    liveArrays++;
+    return memory;
+}
+
+void operator delete[](void *memory) noexcept
+{
+    if (memory != nullptr)
+    {
+        liveArrays--;
+    }
+
+    free(memory);
+}
+
+class Stress_Pattern : public LED_Pattern_Interface
+{
+public:
+    Stress_Pattern() { livePatterns++; }
+    ~Stress_Pattern() { livePatterns--; }
+
+    void SetRegisteredPatternID(int patternID) {}
+
+    int configures = 0;
+};
+
+static size_t failures = 0;
+
+static void fail(const char *what, int patternID)
+{
+    if (failures < 10)
+    {
+        fprintf(stderr, "%s: pattern %d\n", what, patternID);
+    }
+
+    failures++;
+}
+
+// Stands in for LED_Utils::processCommand
+static void handleCommand(LED_Pattern_Status &status, LED_Command &command, size_t frameMS)
+{
+    switch (command.type)
+    {
+    case LED_COMMAND_ENABLE:
+        status.enabled = true;
+        break;
+    case LED_COMMAND_CONFIGURE:
+        ((Stress_Pattern *)status.pattern)->configures++;
+        break;
+    case LED_COMMAND_ITERATE:
+        if (status.enabled)
+        {
+            fill_solid(status.pattern->Layer(), NUM_LEDS, LAYER_COLOR);
+            status.visible = true;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static LED_Pattern_Table patterns(handleCommand);
+
+static bool sendCommand(LED_Command_Type type, int patternID)
+{
+    LED_Command command = {type, patternID};
+    return patterns.sendCommand(command);
+}
+
+int main(int argc, char **argv)
+{
+    int numThreads = argc > 1 ? atoi(argv[1]) : 6;
+    int iterations = argc > 2 ? atoi(argv[2]) : 3000;
+
+    LED_Pattern_Interface::setNumLeds(NUM_LEDS);
+
+    QueueHandle_t queue = xQueueCreate(LED_COMMAND_QUEUE_LENGTH, sizeof(LED_Command));
+    patterns.setQueue(queue);
+
+    std::atomic<bool> ledTaskReady(false);
+    std::atomic<int> producersLeft(numThreads);
+    std::atomic<uint32_t> seenDrops(0);
+    std::atomic<uint32_t> failedRegisters(0);
+    std::atomic<uint32_t> registeredCount(0);
+    std::atomic<uint32_t> noSlot(0);
+    uint32_t frames = 0;
+    uint32_t litFrames = 0;
+
+    std::thread ledTask([&]() {
+        patterns.setLedTask(xTaskGetCurrentTaskHandle());
+        ledTaskReady = true;
+
+        std::mt19937 rng(7);
+        CRGB frame[NUM_LEDS];
+
+        for (uint32_t frameNumber = 1; producersLeft.load() > 0; frameNumber++)
+        {
+            patterns.processCommands(frameNumber);
+
+            fill_solid(frame, NUM_LEDS, CRGB::Black);
+            patterns.composite(frame, NUM_LEDS);
+            frames++;
+
+            if (frame[0] != CRGB(CRGB::Black))
+            {
+                litFrames++;
+            }
+
+            for (int i = 0; i < NUM_LEDS; i++)
+            {
+                if (frame[i] != CRGB(CRGB::Black) && frame[i] != LAYER_COLOR)
+                {
+                    fail("composited an LED that no layer drew", -1);
+                    break;
+                }
+            }
+
+            bool stall = frameNumber % STALL_EVERY_FRAMES == 0;
+            std::this_thread::sleep_for(std::chrono::microseconds(stall ? STALL_MS * 1000 : rng() % 500));
+        }
+
+        patterns.processCommands(0);
+    });
+
+    while (!ledTaskReady.load())
+    {
+        std::this_thread::yield();
+    }
+
+    std::vector<std::thread> producers;
+
+    for (int t = 0; t < numThreads; t++)
+    {
+        producers.emplace_back([&, t]() {
+            std::mt19937 rng(t + 1);
+
+            for (int i = 0; i < iterations; i++)
+            {
+                Stress_Pattern *pattern = new Stress_Pattern();
+                int patternID = patterns.registerPattern(pattern, NUM_LEDS);
+
+                if (patternID < 0)
+                {
+                    // The caller still owns a pattern that failed to register
+                    delete pattern;
+
+                    // Every ID is claimed until the LED thread deletes some, so wait for a frame and try again
+                    if (patternID == LED_PATTERN_NO_SLOT)
+                    {
+                        noSlot++;
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                        i--;
+                        continue;
+                    }
+
+                    failedRegisters++;
+                    continue;
+                }
+
+                registeredCount++;
+
+                if (!sendCommand(LED_COMMAND_ENABLE, patternID))
+                {
+                    seenDrops++;
+                }
+
+                for (uint32_t c = rng() % 6; c > 0; c--)
+                {
+                    if (!sendCommand(c % 2 ? LED_COMMAND_ITERATE : LED_COMMAND_CONFIGURE, patternID))
+                    {
+                        seenDrops++;
+                    }
+                }
+
+                patterns.unregisterPattern(patternID);
+            }
+
+            producersLeft--;
+        });
+    }
+
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+
+    ledTask.join();
+
+    for (int id = 0; id < MAX_LED_PATTERNS; id++)
+    {
+        if (patterns.status(id).pattern != nullptr)
+        {
+            fail("pattern still registered", id);
+        }
+    }
+
+    if (livePatterns.load() != 0 || liveArrays.load() != 0)
+    {
+        fail("leaked patterns or layers", -1);
+    }
+
+    for (int id = 0; id < MAX_LED_PATTERNS; id++)
+    {
+        if (patterns.isClaimed(id))
+        {
+            fail("ID still claimed", id);
+        }
+    }
+
+    // Every dropped command is either one a caller saw fail or a register that was rolled back
+    if (patterns.DroppedCommands() != seenDrops.load() + failedRegisters.load())
+    {
+        fail("drop counter does not match the drops seen", -1);
+    }
+
+    if (registeredCount.load() + failedRegisters.load() != (uint32_t)(numThreads * iterations))
+    {
+        fail("registers went missing", -1);
+    }
+
+    if (litFrames == 0)
+    {
+        fail("no layer was ever composited", -1);
+    }
+
+    vQueueDelete(queue);
+
+    printf("%d threads x %d patterns\n\n", numThreads, iterations);
+    printf("registered:            %8u\n", registeredCount.load());
+    printf("register timed out:    %8u\n", failedRegisters.load());
+    printf("no free slot, retried: %8u\n", noSlot.load());
+    printf("commands dropped:      %8u\n", patterns.DroppedCommands());
+    printf("frames composited:     %8u, %u with a layer showing\n", frames, litFrames);
+    printf("leaked patterns:       %8d\n", livePatterns.load());
+    printf("leaked layers:         %8d\n", liveArrays.load());
+    printf("failures:              %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,359 @@
+/*
+    Renders overlapping LED patterns through the compositor for a few seconds of real frames and counts
+    FastLED.show() calls.
+
+        g++ -O2 -Wall -I host/ui -I host -I ../include -I ../include/Interfaces -I ../include/Utilities \
+            -I ../include/HelperClasses/LED_Patterns led_composite_test.cpp \
+            ../src/HelperClasses/LED_Patterns/LED_Pattern_Interface.cpp \
+            ../src/HelperClasses/LED_Patterns/LED_Output_Stage.cpp -o led_composite_test
+        ./led_composite_test [seconds]
+
+    Registering, iterating and compositing are the real LED_Pattern_Table, and each frame goes through the real
+    LED_Output_Stage before FastLED.show(). The frame loop is LED_Utils::iteratePatterns at its default 50 ms
+    tick: drain the commands, iterate, composite over the base layer, render, show, then vTaskDelayUntil. The
+    command handler stands in for LED_Utils::processCommand for the commands used here.
+
+    Five patterns overlap on a 16 LED ring and 4 button LEDs, one per blend mode plus a replace layer beneath
+    the others, over a base layer like LED_Manager's. A button flash plays 10 single frame loops and stops,
+    and the ring pulse is cleared part way through. Every composited frame must match a per LED reference of
+    the layer order and blend arithmetic. There must be exactly one show() per frame, at 20 per second within
+    10%. Exits with 1 on any failure.
+*/
+
+#include "LED_Pattern_Table.h"
+#include "LED_Output_Stage.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+// 16 ring LEDs, then 4 button LEDs
+#define NUM_LEDS 20
+
+// LED_Utils' default tick rate
+#define FRAME_MS 50
+
+#define LED_COMMAND_QUEUE_LENGTH 16
+
+typedef std::chrono::steady_clock Clock;
+
+struct Layer_Spec
+{
+    const char *name;
+    CRGB color;
+    int begin;
+    int end;
+    LED_Blend_Mode blendMode;
+    uint8_t alpha;
+    int8_t zOrder;
+
+    // -1 loops forever. Every loop is one frame long.
+    int loops;
+
+    // Frame the pattern is cleared on, or 0
+    uint32_t clearFrame;
+};
+
+// In registration order, so pattern IDs follow this order
+static const Layer_Spec LAYERS[] = {
+    {"beneath", CRGB(9, 9, 9), 2, 5, LED_BLEND_REPLACE, 255, -1, -1, 0},
+    {"ring point", CRGB(0, 60, 0), 0, 15, LED_BLEND_REPLACE, 255, 0, -1, 0},
+    {"ring pulse", CRGB(50, 220, 0), 0, 15, LED_BLEND_ADD, 255, 0, -1, 30},
+    {"button flash", CRGB(200, 30, 200), 12, 19, LED_BLEND_MAX, 255, 1, 10, 0},
+    {"alert", CRGB(255, 0, 0), 4, 9, LED_BLEND_ALPHA, 128, 2, -1, 0},
+};
+
+#define NUM_LAYERS (sizeof(LAYERS) / sizeof(LAYERS[0]))
+
+static const CRGB BASE_COLOR(0, 0, 40);
+
+class Test_Layer : public LED_Pattern_Interface
+{
+public:
+    Test_Layer(const Layer_Spec &spec) : spec(spec)
+    {
+        setBlendMode(spec.blendMode, spec.alpha);
+        setZOrder(spec.zOrder);
+    }
+
+    void SetRegisteredPatternID(int patternID) {}
+
+    void GetLayerRange(int &begin, int &end)
+    {
+        begin = spec.begin;
+        end = spec.end;
+    }
+
+    bool iterateFrame()
+    {
+        for (int i = spec.begin; i <= spec.end; i++)
+        {
+            leds[i] = spec.color;
+        }
+
+        iterations++;
+        return true;
+    }
+
+    void clearPattern()
+    {
+        fill_solid(leds, numLeds, CRGB::Black);
+    }
+
+    const Layer_Spec &spec;
+    uint32_t iterations = 0;
+};
+
+// Stands in for LED_Utils::processCommand
+static void handleCommand(LED_Pattern_Status &status, LED_Command &command, size_t frameMS)
+{
+    switch (command.type)
+    {
+    case LED_COMMAND_ENABLE:
+        status.enabled = true;
+        break;
+    case LED_COMMAND_LOOP:
+        status.loopsRemaining = command.value;
+        break;
+    case LED_COMMAND_CLEAR:
+        status.pattern->clearPattern();
+        status.visible = false;
+        status.loopsRemaining = 0;
+        break;
+    default:
+        break;
+    }
+}
+
+static LED_Pattern_Table patterns(handleCommand);
+static size_t failures = 0;
+
+static bool layerShows(const Layer_Spec &spec, uint32_t frame)
+{
+    if (spec.clearFrame != 0 && frame >= spec.clearFrame)
+    {
+        return false;
+    }
+
+    // The last loop's frame is not composited, as iterate marks a finished animation invisible
+    return spec.loops < 0 || frame < (uint32_t)spec.loops;
+}
+
+static uint8_t addChannel(uint8_t a, uint8_t b)
+{
+    return a + b > 255 ? 255 : a + b;
+}
+
+static uint8_t blendChannel(uint8_t a, uint8_t b, uint8_t alpha)
+{
+    return (a * (255 - alpha) + a + b * alpha + b) >> 8;
+}
+
+// What frame should hold after compositing, worked out one LED at a time
+static void referenceFrame(uint32_t frame, CRGB *expected)
+{
+    std::vector<size_t> order;
+
+    for (size_t l = 0; l < NUM_LAYERS; l++)
+    {
+        if (layerShows(LAYERS[l], frame))
+        {
+            order.push_back(l);
+        }
+    }
+
+    std::stable_sort(order.begin(), order.end(), [](size_t a, size_t b) { return LAYERS[a].zOrder < LAYERS[b].zOrder; });
+
+    for (int i = 0; i < NUM_LEDS; i++)
+    {
+        CRGB led = BASE_COLOR;
+
+        for (size_t l : order)
+        {
+            const Layer_Spec &spec = LAYERS[l];
+
+            if (i < spec.begin || i > spec.end)
+            {
+                continue;
+            }
+
+            for (int c = 0; c < 3; c++)
+            {
+                switch (spec.blendMode)
+                {
+                case LED_BLEND_ADD:
+                    led.raw[c] = addChannel(led.raw[c], spec.color.raw[c]);
+                    break;
+                case LED_BLEND_MAX:
+                    led.raw[c] = std::max(led.raw[c], spec.color.raw[c]);
+                    break;
+                case LED_BLEND_ALPHA:
+                    led.raw[c] = blendChannel(led.raw[c], spec.color.raw[c], spec.alpha);
+                    break;
+                default:
+                    led.raw[c] = spec.color.raw[c];
+                    break;
+                }
+            }
+        }
+
+        expected[i] = led;
+    }
+}
+
+static void sendCommand(LED_Command_Type type, int patternID, int32_t value = 0)
+{
+    LED_Command command = {type, patternID};
+    command.value = value;
+
+    if (!patterns.sendCommand(command))
+    {
+        fprintf(stderr, "FAIL: command %u for pattern %d dropped\n", type, patternID);
+        failures++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 3;
+
+    if (seconds <= 0)
+    {
+        fprintf(stderr, "usage: %s [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t numFrames = seconds * 1000 / FRAME_MS;
+
+    LED_Pattern_Interface::setNumLeds(NUM_LEDS);
+    LED_Pattern_Interface::setTickRate(FRAME_MS);
+    LED_Output_Stage::init(NUM_LEDS);
+
+    QueueHandle_t queue = xQueueCreate(LED_COMMAND_QUEUE_LENGTH, sizeof(LED_Command));
+    patterns.setQueue(queue);
+    patterns.setLedTask(xTaskGetCurrentTaskHandle());
+
+    Test_Layer *layers[NUM_LAYERS];
+    int patternIDs[NUM_LAYERS];
+
+    for (size_t l = 0; l < NUM_LAYERS; l++)
+    {
+        layers[l] = new Test_Layer(LAYERS[l]);
+        patternIDs[l] = patterns.registerPattern(layers[l], NUM_LEDS);
+
+        if (patternIDs[l] < 0)
+        {
+            fprintf(stderr, "FAIL: %s did not register\n", LAYERS[l].name);
+            return 1;
+        }
+
+        sendCommand(LED_COMMAND_ENABLE, patternIDs[l]);
+        sendCommand(LED_COMMAND_LOOP, patternIDs[l], LAYERS[l].loops);
+    }
+
+    CRGB base[NUM_LEDS];
+    CRGB frameLeds[NUM_LEDS];
+    CRGB outputLeds[NUM_LEDS];
+    CRGB expected[NUM_LEDS];
+
+    fill_solid(base, NUM_LEDS, BASE_COLOR);
+
+    uint32_t mismatchedFrames = 0;
+    uint32_t showsBefore = FastLED.shows;
+    TickType_t lastWakeTime = xTaskGetTickCount();
+    auto start = Clock::now();
+
+    for (uint32_t frame = 1; frame <= numFrames; frame++)
+    {
+        for (size_t l = 0; l < NUM_LAYERS; l++)
+        {
+            if (LAYERS[l].clearFrame == frame)
+            {
+                sendCommand(LED_COMMAND_CLEAR, patternIDs[l]);
+            }
+        }
+
+        size_t frameMS = lastWakeTime * portTICK_PERIOD_MS;
+
+        patterns.processCommands(frameMS);
+        bool workToDo = patterns.iterate(frameMS);
+
+        memcpy(frameLeds, base, sizeof(frameLeds));
+        patterns.composite(frameLeds, NUM_LEDS);
+        LED_Output_Stage::render(frameLeds, outputLeds, NUM_LEDS);
+        FastLED.show();
+
+        referenceFrame(frame, expected);
+
+        if (memcmp(frameLeds, expected, sizeof(frameLeds)) != 0)
+        {
+            if (mismatchedFrames < 5)
+            {
+                for (int i = 0; i < NUM_LEDS; i++)
+                {
+                    if (frameLeds[i] != expected[i])
+                    {
+                        fprintf(stderr, "FAIL frame %u LED %d: %u,%u,%u expected %u,%u,%u\n", frame, i,
+                                frameLeds[i].r, frameLeds[i].g, frameLeds[i].b, expected[i].r, expected[i].g, expected[i].b);
+                        break;
+                    }
+                }
+            }
+
+            mismatchedFrames++;
+        }
+
+        if (!workToDo)
+        {
+            fprintf(stderr, "FAIL frame %u: no work left with patterns looping forever\n", frame);
+            failures++;
+        }
+
+        vTaskDelayUntil(&lastWakeTime, pdMS_TO_TICKS(FRAME_MS));
+    }
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    uint32_t shows = FastLED.shows - showsBefore;
+    double showsPerSecond = shows / elapsed.count();
+    double expectedPerSecond = 1000.0 / FRAME_MS;
+
+    failures += mismatchedFrames;
+
+    if (shows != numFrames)
+    {
+        fprintf(stderr, "FAIL: %u show() calls for %u frames\n", shows, numFrames);
+        failures++;
+    }
+
+    if (showsPerSecond < expectedPerSecond * 0.9 || showsPerSecond > expectedPerSecond * 1.1)
+    {
+        fprintf(stderr, "FAIL: %.1f show() calls per second, expected %.0f\n", showsPerSecond, expectedPerSecond);
+        failures++;
+    }
+
+    printf("%u frames of %d ms, %zu overlapping patterns on %d LEDs\n\n", numFrames, FRAME_MS, NUM_LAYERS, NUM_LEDS);
+
+    for (size_t l = 0; l < NUM_LAYERS; l++)
+    {
+        printf("%-14s LEDs %2d-%2d  z %2d  iterated %3u frames\n", LAYERS[l].name, LAYERS[l].begin, LAYERS[l].end,
+               LAYERS[l].zOrder, layers[l]->iterations);
+    }
+
+    printf("\nshow() calls:        %8u\n", shows);
+    printf("show() per second:   %8.1f\n", showsPerSecond);
+    printf("mismatched frames:   %8u\n", mismatchedFrames);
+    printf("failures:            %8zu\n", failures);
+
+    for (size_t l = 0; l < NUM_LAYERS; l++)
+    {
+        patterns.unregisterPattern(patternIDs[l]);
+    }
+
+    patterns.processCommands(0);
+    vQueueDelete(queue);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,416 @@
+/*
+    Runs the LED task's frame loop in real time with several patterns and measures how far frames wake from
+    their schedule, what frame times the patterns see and how overruns are skipped.
+
+        g++ -O2 -Wall -I host/ui -I host -I ../include -I ../include/Interfaces -I ../include/Utilities \
+            -I ../include/HelperClasses/LED_Patterns led_frame_jitter.cpp \
+            ../src/HelperClasses/LED_Patterns/LED_Pattern_Interface.cpp -o led_frame_jitter
+        ./led_frame_jitter [seconds] [periodMS]
+
+    The clock is the real LED_Frame_Clock and the patterns run through the real LED_Pattern_Table, in the order
+    LED_Utils::iteratePatterns runs them. Four patterns play at once:
+
+        ring pulse    LED_Program_Evaluator::RingPulse, played as Keyframe_Pattern plays it
+        button flash  LED_Program_Evaluator::ButtonFlash, the same way
+        ring point    a static layer, redrawn every frame
+        load          spins for 2 ms every frame, and for 2.5 frame periods every 25th frame
+
+    The same loop is then run with a vTaskDelay of the period after each frame, as a loop without the frame
+    clock would, for comparison.
+
+    With the frame clock, every frame must be scheduled on the grid of the period and every pattern must see
+    frame times that step by exactly the period, or by the period times the frames skipped before it. Each
+    overrun must skip 2 frames, with at most 2% more skipped for host scheduling noise. Frames shown plus frames
+    skipped must account for the whole run, so the clock does not drift. Exits with 1 on any failure.
+*/
+
+#include "LED_Pattern_Table.h"
+#include "LED_Frame_Clock.h"
+#include "LED_Program.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define NUM_LEDS 20
+#define LED_COMMAND_QUEUE_LENGTH 16
+
+#define LOAD_WORK_MS 2.0
+#define OVERRUN_EVERY_FRAMES 25
+#define OVERRUN_PERIODS 2.5
+
+typedef std::chrono::steady_clock Clock;
+
+static const CRGB THEME_COLOR(0, 80, 255);
+
+// Milliseconds since the host tick count started
+static double nowMS()
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - Host_FreeRTOS::start).count();
+}
+
+static void spin(double ms)
+{
+    double until = nowMS() + ms;
+
+    while (nowMS() < until)
+    {
+    }
+}
+
+// Common to every pattern in the sim: records the frame times it was given
+class Sim_Pattern : public LED_Pattern_Interface
+{
+public:
+    Sim_Pattern(const char *name, int begin, int end) : name(name), begin(begin), end(end) {}
+
+    void SetRegisteredPatternID(int patternID) {}
+
+    void GetLayerRange(int &rangeBegin, int &rangeEnd)
+    {
+        rangeBegin = begin;
+        rangeEnd = end;
+    }
+
+    bool iterateFrame()
+    {
+        deltas.push_back(hasDelta ? frameDeltaMS : 0);
+        hasDelta = true;
+        return render();
+    }
+
+    virtual bool render() = 0;
+
+    const char *name;
+    int begin;
+    int end;
+
+    // frameDeltaMS of every frame after the first
+    std::vector<size_t> deltas;
+    bool hasDelta = false;
+};
+
+// Plays a single track program the way Keyframe_Pattern::iterateFrame does
+class Program_Pattern : public Sim_Pattern
+{
+public:
+    Program_Pattern(const char *name, int begin, int end, const LED_Program &program)
+        : Sim_Pattern(name, begin, end), program(program) {}
+
+    bool render()
+    {
+        size_t currMS = elapsedMS();
+
+        if (currMS >= program.lengthMS)
+        {
+            fill_solid(&leds[begin], end - begin + 1, CRGB::Black);
+            resetPattern();
+            return true;
+        }
+
+        uint16_t position = LED_Program_Evaluator::Position(currMS, program.lengthMS);
+        CRGB color = THEME_COLOR;
+        color.nscale8(LED_Program_Evaluator::Level(program, program.tracks[0], position));
+
+        fill_solid(&leds[begin], end - begin + 1, color);
+        return false;
+    }
+
+    LED_Program program;
+};
+
+class Static_Pattern : public Sim_Pattern
+{
+public:
+    Static_Pattern() : Sim_Pattern("ring point", 0, 15) {}
+
+    bool render()
+    {
+        fill_solid(&leds[begin], end - begin + 1, CRGB::Black);
+        leds[3] = CRGB::White;
+        return true;
+    }
+};
+
+class Load_Pattern : public Sim_Pattern
+{
+public:
+    Load_Pattern() : Sim_Pattern("load", 16, 19) {}
+
+    bool render()
+    {
+        frames++;
+        spin(frames % OVERRUN_EVERY_FRAMES == 0 ? OVERRUN_PERIODS * periodMS : LOAD_WORK_MS);
+        return true;
+    }
+
+    uint32_t frames = 0;
+    uint32_t periodMS = 0;
+};
+
+static void handleCommand(LED_Pattern_Status &status, LED_Command &command, size_t frameMS)
+{
+    switch (command.type)
+    {
+    case LED_COMMAND_ENABLE:
+        status.enabled = true;
+        break;
+    case LED_COMMAND_LOOP:
+        status.loopsRemaining = command.value;
+        break;
+    default:
+        break;
+    }
+}
+
+struct Run_Result
+{
+    uint32_t frames = 0;
+    uint32_t skipped = 0;
+    uint32_t overruns = 0;
+
+    // How late each frame woke after its scheduled time
+    std::vector<double> lateMS;
+    std::vector<size_t> scheduledMS;
+
+    // Frames skipped by the wait before each frame
+    std::vector<uint32_t> skippedBefore;
+
+    // Names and frameDeltaMS of every frame of each pattern, kept as the table deletes the patterns
+    std::vector<const char *> patternNames;
+    std::vector<std::vector<size_t>> patternDeltas;
+
+    size_t minDeltaMS = SIZE_MAX;
+    size_t maxDeltaMS = 0;
+    double elapsedMS = 0;
+};
+
+static size_t failures = 0;
+
+static void fail(const char *run, const char *what, long value)
+{
+    if (failures < 10)
+    {
+        fprintf(stderr, "FAIL %s: %s (%ld)\n", run, what, value);
+    }
+
+    failures++;
+}
+
+static std::vector<Sim_Pattern *> makePatterns(uint32_t periodMS, Load_Pattern *&load)
+{
+    load = new Load_Pattern();
+    load->periodMS = periodMS;
+
+    return {
+        new Program_Pattern("ring pulse", 0, 15, LED_Program_Evaluator::RingPulse()),
+        new Static_Pattern(),
+        new Program_Pattern("button flash", 16, 19, LED_Program_Evaluator::ButtonFlash()),
+        load,
+    };
+}
+
+// Runs the LED task's loop for durationMS. With useClock false, frames are paced by a vTaskDelay of the period.
+static Run_Result runFrames(bool useClock, uint32_t periodMS, uint32_t durationMS)
+{
+    Load_Pattern *load;
+    std::vector<Sim_Pattern *> patterns = makePatterns(periodMS, load);
+
+    LED_Pattern_Table table(handleCommand);
+    LED_Frame_Clock clock;
+    Run_Result result;
+
+    QueueHandle_t queue = xQueueCreate(LED_COMMAND_QUEUE_LENGTH, sizeof(LED_Command));
+    table.setQueue(queue);
+    table.setLedTask(xTaskGetCurrentTaskHandle());
+
+    std::vector<int> patternIDs;
+
+    for (Sim_Pattern *pattern : patterns)
+    {
+        int patternID = table.registerPattern(pattern, NUM_LEDS);
+        LED_Command enable = {LED_COMMAND_ENABLE, patternID};
+        LED_Command loop = {LED_COMMAND_LOOP, patternID};
+        loop.value = -1;
+
+        table.sendCommand(enable);
+        table.sendCommand(loop);
+        patternIDs.push_back(patternID);
+    }
+
+    CRGB frame[NUM_LEDS];
+    uint32_t missedFrames = 0;
+
+    clock.restart();
+    double startMS = nowMS();
+    TickType_t naiveWakeTime = xTaskGetTickCount();
+
+    while (nowMS() - startMS < durationMS)
+    {
+        size_t frameMS = useClock ? clock.FrameMS() : naiveWakeTime * portTICK_PERIOD_MS;
+
+        result.lateMS.push_back(nowMS() - frameMS);
+        result.scheduledMS.push_back(frameMS);
+        result.skippedBefore.push_back(missedFrames);
+
+        table.processCommands(frameMS);
+        table.iterate(frameMS);
+
+        fill_solid(frame, NUM_LEDS, CRGB::Black);
+        table.composite(frame, NUM_LEDS);
+        result.frames++;
+
+        if (useClock)
+        {
+            missedFrames = clock.waitForNextFrame(periodMS);
+        }
+        else
+        {
+            vTaskDelay(pdMS_TO_TICKS(periodMS));
+            naiveWakeTime = xTaskGetTickCount();
+        }
+    }
+
+    result.elapsedMS = nowMS() - startMS;
+    result.skipped = clock.SkippedFrames();
+    result.overruns = load->frames / OVERRUN_EVERY_FRAMES;
+
+    for (Sim_Pattern *pattern : patterns)
+    {
+        result.patternNames.push_back(pattern->name);
+        result.patternDeltas.push_back(pattern->deltas);
+
+        for (size_t delta : pattern->deltas)
+        {
+            if (delta > 0)
+            {
+                result.minDeltaMS = std::min(result.minDeltaMS, delta);
+                result.maxDeltaMS = std::max(result.maxDeltaMS, delta);
+            }
+        }
+    }
+
+    for (int patternID : patternIDs)
+    {
+        table.unregisterPattern(patternID);
+    }
+
+    table.processCommands(0);
+    vQueueDelete(queue);
+
+    return result;
+}
+
+// Checks the patterns' frame times against the clock's schedule
+static void checkClockRun(const Run_Result &result, uint32_t periodMS)
+{
+    const char *run = "frame clock";
+
+    for (size_t f = 1; f < result.frames; f++)
+    {
+        if ((result.scheduledMS[f] - result.scheduledMS[0]) % periodMS != 0)
+        {
+            fail(run, "frame scheduled off the grid", f);
+        }
+
+        size_t expected = periodMS * (1 + result.skippedBefore[f]);
+
+        if (result.scheduledMS[f] - result.scheduledMS[f - 1] != expected)
+        {
+            fail(run, "frame time stepped by other than the period and the frames skipped", f);
+        }
+    }
+
+    for (size_t p = 0; p < result.patternDeltas.size(); p++)
+    {
+        const std::vector<size_t> &deltas = result.patternDeltas[p];
+
+        if (deltas.size() != result.frames)
+        {
+            fail(result.patternNames[p], "not iterated every frame", deltas.size());
+            continue;
+        }
+
+        for (size_t f = 1; f < result.frames; f++)
+        {
+            if (deltas[f] != result.scheduledMS[f] - result.scheduledMS[f - 1])
+            {
+                fail(result.patternNames[p], "saw a frame time other than the schedule", f);
+            }
+        }
+    }
+
+    if (result.skipped < result.overruns * 2)
+    {
+        fail(run, "an overrun skipped fewer than 2 frames", result.skipped);
+    }
+
+    if (result.skipped > result.overruns * 2 + result.frames / 50)
+    {
+        fail(run, "frames skipped without an overrun", result.skipped);
+    }
+
+    // Every period of the run is either a frame or a skipped frame. The last frame may be cut short.
+    long periods = (long)(result.elapsedMS / periodMS);
+    long accounted = result.frames + result.skipped;
+
+    if (accounted < periods || accounted > periods + 2)
+    {
+        fail(run, "frames shown and skipped do not cover the run", accounted - periods);
+    }
+}
+
+static void printRun(const char *name, const Run_Result &result, uint32_t periodMS)
+{
+    std::vector<double> late = result.lateMS;
+    std::sort(late.begin(), late.end());
+
+    double mean = 0;
+
+    for (double ms : late)
+    {
+        mean += ms;
+    }
+
+    mean /= late.size();
+
+    double p99 = late[std::min(late.size() - 1, late.size() * 99 / 100)];
+
+    printf("%-14s %6u %7u %8.0f %8.2f %8.2f %8.2f %6zu-%zu\n", name, result.frames, result.skipped,
+           result.elapsedMS / periodMS, mean, p99, late.back(), result.minDeltaMS, result.maxDeltaMS);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seconds = argc > 1 ? atoi(argv[1]) : 4;
+    uint32_t periodMS = argc > 2 ? atoi(argv[2]) : 50;
+
+    if (seconds == 0 || periodMS < LOAD_WORK_MS * 2)
+    {
+        fprintf(stderr, "usage: %s [seconds] [periodMS]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t durationMS = seconds * 1000;
+
+    LED_Pattern_Interface::setNumLeds(NUM_LEDS);
+    LED_Pattern_Interface::setTickRate(periodMS);
+
+    Run_Result clockRun = runFrames(true, periodMS, durationMS);
+    Run_Result naiveRun = runFrames(false, periodMS, durationMS);
+
+    checkClockRun(clockRun, periodMS);
+
+    printf("%u s at %u ms per frame, %zu patterns, %u overruns of %.1f periods\n\n", seconds, periodMS,
+           clockRun.patternNames.size(), clockRun.overruns, OVERRUN_PERIODS);
+    printf("%-14s %6s %7s %8s %8s %8s %8s %9s\n", "pacing", "frames", "skipped", "periods", "late ms",
+           "p99 ms", "max ms", "delta ms");
+    printRun("frame clock", clockRun, periodMS);
+    printRun("vTaskDelay", naiveRun, periodMS);
+
+    printf("\nfailures:            %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,372 @@
+/*
+    Streams 5000 saved locations through MsgPack_Encoder and back through MsgPack_Decoder, as
+    WriteFileStreamed and ReadArrayFile do, and reports bytes, flash accesses and time per location.
+
+        g++ -O2 -Wall -Wextra -I host -I ../include/Utilities msgpack_bench.cpp ../src/Utilities/MsgPack_Encoding.cpp -o msgpack_bench
+        ./msgpack_bench [numLocations]
+
+    ArduinoJson is not available on the host, so each element is encoded by hand into a buffer the size of
+    the StaticJsonDocument SerializeSavedLocations uses, with the same keys, and written with writeRaw. The
+    element serialization itself is therefore not in the timings, only the streaming around it. Lat and Lng
+    are float64. Every location read back is compared with the one written. Exits with 1 on any failure.
+*/
+
+#include "MsgPack_Encoding.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// WriteBufferingPrint and ReadBufferingStream capacity in FilesystemUtils.cpp
+#define STREAM_BUFFER_SIZE 64
+
+// ArduinoJson slot size on the ESP32, for the whole document the streamed path replaced
+#define JSON_SLOT_SIZE 16
+
+struct Location
+{
+    std::string name;
+    double latitude;
+    double longitude;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        if (failures < 10)
+        {
+            fprintf(stderr, "FAIL: %s\n", what);
+        }
+
+        failures++;
+    }
+}
+
+// The file on flash. Counts the writes and reads that reach it.
+class Memory_File : public Stream
+{
+public:
+    std::string contents;
+    size_t position = 0;
+    size_t writes = 0;
+    size_t reads = 0;
+
+    size_t write(uint8_t value) override { return write(&value, 1); }
+
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        writes++;
+        contents.append((const char *)buffer, size);
+        return size;
+    }
+
+    int available() override { return contents.size() - position; }
+    int peek() override { return position < contents.size() ? (uint8_t)contents[position] : -1; }
+
+    int read() override
+    {
+        uint8_t value;
+        return readChunk(&value, 1) == 1 ? value : -1;
+    }
+
+    size_t readChunk(uint8_t *buffer, size_t size)
+    {
+        reads++;
+        size_t count = std::min(size, contents.size() - position);
+        memcpy(buffer, contents.data() + position, count);
+        position += count;
+        return count;
+    }
+};
+
+// Counts and checksums the first pass, like Crc_Print without an output
+class Counting_Print : public Print
+{
+public:
+    size_t length = 0;
+    uint32_t sum = 0;
+
+    size_t write(uint8_t value) override { return write(&value, 1); }
+
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            sum = sum * 31 + buffer[i];
+        }
+
+        length += size;
+        return size;
+    }
+};
+
+// Stands in for WriteBufferingPrint
+class Buffered_Print : public Print
+{
+public:
+    explicit Buffered_Print(Print &target) : target(target) {}
+
+    size_t write(uint8_t value) override { return write(&value, 1); }
+
+    size_t write(const uint8_t *data, size_t size) override
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            if (used == sizeof(buffer))
+            {
+                flush();
+            }
+
+            buffer[used++] = data[i];
+        }
+
+        return size;
+    }
+
+    void flush()
+    {
+        target.write(buffer, used);
+        used = 0;
+    }
+
+private:
+    Print &target;
+    uint8_t buffer[STREAM_BUFFER_SIZE];
+    size_t used = 0;
+};
+
+// Stands in for ReadBufferingStream
+class Buffered_Stream : public Stream
+{
+public:
+    explicit Buffered_Stream(Memory_File &source) : source(source) {}
+
+    size_t write(uint8_t) override { return 0; }
+    int available() override { return (end - next) + source.available(); }
+
+    int peek() override { return fill() ? buffer[next] : -1; }
+    int read() override { return fill() ? buffer[next++] : -1; }
+
+private:
+    Memory_File &source;
+    uint8_t buffer[STREAM_BUFFER_SIZE];
+    size_t next = 0;
+    size_t end = 0;
+
+    bool fill()
+    {
+        if (next == end)
+        {
+            next = 0;
+            end = source.readChunk(buffer, sizeof(buffer));
+        }
+
+        return next < end;
+    }
+};
+
+static void appendString(std::vector<uint8_t> &out, const char *value)
+{
+    size_t length = strlen(value);
+    out.push_back(0xa0 | length);
+    out.insert(out.end(), value, value + length);
+}
+
+static void appendDouble(std::vector<uint8_t> &out, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    out.push_back(0xcb);
+
+    for (int shift = 56; shift >= 0; shift -= 8)
+    {
+        out.push_back((bits >> shift) & 0xff);
+    }
+}
+
+static bool readDouble(Stream &input, double &value)
+{
+    if (input.read() != 0xcb)
+    {
+        return false;
+    }
+
+    uint64_t bits = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        int next = input.read();
+
+        if (next < 0)
+        {
+            return false;
+        }
+
+        bits = (bits << 8) | (uint8_t)next;
+    }
+
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+// The shape SerializeSavedLocations writes
+static void produce(MsgPack_Encoder &writer, const std::vector<Location> &locations)
+{
+    std::vector<uint8_t> element;
+    element.reserve(64);
+
+    writer.beginMap(1);
+    writer.writeString("Locations");
+    writer.beginArray(locations.size());
+
+    for (const auto &location : locations)
+    {
+        element.clear();
+        element.push_back(0x83);
+        appendString(element, "Name");
+        appendString(element, location.name.c_str());
+        appendString(element, "Lat");
+        appendDouble(element, location.latitude);
+        appendString(element, "Lng");
+        appendDouble(element, location.longitude);
+
+        writer.writeRaw(element.data(), element.size());
+    }
+}
+
+// The walk ReadArrayFile does, with each element decoded in place of readElement
+static bool consume(Buffered_Stream &input, std::vector<Location> &locations)
+{
+    MsgPack_Decoder reader(input);
+
+    char key[32];
+    uint32_t numEntries = 0;
+    uint32_t numElements = 0;
+
+    if (!reader.readMapHeader(numEntries) || numEntries != 1 || !reader.readString(key, sizeof(key)) ||
+        strcmp(key, "Locations") != 0 || !reader.readArrayHeader(numElements))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < numElements; i++)
+    {
+        uint32_t numFields = 0;
+        char name[32];
+        Location location;
+
+        if (!reader.readMapHeader(numFields) || numFields != 3)
+        {
+            return false;
+        }
+
+        bool ok = reader.readString(key, sizeof(key)) && reader.readString(name, sizeof(name)) &&
+                  reader.readString(key, sizeof(key)) && readDouble(input, location.latitude) &&
+                  reader.readString(key, sizeof(key)) && readDouble(input, location.longitude);
+
+        if (!ok)
+        {
+            return false;
+        }
+
+        location.name = name;
+        locations.push_back(location);
+    }
+
+    return reader.ok();
+}
+
+static double elapsedNS(Clock::time_point start, size_t count)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+}
+
+int main(int argc, char **argv)
+{
+    size_t numLocations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 5000;
+
+    if (numLocations == 0)
+    {
+        fprintf(stderr, "usage: %s [numLocations > 0]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Location> locations;
+
+    for (size_t i = 0; i < numLocations; i++)
+    {
+        locations.push_back({"Location " + std::to_string(i), 40.7128 + i * 1e-4, -74.0060 - i * 1e-4});
+    }
+
+    // First pass, checksum only
+    Counting_Print counted;
+    auto start = Clock::now();
+    {
+        MsgPack_Encoder writer(counted);
+        produce(writer, locations);
+        check(writer.BytesWritten() == counted.length, "encoder count differs from the bytes it wrote");
+    }
+    double countNS = elapsedNS(start, numLocations);
+
+    // Second pass, through the write buffer to the file
+    Memory_File file;
+    start = Clock::now();
+    {
+        Buffered_Print buffered(file);
+        MsgPack_Encoder writer(buffered);
+        produce(writer, locations);
+        buffered.flush();
+    }
+    double writeNS = elapsedNS(start, numLocations);
+
+    Counting_Print recount;
+    recount.write((const uint8_t *)file.contents.data(), file.contents.size());
+    check(recount.length == counted.length && recount.sum == counted.sum, "passes wrote different bytes");
+
+    // Read back through the read buffer
+    std::vector<Location> readBack;
+    readBack.reserve(numLocations);
+
+    Buffered_Stream input(file);
+    start = Clock::now();
+    check(consume(input, readBack), "file did not decode");
+    double readNS = elapsedNS(start, numLocations);
+
+    check(readBack.size() == numLocations, "wrong number of locations read back");
+
+    for (size_t i = 0; i < readBack.size() && i < numLocations; i++)
+    {
+        check(readBack[i].name == locations[i].name && readBack[i].latitude == locations[i].latitude &&
+                  readBack[i].longitude == locations[i].longitude,
+              "location read back differs");
+    }
+
+    // The document the whole list needed before it was streamed: an array slot and three member slots per location
+    size_t documentBytes = numLocations * 4 * JSON_SLOT_SIZE;
+
+    for (const auto &location : locations)
+    {
+        documentBytes += location.name.size() + 1;
+    }
+
+    printf("%zu locations\n\n", numLocations);
+    printf("file payload:          %8zu bytes, %.1f per location\n", file.contents.size(), (double)file.contents.size() / numLocations);
+    printf("flash writes:          %8zu of up to %d bytes\n", file.writes, STREAM_BUFFER_SIZE);
+    printf("flash reads:           %8zu\n", file.reads);
+    printf("checksum pass:         %8.1f ns per location\n", countNS);
+    printf("write pass:            %8.1f ns per location\n", writeNS);
+    printf("read:                  %8.1f ns per location\n", readNS);
+    printf("stream buffers:        %8d bytes, independent of count\n", 2 * STREAM_BUFFER_SIZE);
+    printf("whole document:        %8zu bytes on the ESP32, for comparison\n", documentBytes);
+    printf("failures:              %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
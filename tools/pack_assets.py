@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+"""
+Packs and inspects the read-only asset partition read by Asset_Utils.
+
+    pack_assets.py pack assets.json assets.bin [--size 65536]
+    pack_assets.py list assets.bin
+    pack_assets.py lookup assets.bin messages/default
+    pack_assets.py bench assets.bin [--iterations 100000]
+
+Flash the image to the "assets" partition, for example with
+    parttool.py write_partition --partition-name=assets --input=assets.bin
+
+The layout must match include/Utilities/Asset_Utils.h.
+"""
+
+import argparse
+import json
+import mmap
+import struct
+import sys
+import time
+import zlib
+
+ASSET_MAGIC = 0x54535341
+ASSET_VERSION = 1
+ASSET_LOCATION_NAME_LENGTH = 24
+
+ASSET_TYPE_BLOB = 0
+ASSET_TYPE_STRINGS = 1
+ASSET_TYPE_LOCATIONS = 2
+ASSET_TYPE_MSGPACK = 3
+
+TYPE_NAMES = {
+    ASSET_TYPE_BLOB: "blob",
+    ASSET_TYPE_STRINGS: "strings",
+    ASSET_TYPE_LOCATIONS: "locations",
+    ASSET_TYPE_MSGPACK: "msgpack",
+}
+
+HEADER = struct.Struct("<IHHII")
+INDEX_ENTRY = struct.Struct("<IIHHII")
+LOCATION = struct.Struct("<dd%ds" % ASSET_LOCATION_NAME_LENGTH)
+
+
+def fnv1a(name):
+    value = 2166136261
+    for byte in name.encode("utf-8"):
+        value ^= byte
+        value = (value * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def msgpack(value):
+    """Minimal MessagePack encoder, enough for settings documents."""
+    if value is None:
+        return b"\xc0"
+    if value is True:
+        return b"\xc3"
+    if value is False:
+        return b"\xc2"
+    if isinstance(value, int):
+        if 0 <= value < 0x80:
+            return struct.pack("B", value)
+        if -32 <= value < 0:
+            return struct.pack("b", value)
+        if 0 <= value <= 0xFFFFFFFF:
+            return b"\xce" + struct.pack(">I", value)
+        return b"\xd3" + struct.pack(">q", value)
+    if isinstance(value, float):
+        return b"\xcb" + struct.pack(">d", value)
+    if isinstance(value, str):
+        encoded = value.encode("utf-8")
+        if len(encoded) < 32:
+            return struct.pack("B", 0xA0 | len(encoded)) + encoded
+        if len(encoded) <= 0xFF:
+            return b"\xd9" + struct.pack("B", len(encoded)) + encoded
+        return b"\xda" + struct.pack(">H", len(encoded)) + encoded
+    if isinstance(value, list):
+        header = struct.pack("B", 0x90 | len(value)) if len(value) < 16 else b"\xdc" + struct.pack(">H", len(value))
+        return header + b"".join(msgpack(item) for item in value)
+    if isinstance(value, dict):
+        header = struct.pack("B", 0x80 | len(value)) if len(value) < 16 else b"\xde" + struct.pack(">H", len(value))
+        return header + b"".join(msgpack(key) + msgpack(item) for key, item in value.items())
+    raise TypeError("Cannot encode %r" % (value,))
+
+
+def encode_asset(name, source):
+    kind = source["type"]
+
+    if kind == "strings":
+        values = source["values"]
+        return ASSET_TYPE_STRINGS, len(values), b"".join(v.encode("utf-8") + b"\0" for v in values)
+
+    if kind == "locations":
+        values = source["values"]
+        records = []
+        for location in values:
+            encoded = location["name"].encode("utf-8")
+            if len(encoded) >= ASSET_LOCATION_NAME_LENGTH:
+                raise ValueError("%s: name too long: %s" % (name, location["name"]))
+            records.append(LOCATION.pack(location["lat"], location["lng"], encoded))
+        return ASSET_TYPE_LOCATIONS, len(values), b"".join(records)
+
+    if kind == "msgpack":
+        return ASSET_TYPE_MSGPACK, 1, msgpack(source["value"])
+
+    if kind == "file":
+        with open(source["path"], "rb") as blob:
+            return ASSET_TYPE_BLOB, 1, blob.read()
+
+    raise ValueError("%s: unknown type %s" % (name, kind))
+
+
+def pack(assets):
+    entries = []
+    for name, source in assets.items():
+        asset_type, count, payload = encode_asset(name, source)
+        if count > 0xFFFF:
+            raise ValueError("%s: too many elements" % name)
+        entries.append((fnv1a(name), name, asset_type, count, payload))
+
+    entries.sort(key=lambda entry: (entry[0], entry[1]))
+
+    names = b""
+    name_offsets = []
+    names_start = HEADER.size + INDEX_ENTRY.size * len(entries)
+    for entry in entries:
+        name_offsets.append(names_start + len(names))
+        names += entry[1].encode("utf-8") + b"\0"
+
+    # Payloads are aligned to 8 bytes from the start of the partition so records can be read in place
+    body = names + b"\0" * (-(names_start + len(names)) % 8)
+    payload_offsets = []
+    for entry in entries:
+        payload_offsets.append(names_start + len(body))
+        body += entry[4] + b"\0" * (-(names_start + len(body) + len(entry[4])) % 8)
+
+    index = b"".join(
+        INDEX_ENTRY.pack(entry[0], name_offsets[i], entry[2], entry[3], payload_offsets[i], len(entry[4]))
+        for i, entry in enumerate(entries))
+
+    after_header = index + body
+    header = HEADER.pack(ASSET_MAGIC, ASSET_VERSION, len(entries), HEADER.size + len(after_header), zlib.crc32(after_header))
+    return header + after_header
+
+
+class AssetImage:
+    """Reads a packed image in place, the same way the firmware reads the mapped partition."""
+
+    def __init__(self, image):
+        self.image = image
+        magic, version, self.num_entries, self.total_size, crc = HEADER.unpack_from(image, 0)
+
+        if magic != ASSET_MAGIC or version != ASSET_VERSION:
+            raise ValueError("Not an asset image")
+        if self.total_size > len(image) or zlib.crc32(image[HEADER.size:self.total_size]) != crc:
+            raise ValueError("Asset image is corrupt")
+
+        self.hashes = [INDEX_ENTRY.unpack_from(image, HEADER.size + i * INDEX_ENTRY.size)[0] for i in range(self.num_entries)]
+
+    def entry(self, i):
+        return INDEX_ENTRY.unpack_from(self.image, HEADER.size + i * INDEX_ENTRY.size)
+
+    def name(self, offset):
+        end = self.image.find(b"\0", offset)
+        return self.image[offset:end].decode("utf-8")
+
+    def find(self, name):
+        target = fnv1a(name)
+        low, high = 0, self.num_entries
+        while low < high:
+            mid = (low + high) // 2
+            if self.hashes[mid] < target:
+                low = mid + 1
+            else:
+                high = mid
+
+        for i in range(low, self.num_entries):
+            name_hash, name_offset, asset_type, count, offset, length = self.entry(i)
+            if name_hash != target:
+                break
+            if self.name(name_offset) == name:
+                return asset_type, count, offset, length
+        return None
+
+    def describe(self, name):
+        found = self.find(name)
+        if found is None:
+            return None
+
+        asset_type, count, offset, length = found
+        data = self.image[offset:offset + length]
+
+        if asset_type == ASSET_TYPE_STRINGS:
+            return [s.decode("utf-8") for s in bytes(data).split(b"\0")[:count]]
+        if asset_type == ASSET_TYPE_LOCATIONS:
+            locations = []
+            for i in range(count):
+                lat, lng, raw_name = LOCATION.unpack_from(data, i * LOCATION.size)
+                locations.append({"name": raw_name.rstrip(b"\0").decode("utf-8"), "lat": lat, "lng": lng})
+            return locations
+        return "%s, %d bytes" % (TYPE_NAMES.get(asset_type, "unknown"), length)
+
+
+def open_image(path):
+    with open(path, "rb") as image_file:
+        return AssetImage(mmap.mmap(image_file.fileno(), 0, access=mmap.ACCESS_READ))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    pack_command = commands.add_parser("pack")
+    pack_command.add_argument("source")
+    pack_command.add_argument("output")
+    pack_command.add_argument("--size", type=int, default=0, help="pad the image to the partition size")
+
+    list_command = commands.add_parser("list")
+    list_command.add_argument("image")
+
+    lookup_command = commands.add_parser("lookup")
+    lookup_command.add_argument("image")
+    lookup_command.add_argument("name")
+
+    bench_command = commands.add_parser("bench")
+    bench_command.add_argument("image")
+    bench_command.add_argument("--iterations", type=int, default=100000)
+
+    args = parser.parse_args()
+
+    if args.command == "pack":
+        with open(args.source) as source:
+            image = pack(json.load(source))
+        if args.size:
+            if len(image) > args.size:
+                sys.exit("Image is %d bytes, larger than the partition" % len(image))
+            image += b"\xff" * (args.size - len(image))
+        with open(args.output, "wb") as output:
+            output.write(image)
+        print("Packed %d bytes" % len(image))
+
+    elif args.command == "list":
+        image = open_image(args.image)
+        for i in range(image.num_entries):
+            _, name_offset, asset_type, count, offset, length = image.entry(i)
+            print("%-24s %-10s count %-5d %6d bytes at 0x%x" % (image.name(name_offset), TYPE_NAMES.get(asset_type, "unknown"), count, length, offset))
+
+    elif args.command == "lookup":
+        found = open_image(args.image).describe(args.name)
+        if found is None:
+            sys.exit("No asset named %s" % args.name)
+        print(json.dumps(found, indent=4) if not isinstance(found, str) else found)
+
+    elif args.command == "bench":
+        image = open_image(args.image)
+        names = [image.name(image.entry(i)[1]) for i in range(image.num_entries)]
+        start = time.perf_counter()
+        for i in range(args.iterations):
+            image.find(names[i % len(names)])
+        elapsed = time.perf_counter() - start
+        print("%d lookups in %.3f s, %.2f us per lookup" % (args.iterations, elapsed, elapsed * 1e6 / args.iterations))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,370 @@
+/*
+    Cuts the power at every step of an Atomic_File write and checks that the file survives.
+
+        g++ -O2 -Wall -Wextra -I ../include/Utilities power_loss_test.cpp -o power_loss_test
+        ./power_loss_test
+
+    The filesystem is emulated in memory. Opening a file for writing, every byte written, a remove and a rename
+    each cost one step, and once the budget runs out they fail and change nothing, as after a reset. For every
+    cut the power is restored and Recover runs, itself cut at every step, as FilesystemModule::Utilities::Init
+    does after a reset. The file must then pass CheckHeader and hold exactly the old or the new payload, the new
+    one if Write reported success, with no temporary file left behind.
+
+    A full partition is checked the same way, including SPIFFS reporting bytes as written that never reach
+    flash. Exits with 1 on any failure.
+*/
+
+#include "Atomic_File.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+using namespace FilesystemModule;
+
+#define FILENAME "/locations.msgpack"
+#define TEMP_FILENAME FILENAME PERSISTED_FILE_TEMP_SUFFIX
+
+class Emulated_Filesystem
+{
+public:
+    class File
+    {
+    public:
+        File() {}
+        File(Emulated_Filesystem *fs, const std::string &name, bool writing) : fs(fs), name(name), writing(writing) {}
+
+        explicit operator bool() const { return fs != nullptr; }
+
+        size_t write(const uint8_t *data, size_t length)
+        {
+            size_t written = 0;
+
+            while (writing && written < length && fs->spend())
+            {
+                if (fs->freeBytes == 0)
+                {
+                    // SPIFFS can report bytes as written that are lost when its cache is flushed
+                    if (fs->reportsFull)
+                    {
+                        break;
+                    }
+
+                    written++;
+                    continue;
+                }
+
+                if (fs->freeBytes > 0)
+                {
+                    fs->freeBytes--;
+                }
+
+                fs->files[name] += (char)data[written++];
+            }
+
+            return written;
+        }
+
+        int peek() { return position < contents().size() ? (uint8_t)contents()[position] : -1; }
+
+        size_t read(uint8_t *buffer, size_t length)
+        {
+            size_t count = std::min(length, contents().size() - std::min(position, contents().size()));
+            memcpy(buffer, contents().data() + position, count);
+            position += count;
+            return count;
+        }
+
+        size_t size() { return contents().size(); }
+        bool seek(size_t offset) { position = offset; return offset <= size(); }
+        void close() { fs = nullptr; }
+
+    private:
+        Emulated_Filesystem *fs = nullptr;
+        std::string name;
+        bool writing = false;
+        size_t position = 0;
+
+        const std::string &contents() { return fs->files[name]; }
+    };
+
+    std::map<std::string, std::string> files;
+
+    // Steps left before the power is cut, or -1 for no limit
+    long budget = -1;
+    size_t steps = 0;
+
+    // Bytes left on the partition, or -1 for no limit. Writes to a full partition come up short unless
+    // reportsFull is false, in which case the bytes are silently dropped.
+    long freeBytes = -1;
+    bool reportsFull = true;
+
+    File openRead(const char *name) { return files.count(name) ? File(this, name, false) : File(); }
+
+    File openWrite(const char *name)
+    {
+        if (!spend())
+        {
+            return File();
+        }
+
+        release(name);
+        files[name].clear();
+        return File(this, name, true);
+    }
+
+    bool exists(const char *name) { return files.count(name) != 0; }
+
+    bool remove(const char *name)
+    {
+        if (!spend())
+        {
+            return false;
+        }
+
+        release(name);
+        return files.erase(name) != 0;
+    }
+
+    // Like SPIFFS, rename does not replace an existing file
+    bool rename(const char *from, const char *to)
+    {
+        if (!spend() || !files.count(from) || files.count(to))
+        {
+            return false;
+        }
+
+        files[to] = files[from];
+        files.erase(from);
+        return true;
+    }
+
+    // esp_rom_crc32_le, which FilesystemUtils uses on the device
+    static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t length)
+    {
+        crc = ~crc;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            crc ^= data[i];
+
+            for (uint8_t bit = 0; bit < 8; bit++)
+            {
+                crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+            }
+        }
+
+        return ~crc;
+    }
+
+    void release(const char *name)
+    {
+        if (freeBytes >= 0 && files.count(name))
+        {
+            freeBytes += files[name].size();
+        }
+    }
+
+    bool spend()
+    {
+        if (budget == 0)
+        {
+            return false;
+        }
+
+        if (budget > 0)
+        {
+            budget--;
+        }
+
+        steps++;
+        return true;
+    }
+};
+
+typedef Atomic_File<Emulated_Filesystem> Test_File;
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what, long cut, long recoverCut = -1)
+{
+    if (!condition)
+    {
+        if (failures < 20)
+        {
+            fprintf(stderr, "cut %ld, recovery cut %ld: %s\n", cut, recoverCut, what);
+        }
+
+        failures++;
+    }
+}
+
+static uint32_t checksum(const std::string &payload)
+{
+    return Emulated_Filesystem::crc32(0, (const uint8_t *)payload.data(), payload.size());
+}
+
+// Writes payload, or written instead when it differs, as WriteFileStreamed does when the contents change between passes
+static FilesystemReturnCode writePayload(Emulated_Filesystem &fs, const std::string &payload, const std::string &written)
+{
+    return Test_File::Write(fs, FILENAME, payload.size(), checksum(payload), [&](Emulated_Filesystem::File &file, uint32_t &crc) {
+        size_t count = file.write((const uint8_t *)written.data(), written.size());
+        crc = Emulated_Filesystem::crc32(0, (const uint8_t *)written.data(), count);
+        return count;
+    });
+}
+
+static FilesystemReturnCode writePayload(Emulated_Filesystem &fs, const std::string &payload)
+{
+    return writePayload(fs, payload, payload);
+}
+
+// The payload of FILENAME if it passes CheckHeader. Empty with found false if it is missing.
+static bool readPayload(Emulated_Filesystem &fs, std::string &payload, bool &found)
+{
+    payload.clear();
+    found = fs.exists(FILENAME);
+
+    if (!found)
+    {
+        return true;
+    }
+
+    Emulated_Filesystem::File file = fs.openRead(FILENAME);
+
+    if (file.peek() != PERSISTED_FILE_MAGIC || Test_File::CheckHeader(file) != FilesystemReturnCode::FILESYSTEM_OK)
+    {
+        return false;
+    }
+
+    uint8_t byte;
+
+    while (file.read(&byte, 1) == 1)
+    {
+        payload += (char)byte;
+    }
+
+    return true;
+}
+
+// Steps taken by an uninterrupted write of newPayload, with oldPayload on flash if it is not empty
+static size_t measureWrite(const std::string &oldPayload, const std::string &newPayload)
+{
+    Emulated_Filesystem fs;
+
+    if (!oldPayload.empty())
+    {
+        writePayload(fs, oldPayload);
+    }
+
+    fs.steps = 0;
+    writePayload(fs, newPayload);
+    return fs.steps;
+}
+
+// Cuts the write at every step, and the recovery after it at every step, and checks what is left
+static void checkCuts(const std::string &oldPayload, const std::string &newPayload)
+{
+    long totalSteps = measureWrite(oldPayload, newPayload);
+
+    for (long cut = 0; cut <= totalSteps; cut++)
+    {
+        for (long recoverCut = 0; recoverCut <= 4; recoverCut++)
+        {
+            Emulated_Filesystem fs;
+
+            if (!oldPayload.empty())
+            {
+                check(writePayload(fs, oldPayload) == FilesystemReturnCode::FILESYSTEM_OK, "old payload not written", cut);
+            }
+
+            fs.budget = cut;
+            FilesystemReturnCode result = writePayload(fs, newPayload);
+
+            if (cut == totalSteps)
+            {
+                check(result == FilesystemReturnCode::FILESYSTEM_OK, "uninterrupted write failed", cut);
+            }
+
+            // A reset during recovery, then a full recovery on the next boot
+            fs.budget = recoverCut;
+            Test_File::Recover(fs, FILENAME);
+
+            fs.budget = -1;
+            Test_File::Recover(fs, FILENAME);
+
+            std::string payload;
+            bool found = false;
+
+            check(readPayload(fs, payload, found), "file fails CheckHeader", cut, recoverCut);
+            check(!fs.exists(TEMP_FILENAME), "temporary file left behind", cut, recoverCut);
+
+            if (result == FilesystemReturnCode::FILESYSTEM_OK)
+            {
+                check(found && payload == newPayload, "successful write not on flash", cut, recoverCut);
+            }
+            else if (oldPayload.empty())
+            {
+                check(!found || payload == newPayload, "first write left a partial file", cut, recoverCut);
+            }
+            else
+            {
+                check(found && (payload == oldPayload || payload == newPayload), "neither old nor new payload", cut, recoverCut);
+            }
+        }
+    }
+}
+
+int main()
+{
+    const char *reference = "123456789";
+    check(Emulated_Filesystem::crc32(0, (const uint8_t *)reference, 9) == 0xCBF43926, "crc32 check value", -1);
+    check(Emulated_Filesystem::crc32(Emulated_Filesystem::crc32(0, (const uint8_t *)reference, 4), (const uint8_t *)reference + 4, 5) == 0xCBF43926,
+          "crc32 does not chain", -1);
+
+    std::string oldPayload = "\x81\xa9Locations\x91\x83\xa4Name\xa3NYC";
+    std::string newPayload = "\x81\xa9Locations\x92\x83\xa4Name\xa3NYC\x83\xa4Name\xa2SF";
+
+    // Replacing a file, and the first write of one
+    checkCuts(oldPayload, newPayload);
+    checkCuts("", newPayload);
+
+    // Contents that change between the checksum and the write never replace the file
+    Emulated_Filesystem fs;
+    writePayload(fs, oldPayload);
+
+    std::string changed = newPayload;
+    changed[changed.size() - 1] = 'X';
+
+    check(writePayload(fs, newPayload, changed) == FilesystemReturnCode::CHECKSUM_MISMATCH, "changed contents not reported", -1);
+
+    std::string payload;
+    bool found = false;
+    check(readPayload(fs, payload, found) && found && payload == oldPayload, "changed contents replaced the file", -1);
+    check(!fs.exists(TEMP_FILENAME), "temporary file left after a mismatch", -1);
+
+    // A full partition never replaces the file, whether or not the write reports the lost bytes
+    for (bool reportsFull : {true, false})
+    {
+        Emulated_Filesystem full;
+        writePayload(full, oldPayload);
+
+        full.freeBytes = sizeof(Persisted_File_Header) + newPayload.size() / 2;
+        full.reportsFull = reportsFull;
+
+        check(writePayload(full, newPayload) == FilesystemReturnCode::WRITE_FAILED, "write to a full partition not reported", -1);
+        check(readPayload(full, payload, found) && found && payload == oldPayload, "full partition replaced the file", -1);
+        check(!full.exists(TEMP_FILENAME), "temporary file left on a full partition", -1);
+    }
+
+    // A plain file without a header is read from the start
+    fs.files[FILENAME] = "\x80";
+    Emulated_Filesystem::File plain = fs.openRead(FILENAME);
+    check(Test_File::CheckHeader(plain) == FilesystemReturnCode::FILESYSTEM_OK && plain.peek() == 0x80, "plain file not left at offset 0", -1);
+
+    printf("%zu steps to replace a file, each cut and recovered\n", measureWrite(oldPayload, newPayload));
+    printf("failures: %zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,278 @@
+/*
+    Checks what the runtime profiler collects: the sample history ring, queue peak depths, timer callback
+    statistics and task CPU shares.
+
+        g++ -O2 -Wall -pthread -I host -I ../include/Utilities profiler_test.cpp -o profiler_test
+        ./profiler_test
+
+    The collector is the real Runtime_Profiler.h that System_Utils keeps its profiles in, so what is checked here
+    is what GetRuntimeStatsRpc reports:
+
+        history   more samples than RUNTIME_PROFILER_HISTORY are added. The latest and every copy length must
+                  come back oldest first, with the oldest samples dropped.
+        queues    threads send to a host queue while another drains it, recording the depth after each send as
+                  System_Utils::sendToQueue does, and a sampler records it as sampleRuntimeStats does. The peak
+                  must be the deepest any of them saw, no deeper than the queue, and a reset starts from the
+                  current depth.
+        timers    callbacks that spin for known times run through Timer_Profile::run on a timer daemon thread.
+                  Calls, last, max and average must match the durations measured, none shorter than the spin.
+                  A reset clears them and a profile without a callback records nothing.
+        tasks     CPU shares from run time counters, including the first sample, a counter that wraps and a
+                  share above one core. Task entries past RUNTIME_PROFILER_MAX_TASKS are left out of a sample
+                  and free stack is clamped to 16 bits.
+
+    Exits with 1 on any failure.
+*/
+
+#include "Runtime_Profiler.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define QUEUE_LENGTH 8
+#define SENDER_THREADS 4
+#define SENDS_PER_THREAD 20000
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what, long value = 0)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL %s (%ld)\n", what, value);
+        failures++;
+    }
+}
+
+static void checkHistory()
+{
+    Runtime_History history;
+    Runtime_Sample samples[RUNTIME_PROFILER_HISTORY + 4];
+
+    check(history.count() == 0, "empty history has samples", history.count());
+    check(history.copy(samples, RUNTIME_PROFILER_HISTORY) == 0, "empty history copied samples");
+
+    const uint32_t added = RUNTIME_PROFILER_HISTORY * 2 + 5;
+
+    for (uint32_t i = 0; i < added; i++)
+    {
+        Runtime_Sample sample = {};
+        sample.timeMS = i * RUNTIME_PROFILER_PERIOD_MS;
+        history.add(sample);
+
+        check(history.count() == min(i + 1, (uint32_t)RUNTIME_PROFILER_HISTORY), "history count", i);
+        check(history.latest().timeMS == sample.timeMS, "latest is not the last added", i);
+    }
+
+    for (size_t length = 0; length <= RUNTIME_PROFILER_HISTORY + 4; length++)
+    {
+        size_t copied = history.copy(samples, length);
+        check(copied == min(length, (size_t)RUNTIME_PROFILER_HISTORY), "copied the wrong number of samples", length);
+
+        for (size_t i = 0; i < copied; i++)
+        {
+            uint32_t expected = (added - copied + i) * RUNTIME_PROFILER_PERIOD_MS;
+            check(samples[i].timeMS == expected, "copied out of order", length * 100 + i);
+        }
+    }
+}
+
+static void checkQueuePeaks()
+{
+    QueueHandle_t queue = xQueueCreate(QUEUE_LENGTH, sizeof(uint32_t));
+    Queue_Profile profile;
+    std::mutex registry;
+    std::atomic<uint32_t> deepestSeen(0);
+    std::atomic<int> sendersLeft(SENDER_THREADS);
+
+    auto recordDepth = [&](uint32_t depth) {
+        uint32_t seen = deepestSeen.load();
+
+        while (depth > seen && !deepestSeen.compare_exchange_weak(seen, depth))
+        {
+        }
+
+        std::lock_guard<std::mutex> lock(registry);
+        profile.record(depth);
+    };
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < SENDER_THREADS; t++)
+    {
+        threads.emplace_back([&]() {
+            for (uint32_t i = 0; i < SENDS_PER_THREAD; i++)
+            {
+                xQueueSend(queue, &i, pdMS_TO_TICKS(10));
+                recordDepth(uxQueueMessagesWaiting(queue));
+            }
+
+            sendersLeft--;
+        });
+    }
+
+    // The task the queue feeds, slower than the senders so the queue fills now and then
+    threads.emplace_back([&]() {
+        uint32_t item;
+
+        while (sendersLeft.load() > 0 || uxQueueMessagesWaiting(queue) > 0)
+        {
+            if (xQueueReceive(queue, &item, pdMS_TO_TICKS(1)) == pdTRUE)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(2));
+            }
+        }
+    });
+
+    // The sampling timer
+    threads.emplace_back([&]() {
+        while (sendersLeft.load() > 0)
+        {
+            recordDepth(uxQueueMessagesWaiting(queue));
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    });
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    check(profile.peakDepth == deepestSeen.load(), "peak is not the deepest depth seen", profile.peakDepth);
+    check(profile.peakDepth <= QUEUE_LENGTH, "peak deeper than the queue", profile.peakDepth);
+    check(profile.peakDepth > 1, "queue never backed up", profile.peakDepth);
+
+    printf("queue peak depth:    %8u of %d\n", profile.peakDepth, QUEUE_LENGTH);
+
+    // As GetRuntimeStatsRpc with "reset": true
+    uint32_t item = 0;
+    xQueueSend(queue, &item, 0);
+    xQueueSend(queue, &item, 0);
+    profile.reset(uxQueueMessagesWaiting(queue));
+    check(profile.peakDepth == 2, "reset peak is not the current depth", profile.peakDepth);
+
+    profile.record(1);
+    check(profile.peakDepth == 2, "a shallower depth lowered the peak", profile.peakDepth);
+
+    vQueueDelete(queue);
+}
+
+static uint32_t spinUS = 0;
+
+static void spinningCallback(TimerHandle_t timer)
+{
+    int64_t until = esp_timer_get_time() + spinUS;
+
+    while (esp_timer_get_time() < until)
+    {
+    }
+}
+
+static void checkTimers()
+{
+    static const uint32_t SPINS_US[] = {200, 1500, 50, 800, 1200, 10, 400};
+
+    Timer_Profile profile;
+    profile.callback = spinningCallback;
+
+    std::vector<uint32_t> measured;
+
+    // The timer daemon runs every callback, one after another
+    std::thread daemon([&]() {
+        for (uint32_t spin : SPINS_US)
+        {
+            spinUS = spin;
+            profile.run(nullptr);
+            measured.push_back(profile.lastUS);
+        }
+    });
+
+    daemon.join();
+
+    uint32_t maxUS = 0;
+    uint64_t totalUS = 0;
+
+    for (size_t i = 0; i < measured.size(); i++)
+    {
+        check(measured[i] >= SPINS_US[i], "callback timed shorter than it ran", i);
+        maxUS = max(maxUS, measured[i]);
+        totalUS += measured[i];
+    }
+
+    size_t calls = sizeof(SPINS_US) / sizeof(SPINS_US[0]);
+
+    check(profile.calls == calls, "calls", profile.calls);
+    check(profile.lastUS == measured.back(), "last", profile.lastUS);
+    check(profile.maxUS == maxUS, "max", profile.maxUS);
+    check(profile.averageUS() == (uint32_t)(totalUS / calls), "average", profile.averageUS());
+    check(profile.maxUS >= 1500 && profile.averageUS() >= 594, "max or average below the spins", profile.maxUS);
+
+    printf("timer calls:         %8u, max %u us, average %u us\n", profile.calls, profile.maxUS, profile.averageUS());
+
+    // As GetRuntimeStatsRpc with "reset": true
+    profile.resetStats();
+    check(profile.calls == 0 && profile.maxUS == 0 && profile.totalUS == 0, "reset left statistics", profile.calls);
+    check(profile.averageUS() == 0, "average of no calls", profile.averageUS());
+
+    // A deleted timer's profile keeps working for a callback already running
+    profile.deleted = true;
+    spinUS = 100;
+    profile.run(nullptr);
+    check(profile.calls == 1 && profile.maxUS >= 100, "deleted timer's run was not recorded", profile.calls);
+
+    Timer_Profile empty;
+    empty.run(nullptr);
+    check(empty.calls == 0, "run without a callback was recorded", empty.calls);
+}
+
+static void checkTasks()
+{
+    Task_Profile profile;
+
+    // The first sample has nothing to measure from
+    profile.update(123456, 0);
+    check(profile.cpuPercent == RUNTIME_CPU_UNAVAILABLE, "first sample has a share", profile.cpuPercent);
+
+    profile.update(123456 + 1250000, 5000000);
+    check(profile.cpuPercent == 25, "quarter of a core", profile.cpuPercent);
+
+    profile.update(123456 + 1250000, 5000000);
+    check(profile.cpuPercent == 0, "idle task has a share", profile.cpuPercent);
+
+    // The counter is 32 bits of microseconds and wraps after about 71 minutes
+    profile.lastRunTime = UINT32_MAX - 999999;
+    profile.update(2000000, 5000000);
+    check(profile.cpuPercent == 60, "share across a counter wrap", profile.cpuPercent);
+
+    // Time stamps taken a little apart can make a busy task look like more than a core
+    profile.update(2000000 + 5100000, 5000000);
+    check(profile.cpuPercent == 100, "share above one core is not clamped", profile.cpuPercent);
+
+    Runtime_Sample sample = {};
+
+    for (int taskID = 0; taskID < RUNTIME_PROFILER_MAX_TASKS + 3; taskID++)
+    {
+        bool added = sample.addTask(taskID, taskID, taskID == 0 ? 100000 : 2048);
+        check(added == (taskID < RUNTIME_PROFILER_MAX_TASKS), "task past the sample's room", taskID);
+    }
+
+    check(sample.numTasks == RUNTIME_PROFILER_MAX_TASKS, "tasks in sample", sample.numTasks);
+    check(sample.tasks[0].stackFree == UINT16_MAX, "free stack not clamped", sample.tasks[0].stackFree);
+    check(sample.tasks[5].taskID == 5 && sample.tasks[5].cpuPercent == 5 && sample.tasks[5].stackFree == 2048,
+          "task entry", sample.tasks[5].taskID);
+}
+
+int main()
+{
+    checkHistory();
+    checkQueuePeaks();
+    checkTimers();
+    checkTasks();
+
+    printf("failures:            %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+/*
+    Counts the redraws the adaptive refresh timer makes for the refreshing screens, stationary and moving,
+    against the fixed timer they used before.
+
+        g++ -O2 -Wall -DHARDWARE_VERSION=2 -I host/ui -I host -I ../include -I ../include/Utilities \
+            refresh_sim.cpp ../src/Utilities/Display_Utils.cpp ../src/Utilities/EventHandler.cpp -o refresh_sim
+        ./refresh_sim [seconds]
+
+    The real Display_Utils::NextRefreshWaitMS and ShouldRefresh decide when to redraw, stepped the way
+    processCommandQueue waits on its queue, on a simulated clock with no inputs arriving. The refresh sources
+    are Display_Manager's, fed by models instead of the sensors:
+
+        GPS       a 1 Hz fix through Display_Utils::LocationRefreshValue. Stationary is run twice, once with
+                  the receiver holding its fix and once with 2 m RMS of position noise. Moving is a 1.4 m/s walk.
+        COMPASS   20 Hz magnetometer samples with 2 degrees RMS of noise through the real Heading_Filter,
+                  rounded as Heading_Utils::GetAzimuth does. Moving is a 30 degree/s turn.
+        MESSAGES  the message store version, bumped by a ping arriving every 45 s.
+        CLOCK     uptime seconds, as the source falls back to before the GPS has the time.
+
+    Each screen is run for the given time, 600 s by default, with the dependencies and period it now enables.
+    Stationary with a held fix, the GPS window must draw only its first frame. Stationary, no screen may draw
+    more than the fixed timer did, and the compass must draw at most half as often. Moving, the GPS and compass
+    screens must draw at least 80% as often as the fixed timer, so they keep up. Repeat_Message_State must
+    still repeat every MESSAGE_REPEAT_INTERVAL_MS. With the fix held, Nearby_State must draw once for each
+    ping that arrives and not otherwise. Exits with 1 on any failure.
+*/
+
+#include "Display_Utils.h"
+#include "Heading_Filter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+// As in the screens
+#define GPS_WINDOW_REFRESH_RATE_MS 1000
+#define COMPASS_WINDOW_REFRESH_RATE_MS 100
+#define MESSAGE_REPEAT_INTERVAL_MS 30000
+
+// As in Heading_Utils.h
+#define HEADING_SAMPLE_PERIOD_MS 50
+
+#define GPS_FIX_PERIOD_MS 1000
+#define PING_PERIOD_MS 45000
+#define METERS_PER_DEGREE 111320.0
+
+enum Motion
+{
+    MOTION_HELD,
+    MOTION_STATIONARY,
+    MOTION_MOVING,
+};
+
+static const char *const MOTION_NAMES[] = {"held fix", "stationary", "moving"};
+
+// Sensor models, advanced to the simulated time before every refresh check
+struct Sensor_Model
+{
+    Motion motion = MOTION_STATIONARY;
+    uint64_t nowMS = 0;
+
+    std::mt19937 random{1234};
+
+    uint64_t nextFixMS = 0;
+    bool fixValid = false;
+    double lat = 0;
+    double lng = 0;
+    double walkedM = 0;
+
+    uint64_t nextSampleMS = 0;
+    Heading_Filter filter;
+    float truthHeadingDeg = 200.0f;
+
+    uint32_t messageStoreVersion = 0;
+
+    void reset(Motion newMotion)
+    {
+        motion = newMotion;
+        nowMS = 0;
+        random.seed(1234);
+        nextFixMS = 0;
+        fixValid = false;
+        walkedM = 0;
+        nextSampleMS = 0;
+        filter.reset();
+        truthHeadingDeg = 200.0f;
+        messageStoreVersion = 0;
+    }
+
+    void advance(uint64_t toMS)
+    {
+        std::normal_distribution<double> positionNoiseM(0.0, motion == MOTION_STATIONARY ? 2.0 : 0.0);
+        std::normal_distribution<float> headingNoiseDeg(0.0f, 2.0f);
+
+        while (nextFixMS <= toMS)
+        {
+            if (motion == MOTION_MOVING)
+            {
+                walkedM = nextFixMS * 1.4 / 1000.0;
+            }
+
+            lat = 47.6 + (walkedM + positionNoiseM(random)) / METERS_PER_DEGREE;
+            lng = -122.3 + positionNoiseM(random) / METERS_PER_DEGREE;
+            fixValid = true;
+            nextFixMS += GPS_FIX_PERIOD_MS;
+        }
+
+        while (nextSampleMS <= toMS)
+        {
+            if (motion == MOTION_MOVING)
+            {
+                truthHeadingDeg = Heading_Filter::wrap360(200.0f + nextSampleMS * 30.0f / 1000.0f);
+            }
+
+            filter.update(truthHeadingDeg + headingNoiseDeg(random), HEADING_SAMPLE_PERIOD_MS / 1000.0f, 0, 0, false);
+            nextSampleMS += HEADING_SAMPLE_PERIOD_MS;
+        }
+
+        messageStoreVersion = toMS / PING_PERIOD_MS;
+        nowMS = toMS;
+    }
+};
+
+static Sensor_Model sensors;
+
+struct Screen
+{
+    const char *name;
+    uint32_t periodMS;
+    uint32_t dependencies;
+};
+
+static const Screen SCREENS[] = {
+    {"GPS_Window", GPS_WINDOW_REFRESH_RATE_MS, REFRESH_DEPENDENCY_GPS},
+    {"CompassDebugState", COMPASS_WINDOW_REFRESH_RATE_MS, REFRESH_DEPENDENCY_COMPASS},
+    {"Nearby_State", 1000, REFRESH_DEPENDENCY_GPS | REFRESH_DEPENDENCY_MESSAGES},
+    {"Repeat_Message_State", MESSAGE_REPEAT_INTERVAL_MS, REFRESH_DEPENDENCY_CLOCK},
+    {"Repeat_Message_State live", MESSAGE_REPEAT_INTERVAL_MS, REFRESH_DEPENDENCY_CLOCK | REFRESH_DEPENDENCY_GPS},
+};
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *screen, const char *motion, const char *what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL %s, %s: %s\n", screen, motion, what);
+        failures++;
+    }
+}
+
+// Runs a screen for durationMS on the simulated clock and returns the number of redraws
+static uint32_t runScreen(const Screen &screen, uint32_t dependencies, Motion motion, uint64_t durationMS)
+{
+    sensors.reset(motion);
+    Display_Utils::enableRefreshTimer(screen.periodMS, dependencies);
+
+    uint32_t drawnBefore = Display_Utils::RefreshesDrawn();
+    uint64_t nowMS = 0;
+
+    while (true)
+    {
+        nowMS += Display_Utils::NextRefreshWaitMS();
+
+        if (nowMS > durationMS)
+        {
+            break;
+        }
+
+        sensors.advance(nowMS);
+        Display_Utils::ShouldRefresh();
+    }
+
+    Display_Utils::disableRefreshTimer();
+    return Display_Utils::RefreshesDrawn() - drawnBefore;
+}
+
+static void registerSources()
+{
+    // As Display_Manager::registerRefreshSources
+    Display_Utils::RegisterRefreshSource(REFRESH_DEPENDENCY_COMPASS, []() -> uint32_t {
+        if (!sensors.filter.valid())
+        {
+            return (uint32_t)-1;
+        }
+
+        return (uint32_t)((int)lroundf(sensors.filter.heading()) % 360);
+    });
+
+    Display_Utils::RegisterRefreshSource(REFRESH_DEPENDENCY_GPS, []() -> uint32_t {
+        return Display_Utils::LocationRefreshValue(sensors.fixValid, sensors.lat, sensors.lng);
+    });
+
+    Display_Utils::RegisterRefreshSource(REFRESH_DEPENDENCY_MESSAGES, []() -> uint32_t {
+        return sensors.messageStoreVersion;
+    });
+
+    Display_Utils::RegisterRefreshSource(REFRESH_DEPENDENCY_CLOCK, []() -> uint32_t {
+        return (uint32_t)(sensors.nowMS / 1000);
+    });
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t durationMS = 600000;
+
+    if (argc > 1)
+    {
+        durationMS = strtoull(argv[1], nullptr, 10) * 1000;
+
+        if (durationMS == 0)
+        {
+            fprintf(stderr, "usage: %s [seconds]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    registerSources();
+
+    printf("%llu s simulated per run\n\n", (unsigned long long)(durationMS / 1000));
+    printf("%-26s %-11s %8s %8s %7s\n", "screen", "motion", "fixed", "adaptive", "share");
+
+    for (const Screen &screen : SCREENS)
+    {
+        for (int m = MOTION_HELD; m <= MOTION_MOVING; m++)
+        {
+            Motion motion = (Motion)m;
+            uint32_t fixed = runScreen(screen, REFRESH_DEPENDENCY_NONE, motion, durationMS);
+            uint32_t adaptive = runScreen(screen, screen.dependencies, motion, durationMS);
+
+            printf("%-26s %-11s %8u %8u %6.1f%%\n", screen.name, MOTION_NAMES[m], fixed, adaptive,
+                   fixed > 0 ? 100.0 * adaptive / fixed : 0.0);
+
+            bool usesGPS = screen.dependencies & REFRESH_DEPENDENCY_GPS;
+            bool usesCompass = screen.dependencies & REFRESH_DEPENDENCY_COMPASS;
+            bool usesClock = screen.dependencies & REFRESH_DEPENDENCY_CLOCK;
+
+            check(adaptive > 0, screen.name, MOTION_NAMES[m], "never drawn");
+
+            if (motion != MOTION_MOVING)
+            {
+                check(adaptive <= fixed, screen.name, MOTION_NAMES[m], "more redraws than the fixed timer");
+            }
+
+            if (motion == MOTION_HELD && usesGPS && !usesClock)
+            {
+                uint32_t pings = (screen.dependencies & REFRESH_DEPENDENCY_MESSAGES) ? durationMS / PING_PERIOD_MS : 0;
+                check(adaptive == 1 + pings, screen.name, MOTION_NAMES[m], "redrawn while the fix is held");
+            }
+
+            if (motion != MOTION_MOVING && usesCompass)
+            {
+                check(adaptive * 2 <= fixed, screen.name, MOTION_NAMES[m], "compass noise still redraws");
+            }
+
+            if (motion == MOTION_MOVING && (usesGPS || usesCompass) && !usesClock)
+            {
+                check(adaptive * 5 >= fixed * 4, screen.name, MOTION_NAMES[m], "falls behind the fixed timer");
+            }
+
+            if (usesClock)
+            {
+                check(adaptive == fixed, screen.name, MOTION_NAMES[m], "no longer repeats every interval");
+            }
+        }
+    }
+
+    printf("\nchecks skipped:      %8u\n", Display_Utils::RefreshesSkipped());
+    printf("failures:            %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
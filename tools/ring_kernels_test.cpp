@@ -0,0 +1,242 @@
+/*
+    Checks Ring_Kernels against the float code it replaced and times both.
+
+        g++ -O2 -I host -I ../include/HelperClasses/LED_Patterns ring_kernels_test.cpp \
+            ../src/HelperClasses/LED_Patterns/Ring_Kernels.cpp -o ring_kernels_test
+        ./ring_kernels_test
+
+    The references are RingPoint::GetLEDPointBrightness, ScrollWheel::_CalculateLEDPointBrightness and the three
+    parabolas of LED_Manager::interpolateLEDsDegrees as they were before the kernel. Each caller's parameters are
+    swept and every channel of every LED must be within one LSB of the reference. Exits with 1 otherwise.
+*/
+
+#include "Ring_Kernels.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// As LED_Manager.h
+#define NUM_COMPASS_LEDS 16
+
+#define MAX_RING_LEDS 64
+#define BENCH_FRAMES 200000
+
+typedef std::chrono::steady_clock Clock;
+
+static const CRGB colors[] = {CRGB(255, 255, 255), CRGB(255, 128, 0), CRGB(37, 200, 3), CRGB(1, 2, 254)};
+
+struct Result
+{
+    size_t channels = 0;
+    size_t exact = 0;
+    size_t failures = 0;
+    int maxError = 0;
+};
+
+static void compare(const char *name, const CRGB *expected, const CRGB *actual, int numLeds, Result &result)
+{
+    for (int i = 0; i < numLeds; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            int error = abs((int)expected[i].raw[c] - (int)actual[i].raw[c]);
+
+            result.channels++;
+            result.exact += error == 0;
+            result.maxError = max(result.maxError, error);
+
+            if (error > 1)
+            {
+                if (result.failures < 10)
+                {
+                    fprintf(stderr, "%s: LED %d channel %d expected %d got %d\n", name, i, c, expected[i].raw[c], actual[i].raw[c]);
+                }
+
+                result.failures++;
+            }
+        }
+    }
+}
+
+static CRGB scaled(const CRGB &color, float brightness)
+{
+    return CRGB(color.r * brightness, color.g * brightness, color.b * brightness);
+}
+
+// RingPoint before the kernel, with beginIdx 0
+static void referenceRingPoint(CRGB *leds, int endIdx, float directionDegrees, float fadeDegrees, const CRGB &color)
+{
+    for (int i = 0; i <= endIdx; i++)
+    {
+        float angle = (float)i * 360.0 / (float)endIdx;
+        float angleDiff = fabsf(angle - directionDegrees);
+
+        if (angleDiff > 180)
+        {
+            angleDiff = 360 - angleDiff;
+        }
+
+        leds[i] = angleDiff > fadeDegrees ? CRGB() : scaled(color, 1.0 - (angleDiff / fadeDegrees));
+    }
+}
+
+// ScrollWheel before the kernel, with beginIdx 0
+static void referenceScrollWheel(CRGB *leds, int endIdx, int numItems, int currItem, const CRGB &color)
+{
+    float targetAngle = ((float)currItem / numItems) * 360.0;
+    float fadeDegrees = max((360.0f / (float)numItems) / 2.0f, (360.0f / endIdx));
+
+    for (int i = 0; i <= endIdx; i++)
+    {
+        float angle = (float)i * 360.0 / (float)endIdx;
+        float angleDiff = fabsf(angle - targetAngle);
+
+        if (angleDiff > 180)
+        {
+            angleDiff = 360 - angleDiff;
+        }
+
+        leds[i] = angleDiff > fadeDegrees ? CRGB() : scaled(color, (-1.0 * pow(angleDiff / fadeDegrees, 2.0)) + 1.0);
+    }
+}
+
+// LED_Manager::interpolateLEDsDegrees before the kernel
+static void referenceCompass(CRGB *leds, double deg, double distanceAway, const CRGB &color)
+{
+    double ledDirection = (deg / 360.0f) * NUM_COMPASS_LEDS;
+    float distanceMultiplier = (7.0f / 2000.0f) * (distanceAway - 20.0f) + (1.0f / 8.0f);
+
+    for (int i = 0; i < NUM_COMPASS_LEDS; i++)
+    {
+        float brightness = -1.0f * distanceMultiplier * (i - ledDirection) * (i - ledDirection) + 1.0f;
+        float brightness2 = -1.0f * distanceMultiplier * (i - (ledDirection - NUM_COMPASS_LEDS)) * (i - (ledDirection - NUM_COMPASS_LEDS)) + 1.0f;
+        float brightness3 = -1.0f * distanceMultiplier * (i - (ledDirection + NUM_COMPASS_LEDS)) * (i - (ledDirection + NUM_COMPASS_LEDS)) + 1.0f;
+
+        brightness = max(brightness, brightness2);
+        brightness = max(brightness, brightness3);
+        brightness = constrain(brightness, 0.0f, 1.0f);
+
+        leds[i] = scaled(color, brightness);
+    }
+}
+
+// The kernel calls as RingPoint, ScrollWheel and LED_Manager make them
+static void kernelRingPoint(CRGB *leds, int endIdx, float directionDegrees, float fadeDegrees, const CRGB &color)
+{
+    Ring_Kernels::renderPoint(leds, 0, endIdx, endIdx, Ring_Kernels::degreesToAngle(directionDegrees),
+                              Ring_Kernels::degreesToWidth(fadeDegrees), color, RING_FALLOFF_LINEAR);
+}
+
+static void kernelScrollWheel(CRGB *leds, int endIdx, int numItems, int currItem, const CRGB &color)
+{
+    uint32_t targetAngle = (uint64_t)currItem * 0x100000000ULL / numItems;
+    uint64_t fadeWidth = max(0x80000000ULL / numItems, 0x100000000ULL / endIdx);
+
+    Ring_Kernels::renderPoint(leds, 0, endIdx, endIdx, targetAngle, min(fadeWidth, (uint64_t)UINT32_MAX), color, RING_FALLOFF_QUADRATIC);
+}
+
+static void kernelCompass(CRGB *leds, double deg, double distanceAway, const CRGB &color)
+{
+    float distanceMultiplier = (7.0f / 2000.0f) * (distanceAway - 20.0f) + (1.0f / 8.0f);
+    uint32_t fadeWidth = distanceMultiplier > 0.0f ? Ring_Kernels::degreesToWidth(360.0f / (NUM_COMPASS_LEDS * sqrtf(distanceMultiplier))) : UINT32_MAX;
+
+    Ring_Kernels::renderPoint(leds, 0, NUM_COMPASS_LEDS - 1, NUM_COMPASS_LEDS, Ring_Kernels::degreesToAngle(deg), fadeWidth, color, RING_FALLOFF_QUADRATIC);
+}
+
+static void report(const char *name, const Result &result)
+{
+    printf("%-12s %10zu %9.2f%% %10d %10zu\n", name, result.channels, 100.0 * result.exact / result.channels, result.maxError, result.failures);
+}
+
+template <typename Render>
+static double nsPerFrame(Render render)
+{
+    CRGB leds[MAX_RING_LEDS];
+    auto start = Clock::now();
+
+    for (int frame = 0; frame < BENCH_FRAMES; frame++)
+    {
+        render(leds, frame);
+    }
+
+    // Keep the frames from being optimised away
+    volatile uint8_t sink = leds[0].r;
+    (void)sink;
+
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / BENCH_FRAMES;
+}
+
+int main()
+{
+    CRGB expected[MAX_RING_LEDS];
+    CRGB actual[MAX_RING_LEDS];
+
+    const int endIdxs[] = {8, 15, 16, 24};
+
+    Result ringPoint;
+
+    for (int endIdx : endIdxs)
+    {
+        for (float direction = 0; direction < 360; direction += 0.7f)
+        {
+            for (float fade = 1; fade <= 180; fade += 3.3f)
+            {
+                for (const CRGB &color : colors)
+                {
+                    referenceRingPoint(expected, endIdx, direction, fade, color);
+                    kernelRingPoint(actual, endIdx, direction, fade, color);
+                    compare("RingPoint", expected, actual, endIdx + 1, ringPoint);
+                }
+            }
+        }
+    }
+
+    Result scrollWheel;
+
+    for (int endIdx : endIdxs)
+    {
+        for (int numItems = 1; numItems <= 200; numItems++)
+        {
+            for (int currItem = 0; currItem < numItems; currItem++)
+            {
+                for (const CRGB &color : colors)
+                {
+                    referenceScrollWheel(expected, endIdx, numItems, currItem, color);
+                    kernelScrollWheel(actual, endIdx, numItems, currItem, color);
+                    compare("ScrollWheel", expected, actual, endIdx + 1, scrollWheel);
+                }
+            }
+        }
+    }
+
+    Result compass;
+
+    for (double deg = 0; deg < 360; deg += 0.37)
+    {
+        for (double distance = 0; distance <= 3000; distance += 7)
+        {
+            for (const CRGB &color : colors)
+            {
+                referenceCompass(expected, deg, distance, color);
+                kernelCompass(actual, deg, distance, color);
+                compare("Compass", expected, actual, NUM_COMPASS_LEDS, compass);
+            }
+        }
+    }
+
+    printf("%-12s %10s %10s %10s %10s\n", "caller", "channels", "exact", "max LSB", "over 1");
+    report("RingPoint", ringPoint);
+    report("ScrollWheel", scrollWheel);
+    report("Compass", compass);
+
+    // A 16 LED compass frame, the most common render
+    double floatNS = nsPerFrame([](CRGB *leds, int frame) { referenceCompass(leds, frame % 360, 100 + frame % 500, colors[0]); });
+    double kernelNS = nsPerFrame([](CRGB *leds, int frame) { kernelCompass(leds, frame % 360, 100 + frame % 500, colors[0]); });
+
+    printf("\n16 LED compass frame: float %.1f ns, kernel %.1f ns\n", floatNS, kernelNS);
+    printf("Host timings only compare the two paths. The ESP32 has no FPU for the double math, so the gap is wider there.\n");
+
+    size_t failures = ringPoint.failures + scrollWheel.failures + compass.failures;
+    return failures == 0 ? 0 : 1;
+}
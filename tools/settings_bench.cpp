@@ -0,0 +1,252 @@
+/*
+    Checks Settings_Store and measures lookup cost and the bytes persist() writes per update.
+
+        g++ -O2 -I ../include/Utilities settings_bench.cpp ../src/Utilities/Settings_Store.cpp -o settings_bench
+        ./settings_bench
+
+    The delta encoding is compared byte for byte against hand encoded MessagePack, which is what
+    Settings_Registry::applyDelta reads back with ArduinoJson. Exits with 1 on any failure.
+*/
+
+#include "Settings_Store.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+
+#define ITERATIONS 1000000
+
+typedef std::chrono::steady_clock Clock;
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static double elapsedNS(Clock::time_point start, size_t count)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+}
+
+static Setting_Value boolValue(bool value)
+{
+    Setting_Value result = {};
+    result.present = true;
+    result.boolean = value;
+    return result;
+}
+
+static Setting_Value intValue(int32_t value)
+{
+    Setting_Value result = {};
+    result.present = true;
+    result.integer = value;
+    return result;
+}
+
+// Encoded delta of a store holding only key set to value
+static std::string encodeOne(Setting_Key key, const Setting_Value &value)
+{
+    Settings_Store store;
+    store.set(key, value);
+
+    uint8_t buffer[SETTINGS_DELTA_MAX_BYTES];
+    size_t length = store.encodeDelta(buffer, sizeof(buffer));
+
+    return std::string((const char *)buffer, length);
+}
+
+// A one entry map of key name to the given value bytes
+static std::string expectedOne(Setting_Key key, std::initializer_list<uint8_t> valueBytes)
+{
+    const char *name = Settings_Store::Descriptor(key).name;
+
+    std::string expected;
+    expected += (char)0x81;
+    expected += (char)(0xa0 | strlen(name));
+    expected += name;
+
+    for (uint8_t byte : valueBytes)
+    {
+        expected += (char)byte;
+    }
+
+    return expected;
+}
+
+static void checkEncoding(Setting_Key key, const Setting_Value &value, std::initializer_list<uint8_t> valueBytes, const char *what)
+{
+    check(encodeOne(key, value) == expectedOne(key, valueBytes), what);
+}
+
+static void checkEncodings()
+{
+    checkEncoding(SETTING_SILENT_MODE, boolValue(true), {0xc3}, "true encodes as 0xc3");
+    checkEncoding(SETTING_SILENT_MODE, boolValue(false), {0xc2}, "false encodes as 0xc2");
+
+    checkEncoding(SETTING_USER_ID, intValue(7), {0x07}, "positive fixint");
+    checkEncoding(SETTING_USER_ID, intValue(-5), {0xfb}, "negative fixint");
+    checkEncoding(SETTING_USER_ID, intValue(200), {0xcc, 0xc8}, "uint8");
+    checkEncoding(SETTING_USER_ID, intValue(300), {0xcd, 0x01, 0x2c}, "uint16");
+    checkEncoding(SETTING_USER_ID, intValue(70000), {0xce, 0x00, 0x01, 0x11, 0x70}, "uint32");
+    checkEncoding(SETTING_USER_ID, intValue(-100), {0xd0, 0x9c}, "int8");
+    checkEncoding(SETTING_USER_ID, intValue(-300), {0xd1, 0xfe, 0xd4}, "int16");
+    checkEncoding(SETTING_USER_ID, intValue(-70000), {0xd2, 0xff, 0xfe, 0xee, 0x90}, "int32");
+
+    checkEncoding(SETTING_DEVICE_NAME, Settings_Store::Parse(SETTING_DEVICE_NAME, "Blake"), {0xa5, 'B', 'l', 'a', 'k', 'e'}, "fixstr");
+
+    // Two keys are written in key order
+    Settings_Store store;
+    store.set(SETTING_24H_TIME, boolValue(true));
+    store.set(SETTING_USER_ID, intValue(1));
+
+    uint8_t buffer[SETTINGS_DELTA_MAX_BYTES];
+    size_t length = store.encodeDelta(buffer, sizeof(buffer));
+
+    std::string expected = "\x82\xa6UserID\x01\xa8" "24H Time\xc3";
+    check(std::string((const char *)buffer, length) == expected, "two key map in key order");
+
+    // Too small a buffer fails rather than truncating
+    check(store.encodeDelta(buffer, length - 1) == 0, "short buffer reports 0");
+    check(store.encodeDelta(buffer, length) == length, "exact buffer fits");
+}
+
+static void checkBehaviour()
+{
+    Settings_Store store;
+
+    check(!store.has(SETTING_USER_ID), "empty store has no keys");
+    check(store.set(SETTING_USER_ID, intValue(5)), "first set changes the value");
+    check(!store.set(SETTING_USER_ID, intValue(5)), "same value is not a change");
+    check(store.dirtyKeys() == (1UL << SETTING_USER_ID), "set marks the key dirty");
+
+    store.markPersisted(store.dirtyKeys());
+    check(store.dirtyKeys() == 0 && store.deltaKeys() == (1UL << SETTING_USER_ID), "persisted keys stay in the delta");
+
+    check(store.load(SETTING_SILENT_MODE, boolValue(true)), "load changes the value");
+    check(store.dirtyKeys() == 0 && !(store.deltaKeys() & (1UL << SETTING_SILENT_MODE)), "loaded keys are not dirty");
+
+    store.loadDelta(SETTING_24H_TIME, boolValue(true));
+    check(store.dirtyKeys() == 0 && (store.deltaKeys() & (1UL << SETTING_24H_TIME)), "delta keys are not dirty");
+
+    store.clearDelta();
+    check(store.dirtyKeys() == 0 && store.deltaKeys() == 0, "clearDelta empties both masks");
+    check(store.value(SETTING_USER_ID).integer == 5, "clearDelta keeps the values");
+
+    check(Settings_Store::Find("WiFi Provisioning") == SETTING_WIFI_PROVISIONING, "find by name");
+    check(Settings_Store::Find("Unknown") == NUM_SETTINGS && Settings_Store::Find(nullptr) == NUM_SETTINGS, "unknown names");
+
+    check(Settings_Store::Parse(SETTING_SILENT_MODE, "true").boolean, "parse true");
+    check(Settings_Store::Parse(SETTING_SILENT_MODE, "1").boolean, "parse 1");
+    check(!Settings_Store::Parse(SETTING_SILENT_MODE, "false").boolean, "parse false");
+    check(Settings_Store::Parse(SETTING_USER_ID, "-42").integer == -42, "parse int");
+
+    std::string longName(100, 'x');
+    Setting_Value truncated = Settings_Store::Parse(SETTING_DEVICE_NAME, longName.c_str());
+    check(strlen(truncated.text) == SETTING_STRING_LENGTH - 1, "long strings are truncated");
+}
+
+int main()
+{
+    checkEncodings();
+    checkBehaviour();
+
+    Settings_Store store;
+    store.set(SETTING_DEVICE_NAME, Settings_Store::Parse(SETTING_DEVICE_NAME, "Blake"));
+    store.set(SETTING_USER_ID, intValue(1234));
+    store.set(SETTING_WIFI_PROVISIONING, intValue(1));
+    store.set(SETTING_SILENT_MODE, boolValue(false));
+    store.set(SETTING_24H_TIME, boolValue(true));
+
+    // Typed read by key, as the getters do
+    volatile uint8_t keyIndex = 0;
+    int64_t sum = 0;
+    auto start = Clock::now();
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        Setting_Key key = (Setting_Key)((keyIndex + i) % NUM_SETTINGS);
+        sum += store.has(key) ? store.value(key).integer : 0;
+    }
+
+    double getNS = elapsedNS(start, ITERATIONS);
+
+    // Name lookup, as the RPC handlers do once per update
+    const char *names[NUM_SETTINGS];
+
+    for (uint8_t key = 0; key < NUM_SETTINGS; key++)
+    {
+        names[key] = Settings_Store::Descriptor((Setting_Key)key).name;
+    }
+
+    start = Clock::now();
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        sum += Settings_Store::Find(names[(keyIndex + i) % NUM_SETTINGS]);
+    }
+
+    double findNS = elapsedNS(start, ITERATIONS);
+
+    // A changed value and the delta persist() then writes
+    uint8_t buffer[SETTINGS_DELTA_MAX_BYTES];
+    start = Clock::now();
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        store.set(SETTING_USER_ID, intValue((int32_t)i));
+        sum += store.encodeDelta(buffer, sizeof(buffer));
+    }
+
+    double updateNS = elapsedNS(start, ITERATIONS);
+
+    printf("typed get:             %8.1f ns\n", getNS);
+    printf("find by name:          %8.1f ns\n", findNS);
+    printf("set and encode delta:  %8.1f ns\n\n", updateNS);
+
+    // Bytes written by the first update of each key after a full write. The file adds its header.
+    printf("%-20s %12s\n", "first update of", "delta bytes");
+
+    for (uint8_t key = 0; key < NUM_SETTINGS; key++)
+    {
+        Setting_Key settingKey = (Setting_Key)key;
+        Settings_Store single;
+        single.set(settingKey, store.value(settingKey));
+
+        printf("%-20s %12zu\n", Settings_Store::Descriptor(settingKey).name, single.encodeDelta(buffer, sizeof(buffer)));
+    }
+
+    printf("%-20s %12zu\n", "all keys", store.encodeDelta(buffer, sizeof(buffer)));
+
+    // Every key at its longest value must fit the buffer persist() uses
+    std::string longest(SETTING_STRING_LENGTH - 1, 'x');
+
+    for (uint8_t key = 0; key < NUM_SETTINGS; key++)
+    {
+        Setting_Key settingKey = (Setting_Key)key;
+        Setting_Value value = Settings_Store::Parse(settingKey, longest.c_str());
+
+        if (Settings_Store::Descriptor(settingKey).type == SETTING_TYPE_INT)
+        {
+            value.integer = INT32_MIN;
+        }
+
+        store.set(settingKey, value);
+    }
+
+    size_t worstBytes = store.encodeDelta(buffer, sizeof(buffer));
+    check(worstBytes != 0, "longest delta fits SETTINGS_DELTA_MAX_BYTES");
+
+    printf("%-20s %12zu of %d\n\n", "longest values", worstBytes, SETTINGS_DELTA_MAX_BYTES);
+    printf("failures: %zu\n", failures);
+
+    return failures == 0 && sum != 0 ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+/*
+    Checks Spatial_Index against a linear scan and times both.
+
+        g++ -O2 -I ../include/Utilities spatial_bench.cpp -o spatial_bench
+        ./spatial_bench [numPoints] [seed]
+
+    Points are clustered around a few towns, as saved locations and pings are, with some spread over the globe
+    and some near the antimeridian and the poles. Every query is compared against the scan and the bench exits
+    with 1 on any difference.
+*/
+
+#include "Spatial_Index.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#define QUERIES 500
+#define NEAREST_COUNT 10
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedUS(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+static Geo_Point_E7 randomPoint(std::mt19937 &rng, const std::vector<Geo_Point_E7> &towns)
+{
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> spread(0.0, 0.05);
+    double choice = unit(rng);
+
+    if (choice < 0.8)
+    {
+        const Geo_Point_E7 &town = towns[rng() % towns.size()];
+        double lat = Geo_Math::toDegrees(town.latE7) + spread(rng);
+        double lng = Geo_Math::toDegrees(town.lngE7) + spread(rng);
+        return Geo_Math::toE7(std::max(-90.0, std::min(90.0, lat)), lng > 180 ? lng - 360 : (lng < -180 ? lng + 360 : lng));
+    }
+
+    if (choice < 0.9)
+    {
+        return Geo_Math::toE7(asin(unit(rng) * 2 - 1) * 180 / M_PI, unit(rng) * 360 - 180);
+    }
+
+    if (choice < 0.95)
+    {
+        return Geo_Math::toE7(unit(rng) * 10 - 5, unit(rng) < 0.5 ? 179.9 + unit(rng) * 0.1 : -180 + unit(rng) * 0.1);
+    }
+
+    return Geo_Math::toE7(89 + unit(rng), unit(rng) * 360 - 180);
+}
+
+static void linearScan(const std::vector<Spatial_Entry> &points, Geo_Point_E7 center, float radiusM, std::vector<Spatial_Match> &matches)
+{
+    Geo_Projection projection(center);
+    matches.clear();
+
+    for (const auto &point : points)
+    {
+        Geo_Vector vector = projection.vectorTo(center, point.point);
+
+        if (vector.distanceM <= radiusM)
+        {
+            matches.push_back({point.kind, point.id, point.point, vector});
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const Spatial_Match &a, const Spatial_Match &b) {
+        return a.vector.distanceM < b.vector.distanceM;
+    });
+}
+
+static bool sameDistances(const std::vector<Spatial_Match> &a, const std::vector<Spatial_Match> &b, size_t count)
+{
+    if (a.size() < count || b.size() < count)
+    {
+        return false;
+    }
+
+    // Ties may come back in either order, so compare distances rather than ids
+    for (size_t i = 0; i < count; i++)
+    {
+        if (a[i].vector.distanceM != b[i].vector.distanceM)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    size_t numPoints = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+    unsigned seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+
+    std::mt19937 rng(seed);
+
+    std::vector<Geo_Point_E7> towns = {
+        Geo_Math::toE7(40.7128, -74.0060),
+        Geo_Math::toE7(37.7749, -122.4194),
+        Geo_Math::toE7(33.7490, -84.3880),
+        Geo_Math::toE7(51.5074, -0.1278),
+        Geo_Math::toE7(-33.8688, 151.2093),
+        Geo_Math::toE7(64.1466, -21.9426),
+    };
+
+    std::vector<Spatial_Entry> points;
+
+    for (size_t i = 0; i < numPoints; i++)
+    {
+        Geo_Point_E7 point = randomPoint(rng, towns);
+        points.push_back({Spatial_Index::Key(point), point, (uint32_t)i, (uint8_t)(i % 2)});
+    }
+
+    Spatial_Index index;
+
+    auto start = Clock::now();
+
+    for (const auto &point : points)
+    {
+        index.insert(point.kind, point.id, point.point);
+    }
+
+    double insertUS = elapsedUS(start);
+
+    std::vector<Geo_Point_E7> centers;
+
+    for (int i = 0; i < QUERIES; i++)
+    {
+        centers.push_back(randomPoint(rng, towns));
+    }
+
+    const float radii[] = {500, 5000, 50000, 2000000};
+
+    std::vector<Spatial_Match> indexed;
+    std::vector<Spatial_Match> scanned;
+    size_t mismatches = 0;
+
+    printf("%zu points, %d queries each\n\n", numPoints, QUERIES);
+    printf("insert one at a time:   %10.2f us per point\n\n", insertUS / numPoints);
+    printf("%-22s %12s %12s %10s\n", "query", "index us", "scan us", "avg found");
+
+    for (float radius : radii)
+    {
+        double indexUS = 0;
+        double scanUS = 0;
+        size_t found = 0;
+
+        for (const auto &center : centers)
+        {
+            start = Clock::now();
+            index.withinRadius(center, radius, indexed);
+            indexUS += elapsedUS(start);
+
+            start = Clock::now();
+            linearScan(points, center, radius, scanned);
+            scanUS += elapsedUS(start);
+
+            found += indexed.size();
+            mismatches += indexed.size() != scanned.size() || !sameDistances(indexed, scanned, indexed.size());
+        }
+
+        char label[32];
+        snprintf(label, sizeof(label), "within %.0f m", radius);
+        printf("%-22s %12.2f %12.2f %10.1f\n", label, indexUS / QUERIES, scanUS / QUERIES, (double)found / QUERIES);
+    }
+
+    double indexUS = 0;
+    double scanUS = 0;
+
+    for (const auto &center : centers)
+    {
+        start = Clock::now();
+        index.nearest(center, NEAREST_COUNT, indexed);
+        indexUS += elapsedUS(start);
+
+        start = Clock::now();
+        linearScan(points, center, SPATIAL_MAX_RADIUS_M, scanned);
+        scanUS += elapsedUS(start);
+
+        size_t expected = std::min<size_t>(NEAREST_COUNT, scanned.size());
+        mismatches += indexed.size() != expected || !sameDistances(indexed, scanned, expected);
+    }
+
+    char label[32];
+    snprintf(label, sizeof(label), "nearest %d", NEAREST_COUNT);
+    printf("%-22s %12.2f %12.2f %10d\n\n", label, indexUS / QUERIES, scanUS / QUERIES, NEAREST_COUNT);
+
+    start = Clock::now();
+
+    for (size_t i = 0; i < points.size(); i += 2)
+    {
+        index.remove(points[i].kind, points[i].id);
+    }
+
+    printf("remove half:            %10.2f us per point\n", elapsedUS(start) / ((points.size() + 1) / 2));
+    printf("entries left:           %10zu\n", index.size());
+    printf("mismatches:             %10zu\n", mismatches);
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/*
+    Times the text heavy screens drawn through Display_Utils::printText, which copies glyph columns into the
+    SSD1306 framebuffer, against the same text printed by Adafruit_GFX, and checks they draw the same pixels.
+
+        g++ -O2 -Wall -DHARDWARE_VERSION=2 -I host/ui -I host -I ../include -I ../include/Utilities \
+            text_bench.cpp ../src/Utilities/Display_Utils.cpp ../src/Utilities/EventHandler.cpp -o text_bench
+        ./text_bench [iterations]
+
+    Each screen is the text a real screen draws, laid out by Display_Utils::printFormattedText, in white on black
+    as OLED_Window sets it. It is drawn three ways on the host/ui shims:
+
+        blit      printText into the fake SSD1306's paged RAM, as the firmware does
+        gfx       printText with no framebuffer set, so Adafruit_GFX::print draws through the SSD1306 drawPixel
+        canvas    the same, onto a GFXcanvas1 of the panel's size
+
+    Every screen is first drawn over a dotted pattern, so clearing the background of each cell is checked too.
+    The blit RAM must equal the gfx RAM byte for byte and the canvas pixel for pixel. Exits with 1 on any
+    mismatch. Times are host times and only the ratio carries over to the ESP32. The host glcdfont.c is a
+    stand in for the Adafruit font, which changes the pixels but not the work done per glyph.
+*/
+
+#include "Display_Utils.h"
+#include "Display_Panel.h"
+#include "globalDefines.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct Screen_Line
+{
+    const char *text;
+    TextAlignmentHorizontal horizontal;
+    TextAlignmentVertical vertical;
+    uint16_t line;
+};
+
+struct Screen
+{
+    const char *name;
+    std::vector<Screen_Line> lines;
+};
+
+static const Screen SCREENS[] = {
+    // DiagnosticsState, with typical values
+    {"diagnostics", {
+        {"Heap Free: 143Kb", ALIGN_LEFT, TEXT_LINE, 1},
+        {"Heap Frag: 12%", ALIGN_LEFT, TEXT_LINE, 2},
+        {"Stack Left: 1876", ALIGN_LEFT, TEXT_LINE, 3},
+    }},
+    // PairBluetoothWindow before a connection
+    {"pair bluetooth", {
+        {"Waiting for", ALIGN_CENTER_HORIZONTAL, TEXT_LINE, 1},
+        {"Connection...", ALIGN_CENTER_HORIZONTAL, TEXT_LINE, 2},
+        {"Visit", ALIGN_CENTER_HORIZONTAL, TEXT_LINE, 4},
+        {"degen.ammaraskar.com", ALIGN_CENTER_HORIZONTAL, TEXT_LINE, 5},
+    }},
+    // A full page of the main menu with the button labels, as Menu_State and OLED_Window draw them
+    {"menu page", {
+        {"Home", ALIGN_LEFT, TEXT_LINE, 1},
+        {"> Messages", ALIGN_LEFT, TEXT_LINE, 2},
+        {"Compass", ALIGN_LEFT, TEXT_LINE, 3},
+        {"Nearby", ALIGN_LEFT, TEXT_LINE, 4},
+        {"Saved Locations", ALIGN_LEFT, TEXT_LINE, 5},
+        {"Settings", ALIGN_LEFT, TEXT_LINE, 6},
+        {"Select", ALIGN_LEFT, ALIGN_BOTTOM, 0},
+        {"Back", ALIGN_RIGHT, ALIGN_BOTTOM, 0},
+    }},
+    // Centered text straddles two pages, as printCenteredText draws it
+    {"centered", {
+        {"GPS Not Connected", ALIGN_CENTER_HORIZONTAL, ALIGN_CENTER_VERTICAL, 0},
+    }},
+};
+
+static size_t failures = 0;
+
+static void drawScreen(const Screen &screen)
+{
+    for (const Screen_Line &line : screen.lines)
+    {
+        TextFormat format;
+        format.horizontalAlignment = line.horizontal;
+        format.verticalAlignment = line.vertical;
+        format.line = line.line;
+
+        Display_Utils::printFormattedText(line.text, format);
+    }
+}
+
+// Dots every few pixels, so a path that skips the background of a cell leaves some behind
+static void drawPattern(Adafruit_GFX &target)
+{
+    for (int16_t y = 0; y < OLED_HEIGHT; y++)
+    {
+        for (int16_t x = 0; x < OLED_WIDTH; x++)
+        {
+            target.drawPixel(x, y, (x * 7 + y * 3) % 5 == 0 ? 1 : 0);
+        }
+    }
+}
+
+static void useTarget(Adafruit_GFX &target, uint8_t *frameBuffer)
+{
+    target.setTextSize(1);
+    target.setTextColor(1, 0);
+    target.setTextWrap(true);
+
+    Display_Utils::setDisplay(&target);
+    Display_Utils::setFrameBuffer(frameBuffer);
+}
+
+// Returns the average time to draw the screen's text, in microseconds. The screen is cleared once, outside the
+// timing, as the shim SSD1306 clears a pixel at a time where the library writes whole bytes.
+static double timeScreen(const Screen &screen, Adafruit_GFX &target, uint8_t *frameBuffer, int iterations)
+{
+    useTarget(target, frameBuffer);
+    Display_Utils::clearDisplay();
+
+    auto start = Clock::now();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        drawScreen(screen);
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+static void checkScreen(const Screen &screen, Display_Panel &blitPanel, Display_Panel &gfxPanel, GFXcanvas1 &canvas)
+{
+    useTarget(blitPanel, blitPanel.getBuffer());
+    drawPattern(blitPanel);
+    drawScreen(screen);
+
+    useTarget(gfxPanel, nullptr);
+    drawPattern(gfxPanel);
+    drawScreen(screen);
+
+    useTarget(canvas, nullptr);
+    drawPattern(canvas);
+    drawScreen(screen);
+
+    if (memcmp(blitPanel.getBuffer(), gfxPanel.getBuffer(), OLED_WIDTH * OLED_HEIGHT / 8) != 0)
+    {
+        fprintf(stderr, "FAIL %s: blit RAM differs from Adafruit_GFX on the SSD1306\n", screen.name);
+        failures++;
+    }
+
+    size_t differing = 0;
+
+    for (int16_t y = 0; y < OLED_HEIGHT; y++)
+    {
+        for (int16_t x = 0; x < OLED_WIDTH; x++)
+        {
+            if (blitPanel.getPixel(x, y) != canvas.getPixel(x, y))
+            {
+                differing++;
+            }
+        }
+    }
+
+    if (differing > 0)
+    {
+        fprintf(stderr, "FAIL %s: %zu pixels differ from Adafruit_GFX on a GFXcanvas1\n", screen.name, differing);
+        failures++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+
+    if (iterations <= 0)
+    {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    Display_Panel blitPanel(OLED_WIDTH, OLED_HEIGHT);
+    Display_Panel gfxPanel(OLED_WIDTH, OLED_HEIGHT);
+    GFXcanvas1 canvas(OLED_WIDTH, OLED_HEIGHT);
+
+    Display_Utils::setDisplayDimensions(OLED_WIDTH, OLED_HEIGHT);
+
+    printf("%d draws of each screen\n\n", iterations);
+    printf("%-16s %6s %10s %10s %10s %8s\n", "screen", "chars", "blit us", "gfx us", "canvas us", "speedup");
+
+    double totalBlit = 0;
+    double totalGfx = 0;
+
+    for (const Screen &screen : SCREENS)
+    {
+        checkScreen(screen, blitPanel, gfxPanel, canvas);
+
+        size_t chars = 0;
+
+        for (const Screen_Line &line : screen.lines)
+        {
+            chars += strlen(line.text);
+        }
+
+        double blitUS = timeScreen(screen, blitPanel, blitPanel.getBuffer(), iterations);
+        double gfxUS = timeScreen(screen, gfxPanel, nullptr, iterations);
+        double canvasUS = timeScreen(screen, canvas, nullptr, iterations);
+
+        totalBlit += blitUS;
+        totalGfx += gfxUS;
+
+        printf("%-16s %6zu %10.2f %10.2f %10.2f %7.1fx\n", screen.name, chars, blitUS, gfxUS, canvasUS, gfxUS / blitUS);
+    }
+
+    printf("\nall screens:          %8.2f us blit, %.2f us gfx, %.1fx\n", totalBlit, totalGfx, totalGfx / totalBlit);
+    printf("failures:             %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
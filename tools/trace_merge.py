@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Joins GetTraceRpc pages saved from a device into one Chrome trace, with task names.
+
+    trace_merge.py page.json [page2.json ...] [-o trace.json]
+
+Each file holds one response, or one response per line, fetched with "format": "chrome" and
+"hold": true. With TRACE_EVENTS_PER_CORE 256 the log holds up to 512 events, which at the default
+48 per page takes 11 pages, at offsets 0, 48, 96 and so on.
+
+Pages can be given in any order. Events are put back in claim order on each core by their "seq",
+which also drops events repeated across pages, and the cores are merged by timestamp with the
+microsecond clock's wraps undone. Task handles are named from the "tasks" the first page carries.
+Load the output in chrome://tracing or Perfetto.
+"""
+
+import argparse
+import heapq
+import json
+import sys
+
+CLOCK_WRAP_US = 1 << 32
+
+
+def load_responses(paths):
+    responses = []
+    for path in paths:
+        with open(path) as f:
+            text = f.read().strip()
+        try:
+            responses.append(json.loads(text))
+        except json.JSONDecodeError:
+            responses.extend(json.loads(line) for line in text.splitlines() if line.strip())
+    return responses
+
+
+def unwrap(events):
+    """Makes the timestamps of events in claim order increase across clock wraps."""
+    offset = 0
+    last = None
+    for event in events:
+        if last is not None and event["ts"] + offset < last - CLOCK_WRAP_US // 2:
+            offset += CLOCK_WRAP_US
+        event["ts"] += offset
+        last = event["ts"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("pages", nargs="+")
+    parser.add_argument("-o", "--output", default="trace.json")
+    args = parser.parse_args()
+
+    responses = load_responses(args.pages)
+    if not any("traceEvents" in response for response in responses):
+        sys.exit("No chrome format pages, fetch them with \"format\": \"chrome\"")
+
+    tasks = {}
+    total = 0
+    skipped = 0
+    cores = {}
+    duplicates = 0
+
+    for response in responses:
+        tasks.update(response.get("tasks", {}))
+        total = max(total, response.get("total", 0))
+
+        # Counted from the oldest event, so the page reaching furthest has seen them all
+        skipped = max(skipped, response.get("skipped", 0))
+
+        for event in response.get("traceEvents", []):
+            core = cores.setdefault(event["pid"], {})
+            seq = event["args"].get("seq")
+            if seq is None:
+                sys.exit("Pages have no event sequences, update the firmware")
+            if seq in core:
+                duplicates += 1
+                continue
+            core[seq] = event
+
+    per_core = []
+    for pid in sorted(cores):
+        events = [cores[pid][seq] for seq in sorted(cores[pid])]
+        unwrap(events)
+        per_core.append(events)
+
+    # Line the cores up if one wrapped before its first event and the other did not
+    first = min(events[0]["ts"] for events in per_core)
+    for events in per_core:
+        if events[0]["ts"] - first > CLOCK_WRAP_US // 2:
+            for event in events:
+                event["ts"] -= CLOCK_WRAP_US
+
+    merged = list(heapq.merge(*per_core, key=lambda event: event["ts"]))
+
+    metadata = []
+    for pid in sorted(cores):
+        metadata.append({"name": "process_name", "ph": "M", "pid": pid, "args": {"name": f"Core {pid}"}})
+        for tid in sorted({event["tid"] for event in cores[pid].values()}):
+            name = tasks.get(str(tid), f"Task {tid:#x}")
+            metadata.append({"name": "thread_name", "ph": "M", "pid": pid, "tid": tid, "args": {"name": name}})
+
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": metadata + merged, "displayTimeUnit": "ms"}, f)
+
+    unnamed = sum(1 for m in metadata if m["name"] == "thread_name" and m["args"]["name"].startswith("Task 0x"))
+
+    print(f"events:      {len(merged)} of {total}, from {len(responses)} pages")
+    print(f"duplicates:  {duplicates}")
+    print(f"incomplete:  {skipped}")
+    print(f"tasks:       {len(metadata) - len(cores)}, {unnamed} without a name")
+    if merged:
+        print(f"span:        {(merged[-1]['ts'] - merged[0]['ts']) / 1000:.1f} ms")
+    print(f"written to   {args.output}")
+
+    missing = total - skipped - len(merged)
+    if missing > 0:
+        print(f"{missing} events missing, check every page from offset 0 to {total} was given", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,560 @@
+/*
+    Runs the UI headless: the real window, state, content and Display_Utils code draws on a fake SSD1306
+    while a script of inputs plays, and every frame the panel receives is timed, counted and can be dumped.
+
+        g++ -O2 -Wall -Wno-stringop-truncation -DHARDWARE_VERSION=2 -I host/ui -I host -I ../include -I ../include/Utilities \
+            -I ../include/HelperClasses/OLED_Content -I ../include/HelperClasses/OLED_Window \
+            -I ../include/HelperClasses/Window_States ui_sim.cpp ../src/Utilities/Display_Utils.cpp \
+            ../src/Utilities/EventHandler.cpp ../src/HelperClasses/OLED_Window/OLED_Window.cpp \
+            ../src/HelperClasses/OLED_Content/OLED_Content.cpp -o ui_sim
+        ./ui_sim [script|-] [frameDir]
+
+    host/ui holds the Adafruit_GFX, SSD1306 and ArduinoJson shims and stubs for the LED and system modules.
+    The fake SSD1306 keeps the library's paged RAM and copies it onto a GFXcanvas1 on display(), which stands
+    for the panel. Display_Manager pulls in the whole firmware, so the sim builds a home window like
+    Home_State's and the main menu as generateMenuWindow and populateMainMenu do. Inputs are played back like
+    InjectInputsRpc's timer, one per interval without blocking, into a one item queue that a display task
+    drains as processCommandQueue does: debounce, callback lookup, execBtnCallback, the callback, then
+    drawCurrentWindow, which records DisplayFrameStats from the Display_Panel counters.
+
+    A script has one input per line, up, down, select, back or b1 to b4, optionally followed by the gap in ms
+    before the next one. '#' starts a comment. Without one a built in script opens the menu, scrolls through
+    every item both ways, selects Flashlight and goes back home. Each frame is written to frameDir as a PBM
+    (P4) when given.
+
+    Every frame must reach the panel, and Display_Panel must count exactly the transfers the fake panel saw.
+    The PBM Display_Utils::writePbm makes from the RAM must match what the panel shows. In the menu, the
+    label the panel shows must match the same text printed by Adafruit_GFX onto a GFXcanvas1. Back on the
+    home window the frame must equal the first home frame. The built in script must also drop no inputs and
+    toggle the flashlight once. Exits with 1 on any failure.
+*/
+
+#include "Display_Utils.h"
+#include "Display_Panel.h"
+#include "Menu_Window.h"
+#include "Text_Display_Content.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// As in Display_Manager.h
+#define DEBOUNCE_DELAY 100
+#define DISPLAY_COMMAND_QUEUE_LENGTH 1
+
+// InjectInputsRpc's default spacing
+#define DEFAULT_INTERVAL_MS (DEBOUNCE_DELAY * 2)
+
+#define FRAME_BYTES (OLED_WIDTH * OLED_HEIGHT / 8)
+
+struct Script_Input
+{
+    uint8_t inputID;
+    uint32_t intervalMS;
+    std::string name;
+};
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what, uint32_t frame)
+{
+    if (!condition)
+    {
+        if (failures < 10)
+        {
+            fprintf(stderr, "FAIL frame %u: %s\n", frame, what);
+        }
+
+        failures++;
+    }
+}
+
+// As populateMainMenu on a HARDWARE_VERSION 2 board
+static const char *const MAIN_MENU[] = {
+    "Settings", "Pair With Terminal", "Edit Status Messages", "Edit Saved Locations", "Nearby",
+    "Received Messages", "Flashlight", "Debug Compass", "Debug GPS", "Diagnostics", "Reboot Device",
+    "Pair Bluetooth"};
+
+static const uint32_t MAIN_MENU_ACTIONS[] = {
+    ACTION_GENERATE_SETTINGS_WINDOW, ACTION_OPEN_WIFI_RPC_WINDOW, ACTION_OPEN_SAVED_MESSAGES_WINDOW,
+    ACTION_OPEN_SAVED_LOCATIONS_WINDOW, ACTION_OPEN_NEARBY_WINDOW, ACTION_GENERATE_STATUSES_WINDOW,
+    ACTION_TOGGLE_FLASHLIGHT, ACTION_GENERATE_COMPASS_WINDOW, ACTION_GENERATE_GPS_WINDOW,
+    ACTION_OPEN_DIAGNOSTICS_WINDOW, ACTION_REBOOT_DEVICE, ACTION_INIT_BLE};
+
+#define MAIN_MENU_SIZE (sizeof(MAIN_MENU) / sizeof(MAIN_MENU[0]))
+#define FLASHLIGHT_INDEX 6
+
+// The home screen's static parts: clock and status text, battery and bell icons
+class Sim_Home_Content : public Text_Display_Content
+{
+public:
+    Sim_Home_Content(std::vector<TextDrawData> textData) : Text_Display_Content(textData) {}
+
+    void printContent()
+    {
+        drawBatteryIcon(Display_Utils::alignTextLeft(0), Display_Utils::selectTextLine(2), 70);
+        drawBellIcon(Display_Utils::alignTextLeft(3), Display_Utils::selectTextLine(2), true);
+        drawMessageIcon(Display_Utils::alignTextLeft(6), Display_Utils::selectTextLine(2));
+        Text_Display_Content::printContent();
+    }
+};
+
+class UI_Sim
+{
+public:
+    Display_Panel display{OLED_WIDTH, OLED_HEIGHT, &Wire};
+    QueueHandle_t queue = nullptr;
+
+    OLED_Window *currentWindow = nullptr;
+    Menu_Window *menuWindow = nullptr;
+    size_t menuIndex = 0;
+
+    DisplayFrameStats frameStats;
+    uint32_t flashlightToggles = 0;
+    uint32_t inputsProcessed = 0;
+    uint32_t inputsDebounced = 0;
+
+    std::vector<uint8_t> homeFrame;
+    const char *frameDir = nullptr;
+
+    UI_Sim()
+    {
+        // As Display_Manager::init
+        OLED_Window::display = &display;
+        Window_State::display = &display;
+        OLED_Content::display = &display;
+        Display_Utils::setDisplay(&display);
+        Display_Utils::setDisplayDimensions(OLED_WIDTH, OLED_HEIGHT);
+
+        queue = xQueueCreate(DISPLAY_COMMAND_QUEUE_LENGTH, sizeof(DisplayCommandQueueItem));
+        Display_Utils::setDisplayCommandQueue(queue);
+
+        display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+        Display_Utils::setFrameBuffer(display.getBuffer());
+        display.clearDisplay();
+        display.setTextSize(1);
+        display.setTextColor(SSD1306_WHITE);
+        display.display();
+
+        generateHomeWindow();
+
+        const uint8_t *shown = display.panel.getBuffer();
+        homeFrame.assign(shown, shown + FRAME_BYTES);
+    }
+
+    ~UI_Sim()
+    {
+        while (currentWindow != nullptr)
+        {
+            OLED_Window *parent = currentWindow->getParentWindow();
+            delete currentWindow;
+            currentWindow = parent != currentWindow ? parent : nullptr;
+        }
+
+        vQueueDelete(queue);
+    }
+
+    // Home_State's inputs, only Main Menu is wired up
+    void generateHomeWindow()
+    {
+        OLED_Window *home = new OLED_Window();
+
+        std::vector<TextDrawData> textData;
+        TextDrawData clock("12:00 PM");
+        clock.format.horizontalAlignment = ALIGN_RIGHT;
+        clock.format.verticalAlignment = TEXT_LINE;
+        clock.format.line = 2;
+        textData.push_back(clock);
+
+        TextDrawData status("No new messages");
+        status.format.verticalAlignment = TEXT_LINE;
+        status.format.line = 3;
+        textData.push_back(status);
+
+        Sim_Home_Content *content = new Sim_Home_Content(textData);
+        home->PushToContentList(content);
+
+        Window_State *state = new Window_State();
+        state->renderContent = content;
+        state->assignInput(BUTTON_1, ACTION_GENERATE_QUICK_ACTION_MENU, "Actions");
+        state->assignInput(BUTTON_2, ACTION_CALL_FUNCTIONAL_WINDOW_STATE, "Broadcast");
+        state->assignInput(BUTTON_3, ACTION_CALL_FUNCTIONAL_WINDOW_STATE, "Lock");
+        state->assignInput(BUTTON_4, ACTION_GENERATE_MENU_WINDOW, "Main Menu");
+        home->PushToStateList(state);
+        home->setInitialState(state);
+
+        currentWindow = home;
+        currentWindow->drawWindow();
+    }
+
+    void generateMenuWindow()
+    {
+        menuWindow = new Menu_Window(currentWindow);
+
+        for (size_t i = 0; i < MAIN_MENU_SIZE; i++)
+        {
+            menuWindow->addMenuItem(MAIN_MENU[i], MAIN_MENU_ACTIONS[i]);
+        }
+
+        menuIndex = 0;
+        currentWindow->Pause();
+        currentWindow = menuWindow;
+        currentWindow->drawWindow();
+    }
+
+    void goBack()
+    {
+        OLED_Window *parent = currentWindow->getParentWindow();
+
+        if (parent == nullptr || parent == currentWindow)
+        {
+            return;
+        }
+
+        OLED_Window *closed = currentWindow;
+        currentWindow = parent;
+        delete closed;
+
+        if (closed == menuWindow)
+        {
+            menuWindow = nullptr;
+        }
+
+        if (currentWindow->isPaused)
+        {
+            currentWindow->Resume();
+        }
+
+        currentWindow->drawWindow();
+    }
+
+    void processEventCallback(uint32_t callbackID)
+    {
+        switch (callbackID)
+        {
+        case ACTION_GENERATE_MENU_WINDOW:
+            generateMenuWindow();
+            break;
+        case ACTION_BACK:
+            goBack();
+            break;
+        case ACTION_TOGGLE_FLASHLIGHT:
+            flashlightToggles++;
+            break;
+        default:
+            break;
+        }
+    }
+
+    // As Display_Manager::processCommandQueue, polling so it can stop once the script has played
+    void displayTask(const std::atomic<bool> &scriptDone, TickType_t &lastButtonPressTick)
+    {
+        while (!scriptDone || uxQueueMessagesWaiting(queue) > 0)
+        {
+            DisplayCommandQueueItem command;
+
+            if (xQueueReceive(queue, &command, pdMS_TO_TICKS(10)) != pdTRUE || command.commandType != INPUT_COMMAND)
+            {
+                continue;
+            }
+
+            if ((xTaskGetTickCount() - lastButtonPressTick) <= DEBOUNCE_DELAY)
+            {
+                inputsDebounced++;
+                continue;
+            }
+
+            uint8_t input = command.commandData.inputCommand.inputID;
+            xQueueReset(queue);
+
+            CallbackData *cbPtr = currentWindow->getCallbackDataByInputID(input);
+            CallbackData callbackData;
+
+            if (cbPtr != nullptr)
+            {
+                callbackData = CallbackData(*cbPtr);
+            }
+
+            trackMenu(input, cbPtr != nullptr ? callbackData.callbackID : ACTION_NONE);
+            currentWindow->execBtnCallback(input);
+
+            if (cbPtr != nullptr)
+            {
+                processEventCallback(callbackData.callbackID);
+            }
+
+            drawCurrentWindow(input);
+            inputsProcessed++;
+
+            lastButtonPressTick = xTaskGetTickCount();
+        }
+    }
+
+    // The selection Menu_State should be showing, to check the panel against
+    void trackMenu(uint8_t input, uint32_t callbackID)
+    {
+        if (currentWindow != menuWindow || menuWindow == nullptr)
+        {
+            return;
+        }
+
+        if (input == ENC_DOWN)
+        {
+            menuIndex = (menuIndex + 1) % MAIN_MENU_SIZE;
+        }
+        else if (input == ENC_UP)
+        {
+            menuIndex = (menuIndex + MAIN_MENU_SIZE - 1) % MAIN_MENU_SIZE;
+        }
+        else if (input == BUTTON_4)
+        {
+            check(callbackID == MAIN_MENU_ACTIONS[menuIndex], "select ran another item's callback", frameStats.frameCount);
+        }
+    }
+
+    void drawCurrentWindow(uint8_t input)
+    {
+        uint32_t flushes = display.Flushes();
+        uint64_t bytesFlushed = display.BytesFlushed();
+        uint32_t panelFrames = display.panelFrames;
+
+        int64_t startTime = esp_timer_get_time();
+        currentWindow->drawWindow();
+        uint32_t drawTime = (uint32_t)(esp_timer_get_time() - startTime);
+
+        uint32_t frameFlushes = display.Flushes() - flushes;
+        uint32_t frameBytes = (uint32_t)(display.BytesFlushed() - bytesFlushed);
+        frameStats.record(drawTime, frameFlushes, frameBytes);
+
+        uint32_t frame = frameStats.frameCount;
+        printf("%5u  input %u  %6u us  %u flushes  %5u bytes\n", frame, input, drawTime, frameFlushes, frameBytes);
+
+        check(frameFlushes > 0, "frame never reached the panel", frame);
+        check(frameFlushes == display.panelFrames - panelFrames, "Display_Panel count differs from the transfers", frame);
+        check(frameBytes == frameFlushes * FRAME_BYTES, "bytes differ from whole framebuffer transfers", frame);
+
+        checkFrame(frame);
+    }
+
+    void checkFrame(uint32_t frame)
+    {
+        std::vector<uint8_t> pbm(Display_Utils::pbmLength(OLED_WIDTH, OLED_HEIGHT));
+        Display_Utils::writePbm(display.getBuffer(), OLED_WIDTH, OLED_HEIGHT, pbm.data());
+
+        const uint8_t *shown = display.panel.getBuffer();
+        size_t headerLength = pbm.size() - FRAME_BYTES;
+
+        check(memcmp(pbm.data(), "P4\n128 64\n", headerLength) == 0, "PBM header", frame);
+        check(memcmp(pbm.data() + headerLength, shown, FRAME_BYTES) == 0, "PBM differs from the panel", frame);
+
+        if (currentWindow == menuWindow && menuWindow != nullptr)
+        {
+            checkLabel(MAIN_MENU[menuIndex], frame);
+        }
+        else if (currentWindow->getParentWindow() == currentWindow)
+        {
+            check(memcmp(homeFrame.data(), shown, FRAME_BYTES) == 0, "home frame changed", frame);
+        }
+
+        if (frameDir != nullptr)
+        {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/frame_%04u.pbm", frameDir, frame);
+
+            FILE *file = fopen(path, "wb");
+            check(file != nullptr && fwrite(pbm.data(), 1, pbm.size(), file) == pbm.size(), "could not write frame", frame);
+
+            if (file != nullptr)
+            {
+                fclose(file);
+            }
+        }
+    }
+
+    // The label's cell on the panel against Adafruit_GFX printing it
+    void checkLabel(const char *label, uint32_t frame)
+    {
+        int16_t x = Display_Utils::centerTextHorizontal(label);
+        int16_t y = Display_Utils::centerTextVertical();
+        int16_t width = strlen(label) * 6;
+
+        GFXcanvas1 reference(OLED_WIDTH, OLED_HEIGHT);
+        reference.setTextWrap(false);
+        reference.setTextColor(1, 0);
+        reference.setCursor(x, y);
+        reference.print(label);
+
+        bool same = true;
+
+        for (int16_t row = y; row < y + 8; row++)
+        {
+            for (int16_t col = x; col < x + width; col++)
+            {
+                same = same && reference.getPixel(col, row) == display.panel.getPixel(col, row);
+            }
+        }
+
+        check(same, "menu label differs from Adafruit_GFX", frame);
+    }
+};
+
+static bool parseInput(const std::string &name, uint8_t &inputID)
+{
+    static const std::map<std::string, uint8_t> INPUTS = {
+        {"up", ENC_UP}, {"down", ENC_DOWN}, {"select", BUTTON_4}, {"back", BUTTON_3},
+        {"b1", BUTTON_1}, {"b2", BUTTON_2}, {"b3", BUTTON_3}, {"b4", BUTTON_4}};
+
+    auto it = INPUTS.find(name);
+
+    if (it == INPUTS.end())
+    {
+        return false;
+    }
+
+    inputID = it->second;
+    return true;
+}
+
+static bool loadScript(const char *path, std::vector<Script_Input> &script)
+{
+    std::ifstream file(path);
+    std::string line;
+
+    if (!file)
+    {
+        return false;
+    }
+
+    while (std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        Script_Input input;
+
+        if (!(fields >> input.name))
+        {
+            continue;
+        }
+
+        if (!parseInput(input.name, input.inputID))
+        {
+            fprintf(stderr, "unknown input '%s'\n", input.name.c_str());
+            return false;
+        }
+
+        if (!(fields >> input.intervalMS))
+        {
+            input.intervalMS = DEFAULT_INTERVAL_MS;
+        }
+
+        script.push_back(input);
+    }
+
+    return true;
+}
+
+static std::vector<Script_Input> builtInScript()
+{
+    std::vector<std::string> names = {"select"};
+
+    for (size_t i = 0; i < MAIN_MENU_SIZE; i++)
+    {
+        names.push_back("down");
+    }
+
+    for (size_t i = 0; i < MAIN_MENU_SIZE + 2; i++)
+    {
+        names.push_back("up");
+    }
+
+    for (size_t i = 0; i < FLASHLIGHT_INDEX + 2; i++)
+    {
+        names.push_back("down");
+    }
+
+    names.push_back("select");
+    names.push_back("back");
+    names.push_back("b2");
+
+    std::vector<Script_Input> script;
+
+    for (auto &name : names)
+    {
+        Script_Input input;
+        input.name = name;
+        input.intervalMS = DEBOUNCE_DELAY + 20;
+        parseInput(name, input.inputID);
+        script.push_back(input);
+    }
+
+    return script;
+}
+
+int main(int argc, char **argv)
+{
+    bool builtIn = argc < 2 || strcmp(argv[1], "-") == 0;
+    std::vector<Script_Input> script;
+
+    if (builtIn)
+    {
+        script = builtInScript();
+    }
+    else if (!loadScript(argv[1], script))
+    {
+        fprintf(stderr, "usage: %s [script|-] [frameDir]\n", argv[0]);
+        return 1;
+    }
+
+    UI_Sim sim;
+    sim.frameDir = argc > 2 ? argv[2] : nullptr;
+
+    std::atomic<bool> scriptDone{false};
+
+    // Debounce counts from the home window's first draw
+    TickType_t lastButtonPressTick = xTaskGetTickCount();
+    std::thread displayTask([&]() { sim.displayTask(scriptDone, lastButtonPressTick); });
+
+    // As the input script timer: one input per interval, retried on the next one while the queue is full
+    for (size_t next = 0; next < script.size();)
+    {
+        vTaskDelay(pdMS_TO_TICKS(script[next].intervalMS));
+
+        if (Display_Utils::trySendInputCommand(script[next].inputID))
+        {
+            next++;
+        }
+    }
+
+    scriptDone = true;
+    displayTask.join();
+
+    const DisplayFrameStats &stats = sim.frameStats;
+
+    printf("\n%zu inputs, %u processed, %u debounced\n", script.size(), sim.inputsProcessed, sim.inputsDebounced);
+    printf("frames:              %8u\n", stats.frameCount);
+    printf("draw time:           %8.1f us average, %u us max\n",
+           stats.frameCount > 0 ? (double)stats.totalDrawTimeUS / stats.frameCount : 0.0, stats.maxDrawTimeUS);
+    printf("flushes:             %8u in frames, %u in total\n", stats.flushes, sim.display.Flushes());
+    printf("bytes flushed:       %8llu in frames, %llu in total\n", (unsigned long long)stats.bytesFlushed,
+           (unsigned long long)sim.display.BytesFlushed());
+    printf("assumed before:      %8u bytes at one flush per frame\n", stats.frameCount * FRAME_BYTES);
+
+    if (builtIn)
+    {
+        check(sim.inputsProcessed == script.size(), "inputs were dropped", stats.frameCount);
+        check(sim.flashlightToggles == 1, "Flashlight was not selected once", stats.frameCount);
+        check(sim.currentWindow->getParentWindow() == sim.currentWindow,
+              "did not end on the home window", stats.frameCount);
+    }
+
+    printf("failures:            %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
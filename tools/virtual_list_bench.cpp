@@ -0,0 +1,151 @@
+/*
+    Scrolls a Virtual_List over a large data source and reports memory use and per-scroll cost.
+
+        g++ -O2 -I ../include/HelperClasses/OLED_Content virtual_list_bench.cpp -o virtual_list_bench
+        ./virtual_list_bench [numItems]
+
+    Rows are built like SavedLocation, a name string and coordinates, so fetch cost is close to the real
+    pickers. Every scroll is checked: the selected row must hold the right item, the viewport must contain the
+    selection and no scroll may fetch more than the selected row and its prefetched neighbour.
+    Exits with 1 on any failure.
+*/
+
+#include "Virtual_List.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#define VIEWPORT 4
+
+struct Row
+{
+    std::string name;
+    double latitude;
+    double longitude;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static size_t numItems = 10000;
+static size_t fetches = 0;
+
+static bool fetchRow(size_t index, Row &row)
+{
+    fetches++;
+    row.name = "Location " + std::to_string(index);
+    row.latitude = index * 0.001;
+    row.longitude = -(double)index * 0.001;
+    return true;
+}
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what, size_t step)
+{
+    if (!condition)
+    {
+        if (failures < 10)
+        {
+            fprintf(stderr, "step %zu: %s\n", step, what);
+        }
+
+        failures++;
+    }
+}
+
+template <typename List>
+static void checkSelection(List &list, size_t expected, size_t step)
+{
+    const Row *row = list.selected();
+
+    check(list.selectedIndex() == expected, "wrong selected index", step);
+    check(row != nullptr && row->latitude == expected * 0.001, "selected row holds the wrong item", step);
+    check(list.selectedIndex() >= list.firstVisibleIndex() && list.selectedIndex() < list.firstVisibleIndex() + VIEWPORT,
+          "selection outside the viewport", step);
+}
+
+int main(int argc, char **argv)
+{
+    numItems = argc > 1 ? strtoul(argv[1], nullptr, 10) : numItems;
+
+    if (numItems < 2)
+    {
+        fprintf(stderr, "usage: %s [numItems >= 2]\n", argv[0]);
+        return 1;
+    }
+
+    Virtual_List<Row, VIEWPORT> list([]() { return numItems; }, fetchRow);
+
+    size_t maxFetches = 0;
+    size_t step = 0;
+
+    // Down the whole list, wrapping once to the top
+    auto start = Clock::now();
+
+    for (size_t i = 1; i <= numItems; i++, step++)
+    {
+        size_t before = fetches;
+        list.scrollDown();
+        list.selected();
+
+        maxFetches = std::max(maxFetches, fetches - before);
+        checkSelection(list, i % numItems, step);
+    }
+
+    double downNS = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / numItems;
+
+    // Back up, wrapping to the bottom
+    start = Clock::now();
+
+    for (size_t i = 1; i <= numItems; i++, step++)
+    {
+        size_t before = fetches;
+        list.scrollUp();
+        list.selected();
+
+        maxFetches = std::max(maxFetches, fetches - before);
+        checkSelection(list, (numItems - i) % numItems, step);
+    }
+
+    double upNS = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / numItems;
+
+    // Drawing a page fetches only the rows not already cached
+    size_t before = fetches;
+
+    for (size_t row = 0; row < VIEWPORT; row++)
+    {
+        list.visibleRow(row);
+    }
+
+    size_t pageFetches = fetches - before;
+
+    // Without wrapping the selection stops at the ends
+    list.reset();
+    list.scrollUp(false);
+    checkSelection(list, 0, step++);
+
+    for (size_t i = 0; i < numItems + 5; i++)
+    {
+        list.scrollDown(false);
+    }
+
+    checkSelection(list, numItems - 1, step++);
+    size_t lastVisible = std::min<size_t>(VIEWPORT, numItems) - 1;
+    check(list.visibleRow(lastVisible) != nullptr && list.visibleRow(lastVisible + 1) == nullptr, "viewport not clamped to the end", step);
+
+    check(maxFetches <= 2, "a scroll fetched more than the selected row and its neighbour", step);
+
+    printf("%zu items, %d row viewport\n\n", numItems, VIEWPORT);
+    printf("list object:           %8zu bytes, independent of item count\n", sizeof(list));
+    printf("backing data if copied:%8zu bytes (name buffers excluded)\n", numItems * sizeof(Row));
+    printf("scroll down:           %8.1f ns per step, fetch included\n", downNS);
+    printf("scroll up:             %8.1f ns per step, fetch included\n", upNS);
+    printf("most fetches per step: %8zu\n", maxFetches);
+    printf("fetches to draw page:  %8zu\n", pageFetches);
+    printf("failures:              %8zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,529 @@
+/*
+    Drives Window_Pool_Slot through 10 000 random navigations and compares the heap with and without the pool.
+
+        g++ -O2 -Wall -Wextra -I ../include/HelperClasses/OLED_Window window_pool_test.cpp -o window_pool_test
+        ./window_pool_test [navigations] [seed]
+
+    The windows are stand-ins with the allocation pattern of the real ones: the window object, its states and
+    content, and the lists their constructors fill. The sizes are representative, not measured, so only the
+    comparison between the two runs means anything. Received messages are allocated and replaced while the user
+    navigates, as LoraUtils does, so freed windows leave holes between them the way they do on the device.
+
+    Navigation follows Display_Manager: the pooled windows are acquired from their slot and fall back to the heap
+    when the slot is already on the window stack, goBack releases to the slots and deletes the rest. The same
+    navigation runs a second time with every window on the heap, as before the pool.
+
+    The heap is a first fit allocator over a fixed arena with 8 byte block headers, and fragmentation is counted
+    as Heap_Utils does. The pooled run must never allocate a window that has a free slot, and must free everything
+    it allocated apart from what the slots keep. It must not end up more fragmented than the heap run, and its
+    peak may only be higher by the windows the slots keep. Exits with 1 on any failure.
+*/
+
+#include "Window_Pool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#define ARENA_BYTES (48 * 1024)
+#define BLOCK_HEADER_BYTES 8
+
+#define MAX_WINDOW_DEPTH 6
+#define MAX_WINDOW_ALLOCATIONS 16
+
+// Received messages kept at once, and the chance a navigation step also receives one
+#define MAX_MESSAGES 24
+#define MESSAGE_PERCENT 30
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *what, size_t step)
+{
+    if (!condition)
+    {
+        if (failures < 10)
+        {
+            fprintf(stderr, "step %zu: %s\n", step, what);
+        }
+
+        failures++;
+    }
+}
+
+// First fit over a fixed arena. Free neighbours are merged, so the largest free block shows the fragmentation.
+class Simulated_Heap
+{
+public:
+    Simulated_Heap()
+    {
+        setBlock(0, ARENA_BYTES, false);
+    }
+
+    void *allocate(size_t size)
+    {
+        size_t needed = BLOCK_HEADER_BYTES + ((size + 7) & ~(size_t)7);
+
+        for (size_t offset = 0; offset < ARENA_BYTES; offset += blockSize(offset))
+        {
+            if (blockUsed(offset) || blockSize(offset) < needed)
+            {
+                continue;
+            }
+
+            size_t remaining = blockSize(offset) - needed;
+
+            if (remaining >= 2 * BLOCK_HEADER_BYTES)
+            {
+                setBlock(offset + needed, remaining, false);
+                setBlock(offset, needed, true);
+            }
+            else
+            {
+                setBlock(offset, blockSize(offset), true);
+            }
+
+            allocations++;
+            return arena + offset + BLOCK_HEADER_BYTES;
+        }
+
+        failedAllocations++;
+        return nullptr;
+    }
+
+    void release(void *ptr)
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+
+        size_t offset = (uint8_t *)ptr - arena - BLOCK_HEADER_BYTES;
+        setBlock(offset, blockSize(offset), false);
+
+        // Merge every run of free blocks
+        for (size_t start = 0; start < ARENA_BYTES; start += blockSize(start))
+        {
+            while (!blockUsed(start) && start + blockSize(start) < ARENA_BYTES && !blockUsed(start + blockSize(start)))
+            {
+                setBlock(start, blockSize(start) + blockSize(start + blockSize(start)), false);
+            }
+        }
+    }
+
+    size_t freeBytes() const { return walk(false); }
+    size_t largestFreeBlock() const { return walk(true); }
+
+    // As Heap_Utils::FragmentationPercent
+    uint8_t fragmentationPercent() const
+    {
+        size_t free = freeBytes();
+        return free == 0 ? 0 : 100 - (uint8_t)((uint64_t)largestFreeBlock() * 100 / free);
+    }
+
+    size_t usedBytes() const { return ARENA_BYTES - freeBytes(); }
+
+    size_t allocations = 0;
+    size_t failedAllocations = 0;
+
+private:
+    alignas(8) uint8_t arena[ARENA_BYTES];
+
+    uint32_t blockSize(size_t offset) const
+    {
+        uint32_t header;
+        memcpy(&header, arena + offset, sizeof(header));
+        return header & ~1u;
+    }
+
+    bool blockUsed(size_t offset) const
+    {
+        uint32_t header;
+        memcpy(&header, arena + offset, sizeof(header));
+        return header & 1u;
+    }
+
+    void setBlock(size_t offset, size_t size, bool used)
+    {
+        uint32_t header = (uint32_t)size | (used ? 1u : 0u);
+        memcpy(arena + offset, &header, sizeof(header));
+    }
+
+    // Sum of the free space past the headers, or the largest such block
+    size_t walk(bool largest) const
+    {
+        size_t result = 0;
+
+        for (size_t offset = 0; offset < ARENA_BYTES; offset += blockSize(offset))
+        {
+            if (!blockUsed(offset))
+            {
+                size_t usable = blockSize(offset) - BLOCK_HEADER_BYTES;
+                result = largest ? std::max(result, usable) : result + usable;
+            }
+        }
+
+        return result;
+    }
+};
+
+static Simulated_Heap heap;
+
+// The window hierarchy, as far as the pool and Display_Manager see it
+class OLED_Window
+{
+public:
+    OLED_Window(OLED_Window *parent) : parentWindow(parent) {}
+
+    virtual ~OLED_Window()
+    {
+        for (size_t i = 0; i < numAllocations; i++)
+        {
+            heap.release(allocations[i]);
+        }
+    }
+
+    OLED_Window *getParentWindow() { return parentWindow; }
+
+    // Pooled windows keep their states and content between visits
+    virtual void releaseWindow() { visits++; }
+    virtual void reuseWindow(OLED_Window *parent) { parentWindow = parent; }
+
+    size_t visits = 0;
+
+protected:
+    OLED_Window *parentWindow;
+
+    void *allocations[MAX_WINDOW_ALLOCATIONS];
+    size_t numAllocations = 0;
+
+    // States, content and lists are all allocated by the constructors
+    void own(size_t size)
+    {
+        if (numAllocations < MAX_WINDOW_ALLOCATIONS)
+        {
+            allocations[numAllocations++] = heap.allocate(size);
+        }
+    }
+
+    // Replaces the last allocation with a larger one, as a growing vector does
+    void grow(size_t size)
+    {
+        void *grown = heap.allocate(size);
+        heap.release(allocations[numAllocations - 1]);
+        allocations[numAllocations - 1] = grown;
+    }
+};
+
+// A menu state and the items populateMainMenu adds, in a list that grows as they are added
+class Menu_Window : public OLED_Window
+{
+public:
+    Menu_Window(OLED_Window *parent) : OLED_Window(parent)
+    {
+        own(96);
+        own(12);
+
+        for (size_t capacity = 2; capacity <= 16; capacity *= 2)
+        {
+            grow(capacity * 12);
+        }
+    }
+
+    uint8_t padding[64];
+};
+
+// Settings, edit states for each value type and the content with its copy of the settings
+class Settings_Window : public OLED_Window
+{
+public:
+    Settings_Window(OLED_Window *parent) : OLED_Window(parent)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            own(72);
+        }
+
+        own(160);
+        own(1024);
+    }
+
+    uint8_t padding[48];
+};
+
+class ReceivedMessagesWindow : public OLED_Window
+{
+public:
+    ReceivedMessagesWindow(OLED_Window *parent) : OLED_Window(parent)
+    {
+        own(88);
+        own(88);
+        own(136);
+        own(256);
+    }
+
+    uint8_t padding[40];
+};
+
+// Windows that are not pooled, like GPS_Window and Compass_Window
+class Heap_Window : public OLED_Window
+{
+public:
+    Heap_Window(OLED_Window *parent) : OLED_Window(parent)
+    {
+        own(80);
+        own(120);
+    }
+
+    uint8_t padding[32];
+};
+
+enum Window_Kind
+{
+    WINDOW_MENU,
+    WINDOW_SETTINGS,
+    WINDOW_MESSAGES,
+    WINDOW_OTHER,
+    NUM_WINDOW_KINDS,
+};
+
+struct Run_Result
+{
+    size_t peakUsed;
+    uint8_t maxFragmentation;
+    size_t windowAllocations;
+    size_t finalUsed;
+};
+
+// Lets the test free what a slot keeps, which the device never does
+template <typename T>
+class Destroyable_Slot : public Window_Pool_Slot<T>
+{
+public:
+    void destroy()
+    {
+        if (this->instance != nullptr)
+        {
+            this->instance->~T();
+            this->instance = nullptr;
+        }
+    }
+};
+
+class Navigator
+{
+public:
+    Navigator(bool pooled) : pooled(pooled), home(nullptr) {}
+
+    Destroyable_Slot<Menu_Window> menuWindowSlot;
+    Destroyable_Slot<Settings_Window> settingsWindowSlot;
+    Destroyable_Slot<ReceivedMessagesWindow> receivedMessagesWindowSlot;
+
+    OLED_Window *currentWindow = &home;
+    size_t depth = 0;
+    size_t windowAllocations = 0;
+
+    void open(Window_Kind kind)
+    {
+        switch (kind)
+        {
+        case WINDOW_MENU:
+            attach(generate(menuWindowSlot));
+            break;
+        case WINDOW_SETTINGS:
+            attach(generate(settingsWindowSlot));
+            break;
+        case WINDOW_MESSAGES:
+            attach(generate(receivedMessagesWindowSlot));
+            break;
+        default:
+            attach(create<Heap_Window>());
+            break;
+        }
+    }
+
+    // As Display_Manager::goBack and releaseWindow
+    void goBack()
+    {
+        if (currentWindow->getParentWindow() == nullptr)
+        {
+            return;
+        }
+
+        OLED_Window *window = currentWindow;
+        currentWindow = currentWindow->getParentWindow();
+        depth--;
+
+        if (pooled && (menuWindowSlot.release(window) || settingsWindowSlot.release(window) || receivedMessagesWindowSlot.release(window)))
+        {
+            return;
+        }
+
+        window->~OLED_Window();
+        heap.release(window);
+    }
+
+    // Frees what the slots keep, so everything allocated can be accounted for
+    void destroySlots()
+    {
+        destroy(menuWindowSlot);
+        destroy(settingsWindowSlot);
+        destroy(receivedMessagesWindowSlot);
+    }
+
+private:
+    bool pooled;
+    OLED_Window home;
+
+    template <typename T>
+    void destroy(Destroyable_Slot<T> &slot)
+    {
+        slot.destroy();
+    }
+
+    template <typename T>
+    T *create()
+    {
+        size_t before = heap.allocations;
+        void *memory = heap.allocate(sizeof(T));
+        T *window = memory != nullptr ? new (memory) T(currentWindow) : nullptr;
+        windowAllocations += heap.allocations - before;
+        return window;
+    }
+
+    // As the generate functions in Display_Manager
+    template <typename T>
+    T *generate(Window_Pool_Slot<T> &slot)
+    {
+        if (!pooled)
+        {
+            return create<T>();
+        }
+
+        bool slotFree = slot.isConstructed() && !slot.isInUse();
+        size_t before = heap.allocations;
+        T *window = slot.acquire(currentWindow);
+
+        if (slotFree)
+        {
+            check(window != nullptr && heap.allocations == before, "a free slot allocated", 0);
+        }
+
+        if (window == nullptr)
+        {
+            check(slot.isInUse(), "acquire failed with the slot free", 0);
+            return create<T>();
+        }
+
+        windowAllocations += heap.allocations - before;
+        return window;
+    }
+
+    void attach(OLED_Window *window)
+    {
+        if (window != nullptr)
+        {
+            currentWindow = window;
+            depth++;
+        }
+    }
+};
+
+static Run_Result navigate(bool pooled, size_t navigations, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    Navigator navigator(pooled);
+
+    void *messages[MAX_MESSAGES] = {};
+    size_t nextMessage = 0;
+
+    size_t baseline = heap.usedBytes();
+    Run_Result result = {0, 0, 0, 0};
+
+    for (size_t step = 0; step < navigations; step++)
+    {
+        // Deeper stacks are more likely to go back, so the user keeps returning home
+        bool back = navigator.depth == MAX_WINDOW_DEPTH || (navigator.depth > 0 && random() % MAX_WINDOW_DEPTH < navigator.depth);
+
+        if (back)
+        {
+            navigator.goBack();
+        }
+        else
+        {
+            navigator.open((Window_Kind)(random() % NUM_WINDOW_KINDS));
+        }
+
+        if (random() % 100 < MESSAGE_PERCENT)
+        {
+            heap.release(messages[nextMessage]);
+            messages[nextMessage] = heap.allocate(24 + random() % 160);
+            nextMessage = (nextMessage + 1) % MAX_MESSAGES;
+        }
+
+        result.peakUsed = std::max(result.peakUsed, heap.usedBytes() - baseline);
+        result.maxFragmentation = std::max(result.maxFragmentation, heap.fragmentationPercent());
+    }
+
+    while (navigator.depth > 0)
+    {
+        navigator.goBack();
+    }
+
+    for (void *message : messages)
+    {
+        heap.release(message);
+    }
+
+    result.windowAllocations = navigator.windowAllocations;
+    result.finalUsed = heap.usedBytes() - baseline;
+
+    navigator.destroySlots();
+    check(heap.usedBytes() == baseline, pooled ? "pooled run leaked" : "heap run leaked", navigations);
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    size_t navigations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+    uint32_t seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+
+    // The slot on its own
+    {
+        Navigator navigator(true);
+        OLED_Window parent(nullptr);
+        OLED_Window other(nullptr);
+
+        Menu_Window *first = navigator.menuWindowSlot.acquire(&parent);
+        check(first != nullptr && navigator.menuWindowSlot.isInUse(), "first acquire", 0);
+        check(navigator.menuWindowSlot.acquire(&parent) == nullptr, "acquired a window already in use", 0);
+        check(!navigator.menuWindowSlot.release(&other), "released a window the slot does not own", 0);
+        check(navigator.menuWindowSlot.release(first) && !navigator.menuWindowSlot.release(first), "released twice", 0);
+
+        Menu_Window *second = navigator.menuWindowSlot.acquire(&other);
+        check(second == first && second->getParentWindow() == &other && second->visits == 1, "reuse did not re-parent the same window", 0);
+
+        navigator.menuWindowSlot.release(second);
+        navigator.destroySlots();
+    }
+
+    Run_Result pooled = navigate(true, navigations, seed);
+    Run_Result unpooled = navigate(false, navigations, seed);
+
+    check(heap.failedAllocations == 0, "arena too small for the navigation", 0);
+    // The pool keeps its windows allocated between visits, and may cost that much more at the peak but no more
+    check(pooled.peakUsed <= unpooled.peakUsed + pooled.finalUsed, "pool raised the peak by more than it keeps", navigations);
+    check(pooled.maxFragmentation <= unpooled.maxFragmentation, "pool raised the fragmentation", navigations);
+    check(pooled.windowAllocations < unpooled.windowAllocations, "pool did not save allocations", navigations);
+
+    printf("%zu navigations, seed %u, %d byte arena\n\n", navigations, seed, ARENA_BYTES);
+    printf("                       pooled       heap\n");
+    printf("window allocations: %9zu  %9zu\n", pooled.windowAllocations, unpooled.windowAllocations);
+    printf("peak bytes used:    %9zu  %9zu\n", pooled.peakUsed, unpooled.peakUsed);
+    printf("max fragmentation:  %8u%%  %8u%%\n", pooled.maxFragmentation, unpooled.maxFragmentation);
+    printf("kept by the slots:  %9zu  %9zu\n", pooled.finalUsed, unpooled.finalUsed);
+    printf("failures: %zu\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}